@@ -1265,6 +1265,24 @@ static int confdb_get_domain_internal(struct confdb_ctx *cdb,
               domain->refresh_expired_interval);
     }
 
+    ret = get_entry_as_uint32(res->msgs[0], &domain->prewarm_cache_entries,
+                              CONFDB_DOMAIN_PREWARM_CACHE_ENTRIES, 0);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Invalid value for [%s]\n",
+               CONFDB_DOMAIN_PREWARM_CACHE_ENTRIES);
+        goto done;
+    }
+
+    ret = get_entry_as_bool(res->msgs[0], &domain->dp_binary_ipc,
+                            CONFDB_DOMAIN_DP_BINARY_IPC, 0);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Invalid value for [%s]\n",
+               CONFDB_DOMAIN_DP_BINARY_IPC);
+        goto done;
+    }
+
     /* Set the PAM warning time, if specified. If not specified, pass on
      * the "not set" value of "-1" which means "use provider default". The
      * value 0 means "always display the warning if server sends one" */
@@ -1569,6 +1587,8 @@ int confdb_get_domains(struct confdb_ctx *cdb,
         goto done;
     }
 
+    sss_domain_index_update(cdb->doms);
+
     *domains = cdb->doms;
     ret = EOK;
 
@@ -95,12 +95,15 @@
 #define CONFDB_RESPONDER_IDLE_TIMEOUT "responder_idle_timeout"
 #define CONFDB_RESPONDER_IDLE_DEFAULT_TIMEOUT 300
 #define CONFDB_RESPONDER_CACHE_FIRST "cache_first"
+#define CONFDB_RESPONDER_ENTRY_CACHE_GRACE_PERIOD "entry_cache_grace_period"
+#define CONFDB_RESPONDER_ENTRY_CACHE_GRACE_PERIOD_DEFAULT 0
 
 /* NSS */
 #define CONFDB_NSS_CONF_ENTRY "config/nss"
 #define CONFDB_NSS_ENUM_CACHE_TIMEOUT "enum_cache_timeout"
 #define CONFDB_NSS_ENTRY_CACHE_NOWAIT_PERCENTAGE "entry_cache_nowait_percentage"
 #define CONFDB_NSS_ENTRY_NEG_TIMEOUT "entry_negative_timeout"
+#define CONFDB_NSS_ENTRY_NEG_TIMEOUT_MAX "entry_negative_timeout_max"
 #define CONFDB_NSS_FILTER_USERS_IN_GROUPS "filter_users_in_groups"
 #define CONFDB_NSS_FILTER_USERS "filter_users"
 #define CONFDB_NSS_FILTER_GROUPS "filter_groups"
@@ -123,6 +126,7 @@
 #define CONFDB_DEFAULT_PAM_FAILED_LOGIN_ATTEMPTS 0
 #define CONFDB_PAM_FAILED_LOGIN_DELAY "offline_failed_login_delay"
 #define CONFDB_DEFAULT_PAM_FAILED_LOGIN_DELAY 5
+#define CONFDB_PAM_OFFLINE_AUTH_WORKERS "offline_auth_workers"
 #define CONFDB_PAM_VERBOSITY "pam_verbosity"
 #define CONFDB_PAM_RESPONSE_FILTER "pam_response_filter"
 #define CONFDB_PAM_ID_TIMEOUT "pam_id_timeout"
@@ -149,6 +153,7 @@
 #define CONFDB_DEFAULT_SUDO_INVERSE_ORDER false
 #define CONFDB_SUDO_THRESHOLD "sudo_threshold"
 #define CONFDB_DEFAULT_SUDO_THRESHOLD 50
+#define CONFDB_DEFAULT_SUDO_MEMCACHE_TIMEOUT 60
 
 /* autofs */
 #define CONFDB_AUTOFS_CONF_ENTRY "config/autofs"
@@ -178,6 +183,9 @@
 #define CONFDB_IFP_CONF_ENTRY "config/ifp"
 #define CONFDB_IFP_USER_ATTR_LIST "user_attributes"
 #define CONFDB_IFP_WILDCARD_LIMIT "wildcard_limit"
+#define CONFDB_IFP_RESOLVE_MEMBERS_CONCURRENCY "resolve_members_concurrency"
+#define CONFDB_DEFAULT_IFP_RESOLVE_MEMBERS_CONCURRENCY 10
+#define CONFDB_IFP_RESOLVE_MEMBERS_LIMIT "resolve_members_limit"
 
 /* Session Recording */
 #define CONFDB_SESSION_RECORDING_CONF_ENTRY "config/session_recording"
@@ -233,6 +241,8 @@
 #define CONFDB_DOMAIN_COMPUTER_CACHE_TIMEOUT "entry_cache_computer_timeout"
 #define CONFDB_DOMAIN_PWD_EXPIRATION_WARNING "pwd_expiration_warning"
 #define CONFDB_DOMAIN_REFRESH_EXPIRED_INTERVAL "refresh_expired_interval"
+#define CONFDB_DOMAIN_PREWARM_CACHE_ENTRIES "prewarm_cache_entries"
+#define CONFDB_DOMAIN_DP_BINARY_IPC "dp_binary_ipc"
 #define CONFDB_DOMAIN_OFFLINE_TIMEOUT "offline_timeout"
 #define CONFDB_DOMAIN_SUBDOMAIN_INHERIT "subdomain_inherit"
 #define CONFDB_DOMAIN_CACHED_AUTH_TIMEOUT "cached_auth_timeout"
@@ -296,6 +306,8 @@
 
 struct confdb_ctx;
 struct config_file_ctx;
+struct sss_domain_index;
+struct sysdb_cache_gen;
 
 /** sssd domain state */
 enum sss_domain_state {
@@ -377,6 +389,8 @@ struct sss_domain_info {
     uint32_t computer_timeout;
 
     uint32_t refresh_expired_interval;
+    uint32_t prewarm_cache_entries;
+    bool dp_binary_ipc;
     uint32_t subdomain_refresh_interval;
     uint32_t cached_auth_timeout;
 
@@ -415,6 +429,14 @@ struct sss_domain_info {
     /* Do not use the _output_fqnames property directly in new code, but rather
      * use sss_domain_info_{get,set}_output_fqnames(). */
     bool output_fqnames;
+
+    /* Name and SID lookup index, only set on the first domain in the list.
+     * See sss_domain_index_update(). */
+    struct sss_domain_index *index;
+
+    /* Cache generations last read from sysdb, see
+     * sysdb_get_cache_generation_cached(). */
+    struct sysdb_cache_gen *cache_gen;
 };
 
 /**
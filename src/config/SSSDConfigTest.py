@@ -605,6 +605,8 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'entry_cache_sudo_timeout',
             'entry_cache_ssh_host_timeout',
             'refresh_expired_interval',
+            'prewarm_cache_entries',
+            'dp_binary_ipc',
             'lookup_family_order',
             'account_cache_expiration',
             'dns_resolver_server_timeout',
@@ -977,6 +979,8 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'entry_cache_sudo_timeout',
             'entry_cache_ssh_host_timeout',
             'refresh_expired_interval',
+            'prewarm_cache_entries',
+            'dp_binary_ipc',
             'account_cache_expiration',
             'lookup_family_order',
             'dns_resolver_server_timeout',
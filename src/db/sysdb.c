@@ -1398,6 +1398,206 @@ done:
     return ret;
 }
 
+static const char *sysdb_cache_gen_attr(enum sysdb_cache_gen_type type)
+{
+    switch (type) {
+    case SYSDB_CACHE_GEN_USERS:
+        return SYSDB_USER_CACHE_GEN;
+    case SYSDB_CACHE_GEN_GROUPS:
+        return SYSDB_GROUP_CACHE_GEN;
+    case SYSDB_CACHE_GEN_NETGROUPS:
+        return SYSDB_NETGROUP_CACHE_GEN;
+    case SYSDB_CACHE_GEN_SERVICES:
+        return SYSDB_SERVICE_CACHE_GEN;
+    case SYSDB_CACHE_GEN_AUTOFS:
+        return SYSDB_AUTOFS_CACHE_GEN;
+    case SYSDB_CACHE_GEN_SSH_HOSTS:
+        return SYSDB_SSH_HOST_CACHE_GEN;
+    case SYSDB_CACHE_GEN_INITGROUPS:
+        return SYSDB_INITGR_CACHE_GEN;
+    case SYSDB_CACHE_GEN_SENTINEL:
+        break;
+    }
+
+    return NULL;
+}
+
+errno_t sysdb_get_cache_generation(struct sss_domain_info *domain,
+                                   enum sysdb_cache_gen_type type,
+                                   uint32_t *_generation)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_dn *dn;
+    const char *attr;
+    uint32_t generation;
+    errno_t ret;
+
+    attr = sysdb_cache_gen_attr(type);
+    if (attr == NULL) {
+        return EINVAL;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    dn = sysdb_domain_dn(tmp_ctx, domain);
+    if (dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sysdb_get_uint(domain->sysdb, dn, attr, &generation);
+    if (ret == ENOENT) {
+        generation = 0;
+    } else if (ret != EOK) {
+        goto done;
+    }
+
+    *_generation = generation;
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+struct sysdb_cache_gen {
+    uint32_t generation[SYSDB_CACHE_GEN_SENTINEL];
+    time_t last_read[SYSDB_CACHE_GEN_SENTINEL];
+};
+
+static struct sysdb_cache_gen *
+sysdb_cache_gen_get(struct sss_domain_info *domain)
+{
+    if (domain->cache_gen == NULL) {
+        domain->cache_gen = talloc_zero(domain, struct sysdb_cache_gen);
+    }
+
+    return domain->cache_gen;
+}
+
+errno_t sysdb_refresh_cache_generation(struct sss_domain_info *domain,
+                                       enum sysdb_cache_gen_type type,
+                                       uint32_t *_generation)
+{
+    struct sysdb_cache_gen *cache;
+    uint32_t generation;
+    errno_t ret;
+
+    if (type < 0 || type >= SYSDB_CACHE_GEN_SENTINEL) {
+        return EINVAL;
+    }
+
+    cache = sysdb_cache_gen_get(domain);
+    if (cache == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_get_cache_generation(domain, type, &generation);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    cache->generation[type] = generation;
+    cache->last_read[type] = time(NULL);
+
+    *_generation = generation;
+    return EOK;
+}
+
+errno_t sysdb_get_cache_generation_cached(struct sss_domain_info *domain,
+                                          enum sysdb_cache_gen_type type,
+                                          uint32_t *_generation)
+{
+    struct sysdb_cache_gen *cache;
+    time_t now;
+
+    if (type < 0 || type >= SYSDB_CACHE_GEN_SENTINEL) {
+        return EINVAL;
+    }
+
+    cache = sysdb_cache_gen_get(domain);
+    if (cache == NULL) {
+        return ENOMEM;
+    }
+
+    now = time(NULL);
+    if (cache->last_read[type] != 0
+            && now >= cache->last_read[type]
+            && now - cache->last_read[type] < SYSDB_CACHE_GEN_REFRESH) {
+        *_generation = cache->generation[type];
+        return EOK;
+    }
+
+    return sysdb_refresh_cache_generation(domain, type, _generation);
+}
+
+errno_t sysdb_bump_cache_generation(struct sss_domain_info *domain,
+                                    enum sysdb_cache_gen_type type)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_dn *dn;
+    const char *attr;
+    uint32_t generation;
+    uint32_t now;
+    errno_t ret;
+
+    attr = sysdb_cache_gen_attr(type);
+    if (attr == NULL) {
+        return EINVAL;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    dn = sysdb_domain_dn(tmp_ctx, domain);
+    if (dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sysdb_get_uint(domain->sysdb, dn, attr, &generation);
+    if (ret == ENOENT) {
+        generation = 0;
+    } else if (ret != EOK) {
+        goto done;
+    }
+
+    /* The generation must always move forward, even if the clock did not. */
+    now = time(NULL);
+    generation = now > generation ? now : generation + 1;
+
+    ret = sysdb_set_uint(domain->sysdb, dn, domain->name, attr, generation);
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+bool sysdb_is_older_than_generation(struct ldb_message *msg,
+                                    enum sysdb_cache_gen_type type,
+                                    uint32_t generation)
+{
+    const char *attr;
+    uint64_t last_update;
+
+    if (generation == 0) {
+        return false;
+    }
+
+    attr = type == SYSDB_CACHE_GEN_INITGROUPS ? SYSDB_INITGR_LAST_UPDATE
+                                              : SYSDB_LAST_UPDATE;
+
+    /* Objects updated in the same second as the invalidation are considered
+     * expired as well since we can not tell which happened first. */
+    last_update = ldb_msg_find_attr_as_uint64(msg, attr, 0);
+    return last_update <= generation;
+}
+
 errno_t sysdb_attrs_primary_name(struct sysdb_ctx *sysdb,
                                  struct sysdb_attrs *attrs,
                                  const char *ldap_attr,
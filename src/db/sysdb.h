@@ -98,6 +98,7 @@
 #define SYSDB_LAST_UPDATE "lastUpdate"
 #define SYSDB_CACHE_EXPIRE "dataExpireTimestamp"
 #define SYSDB_INITGR_EXPIRE "initgrExpireTimestamp"
+#define SYSDB_INITGR_LAST_UPDATE "initgrLastUpdate"
 #define SYSDB_ENUM_EXPIRE "enumerationExpireTimestamp"
 #define SYSDB_IFP_CACHED "ifpCached"
 
@@ -229,9 +230,18 @@
 #define SYSDB_HAS_ENUMERATED "has_enumerated"
 #define SYSDB_HAS_ENUMERATED_ID       0x00000001
 
+#define SYSDB_USER_CACHE_GEN "userCacheGeneration"
+#define SYSDB_GROUP_CACHE_GEN "groupCacheGeneration"
+#define SYSDB_NETGROUP_CACHE_GEN "netgroupCacheGeneration"
+#define SYSDB_SERVICE_CACHE_GEN "serviceCacheGeneration"
+#define SYSDB_AUTOFS_CACHE_GEN "autofsCacheGeneration"
+#define SYSDB_SSH_HOST_CACHE_GEN "sshHostCacheGeneration"
+#define SYSDB_INITGR_CACHE_GEN "initgrCacheGeneration"
+
 #define SYSDB_DEFAULT_ATTRS SYSDB_LAST_UPDATE, \
                             SYSDB_CACHE_EXPIRE, \
                             SYSDB_INITGR_EXPIRE, \
+                            SYSDB_INITGR_LAST_UPDATE, \
                             SYSDB_OBJECTCLASS, \
                             SYSDB_OBJECTCATEGORY
 
@@ -674,6 +684,13 @@ errno_t sysdb_add_overrides_to_object(struct sss_domain_info *domain,
                                       struct ldb_message *override_obj,
                                       const char **req_attrs);
 
+/* Same as calling sysdb_add_overrides_to_object() without an override object
+ * and attribute list for each object, but reads the overrides with a single
+ * search if many of the objects have one. */
+errno_t sysdb_add_overrides_to_objects(struct sss_domain_info *domain,
+                                       struct ldb_message **objs,
+                                       size_t count);
+
 errno_t sysdb_add_group_member_overrides(struct sss_domain_info *domain,
                                          struct ldb_message *obj,
                                          bool expect_override_dn);
@@ -1179,6 +1196,23 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
                      time_t *_expire_date,
                      time_t *_delayed_until);
 
+struct sss_crypt_pool;
+
+/* Same as sysdb_cache_auth() but the password hash is computed by the
+ * helper threads of @pool, if it is not NULL, so the caller's event loop is
+ * not blocked. The returned values are the same as of sysdb_cache_auth(). */
+struct tevent_req *sysdb_cache_auth_send(TALLOC_CTX *mem_ctx,
+                                         struct tevent_context *ev,
+                                         struct sss_crypt_pool *pool,
+                                         struct sss_domain_info *domain,
+                                         const char *name,
+                                         const char *password,
+                                         struct confdb_ctx *cdb,
+                                         bool just_check);
+int sysdb_cache_auth_recv(struct tevent_req *req,
+                          time_t *_expire_date,
+                          time_t *_delayed_until);
+
 int sysdb_store_custom(struct sss_domain_info *domain,
                        const char *object_name,
                        const char *subtree_name,
@@ -1324,6 +1358,55 @@ errno_t sysdb_remove_attrs(struct sss_domain_info *domain,
                            enum sysdb_member_type type,
                            char **remove_attrs);
 
+/* Cache generations make it possible to invalidate all cached objects of
+ * one type in a domain without touching the objects themselves. The
+ * generation is stored in the domain entry and is the time of the last
+ * invalidation. Objects whose SYSDB_LAST_UPDATE is not newer than the
+ * generation must be treated as expired. Group memberships of users are
+ * compared by SYSDB_INITGR_LAST_UPDATE instead, since looking up the user
+ * alone does not refresh them. */
+enum sysdb_cache_gen_type {
+    SYSDB_CACHE_GEN_USERS,
+    SYSDB_CACHE_GEN_GROUPS,
+    SYSDB_CACHE_GEN_NETGROUPS,
+    SYSDB_CACHE_GEN_SERVICES,
+    SYSDB_CACHE_GEN_AUTOFS,
+    SYSDB_CACHE_GEN_SSH_HOSTS,
+    SYSDB_CACHE_GEN_INITGROUPS,
+
+    SYSDB_CACHE_GEN_SENTINEL
+};
+
+/* Returns 0 in @_generation if the objects were never invalidated. */
+errno_t sysdb_get_cache_generation(struct sss_domain_info *domain,
+                                   enum sysdb_cache_gen_type type,
+                                   uint32_t *_generation);
+
+/* Same as sysdb_get_cache_generation() but the generation is read from the
+ * cache at most once per SYSDB_CACHE_GEN_REFRESH seconds per domain and type,
+ * so it can be used on every cache hit. An invalidation may be noticed up to
+ * SYSDB_CACHE_GEN_REFRESH seconds late. */
+#define SYSDB_CACHE_GEN_REFRESH 1
+
+errno_t sysdb_get_cache_generation_cached(struct sss_domain_info *domain,
+                                          enum sysdb_cache_gen_type type,
+                                          uint32_t *_generation);
+
+/* Read the generation from the cache now and update the value used by
+ * sysdb_get_cache_generation_cached(). Use it before an object that was
+ * checked with the cached value is copied to a cache that is invalidated
+ * together with the generation, e.g. the memory cache. */
+errno_t sysdb_refresh_cache_generation(struct sss_domain_info *domain,
+                                       enum sysdb_cache_gen_type type,
+                                       uint32_t *_generation);
+
+errno_t sysdb_bump_cache_generation(struct sss_domain_info *domain,
+                                    enum sysdb_cache_gen_type type);
+
+bool sysdb_is_older_than_generation(struct ldb_message *msg,
+                                    enum sysdb_cache_gen_type type,
+                                    uint32_t generation);
+
 /**
  * @brief Return direct parents of an object in the cache
  *
@@ -41,6 +41,7 @@ const char *sysdb_ts_cache_attrs[] = {
     SYSDB_CACHE_EXPIRE,
     SYSDB_ORIG_MODSTAMP,
     SYSDB_INITGR_EXPIRE,
+    SYSDB_INITGR_LAST_UPDATE,
     SYSDB_USN,
 
     NULL,
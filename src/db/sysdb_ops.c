@@ -24,6 +24,7 @@
 #include "db/sysdb_services.h"
 #include "db/sysdb_autofs.h"
 #include "util/crypto/sss_crypto.h"
+#include "util/sss_crypt_pool.h"
 #include "util/cert.h"
 #include <time.h>
 
@@ -3330,6 +3331,12 @@ static errno_t set_initgroups_expire_attribute(struct sss_domain_info *domain,
         goto done;
     }
 
+    ret = sysdb_attrs_add_time_t(attrs, SYSDB_INITGR_LAST_UPDATE, time(NULL));
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Could not set up attrs\n");
+        goto done;
+    }
+
     ret = sysdb_set_user_attr(domain, name, attrs, SYSDB_MOD_REP);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
@@ -4604,19 +4611,16 @@ done:
     return ret;
 }
 
-static errno_t check_for_combined_2fa_password(struct sss_domain_info *domain,
+static errno_t get_combined_2fa_short_password(TALLOC_CTX *mem_ctx,
+                                               struct sss_domain_info *domain,
                                                struct ldb_message *ldb_msg,
                                                const char *password,
-                                               const char *userhash)
+                                               char **_short_pw)
 {
-
     unsigned int cached_authtok_type;
     unsigned int cached_fa2_len;
     char *short_pw;
-    char *comphash;
     size_t pw_len;
-    TALLOC_CTX *tmp_ctx;
-    int ret;
 
     cached_authtok_type = ldb_msg_find_attr_as_uint(ldb_msg,
                                                     SYSDB_CACHEDPWD_TYPE,
@@ -4639,20 +4643,39 @@ static errno_t check_for_combined_2fa_password(struct sss_domain_info *domain,
         return EINVAL;
     }
 
+    short_pw = talloc_strndup(mem_ctx, password, (pw_len - cached_fa2_len));
+    if (short_pw == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "talloc_strndup failed.\n");
+        return ENOMEM;
+    }
+    talloc_set_destructor((TALLOC_CTX *)short_pw,
+                          sss_erase_talloc_mem_securely);
+
+    *_short_pw = short_pw;
+    return EOK;
+}
+
+static errno_t check_for_combined_2fa_password(struct sss_domain_info *domain,
+                                               struct ldb_message *ldb_msg,
+                                               const char *password,
+                                               const char *userhash)
+{
+    char *short_pw;
+    char *comphash;
+    TALLOC_CTX *tmp_ctx;
+    int ret;
+
     tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
         DEBUG(SSSDBG_OP_FAILURE, "talloc_new failed.\n");
         return ENOMEM;
     }
 
-    short_pw = talloc_strndup(tmp_ctx, password, (pw_len - cached_fa2_len));
-    if (short_pw == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE, "talloc_strndup failed.\n");
-        ret = ENOMEM;
+    ret = get_combined_2fa_short_password(tmp_ctx, domain, ldb_msg, password,
+                                          &short_pw);
+    if (ret != EOK) {
         goto done;
     }
-    talloc_set_destructor((TALLOC_CTX *)short_pw,
-                          sss_erase_talloc_mem_securely);
 
     ret = s3crypt_sha512(tmp_ctx, short_pw, userhash, &comphash);
     if (ret != EOK) {
@@ -4676,33 +4699,10 @@ done:
     return ret;
 }
 
-int sysdb_cache_auth(struct sss_domain_info *domain,
-                     const char *name,
-                     const char *password,
-                     struct confdb_ctx *cdb,
-                     bool just_check,
-                     time_t *_expire_date,
-                     time_t *_delayed_until)
+static errno_t sysdb_cache_auth_check_input(struct sss_domain_info *domain,
+                                            const char *name,
+                                            struct confdb_ctx *cdb)
 {
-    TALLOC_CTX *tmp_ctx;
-    const char *attrs[] = { SYSDB_NAME, SYSDB_CACHEDPWD, SYSDB_DISABLED,
-                            SYSDB_LAST_LOGIN, SYSDB_LAST_ONLINE_AUTH,
-                            "lastCachedPasswordChange",
-                            "accountExpires", SYSDB_FAILED_LOGIN_ATTEMPTS,
-                            SYSDB_LAST_FAILED_LOGIN, SYSDB_CACHEDPWD_TYPE,
-                            SYSDB_CACHEDPWD_FA2_LEN, NULL };
-    struct ldb_message *ldb_msg;
-    const char *userhash;
-    char *comphash;
-    uint64_t lastLogin = 0;
-    int cred_expiration;
-    uint32_t failed_login_attempts = 0;
-    struct sysdb_attrs *update_attrs;
-    bool authentication_successful = false;
-    time_t expire_date = -1;
-    time_t delayed_until = -1;
-    int ret;
-
     if (name == NULL || *name == '\0') {
         DEBUG(SSSDBG_CRIT_FAILURE, "Missing user name.\n");
         return EINVAL;
@@ -4723,25 +4723,41 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
         return EINVAL;
     }
 
-    tmp_ctx = talloc_new(NULL);
-    if (!tmp_ctx) {
-        return ENOMEM;
-    }
+    return EOK;
+}
 
-    ret = ldb_transaction_start(domain->sysdb->ldb);
-    if (ret) {
-        talloc_zfree(tmp_ctx);
-        ret = sysdb_error_to_errno(ret);
-        return ret;
-    }
+/* Reads the cached user entry and checks if offline authentication is
+ * permitted at all. Everything is done except the expensive comparison
+ * of the password hashes. */
+static errno_t sysdb_cache_auth_get_user(TALLOC_CTX *mem_ctx,
+                                         struct sss_domain_info *domain,
+                                         const char *name,
+                                         struct confdb_ctx *cdb,
+                                         struct ldb_message **_ldb_msg,
+                                         const char **_userhash,
+                                         uint32_t *_failed_login_attempts,
+                                         time_t *_expire_date,
+                                         time_t *_delayed_until)
+{
+    const char *attrs[] = { SYSDB_NAME, SYSDB_CACHEDPWD, SYSDB_DISABLED,
+                            SYSDB_LAST_LOGIN, SYSDB_LAST_ONLINE_AUTH,
+                            "lastCachedPasswordChange",
+                            "accountExpires", SYSDB_FAILED_LOGIN_ATTEMPTS,
+                            SYSDB_LAST_FAILED_LOGIN, SYSDB_CACHEDPWD_TYPE,
+                            SYSDB_CACHEDPWD_FA2_LEN, NULL };
+    struct ldb_message *ldb_msg;
+    const char *userhash;
+    uint64_t lastLogin = 0;
+    int cred_expiration;
+    errno_t ret;
 
-    ret = sysdb_search_user_by_name(tmp_ctx, domain, name, attrs, &ldb_msg);
+    ret = sysdb_search_user_by_name(mem_ctx, domain, name, attrs, &ldb_msg);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "sysdb_search_user_by_name failed [%d][%s].\n",
                   ret, strerror(ret));
         if (ret == ENOENT) ret = ERR_ACCOUNT_UNKNOWN;
-        goto done;
+        return ret;
     }
 
     /* Check offline_auth_cache_timeout */
@@ -4754,28 +4770,27 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "Failed to read expiration time of offline credentials.\n");
-        goto done;
+        return ret;
     }
     DEBUG(SSSDBG_TRACE_ALL, "Offline credentials expiration is [%d] days.\n",
               cred_expiration);
 
     if (cred_expiration) {
-        expire_date = lastLogin + (cred_expiration * 86400);
-        if (expire_date < time(NULL)) {
+        *_expire_date = lastLogin + (cred_expiration * 86400);
+        if (*_expire_date < time(NULL)) {
             DEBUG(SSSDBG_CONF_SETTINGS, "Cached user entry is too old.\n");
-            expire_date = 0;
-            ret = ERR_CACHED_CREDS_EXPIRED;
-            goto done;
+            *_expire_date = 0;
+            return ERR_CACHED_CREDS_EXPIRED;
         }
     } else {
-        expire_date = 0;
+        *_expire_date = 0;
     }
 
-    ret = check_failed_login_attempts(cdb, ldb_msg, &failed_login_attempts,
-                                      &delayed_until);
+    ret = check_failed_login_attempts(cdb, ldb_msg, _failed_login_attempts,
+                                      _delayed_until);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to check login attempts\n");
-        goto done;
+        return ret;
     }
 
     /* TODO: verify user account (disabled, expired ...) */
@@ -4783,15 +4798,28 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
     userhash = ldb_msg_find_attr_as_string(ldb_msg, SYSDB_CACHEDPWD, NULL);
     if (userhash == NULL || *userhash == '\0') {
         DEBUG(SSSDBG_CONF_SETTINGS, "Cached credentials not available.\n");
-        ret = ERR_NO_CACHED_CREDS;
-        goto done;
+        return ERR_NO_CACHED_CREDS;
     }
 
-    ret = s3crypt_sha512(tmp_ctx, password, userhash, &comphash);
-    if (ret) {
-        DEBUG(SSSDBG_CONF_SETTINGS, "Failed to create password hash.\n");
-        ret = ERR_INTERNAL;
-        goto done;
+    *_ldb_msg = ldb_msg;
+    *_userhash = userhash;
+    return EOK;
+}
+
+/* Records the result of the offline authentication in the cache. Failing to
+ * update the entry after a successful authentication is not fatal. */
+static errno_t sysdb_cache_auth_store_result(struct sss_domain_info *domain,
+                                             const char *name,
+                                             bool authentication_successful,
+                                             uint32_t failed_login_attempts)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sysdb_attrs *update_attrs;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
     }
 
     update_attrs = sysdb_new_attrs(tmp_ctx);
@@ -4801,18 +4829,7 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
         goto done;
     }
 
-    if (strcmp(userhash, comphash) == 0
-            || check_for_combined_2fa_password(domain, ldb_msg,
-                                               password, userhash) == EOK) {
-        /* TODO: probable good point for audit logging */
-        DEBUG(SSSDBG_CONF_SETTINGS, "Hashes do match!\n");
-        authentication_successful = true;
-
-        if (just_check) {
-            ret = EOK;
-            goto done;
-        }
-
+    if (authentication_successful) {
         ret = sysdb_attrs_add_time_t(update_attrs,
                                      SYSDB_LAST_LOGIN, time(NULL));
         if (ret != EOK) {
@@ -4830,11 +4847,7 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
             ret = EOK;
             goto done;
         }
-
     } else {
-        DEBUG(SSSDBG_CONF_SETTINGS, "Authentication failed.\n");
-        authentication_successful = false;
-
         ret = sysdb_attrs_add_time_t(update_attrs,
                                      SYSDB_LAST_FAILED_LOGIN,
                                      time(NULL));
@@ -4845,7 +4858,7 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
 
         ret = sysdb_attrs_add_uint32(update_attrs,
                                      SYSDB_FAILED_LOGIN_ATTEMPTS,
-                                     ++failed_login_attempts);
+                                     failed_login_attempts + 1);
         if (ret != EOK) {
             DEBUG(SSSDBG_MINOR_FAILURE, "sysdb_attrs_add_uint32 failed.\n");
             goto done;
@@ -4859,6 +4872,81 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
               "Failed to update Login attempt information!\n");
     }
 
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+int sysdb_cache_auth(struct sss_domain_info *domain,
+                     const char *name,
+                     const char *password,
+                     struct confdb_ctx *cdb,
+                     bool just_check,
+                     time_t *_expire_date,
+                     time_t *_delayed_until)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_message *ldb_msg;
+    const char *userhash;
+    char *comphash;
+    uint32_t failed_login_attempts = 0;
+    bool authentication_successful = false;
+    time_t expire_date = -1;
+    time_t delayed_until = -1;
+    int ret;
+
+    ret = sysdb_cache_auth_check_input(domain, name, cdb);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (!tmp_ctx) {
+        return ENOMEM;
+    }
+
+    ret = ldb_transaction_start(domain->sysdb->ldb);
+    if (ret) {
+        talloc_zfree(tmp_ctx);
+        ret = sysdb_error_to_errno(ret);
+        return ret;
+    }
+
+    ret = sysdb_cache_auth_get_user(tmp_ctx, domain, name, cdb,
+                                    &ldb_msg, &userhash,
+                                    &failed_login_attempts,
+                                    &expire_date, &delayed_until);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = s3crypt_sha512(tmp_ctx, password, userhash, &comphash);
+    if (ret) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "Failed to create password hash.\n");
+        ret = ERR_INTERNAL;
+        goto done;
+    }
+
+    if (strcmp(userhash, comphash) == 0
+            || check_for_combined_2fa_password(domain, ldb_msg,
+                                               password, userhash) == EOK) {
+        /* TODO: probable good point for audit logging */
+        DEBUG(SSSDBG_CONF_SETTINGS, "Hashes do match!\n");
+        authentication_successful = true;
+
+        if (just_check) {
+            ret = EOK;
+            goto done;
+        }
+    } else {
+        DEBUG(SSSDBG_CONF_SETTINGS, "Authentication failed.\n");
+        authentication_successful = false;
+    }
+
+    ret = sysdb_cache_auth_store_result(domain, name,
+                                        authentication_successful,
+                                        failed_login_attempts);
+
 done:
     if (_expire_date != NULL) {
         *_expire_date = expire_date;
@@ -4886,6 +4974,301 @@ done:
     return ret;
 }
 
+struct sysdb_cache_auth_state {
+    struct tevent_context *ev;
+    struct sss_crypt_pool *pool;
+    struct sss_domain_info *domain;
+    struct confdb_ctx *cdb;
+    const char *name;
+    char *password;
+    bool just_check;
+
+    struct ldb_message *ldb_msg;
+    const char *userhash;
+    uint32_t failed_login_attempts;
+    time_t expire_date;
+    time_t delayed_until;
+    bool authentication_successful;
+};
+
+static void sysdb_cache_auth_hashed(struct tevent_req *subreq);
+static void sysdb_cache_auth_2fa_hashed(struct tevent_req *subreq);
+static errno_t sysdb_cache_auth_finish(struct sysdb_cache_auth_state *state);
+
+/* Asynchronous version of sysdb_cache_auth(). The cached entry is read and
+ * updated in the main thread but the password hash is computed by the
+ * helper threads of @pool so the event loop is not blocked. */
+struct tevent_req *sysdb_cache_auth_send(TALLOC_CTX *mem_ctx,
+                                         struct tevent_context *ev,
+                                         struct sss_crypt_pool *pool,
+                                         struct sss_domain_info *domain,
+                                         const char *name,
+                                         const char *password,
+                                         struct confdb_ctx *cdb,
+                                         bool just_check)
+{
+    struct sysdb_cache_auth_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct sysdb_cache_auth_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_req_create() failed\n");
+        return NULL;
+    }
+
+    state->ev = ev;
+    state->pool = pool;
+    state->domain = domain;
+    state->cdb = cdb;
+    state->just_check = just_check;
+    state->expire_date = -1;
+    state->delayed_until = -1;
+
+    ret = sysdb_cache_auth_check_input(domain, name, cdb);
+    if (ret != EOK) {
+        goto immediately;
+    }
+
+    state->name = talloc_strdup(state, name);
+    state->password = talloc_strdup(state, password);
+    if (state->name == NULL || state->password == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+    talloc_set_destructor((TALLOC_CTX *)state->password,
+                          sss_erase_talloc_mem_securely);
+
+    ret = sysdb_cache_auth_get_user(state, domain, name, cdb,
+                                    &state->ldb_msg, &state->userhash,
+                                    &state->failed_login_attempts,
+                                    &state->expire_date,
+                                    &state->delayed_until);
+    if (ret != EOK) {
+        goto immediately;
+    }
+
+    subreq = s3crypt_sha512_send(state, ev, pool, state->password,
+                                 state->userhash);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    tevent_req_set_callback(subreq, sysdb_cache_auth_hashed, req);
+
+    return req;
+
+immediately:
+    tevent_req_error(req, ret);
+    tevent_req_post(req, ev);
+
+    return req;
+}
+
+static void sysdb_cache_auth_hashed(struct tevent_req *subreq)
+{
+    struct sysdb_cache_auth_state *state;
+    struct tevent_req *req;
+    char *short_pw;
+    char *comphash;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sysdb_cache_auth_state);
+
+    ret = s3crypt_sha512_recv(state, subreq, &comphash);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "Failed to create password hash.\n");
+        tevent_req_error(req, ERR_INTERNAL);
+        return;
+    }
+
+    if (strcmp(state->userhash, comphash) == 0) {
+        state->authentication_successful = true;
+        goto done;
+    }
+
+    ret = get_combined_2fa_short_password(state, state->domain, state->ldb_msg,
+                                          state->password, &short_pw);
+    if (ret == EOK) {
+        subreq = s3crypt_sha512_send(state, state->ev, state->pool,
+                                     short_pw, state->userhash);
+        talloc_free(short_pw);
+        if (subreq == NULL) {
+            tevent_req_error(req, ENOMEM);
+            return;
+        }
+
+        tevent_req_set_callback(subreq, sysdb_cache_auth_2fa_hashed, req);
+        return;
+    }
+
+    state->authentication_successful = false;
+
+done:
+    ret = sysdb_cache_auth_finish(state);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static void sysdb_cache_auth_2fa_hashed(struct tevent_req *subreq)
+{
+    struct sysdb_cache_auth_state *state;
+    struct tevent_req *req;
+    char *comphash;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sysdb_cache_auth_state);
+
+    ret = s3crypt_sha512_recv(state, subreq, &comphash);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "Failed to create password hash.\n");
+        tevent_req_error(req, ERR_INTERNAL);
+        return;
+    }
+
+    if (strcmp(state->userhash, comphash) == 0) {
+        state->authentication_successful = true;
+    } else {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Hash of shorten password does not match.\n");
+        state->authentication_successful = false;
+    }
+
+    ret = sysdb_cache_auth_finish(state);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static errno_t sysdb_cache_auth_finish(struct sysdb_cache_auth_state *state)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char *attrs[] = { SYSDB_FAILED_LOGIN_ATTEMPTS,
+                            SYSDB_LAST_FAILED_LOGIN, NULL };
+    struct ldb_message *ldb_msg;
+    time_t delayed_until;
+    bool in_transaction = false;
+    errno_t sret;
+    errno_t ret;
+
+    if (state->authentication_successful) {
+        /* TODO: probable good point for audit logging */
+        DEBUG(SSSDBG_CONF_SETTINGS, "Hashes do match!\n");
+        if (state->just_check) {
+            return EOK;
+        }
+    } else {
+        DEBUG(SSSDBG_CONF_SETTINGS, "Authentication failed.\n");
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sysdb_transaction_start(state->domain->sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
+        goto done;
+    }
+    in_transaction = true;
+
+    /* Other attempts of the same user might have been processed while the
+     * hash was computed, so the counters are read again inside the
+     * transaction which updates them. */
+    ret = sysdb_search_user_by_name(tmp_ctx, state->domain, state->name,
+                                    attrs, &ldb_msg);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "sysdb_search_user_by_name failed [%d][%s].\n",
+              ret, sss_strerror(ret));
+        if (ret == ENOENT) ret = ERR_ACCOUNT_UNKNOWN;
+        goto done;
+    }
+
+    ret = check_failed_login_attempts(state->cdb, ldb_msg,
+                                      &state->failed_login_attempts,
+                                      &delayed_until);
+    if (ret == ERR_AUTH_DENIED) {
+        /* The account was locked by another attempt, the result of this one
+         * must neither unlock it nor count as another failure. */
+        DEBUG(SSSDBG_CONF_SETTINGS,
+              "Account was locked while the hash was computed.\n");
+        state->delayed_until = delayed_until;
+        state->authentication_successful = false;
+        goto done;
+    } else if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to check login attempts\n");
+        goto done;
+    }
+
+    ret = sysdb_cache_auth_store_result(state->domain, state->name,
+                                        state->authentication_successful,
+                                        state->failed_login_attempts);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_transaction_commit(state->domain->sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to commit transaction!\n");
+        goto done;
+    }
+    in_transaction = false;
+
+done:
+    if (in_transaction) {
+        sret = sysdb_transaction_cancel(state->domain->sysdb);
+        if (sret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Could not cancel transaction\n");
+        }
+    }
+    talloc_free(tmp_ctx);
+
+    if (ret != EOK && state->authentication_successful) {
+        /* The password was verified, failing to record it is not fatal. */
+        DEBUG(SSSDBG_MINOR_FAILURE, "Failed to update the cached entry "
+              "[%d]: %s, but authentication is successful.\n",
+              ret, sss_strerror(ret));
+        ret = EOK;
+    }
+
+    return ret;
+}
+
+int sysdb_cache_auth_recv(struct tevent_req *req,
+                          time_t *_expire_date,
+                          time_t *_delayed_until)
+{
+    struct sysdb_cache_auth_state *state;
+    state = tevent_req_data(req, struct sysdb_cache_auth_state);
+
+    if (_expire_date != NULL) {
+        *_expire_date = state->expire_date;
+    }
+    if (_delayed_until != NULL) {
+        *_delayed_until = state->delayed_until;
+    }
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return state->authentication_successful ? EOK : ERR_AUTH_FAILED;
+}
+
 static errno_t sysdb_update_members_ex(struct sss_domain_info *domain,
                                        const char *member,
                                        enum sysdb_member_type type,
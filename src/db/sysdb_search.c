@@ -910,7 +910,6 @@ int sysdb_enumpwent_filter_with_views(TALLOC_CTX *mem_ctx,
 {
     TALLOC_CTX *tmp_ctx;
     struct ldb_result *res;
-    size_t c;
     int ret;
 
     tmp_ctx = talloc_new(NULL);
@@ -926,15 +925,12 @@ int sysdb_enumpwent_filter_with_views(TALLOC_CTX *mem_ctx,
     }
 
     if (DOM_HAS_VIEWS(domain)) {
-        for (c = 0; c < res->count; c++) {
-            ret = sysdb_add_overrides_to_object(domain, res->msgs[c], NULL,
-                                                NULL);
-            /* enumeration assumes that the cache is up-to-date, hence we do not
-             * need to handle ENOENT separately. */
-            if (ret != EOK) {
-                DEBUG(SSSDBG_OP_FAILURE, "sysdb_add_overrides_to_object failed.\n");
-                goto done;
-            }
+        ret = sysdb_add_overrides_to_objects(domain, res->msgs, res->count);
+        /* enumeration assumes that the cache is up-to-date, hence we do not
+         * need to handle ENOENT separately. */
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "sysdb_add_overrides_to_objects failed.\n");
+            goto done;
         }
     }
 
@@ -1534,18 +1530,17 @@ int sysdb_enumgrent_filter_with_views(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    for (c = 0; c < res->count; c++) {
-        if (DOM_HAS_VIEWS(domain)) {
-            ret = sysdb_add_overrides_to_object(domain, res->msgs[c], NULL,
-                                                NULL);
-            /* enumeration assumes that the cache is up-to-date, hence we do not
-             * need to handle ENOENT separately. */
-            if (ret != EOK) {
-                DEBUG(SSSDBG_OP_FAILURE, "sysdb_add_overrides_to_object failed.\n");
-                goto done;
-            }
+    if (DOM_HAS_VIEWS(domain)) {
+        ret = sysdb_add_overrides_to_objects(domain, res->msgs, res->count);
+        /* enumeration assumes that the cache is up-to-date, hence we do not
+         * need to handle ENOENT separately. */
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "sysdb_add_overrides_to_objects failed.\n");
+            goto done;
         }
+    }
 
+    for (c = 0; c < res->count; c++) {
         ret = sysdb_add_group_member_overrides(domain, res->msgs[c],
                                                DOM_HAS_VIEWS(domain));
         if (ret != EOK) {
@@ -1680,7 +1675,6 @@ int sysdb_initgroups_by_upn(TALLOC_CTX *mem_ctx,
     struct ldb_result *res;
     const char *sysdb_name;
     static const char *attrs[] = SYSDB_INITGR_ATTRS;
-    size_t i;
     errno_t ret;
 
     tmp_ctx = talloc_new(NULL);
@@ -1714,14 +1708,12 @@ int sysdb_initgroups_by_upn(TALLOC_CTX *mem_ctx,
 
         ret = sysdb_initgroups(tmp_ctx, domain, sysdb_name, &res);
         if (ret == EOK && DOM_HAS_VIEWS(domain)) {
-            for (i = 0; i < res->count; i++) {
-                ret = sysdb_add_overrides_to_object(domain, res->msgs[i],
-                                                    NULL, NULL);
-                if (ret != EOK) {
-                    DEBUG(SSSDBG_OP_FAILURE,
-                        "sysdb_add_overrides_to_object() failed.\n");
-                    return ret;
-                }
+            ret = sysdb_add_overrides_to_objects(domain, res->msgs,
+                                                 res->count);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_OP_FAILURE,
+                    "sysdb_add_overrides_to_objects() failed.\n");
+                return ret;
             }
         }
     }
@@ -1747,7 +1739,6 @@ int sysdb_initgroups_with_views(TALLOC_CTX *mem_ctx,
     struct ldb_asq_control *control;
     static const char *attrs[] = SYSDB_INITGR_ATTRS;
     int ret;
-    size_t c;
 
     tmp_ctx = talloc_new(NULL);
     if (!tmp_ctx) {
@@ -1828,16 +1819,14 @@ int sysdb_initgroups_with_views(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    if (DOM_HAS_VIEWS(domain)) {
+    if (DOM_HAS_VIEWS(domain) && res->count > 1) {
         /* Skip user entry because it already has override values added */
-        for (c = 1; c < res->count; c++) {
-            ret = sysdb_add_overrides_to_object(domain, res->msgs[c], NULL,
-                                                NULL);
-            if (ret != EOK) {
-                DEBUG(SSSDBG_OP_FAILURE,
-                      "sysdb_add_overrides_to_object failed.\n");
-                goto done;
-            }
+        ret = sysdb_add_overrides_to_objects(domain, res->msgs + 1,
+                                             res->count - 1);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "sysdb_add_overrides_to_objects failed.\n");
+            goto done;
         }
     }
 
@@ -540,6 +540,7 @@ errno_t sysdb_update_subdomains(struct sss_domain_info *domain,
     }
 
     link_forest_roots(domain);
+    sss_domain_index_update(domain);
 
     ret = EOK;
 
@@ -558,6 +559,7 @@ errno_t sysdb_master_domain_update(struct sss_domain_info *domain)
     struct ldb_result *res;
     enum sss_domain_state state;
     bool enabled;
+    bool index_changed = false;
     const char *attrs[] = {"cn",
                            SYSDB_SUBDOMAIN_REALM,
                            SYSDB_SUBDOMAIN_FLAT,
@@ -620,6 +622,7 @@ errno_t sysdb_master_domain_update(struct sss_domain_info *domain)
             ret = ENOMEM;
             goto done;
         }
+        index_changed = true;
     }
 
     tmp_str = ldb_msg_find_attr_as_string(res->msgs[0], SYSDB_SUBDOMAIN_ID,
@@ -633,6 +636,11 @@ errno_t sysdb_master_domain_update(struct sss_domain_info *domain)
             ret = ENOMEM;
             goto done;
         }
+        index_changed = true;
+    }
+
+    if (index_changed) {
+        sss_domain_index_update(domain);
     }
 
     tmp_str = ldb_msg_find_attr_as_string(res->msgs[0], SYSDB_SUBDOMAIN_FOREST,
@@ -26,6 +26,7 @@
 #include "db/sysdb.h"
 #include "db/sysdb_private.h"
 #include "db/sysdb_sudo.h"
+#include "shared/murmurhash3.h"
 
 #define SUDO_ALL_FILTER "(" SYSDB_OBJECTCLASS "=" SYSDB_SUDO_CACHE_OC ")"
 
@@ -1067,6 +1068,306 @@ done:
     return ret;
 }
 
+/* Hash of the rule content as it was downloaded from the server. It does
+ * not depend on the order of attributes and values, which is not
+ * guaranteed by the server. */
+static char *
+sysdb_sudo_rule_hash(TALLOC_CTX *mem_ctx, struct sysdb_attrs *rule)
+{
+    struct ldb_message_element *el;
+    uint32_t name_hash[2];
+    uint32_t hi;
+    uint32_t lo;
+    uint64_t sum = 0;
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < rule->num; i++) {
+        el = &rule->a[i];
+        name_hash[0] = murmurhash3(el->name, strlen(el->name), 0x5344554f);
+        name_hash[1] = murmurhash3(el->name, strlen(el->name), 0x52554c45);
+
+        for (j = 0; j < el->num_values; j++) {
+            hi = murmurhash3((const char *) el->values[j].data,
+                             el->values[j].length, name_hash[0]);
+            lo = murmurhash3((const char *) el->values[j].data,
+                             el->values[j].length, name_hash[1]);
+            sum += ((uint64_t) hi << 32) | lo;
+        }
+    }
+
+    return talloc_asprintf(mem_ctx, "%016"PRIx64, sum);
+}
+
+static errno_t
+sysdb_sudo_get_cached_hashes(TALLOC_CTX *mem_ctx,
+                             struct sss_domain_info *domain,
+                             const char *filter,
+                             hash_table_t **_table)
+{
+    TALLOC_CTX *tmp_ctx;
+    hash_table_t *table;
+    hash_key_t key;
+    hash_value_t value;
+    struct ldb_message **msgs;
+    const char *name;
+    const char *hash;
+    size_t count;
+    size_t i;
+    errno_t ret;
+    int hret;
+    const char *attrs[] = { SYSDB_NAME,
+                            SYSDB_SUDO_CACHE_AT_HASH,
+                            NULL };
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_search_custom(tmp_ctx, domain, filter,
+                              SUDORULE_SUBDIR, attrs,
+                              &count, &msgs);
+    if (ret == ENOENT) {
+        count = 0;
+        msgs = NULL;
+    } else if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Error looking up SUDO rules\n");
+        goto done;
+    }
+
+    ret = sss_hash_create(tmp_ctx, count, &table);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    key.type = HASH_KEY_STRING;
+    value.type = HASH_VALUE_PTR;
+    for (i = 0; i < count; i++) {
+        name = ldb_msg_find_attr_as_string(msgs[i], SYSDB_NAME, NULL);
+        if (name == NULL) {
+            continue;
+        }
+
+        /* rules cached by older versions do not have any hash */
+        hash = ldb_msg_find_attr_as_string(msgs[i], SYSDB_SUDO_CACHE_AT_HASH,
+                                           "");
+
+        key.str = discard_const(name);
+        value.ptr = talloc_strdup(table, hash);
+        if (value.ptr == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        hret = hash_enter(table, &key, &value);
+        if (hret != HASH_SUCCESS) {
+            ret = EIO;
+            goto done;
+        }
+    }
+
+    *_table = talloc_steal(mem_ctx, table);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t
+sysdb_sudo_touch_rule(struct sss_domain_info *domain,
+                      const char *name,
+                      int cache_timeout,
+                      time_t now)
+{
+    struct sysdb_attrs *attrs;
+    time_t expire;
+    errno_t ret;
+
+    attrs = sysdb_new_attrs(NULL);
+    if (attrs == NULL) {
+        return ENOMEM;
+    }
+
+    expire = cache_timeout > 0 ? now + cache_timeout : 0;
+    ret = sysdb_attrs_add_time_t(attrs, SYSDB_CACHE_EXPIRE, expire);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_set_sudo_rule_attr(domain, name, attrs, SYSDB_MOD_REP);
+
+done:
+    talloc_free(attrs);
+    return ret;
+}
+
+errno_t
+sysdb_sudo_sync(struct sss_domain_info *domain,
+                const char *filter,
+                struct sysdb_attrs **rules,
+                size_t num_rules,
+                struct sysdb_sudo_sync_stats *_stats)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sysdb_sudo_sync_stats stats = { 0 };
+    hash_table_t *cached = NULL;
+    hash_key_t key;
+    hash_value_t value;
+    hash_key_t *keys;
+    unsigned long num_keys;
+    const char *name;
+    char *hash;
+    bool in_transaction = false;
+    bool found;
+    errno_t sret;
+    errno_t ret;
+    time_t now;
+    size_t i;
+    int hret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_transaction_start(domain->sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
+        goto done;
+    }
+    in_transaction = true;
+
+    ret = sysdb_sudo_get_cached_hashes(tmp_ctx, domain, filter, &cached);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    now = time(NULL);
+    key.type = HASH_KEY_STRING;
+    for (i = 0; i < num_rules; i++) {
+        name = sysdb_sudo_get_rule_name(rules[i]);
+        if (name == NULL) {
+            /* Loud debug message is in logs. */
+            continue;
+        }
+
+        hash = sysdb_sudo_rule_hash(tmp_ctx, rules[i]);
+        if (hash == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        key.str = discard_const(name);
+        hret = hash_lookup(cached, &key, &value);
+        found = (hret == HASH_SUCCESS);
+        if (found) {
+            hash_delete(cached, &key);
+
+            if (strcmp(value.ptr, hash) == 0) {
+                DEBUG(SSSDBG_TRACE_INTERNAL, "Sudo rule %s did not change\n",
+                      name);
+                ret = sysdb_sudo_touch_rule(domain, name,
+                                            domain->sudo_timeout, now);
+                if (ret != EOK) {
+                    DEBUG(SSSDBG_OP_FAILURE, "Unable to update rule %s "
+                          "[%d]: %s\n", name, ret, sss_strerror(ret));
+                    goto done;
+                }
+                stats.unchanged++;
+                continue;
+            }
+        }
+
+        ret = sysdb_attrs_add_string(rules[i], SYSDB_SUDO_CACHE_AT_HASH, hash);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        if (found) {
+            /* Storing only adds or replaces attributes. Remove the previous
+             * version so that attributes removed on the server, e.g. an
+             * sudoOption, do not stay in the cache. */
+            ret = sysdb_sudo_purge_byname(domain, name);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_OP_FAILURE, "Unable to remove previous version "
+                      "of rule %s [%d]: %s\n", name, ret, sss_strerror(ret));
+                goto done;
+            }
+        }
+
+        ret = sysdb_sudo_store_rule(domain, rules[i],
+                                    domain->sudo_timeout, now);
+        if (ret == EINVAL || ret == ERR_MALFORMED_ENTRY) {
+            /* The rule is skipped, see sysdb_sudo_store(). Its previous
+             * version was already removed above. */
+            if (found) {
+                stats.deleted++;
+            }
+            continue;
+        } else if (ret != EOK) {
+            goto done;
+        }
+
+        if (found) {
+            stats.modified++;
+        } else {
+            stats.added++;
+        }
+    }
+
+    /* Rules left in the table were removed from the server */
+    hret = hash_keys(cached, &num_keys, &keys);
+    if (hret != HASH_SUCCESS) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    talloc_steal(tmp_ctx, keys);
+
+    for (i = 0; i < num_keys; i++) {
+        ret = sysdb_sudo_purge_byname(domain, keys[i].str);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Failed to delete rule "
+                  "%s [%d]: %s\n", keys[i].str, ret, sss_strerror(ret));
+            continue;
+        }
+        stats.deleted++;
+    }
+
+    ret = sysdb_transaction_commit(domain->sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
+        goto done;
+    }
+    in_transaction = false;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Sudo rules synchronized: %zu added, "
+          "%zu modified, %zu deleted, %zu unchanged\n", stats.added,
+          stats.modified, stats.deleted, stats.unchanged);
+
+    if (_stats != NULL) {
+        *_stats = stats;
+    }
+
+done:
+    if (in_transaction) {
+        sret = sysdb_transaction_cancel(domain->sysdb);
+        if (sret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Could not cancel transaction\n");
+        }
+    }
+
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to synchronize sudo rules [%d]: %s\n",
+              ret, sss_strerror(ret));
+    }
+
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 errno_t sysdb_search_sudo_rules(TALLOC_CTX *mem_ctx,
                                 struct sss_domain_info *domain,
                                 const char *sub_filter,
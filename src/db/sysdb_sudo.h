@@ -46,6 +46,9 @@
 #define SYSDB_SUDO_CACHE_AT_NOTAFTER   "sudoNotAfter"
 #define SYSDB_SUDO_CACHE_AT_ORDER      "sudoOrder"
 
+/* hash of the downloaded rule, see sysdb_sudo_sync() */
+#define SYSDB_SUDO_CACHE_AT_HASH       "sudoContentHash"
+
 /* sysdb ipa attributes */
 #define SYSDB_IPA_SUDORULE_OC                 "ipasudorule"
 #define SYSDB_IPA_SUDORULE_ENABLED            "ipaEnabledFlag"
@@ -140,6 +143,24 @@ sysdb_sudo_store(struct sss_domain_info *domain,
                  struct sysdb_attrs **rules,
                  size_t num_rules);
 
+struct sysdb_sudo_sync_stats {
+    size_t added;
+    size_t modified;
+    size_t deleted;
+    size_t unchanged;
+};
+
+/* Make the cached rules that match filter equal to rules. Unlike
+ * sysdb_sudo_purge() followed by sysdb_sudo_store(), only the rules that
+ * were added, modified or deleted on the server are written, the others
+ * just get a new expiration time. _stats may be NULL. */
+errno_t
+sysdb_sudo_sync(struct sss_domain_info *domain,
+                const char *filter,
+                struct sysdb_attrs **rules,
+                size_t num_rules,
+                struct sysdb_sudo_sync_stats *_stats);
+
 errno_t
 sysdb_search_sudo_rules(TALLOC_CTX *mem_ctx,
                         struct sss_domain_info *domain,
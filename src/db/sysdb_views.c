@@ -1515,6 +1515,269 @@ done:
     return ret;
 }
 
+/* With at least this many objects that have an override object, the
+ * overrides of the view are read with a single search instead of one base
+ * search per object. */
+#define SYSDB_OVERRIDES_BULK_MIN 32
+
+/* The single search reads every override of the view. It is cheaper than
+ * the base searches only as long as the view does not have many more
+ * overrides than there are objects with an override. If it does, the search
+ * is stopped after this many overrides per object override and the base
+ * searches are used instead. */
+#define SYSDB_OVERRIDES_BULK_RATIO 4
+
+struct sysdb_override_objects_state {
+    hash_table_t *objects;
+    size_t count;
+    size_t limit;
+};
+
+static int sysdb_override_objects_callback(struct ldb_request *req,
+                                           struct ldb_reply *ares)
+{
+    struct sysdb_override_objects_state *state;
+    hash_key_t key;
+    hash_value_t value;
+    int hret;
+    int ret;
+
+    state = talloc_get_type(req->context, struct sysdb_override_objects_state);
+
+    if (ares == NULL) {
+        return ldb_request_done(req, LDB_ERR_OPERATIONS_ERROR);
+    }
+
+    if (ares->error != LDB_SUCCESS) {
+        ret = ares->error;
+        talloc_free(ares);
+        return ldb_request_done(req, ret);
+    }
+
+    switch (ares->type) {
+    case LDB_REPLY_ENTRY:
+        if (++state->count > state->limit) {
+            talloc_free(ares);
+            return ldb_request_done(req, LDB_ERR_SIZE_LIMIT_EXCEEDED);
+        }
+
+        key.type = HASH_KEY_STRING;
+        key.str = discard_const(ldb_dn_get_casefold(ares->message->dn));
+        if (key.str == NULL) {
+            talloc_free(ares);
+            return ldb_request_done(req, LDB_ERR_OPERATIONS_ERROR);
+        }
+
+        value.type = HASH_VALUE_PTR;
+        value.ptr = talloc_steal(state->objects, ares->message);
+
+        hret = hash_enter(state->objects, &key, &value);
+        talloc_free(ares);
+        if (hret != HASH_SUCCESS) {
+            DEBUG(SSSDBG_OP_FAILURE, "hash_enter failed [%d]: %s\n",
+                  hret, hash_error_string(hret));
+            return ldb_request_done(req, LDB_ERR_OPERATIONS_ERROR);
+        }
+        break;
+    case LDB_REPLY_REFERRAL:
+        talloc_free(ares);
+        break;
+    case LDB_REPLY_DONE:
+        talloc_free(ares);
+        return ldb_request_done(req, LDB_SUCCESS);
+    }
+
+    return LDB_SUCCESS;
+}
+
+/* Map the DNs of all override objects of the view matching filter to the
+ * override objects. Returns E2BIG if the view has more than limit of
+ * them. */
+static errno_t sysdb_get_override_objects(TALLOC_CTX *mem_ctx,
+                                          struct sss_domain_info *domain,
+                                          const char *filter,
+                                          const char **attrs,
+                                          size_t limit,
+                                          hash_table_t **_objects)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_dn *base_dn;
+    struct ldb_request *req;
+    struct sysdb_override_objects_state *state;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    state = talloc_zero(tmp_ctx, struct sysdb_override_objects_state);
+    if (state == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    state->limit = limit;
+
+    ret = sss_hash_create(tmp_ctx, limit, &state->objects);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    base_dn = ldb_dn_new_fmt(tmp_ctx, domain->sysdb->ldb,
+                             SYSDB_TMPL_VIEW_SEARCH_BASE, domain->view_name);
+    if (base_dn == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "ldb_dn_new_fmt failed.\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = ldb_build_search_req(&req, domain->sysdb->ldb, tmp_ctx,
+                               base_dn, LDB_SCOPE_ONELEVEL, filter,
+                               attrs, NULL, state,
+                               sysdb_override_objects_callback, NULL);
+    if (ret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+
+    ret = ldb_request(domain->sysdb->ldb, req);
+    if (ret == LDB_SUCCESS) {
+        ret = ldb_wait(req->handle, LDB_WAIT_ALL);
+    }
+    if (ret == LDB_ERR_SIZE_LIMIT_EXCEEDED) {
+        DEBUG(SSSDBG_TRACE_ALL, "View [%s] has more than %zu overrides "
+              "matching [%s].\n", domain->view_name, limit, filter);
+        ret = E2BIG;
+        goto done;
+    } else if (ret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_ALL, "Read %zu overrides of view [%s].\n",
+          state->count, domain->view_name);
+
+    *_objects = talloc_steal(mem_ctx, state->objects);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Returns ENOENT if objects does not contain override_dn */
+static errno_t sysdb_lookup_override_object(hash_table_t *objects,
+                                            struct ldb_dn *override_dn,
+                                            struct ldb_message **_override)
+{
+    hash_key_t key;
+    hash_value_t value;
+    int hret;
+
+    key.type = HASH_KEY_STRING;
+    key.str = discard_const(ldb_dn_get_casefold(override_dn));
+    if (key.str == NULL) {
+        return ENOMEM;
+    }
+
+    hret = hash_lookup(objects, &key, &value);
+    if (hret == HASH_ERROR_KEY_NOT_FOUND) {
+        return ENOENT;
+    } else if (hret != HASH_SUCCESS) {
+        return EIO;
+    }
+
+    *_override = value.ptr;
+    return EOK;
+}
+
+errno_t sysdb_add_overrides_to_objects(struct sss_domain_info *domain,
+                                       struct ldb_message **objs,
+                                       size_t count)
+{
+    /* The attributes copied by sysdb_add_overrides_to_object() */
+    static const char *attrs[] = { SYSDB_UIDNUM, SYSDB_GIDNUM, SYSDB_GECOS,
+                                   SYSDB_HOMEDIR, SYSDB_SHELL, SYSDB_NAME,
+                                   SYSDB_SSH_PUBKEY, SYSDB_USER_CERT,
+                                   NULL };
+    TALLOC_CTX *tmp_ctx;
+    hash_table_t *overrides = NULL;
+    struct ldb_message *override;
+    struct ldb_dn *override_dn;
+    const char *override_dn_str;
+    size_t num_overrides = 0;
+    size_t c;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "talloc_new failed.\n");
+        return ENOMEM;
+    }
+
+    for (c = 0; c < count; c++) {
+        override_dn_str = ldb_msg_find_attr_as_string(objs[c],
+                                                      SYSDB_OVERRIDE_DN, NULL);
+        if (override_dn_str != NULL
+                && strcasecmp(override_dn_str,
+                              ldb_dn_get_linearized(objs[c]->dn)) != 0) {
+            num_overrides++;
+        }
+    }
+
+    if (num_overrides >= SYSDB_OVERRIDES_BULK_MIN) {
+        ret = sysdb_get_override_objects(tmp_ctx, domain,
+                                "(|(objectClass="SYSDB_OVERRIDE_USER_CLASS")"
+                                  "(objectClass="SYSDB_OVERRIDE_GROUP_CLASS"))",
+                                attrs,
+                                num_overrides * SYSDB_OVERRIDES_BULK_RATIO,
+                                &overrides);
+        if (ret == E2BIG) {
+            /* There are only a few objects compared to the view. */
+            overrides = NULL;
+        } else if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "sysdb_get_override_objects failed.\n");
+            goto done;
+        }
+    }
+
+    for (c = 0; c < count; c++) {
+        override = NULL;
+
+        override_dn_str = ldb_msg_find_attr_as_string(objs[c],
+                                                      SYSDB_OVERRIDE_DN, NULL);
+        if (overrides != NULL && override_dn_str != NULL) {
+            override_dn = ldb_dn_new(tmp_ctx, domain->sysdb->ldb,
+                                     override_dn_str);
+            if (override_dn == NULL) {
+                DEBUG(SSSDBG_OP_FAILURE, "ldb_dn_new failed.\n");
+                ret = ENOMEM;
+                goto done;
+            }
+
+            ret = sysdb_lookup_override_object(overrides, override_dn,
+                                               &override);
+            if (ret == ENOENT) {
+                /* Checked and searched for by sysdb_add_overrides_to_object */
+                override = NULL;
+            } else if (ret != EOK) {
+                goto done;
+            }
+        }
+
+        ret = sysdb_add_overrides_to_object(domain, objs[c], override, NULL);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 errno_t sysdb_add_group_member_overrides(struct sss_domain_info *domain,
                                          struct ldb_message *obj,
                                          bool expect_override_dn)
@@ -1532,6 +1795,10 @@ errno_t sysdb_add_group_member_overrides(struct sss_domain_info *domain,
     char *orig_domain;
     char *val;
     struct sss_domain_info *orig_dom;
+    static const char *name_attrs[] = { SYSDB_NAME, NULL };
+    hash_table_t *overrides = NULL;
+    struct ldb_message *override;
+    size_t num_overrides = 0;
 
     tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
@@ -1551,6 +1818,34 @@ errno_t sysdb_add_group_member_overrides(struct sss_domain_info *domain,
         goto done;
     }
 
+    if (expect_override_dn) {
+        for (c = 0; c < res_members->count; c++) {
+            override_dn_str = ldb_msg_find_attr_as_string(res_members->msgs[c],
+                                                          SYSDB_OVERRIDE_DN,
+                                                          NULL);
+            if (override_dn_str != NULL
+                    && strcasecmp(override_dn_str,
+                        ldb_dn_get_linearized(res_members->msgs[c]->dn)) != 0) {
+                num_overrides++;
+            }
+        }
+    }
+
+    if (num_overrides >= SYSDB_OVERRIDES_BULK_MIN) {
+        ret = sysdb_get_override_objects(tmp_ctx, domain,
+                                "(objectClass="SYSDB_OVERRIDE_USER_CLASS")",
+                                name_attrs,
+                                num_overrides * SYSDB_OVERRIDES_BULK_RATIO,
+                                &overrides);
+        if (ret == E2BIG) {
+            /* The group is small compared to the view. */
+            overrides = NULL;
+        } else if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "sysdb_get_override_objects failed.\n");
+            goto done;
+        }
+    }
+
     for (c = 0; c < res_members->count; c++) {
 
         if (ldb_msg_find_attr_as_uint64(res_members->msgs[c],
@@ -1609,23 +1904,36 @@ errno_t sysdb_add_group_member_overrides(struct sss_domain_info *domain,
             DEBUG(SSSDBG_TRACE_ALL, "Checking override for object [%s].\n",
                   ldb_dn_get_linearized(res_members->msgs[c]->dn));
 
-            ret = ldb_search(domain->sysdb->ldb, res_members, &override_obj,
-                             override_dn, LDB_SCOPE_BASE, member_attrs, NULL);
-            if (ret != LDB_SUCCESS) {
-                ret = sysdb_error_to_errno(ret);
-                goto done;
+            ret = ENOENT;
+            if (overrides != NULL) {
+                ret = sysdb_lookup_override_object(overrides, override_dn,
+                                                   &override);
+                if (ret != EOK && ret != ENOENT) {
+                    goto done;
+                }
             }
 
-            if (override_obj->count != 1) {
-                DEBUG(SSSDBG_CRIT_FAILURE,
-                     "Base search for override object returned [%d] results.\n",
-                    override_obj->count);
-                ret = EINVAL;
-                goto done;
+            if (ret == ENOENT) {
+                ret = ldb_search(domain->sysdb->ldb, res_members, &override_obj,
+                                 override_dn, LDB_SCOPE_BASE, member_attrs,
+                                 NULL);
+                if (ret != LDB_SUCCESS) {
+                    ret = sysdb_error_to_errno(ret);
+                    goto done;
+                }
+
+                if (override_obj->count != 1) {
+                    DEBUG(SSSDBG_CRIT_FAILURE,
+                         "Base search for override object returned [%d] "
+                         "results.\n", override_obj->count);
+                    ret = EINVAL;
+                    goto done;
+                }
+
+                override = override_obj->msgs[0];
             }
 
-            memberuid = ldb_msg_find_attr_as_string(override_obj->msgs[0],
-                                                    SYSDB_NAME,
+            memberuid = ldb_msg_find_attr_as_string(override, SYSDB_NAME,
                                                     memberuid);
         }
 
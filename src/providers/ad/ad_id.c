@@ -102,6 +102,19 @@ done:
     return shortcut;
 }
 
+/* A lookup on one of the connections when they are queried concurrently */
+struct ad_handle_acct_info_lookup {
+    struct tevent_req *req;
+    struct tevent_req *subreq;
+    struct sdap_id_conn_ctx *conn;
+    struct timeval start;
+
+    errno_t ret;
+    int dp_error;
+    const char *err;
+    int sdap_err;
+};
+
 struct ad_handle_acct_info_state {
     struct dp_id_data *ar;
     struct sdap_id_ctx *ctx;
@@ -110,6 +123,11 @@ struct ad_handle_acct_info_state {
     size_t cindex;
     struct ad_options *ad_options;
     bool using_pac;
+    struct timeval start;
+
+    struct ad_handle_acct_info_lookup *lookups;
+    size_t num_lookups;
+    size_t pending;
 
     int dp_error;
     const char *err;
@@ -117,6 +135,38 @@ struct ad_handle_acct_info_state {
 
 static errno_t ad_handle_acct_info_step(struct tevent_req *req);
 static void ad_handle_acct_info_done(struct tevent_req *subreq);
+static bool ad_handle_acct_info_concurrent(struct ad_handle_acct_info_state *state);
+static errno_t ad_handle_acct_info_start_all(struct tevent_req *req);
+static void ad_handle_acct_info_lookup_done(struct tevent_req *subreq);
+static errno_t ad_handle_acct_info_delete_missing(struct ad_handle_acct_info_state *state);
+static void ad_handle_acct_info_fail(struct tevent_req *req, errno_t ret);
+
+static void ad_conn_stats_update(struct sdap_id_conn_ctx *conn,
+                                 struct timeval start,
+                                 bool found)
+{
+    struct timeval now = tevent_timeval_current();
+    struct sdap_id_conn_stats *stats = &conn->stats;
+    uint64_t usec;
+
+    usec = (now.tv_sec - start.tv_sec) * 1000000 + now.tv_usec - start.tv_usec;
+
+    stats->lookups++;
+    if (found) {
+        stats->found++;
+    }
+    stats->total_usec += usec;
+    if (usec > stats->max_usec) {
+        stats->max_usec = usec;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Lookup on [%s] took %"PRIu64" ms; "
+          "%"PRIu64" lookups, %"PRIu64" found, %"PRIu64" ms on average, "
+          "%"PRIu64" ms maximum\n",
+          conn->service != NULL ? conn->service->name : "unknown",
+          usec / 1000, stats->lookups, stats->found,
+          stats->total_usec / stats->lookups / 1000, stats->max_usec / 1000);
+}
 
 struct tevent_req *
 ad_handle_acct_info_send(TALLOC_CTX *mem_ctx,
@@ -160,7 +210,11 @@ ad_handle_acct_info_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = ad_handle_acct_info_step(req);
+    if (ad_handle_acct_info_concurrent(state)) {
+        ret = ad_handle_acct_info_start_all(req);
+    } else {
+        ret = ad_handle_acct_info_step(req);
+    }
     if (ret != EAGAIN) {
         goto immediate;
     }
@@ -232,6 +286,7 @@ ad_handle_acct_info_step(struct tevent_req *req)
         }
     }
 
+    state->start = tevent_timeval_current();
     tevent_req_set_callback(subreq, ad_handle_acct_info_done, req);
     return EAGAIN;
 }
@@ -252,6 +307,8 @@ ad_handle_acct_info_done(struct tevent_req *subreq)
         ret = ad_handle_pac_initgr_recv(subreq, &dp_error, &err, &sdap_err);
     } else {
         ret = sdap_handle_acct_req_recv(subreq, &dp_error, &err, &sdap_err);
+        ad_conn_stats_update(state->conn[state->cindex], state->start,
+                             ret == EOK && sdap_err == EOK);
     }
     if (dp_error == DP_ERR_OFFLINE
         && state->conn[state->cindex+1] != NULL
@@ -302,6 +359,14 @@ ad_handle_acct_info_done(struct tevent_req *subreq)
     return;
 
 fail:
+    ad_handle_acct_info_fail(req, ret);
+}
+
+static void ad_handle_acct_info_fail(struct tevent_req *req, errno_t ret)
+{
+    struct ad_handle_acct_info_state *state = tevent_req_data(req,
+                                            struct ad_handle_acct_info_state);
+
     if (IS_SUBDOMAIN(state->sdom->dom)) {
         /* Deactivate subdomain on lookup errors instead of going
          * offline completely.
@@ -313,7 +378,202 @@ fail:
         ret = ERR_SUBDOM_INACTIVE;
     }
     tevent_req_error(req, ret);
-    return;
+}
+
+/* Group memberships are always looked up one connection after another, the
+ * lookups save them to the cache and may use the PAC. Only objects which
+ * ad_handle_acct_info_delete_missing() can remove are looked up
+ * concurrently. */
+static bool ad_handle_acct_info_concurrent(struct ad_handle_acct_info_state *state)
+{
+    if (!dp_opt_get_bool(state->ad_options->basic, AD_CONCURRENT_GC_LOOKUP)) {
+        return false;
+    }
+
+    if (state->conn[0] == NULL || state->conn[1] == NULL) {
+        return false;
+    }
+
+    switch (state->ar->entry_type & BE_REQ_TYPE_MASK) {
+    case BE_REQ_USER:
+    case BE_REQ_GROUP:
+    case BE_REQ_BY_SECID:
+    case BE_REQ_BY_UUID:
+    case BE_REQ_USER_AND_GROUP:
+    case BE_REQ_BY_CERT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static errno_t ad_handle_acct_info_start_all(struct tevent_req *req)
+{
+    struct ad_handle_acct_info_state *state = tevent_req_data(req,
+                                            struct ad_handle_acct_info_state);
+    struct ad_handle_acct_info_lookup *lookup;
+    size_t i;
+
+    for (state->num_lookups = 0;
+         state->conn[state->num_lookups] != NULL;
+         state->num_lookups++);
+
+    state->lookups = talloc_zero_array(state,
+                                       struct ad_handle_acct_info_lookup,
+                                       state->num_lookups);
+    if (state->lookups == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < state->num_lookups; i++) {
+        lookup = &state->lookups[i];
+        lookup->req = req;
+        lookup->conn = state->conn[i];
+        lookup->start = tevent_timeval_current();
+
+        /* No lookup may remove the object from the cache, another one may
+         * still find it. It is removed only when none of them did. */
+        lookup->subreq = sdap_handle_acct_req_send(state, state->ctx->be,
+                                                   state->ar, state->ctx,
+                                                   state->sdom, lookup->conn,
+                                                   false);
+        if (lookup->subreq == NULL) {
+            return ENOMEM;
+        }
+
+        tevent_req_set_callback(lookup->subreq,
+                                ad_handle_acct_info_lookup_done, lookup);
+        state->pending++;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Looking up the object on %zu connections at "
+          "the same time\n", state->num_lookups);
+
+    return EAGAIN;
+}
+
+static void ad_handle_acct_info_lookup_done(struct tevent_req *subreq)
+{
+    struct ad_handle_acct_info_lookup *lookup;
+    struct ad_handle_acct_info_state *state;
+    struct tevent_req *req;
+    bool is_last;
+    errno_t ret;
+    size_t i;
+
+    lookup = tevent_req_callback_data(subreq, struct ad_handle_acct_info_lookup);
+    req = lookup->req;
+    state = tevent_req_data(req, struct ad_handle_acct_info_state);
+    is_last = (lookup == &state->lookups[state->num_lookups - 1]);
+
+    lookup->ret = sdap_handle_acct_req_recv(subreq, &lookup->dp_error,
+                                            &lookup->err, &lookup->sdap_err);
+    talloc_zfree(subreq);
+    lookup->subreq = NULL;
+    state->pending--;
+
+    ad_conn_stats_update(lookup->conn, lookup->start,
+                         lookup->ret == EOK && lookup->sdap_err == EOK);
+
+    if (lookup->dp_error == DP_ERR_OFFLINE && !is_last
+            && lookup->conn->ignore_mark_offline) {
+        /* GC does not work, rely on the other connections */
+        lookup->ret = EOK;
+        lookup->sdap_err = ENOENT;
+    }
+
+    if (lookup->ret == EOK && lookup->sdap_err == EOK) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Object found on [%s], cancelling %zu "
+              "other lookups\n",
+              lookup->conn->service != NULL ? lookup->conn->service->name
+                                            : "unknown",
+              state->pending);
+
+        for (i = 0; i < state->num_lookups; i++) {
+            talloc_zfree(state->lookups[i].subreq);
+        }
+        state->pending = 0;
+
+        state->dp_error = lookup->dp_error;
+        state->err = lookup->err;
+        tevent_req_done(req);
+        return;
+    }
+
+    if (state->pending > 0) {
+        return;
+    }
+
+    /* The object was not found, report the first failure in the order
+     * of the connections as sequential lookups would. */
+    for (i = 0; i < state->num_lookups; i++) {
+        lookup = &state->lookups[i];
+        state->dp_error = lookup->dp_error;
+        state->err = lookup->err;
+
+        if (lookup->ret != EOK) {
+            ad_handle_acct_info_fail(req, lookup->ret);
+            return;
+        } else if (lookup->sdap_err != ENOENT) {
+            ad_handle_acct_info_fail(req, EIO);
+            return;
+        }
+    }
+
+    /* All lookups completed and none of them found the object. */
+    ret = ad_handle_acct_info_delete_missing(state);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to remove missing object from "
+              "cache [%d]: %s\n", ret, sss_strerror(ret));
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+/* Removes the object that was not found by any connection from the cache
+ * the same way sdap_handle_acct_req_send() would with noexist_delete. */
+static errno_t ad_handle_acct_info_delete_missing(struct ad_handle_acct_info_state *state)
+{
+    struct dp_id_data *ar = state->ar;
+    struct sss_domain_info *dom = state->sdom->dom;
+    bool name_is_upn;
+    errno_t ret;
+
+    switch (ar->entry_type & BE_REQ_TYPE_MASK) {
+    case BE_REQ_USER:
+    case BE_REQ_BY_CERT:
+        name_is_upn = ar->extra_value != NULL
+                        && strcmp(ar->extra_value, EXTRA_NAME_IS_UPN) == 0;
+        return users_get_handle_no_user(state, dom, ar->filter_type,
+                                        ar->filter_value, name_is_upn);
+    case BE_REQ_GROUP:
+        return groups_get_handle_no_group(state, dom, ar->filter_type,
+                                          ar->filter_value);
+    case BE_REQ_BY_SECID:
+    case BE_REQ_BY_UUID:
+    case BE_REQ_USER_AND_GROUP:
+        ret = groups_get_handle_no_group(state, dom, ar->filter_type,
+                                         ar->filter_value);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        ret = users_get_handle_no_user(state, dom, ar->filter_type,
+                                       ar->filter_value, false);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        if (ar->filter_type == BE_FILTER_SECID) {
+            return sysdb_delete_by_sid(dom->sysdb, dom, ar->filter_value);
+        }
+
+        return EOK;
+    default:
+        return EOK;
+    }
 }
 
 errno_t
@@ -147,8 +147,16 @@ struct be_refresh_cb_ctx {
 
 struct be_refresh_ctx {
     struct be_refresh_cb_ctx callbacks[BE_REFRESH_TYPE_SENTINEL];
+    bool prewarmed;
 };
 
+static struct tevent_req *be_prewarm_send(TALLOC_CTX *mem_ctx,
+                                          struct tevent_context *ev,
+                                          struct be_ctx *be_ctx,
+                                          struct be_ptask *be_ptask,
+                                          void *pvt);
+static errno_t be_prewarm_recv(struct tevent_req *req);
+
 static errno_t be_refresh_ctx_init(struct be_ctx *be_ctx,
                                    const char *attr_name)
 {
@@ -188,6 +196,24 @@ static errno_t be_refresh_ctx_init(struct be_ctx *be_ctx,
         }
     }
 
+    if (be_ctx->domain->prewarm_cache_entries > 0) {
+        /* Run once, shortly after startup, or as soon as the back end
+         * goes online. */
+        ret = be_ptask_create(ctx, be_ctx, 0, 10, 5, 0, 0, 0,
+                              be_prewarm_send, be_prewarm_recv,
+                              ctx, "Pre-warm Cache",
+                              BE_PTASK_NO_PERIODIC |
+                              BE_PTASK_OFFLINE_DISABLE |
+                              BE_PTASK_SCHEDULE_FROM_NOW,
+                              NULL);
+        if (ret != EOK) {
+            /* not fatal, lookups will just be slower after startup */
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Unable to initialize pre-warm task [%d]: %s\n",
+                  ret, sss_strerror(ret));
+        }
+    }
+
     be_ctx->refresh_ctx = ctx;
     return EOK;
 }
@@ -572,3 +598,427 @@ struct dp_id_data *be_refresh_acct_req(TALLOC_CTX *mem_ctx,
     account_req->domain = domain->name;
     return account_req;
 }
+
+/* ==Pre-warm============================================================= */
+
+/* After a restart of the back end, refresh the entries that were used most
+ * recently, so that the first lookups after the restart do not have to wait
+ * for the server. The cache itself is the journal: lastLogin tells which
+ * users logged in recently and lastUpdate which entries were looked up. */
+
+/* Refresh requests that run at the same time */
+#define BE_PREWARM_CONCURRENCY 4
+/* Entries refreshed by one request */
+#define BE_PREWARM_BATCH_SIZE 50
+
+struct be_prewarm_entry {
+    uint64_t last_used;
+    const char *value;
+};
+
+static int be_prewarm_cmp_desc(const void *a, const void *b)
+{
+    const struct be_prewarm_entry *entry_a = a;
+    const struct be_prewarm_entry *entry_b = b;
+
+    if (entry_a->last_used > entry_b->last_used) {
+        return -1;
+    } else if (entry_a->last_used < entry_b->last_used) {
+        return 1;
+    }
+
+    return 0;
+}
+
+static errno_t be_prewarm_get_values(TALLOC_CTX *mem_ctx,
+                                     enum be_refresh_type type,
+                                     const char *attr_name,
+                                     struct sss_domain_info *domain,
+                                     uint32_t limit,
+                                     char ***_values,
+                                     size_t *_num_values)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_dn *base_dn;
+    struct ldb_result *res;
+    const char *attrs[3];
+    const char *key_attr;
+    const char *filter;
+    struct be_prewarm_entry *entries;
+    char **values;
+    size_t count;
+    size_t i;
+    int optflags;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    switch (type) {
+    case BE_REFRESH_TYPE_INITGROUPS:
+        /* lastLogin is not stored in the timestamp cache */
+        key_attr = SYSDB_LAST_LOGIN;
+        optflags = SYSDB_SEARCH_WITH_TS_ONLY_SYSDB_FILTER;
+        base_dn = sysdb_user_base_dn(tmp_ctx, domain);
+        break;
+    case BE_REFRESH_TYPE_USERS:
+        key_attr = SYSDB_LAST_UPDATE;
+        optflags = SYSDB_SEARCH_WITH_TS_ONLY_TS_FILTER;
+        base_dn = sysdb_user_base_dn(tmp_ctx, domain);
+        break;
+    case BE_REFRESH_TYPE_GROUPS:
+        key_attr = SYSDB_LAST_UPDATE;
+        optflags = SYSDB_SEARCH_WITH_TS_ONLY_TS_FILTER;
+        base_dn = sysdb_group_base_dn(tmp_ctx, domain);
+        break;
+    default:
+        ret = EINVAL;
+        goto done;
+    }
+
+    if (base_dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    filter = talloc_asprintf(tmp_ctx, "(%s=*)", key_attr);
+    if (filter == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    attrs[0] = attr_name;
+    attrs[1] = key_attr;
+    attrs[2] = NULL;
+
+    ret = sysdb_search_with_ts_attr(tmp_ctx, domain, base_dn,
+                                    LDB_SCOPE_SUBTREE, optflags,
+                                    filter, attrs, &res);
+    if (ret == ENOENT) {
+        *_values = NULL;
+        *_num_values = 0;
+        ret = EOK;
+        goto done;
+    } else if (ret != EOK) {
+        goto done;
+    }
+
+    entries = talloc_array(tmp_ctx, struct be_prewarm_entry, res->count);
+    if (entries == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    count = 0;
+    for (i = 0; i < res->count; i++) {
+        entries[count].value = ldb_msg_find_attr_as_string(res->msgs[i],
+                                                           attr_name, NULL);
+        if (entries[count].value == NULL) {
+            continue;
+        }
+        entries[count].last_used = ldb_msg_find_attr_as_uint64(res->msgs[i],
+                                                               key_attr, 0);
+        count++;
+    }
+
+    /* most recently used first */
+    qsort(entries, count, sizeof(struct be_prewarm_entry),
+          be_prewarm_cmp_desc);
+    count = MIN(count, limit);
+
+    values = talloc_zero_array(tmp_ctx, char *, count + 1);
+    if (values == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < count; i++) {
+        values[i] = talloc_strdup(values, entries[i].value);
+        if (values[i] == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    *_values = talloc_steal(mem_ctx, values);
+    *_num_values = count;
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+struct be_prewarm_batch {
+    struct tevent_req *req;
+    struct be_refresh_cb_ctx *cb_ctx;
+    struct sss_domain_info *domain;
+    char **names;
+    size_t num_names;
+};
+
+struct be_prewarm_state {
+    struct tevent_context *ev;
+    struct be_ctx *be_ctx;
+    struct be_refresh_ctx *ctx;
+
+    struct be_prewarm_batch *batches;
+    size_t num_batches;
+    size_t next_batch;
+    size_t active;
+
+    struct timeval start;
+    size_t total;
+    size_t refreshed;
+    size_t failed;
+};
+
+static errno_t be_prewarm_add_batches(struct be_prewarm_state *state,
+                                      struct be_refresh_cb_ctx *cb_ctx,
+                                      struct sss_domain_info *domain,
+                                      char **values,
+                                      size_t num_values)
+{
+    struct be_prewarm_batch *batch;
+    size_t num_batches;
+    size_t i;
+    size_t j;
+
+    num_batches = (num_values + BE_PREWARM_BATCH_SIZE - 1)
+                  / BE_PREWARM_BATCH_SIZE;
+    if (num_batches == 0) {
+        return EOK;
+    }
+
+    state->batches = talloc_realloc(state, state->batches,
+                                    struct be_prewarm_batch,
+                                    state->num_batches + num_batches);
+    if (state->batches == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < num_batches; i++) {
+        batch = &state->batches[state->num_batches + i];
+        batch->req = NULL;
+        batch->cb_ctx = cb_ctx;
+        batch->domain = domain;
+        batch->num_names = MIN(num_values - i * BE_PREWARM_BATCH_SIZE,
+                               BE_PREWARM_BATCH_SIZE);
+        batch->names = talloc_zero_array(state->batches, char *,
+                                         batch->num_names + 1);
+        if (batch->names == NULL) {
+            return ENOMEM;
+        }
+
+        for (j = 0; j < batch->num_names; j++) {
+            batch->names[j] = talloc_steal(batch->names,
+                                    values[i * BE_PREWARM_BATCH_SIZE + j]);
+        }
+    }
+
+    state->num_batches += num_batches;
+    state->total += num_values;
+
+    return EOK;
+}
+
+static errno_t be_prewarm_prepare(struct be_prewarm_state *state)
+{
+    static const enum be_refresh_type types[] = {
+        BE_REFRESH_TYPE_INITGROUPS,
+        BE_REFRESH_TYPE_USERS,
+        BE_REFRESH_TYPE_GROUPS,
+    };
+    struct be_refresh_cb_ctx *cb_ctx;
+    struct sss_domain_info *domain;
+    uint32_t limit;
+    char **values;
+    size_t num_values;
+    size_t i;
+    errno_t ret;
+
+    limit = state->be_ctx->domain->prewarm_cache_entries;
+
+    for (domain = state->be_ctx->domain;
+         domain != NULL;
+         domain = get_next_domain(domain, SSS_GND_DESCEND)) {
+        /* we can update just subdomains */
+        if (domain != state->be_ctx->domain && !IS_SUBDOMAIN(domain)) {
+            break;
+        }
+
+        for (i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+            cb_ctx = &state->ctx->callbacks[types[i]];
+            if (!cb_ctx->enabled) {
+                continue;
+            }
+
+            ret = be_prewarm_get_values(state, types[i], cb_ctx->attr_name,
+                                        domain, limit, &values, &num_values);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_OP_FAILURE, "Unable to find recently used %s "
+                      "in domain %s [%d]: %s\n", cb_ctx->name, domain->name,
+                      ret, sss_strerror(ret));
+                return ret;
+            }
+
+            DEBUG(SSSDBG_TRACE_FUNC, "Pre-warming %zu %s in domain %s\n",
+                  num_values, cb_ctx->name, domain->name);
+
+            ret = be_prewarm_add_batches(state, cb_ctx, domain,
+                                         values, num_values);
+            talloc_free(values);
+            if (ret != EOK) {
+                return ret;
+            }
+        }
+    }
+
+    return EOK;
+}
+
+static void be_prewarm_issue(struct tevent_req *req);
+static void be_prewarm_done(struct tevent_req *subreq);
+
+static struct tevent_req *be_prewarm_send(TALLOC_CTX *mem_ctx,
+                                          struct tevent_context *ev,
+                                          struct be_ctx *be_ctx,
+                                          struct be_ptask *be_ptask,
+                                          void *pvt)
+{
+    struct be_prewarm_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct be_prewarm_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_req_create() failed\n");
+        return NULL;
+    }
+
+    state->ev = ev;
+    state->be_ctx = be_ctx;
+    state->start = tevent_timeval_current();
+    state->ctx = talloc_get_type(pvt, struct be_refresh_ctx);
+    if (state->ctx == NULL) {
+        ret = EINVAL;
+        goto immediately;
+    }
+
+    /* The task is run again when the back end goes online, but the cache
+     * needs to be pre-warmed only once. */
+    if (state->ctx->prewarmed) {
+        ret = EOK;
+        goto immediately;
+    }
+
+    ret = be_prewarm_prepare(state);
+    if (ret != EOK) {
+        goto immediately;
+    }
+
+    if (state->num_batches == 0) {
+        state->ctx->prewarmed = true;
+        ret = EOK;
+        goto immediately;
+    }
+
+    be_prewarm_issue(req);
+    if (state->active == 0) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    return req;
+
+immediately:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else {
+        tevent_req_error(req, ret);
+    }
+    tevent_req_post(req, ev);
+
+    return req;
+}
+
+static void be_prewarm_issue(struct tevent_req *req)
+{
+    struct be_prewarm_state *state;
+    struct be_prewarm_batch *batch;
+    struct tevent_req *subreq;
+
+    state = tevent_req_data(req, struct be_prewarm_state);
+
+    while (state->active < BE_PREWARM_CONCURRENCY
+            && state->next_batch < state->num_batches) {
+        batch = &state->batches[state->next_batch];
+        state->next_batch++;
+
+        subreq = batch->cb_ctx->cb.send_fn(state, state->ev, state->be_ctx,
+                                           batch->domain, batch->names,
+                                           batch->cb_ctx->cb.pvt);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to pre-warm %zu %s\n",
+                  batch->num_names, batch->cb_ctx->name);
+            state->failed += batch->num_names;
+            continue;
+        }
+
+        batch->req = req;
+        tevent_req_set_callback(subreq, be_prewarm_done, batch);
+        state->active++;
+    }
+}
+
+static void be_prewarm_done(struct tevent_req *subreq)
+{
+    struct be_prewarm_state *state;
+    struct be_prewarm_batch *batch;
+    struct tevent_req *req;
+    struct timeval now;
+    errno_t ret;
+
+    batch = tevent_req_callback_data(subreq, struct be_prewarm_batch);
+    req = batch->req;
+    state = tevent_req_data(req, struct be_prewarm_state);
+
+    ret = batch->cb_ctx->cb.recv_fn(subreq);
+    talloc_zfree(subreq);
+    state->active--;
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to pre-warm %zu %s [%d]: %s\n",
+              batch->num_names, batch->cb_ctx->name, ret, sss_strerror(ret));
+        state->failed += batch->num_names;
+    } else {
+        state->refreshed += batch->num_names;
+    }
+    talloc_zfree(batch->names);
+
+    DEBUG(SSSDBG_FUNC_DATA, "Pre-warm progress: %zu of %zu entries "
+          "refreshed, %zu failed\n", state->refreshed, state->total,
+          state->failed);
+
+    be_prewarm_issue(req);
+    if (state->active > 0) {
+        return;
+    }
+
+    now = tevent_timeval_current();
+    DEBUG(SSSDBG_CONF_SETTINGS, "Cache pre-warmed in %ld seconds: %zu of %zu "
+          "entries refreshed, %zu failed\n",
+          (long) (now.tv_sec - state->start.tv_sec), state->refreshed,
+          state->total, state->failed);
+
+    state->ctx->prewarmed = true;
+    tevent_req_done(req);
+}
+
+static errno_t be_prewarm_recv(struct tevent_req *req)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
@@ -262,6 +262,16 @@ static void dp_init_done(struct tevent_req *subreq)
         goto done;
     }
 
+    if (state->be_ctx->domain->dp_binary_ipc) {
+        /* Responders fall back to sbus if this is not available */
+        ret = dp_fast_init(state->provider);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Binary IPC is not available, "
+                  "account lookups will use sbus only\n");
+        }
+        ret = EOK;
+    }
+
 done:
     if (ret != EOK) {
         talloc_zfree(state->be_ctx->provider);
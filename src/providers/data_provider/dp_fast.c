@@ -0,0 +1,493 @@
+/*
+    SSSD
+
+    Data Provider - binary IPC for account lookups
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <talloc.h>
+#include <tevent.h>
+#include <dhash.h>
+
+#include "util/util.h"
+#include "providers/backend.h"
+#include "providers/data_provider/dp_private.h"
+#include "providers/data_provider/dp_iface.h"
+#include "sss_iface/sss_iface_fast.h"
+
+struct dp_fast_server {
+    struct data_provider *provider;
+    struct tevent_fd *fde;
+    char *path;
+
+    /* Requests in progress by their arguments. Identical requests are
+     * answered by a single lookup, as sbus does. */
+    hash_table_t *calls;
+
+    uint64_t num_requests;
+    uint64_t num_chained;
+};
+
+struct dp_fast_client {
+    struct dp_fast_server *server;
+    struct sss_fast_conn *conn;
+};
+
+struct dp_fast_call;
+
+struct dp_fast_waiter {
+    struct dp_fast_waiter *prev;
+    struct dp_fast_waiter *next;
+
+    struct dp_fast_call *call;
+    struct dp_fast_client *client;
+    uint32_t serial;
+};
+
+struct dp_fast_call {
+    struct dp_fast_server *server;
+    char *key;
+    struct dp_fast_waiter *waiters;
+
+    /* The lookup keeps the arguments, unpacked ones point into the read
+     * buffer which is reused for the next frames. */
+    char *filter;
+    char *domain;
+    char *extra;
+};
+
+static int dp_fast_waiter_destructor(struct dp_fast_waiter *waiter)
+{
+    if (waiter->call != NULL) {
+        DLIST_REMOVE(waiter->call->waiters, waiter);
+    }
+
+    return 0;
+}
+
+static int dp_fast_call_destructor(struct dp_fast_call *call)
+{
+    struct dp_fast_waiter *waiter;
+    hash_key_t key;
+
+    DLIST_FOR_EACH(waiter, call->waiters) {
+        waiter->call = NULL;
+    }
+
+    key.type = HASH_KEY_STRING;
+    key.str = call->key;
+    hash_delete(call->server->calls, &key);
+
+    return 0;
+}
+
+static void dp_fast_reply(struct dp_fast_client *client,
+                          uint32_t serial,
+                          errno_t code,
+                          const uint8_t *body,
+                          size_t body_len)
+{
+    errno_t ret;
+
+    ret = sss_fast_conn_send(client->conn, serial, code, body, body_len);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to send reply [%d]: %s\n",
+              ret, sss_strerror(ret));
+    }
+}
+
+static void dp_fast_call_done(struct tevent_req *subreq)
+{
+    struct dp_fast_waiter *waiter;
+    struct dp_fast_call *call;
+    const char *error_message = NULL;
+    uint16_t dp_error = 0;
+    uint32_t error = 0;
+    uint8_t *body = NULL;
+    size_t body_len = 0;
+    errno_t ret;
+
+    call = tevent_req_callback_data(subreq, struct dp_fast_call);
+
+    ret = dp_get_account_info_recv(call, subreq, &dp_error, &error,
+                                   &error_message);
+    talloc_zfree(subreq);
+    if (ret == EOK) {
+        ret = sss_fast_account_reply_pack(call, dp_error, error, error_message,
+                                          &body, &body_len);
+    }
+
+    DLIST_FOR_EACH(waiter, call->waiters) {
+        dp_fast_reply(waiter->client, waiter->serial, ret, body, body_len);
+    }
+
+    while (call->waiters != NULL) {
+        talloc_free(call->waiters);
+    }
+
+    talloc_free(call);
+}
+
+static errno_t dp_fast_get_account_info(struct dp_fast_client *client,
+                                        uint32_t serial,
+                                        const uint8_t *body,
+                                        size_t body_len)
+{
+    struct dp_fast_server *server = client->server;
+    struct sss_fast_account_req args;
+    struct dp_fast_waiter *waiter;
+    struct dp_fast_call *call;
+    struct tevent_req *subreq;
+    hash_key_t key;
+    hash_value_t value;
+    char *call_key;
+    errno_t ret;
+    int hret;
+
+    ret = sss_fast_account_req_unpack(body, body_len, &args);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Malformed request\n");
+        return ret;
+    }
+
+    waiter = talloc_zero(client, struct dp_fast_waiter);
+    if (waiter == NULL) {
+        return ENOMEM;
+    }
+
+    waiter->client = client;
+    waiter->serial = serial;
+
+    call_key = talloc_asprintf(waiter, "%"PRIu32":%"PRIu32":%s:%s:%s",
+                               args.dp_flags, args.entry_type, args.filter,
+                               args.domain, args.extra);
+    if (call_key == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    server->num_requests++;
+
+    key.type = HASH_KEY_STRING;
+    key.str = call_key;
+
+    hret = hash_lookup(server->calls, &key, &value);
+    if (hret == HASH_SUCCESS) {
+        call = talloc_get_type(value.ptr, struct dp_fast_call);
+        server->num_chained++;
+
+        DEBUG(SSSDBG_TRACE_FUNC, "Chaining request [%s]\n", call_key);
+        ret = EOK;
+        goto done;
+    }
+
+    call = talloc_zero(server, struct dp_fast_call);
+    if (call == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    call->server = server;
+    call->key = talloc_steal(call, call_key);
+    call->filter = talloc_strdup(call, args.filter);
+    call->domain = talloc_strdup(call, args.domain);
+    call->extra = talloc_strdup(call, args.extra);
+    if (call->filter == NULL || call->domain == NULL || call->extra == NULL) {
+        talloc_free(call);
+        ret = ENOMEM;
+        goto done;
+    }
+
+    subreq = dp_get_account_info_send(call, server->provider->ev, NULL,
+                                      server->provider, args.dp_flags,
+                                      args.entry_type, call->filter,
+                                      call->domain, call->extra);
+    if (subreq == NULL) {
+        talloc_free(call);
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, dp_fast_call_done, call);
+
+    key.str = call->key;
+    value.type = HASH_VALUE_PTR;
+    value.ptr = call;
+
+    hret = hash_enter(server->calls, &key, &value);
+    if (hret != HASH_SUCCESS) {
+        talloc_free(call);
+        ret = ENOMEM;
+        goto done;
+    }
+
+    talloc_set_destructor(call, dp_fast_call_destructor);
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(waiter);
+        return ret;
+    }
+
+    waiter->call = call;
+    DLIST_ADD_END(call->waiters, waiter, struct dp_fast_waiter *);
+    talloc_set_destructor(waiter, dp_fast_waiter_destructor);
+
+    return EOK;
+}
+
+static void dp_fast_client_frame(struct sss_fast_conn *conn,
+                                 uint32_t serial,
+                                 uint32_t code,
+                                 const uint8_t *body,
+                                 size_t body_len,
+                                 void *data)
+{
+    struct dp_fast_client *client;
+    errno_t ret;
+
+    client = talloc_get_type(data, struct dp_fast_client);
+
+    switch (code) {
+    case SSS_FAST_DP_GET_ACCOUNT_INFO:
+        ret = dp_fast_get_account_info(client, serial, body, body_len);
+        break;
+    default:
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unknown method %"PRIu32"\n", code);
+        ret = ENOSYS;
+        break;
+    }
+
+    if (ret != EOK) {
+        dp_fast_reply(client, serial, ret, NULL, 0);
+    }
+}
+
+static void dp_fast_client_close(struct sss_fast_conn *conn,
+                                 errno_t error,
+                                 void *data)
+{
+    struct dp_fast_client *client;
+
+    client = talloc_get_type(data, struct dp_fast_client);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Responder disconnected [%d]: %s\n",
+          error, sss_strerror(error));
+
+    /* Lookups in progress are finished and update the cache, but nobody
+     * is waiting for them. The responder sends them again over sbus,
+     * which does not share the table of calls in progress with us. */
+    talloc_free(client);
+}
+
+/* Only root and the user SSSD runs as may connect, as with sbus */
+static errno_t dp_fast_check_peer(struct dp_fast_server *server, int fd)
+{
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    errno_t ret;
+
+    ret = getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len);
+    if (ret != 0) {
+        ret = errno;
+        DEBUG(SSSDBG_OP_FAILURE, "getsockopt failed [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return ret;
+    }
+
+    if (cred.uid != 0 && cred.uid != server->provider->uid) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Connection from uid %"SPRIuid" "
+              "is not allowed\n", cred.uid);
+        return EPERM;
+    }
+
+    return EOK;
+}
+
+static void dp_fast_accept(struct tevent_context *ev,
+                           struct tevent_fd *fde,
+                           uint16_t flags,
+                           void *ptr)
+{
+    struct dp_fast_server *server;
+    struct dp_fast_client *client;
+    errno_t ret;
+    int fd;
+
+    server = talloc_get_type(ptr, struct dp_fast_server);
+
+    fd = accept(tevent_fd_get_fd(fde), NULL, NULL);
+    if (fd == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_OP_FAILURE, "accept failed [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return;
+    }
+
+    ret = dp_fast_check_peer(server, fd);
+    if (ret != EOK) {
+        close(fd);
+        return;
+    }
+
+    client = talloc_zero(server, struct dp_fast_client);
+    if (client == NULL) {
+        close(fd);
+        return;
+    }
+
+    client->server = server;
+
+    ret = sss_fast_conn_create(client, ev, fd, dp_fast_client_frame,
+                               dp_fast_client_close, client, &client->conn);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to set up connection [%d]: %s\n",
+              ret, sss_strerror(ret));
+        talloc_free(client);
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Responder connected over binary IPC\n");
+}
+
+static int dp_fast_server_destructor(struct dp_fast_server *server)
+{
+    DEBUG(SSSDBG_TRACE_FUNC, "Served %"PRIu64" account requests over binary "
+          "IPC, %"PRIu64" of them chained\n",
+          server->num_requests, server->num_chained);
+
+    unlink(server->path);
+    server->provider->fast_server = NULL;
+    return 0;
+}
+
+errno_t dp_fast_init(struct data_provider *provider)
+{
+    struct dp_fast_server *server;
+    struct sockaddr_un addr;
+    mode_t orig_umask;
+    errno_t ret;
+    int fd = -1;
+
+    server = talloc_zero(provider, struct dp_fast_server);
+    if (server == NULL) {
+        return ENOMEM;
+    }
+
+    server->provider = provider;
+
+    server->path = talloc_asprintf(server, SSS_BACKEND_FAST_ADDRESS,
+                                   provider->be_ctx->domain->name);
+    if (server->path == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    if (strlen(server->path) >= sizeof(addr.sun_path)) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Socket path is too long [%s]\n",
+              server->path);
+        ret = EINVAL;
+        goto done;
+    }
+
+    ret = sss_hash_create(server, 0, &server->calls);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, server->path, sizeof(addr.sun_path) - 1);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    /* A stale socket from the previous run */
+    if (unlink(server->path) != 0 && errno != ENOENT) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to remove [%s] [%d]: %s\n",
+              server->path, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    orig_umask = umask(0177);
+    ret = bind(fd, (struct sockaddr *) &addr, sizeof(addr));
+    umask(orig_umask);
+    if (ret != 0) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to bind [%s] [%d]: %s\n",
+              server->path, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    talloc_set_destructor(server, dp_fast_server_destructor);
+
+    if (getuid() == 0 && (provider->uid != 0 || provider->gid != 0)) {
+        ret = chown(server->path, provider->uid, provider->gid);
+        if (ret != 0) {
+            ret = errno;
+            DEBUG(SSSDBG_CRIT_FAILURE, "chown failed for [%s] [%d]: %s\n",
+                  server->path, ret, sss_strerror(ret));
+            goto done;
+        }
+    }
+
+    ret = listen(fd, 128);
+    if (ret != 0) {
+        ret = errno;
+        goto done;
+    }
+
+    server->fde = tevent_add_fd(provider->ev, server, fd, TEVENT_FD_READ,
+                                dp_fast_accept, server);
+    if (server->fde == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    tevent_fd_set_auto_close(server->fde);
+    fd = -1;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Listening for binary IPC on [%s]\n",
+          server->path);
+
+    provider->fast_server = server;
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to set up binary IPC [%d]: %s\n",
+              ret, sss_strerror(ret));
+        if (fd != -1) {
+            close(fd);
+        }
+        talloc_free(server);
+    }
+
+    return ret;
+}
@@ -44,6 +44,7 @@ enum dp_clients {
 
 struct dp_req;
 struct dp_client;
+struct dp_fast_server;
 
 struct dp_module {
     bool initialized;
@@ -80,6 +81,7 @@ struct data_provider {
     struct tevent_context *ev;
     struct sbus_server *sbus_server;
     struct sbus_connection *sbus_conn;
+    struct dp_fast_server *fast_server;
     struct dp_client *clients[DP_CLIENT_SENTINEL];
     bool terminating;
 
@@ -118,6 +120,10 @@ errno_t dp_init_targets(TALLOC_CTX *mem_ctx,
                         struct data_provider *provider,
                         struct dp_module **modules);
 
+/* Binary IPC for account lookups, see dp_binary_ipc option. */
+
+errno_t dp_fast_init(struct data_provider *provider);
+
 /* Data provider request. */
 
 void dp_terminate_active_requests(struct data_provider *provider);
@@ -2632,6 +2632,15 @@ static errno_t ipa_s2n_save_objects(struct sss_domain_info *dom,
                           "sysdb_attrs_add_time_t failed.\n");
                     goto done;
                 }
+
+                ret = sysdb_attrs_add_time_t(attrs->sysdb_attrs,
+                                             SYSDB_INITGR_LAST_UPDATE,
+                                             time(NULL));
+                if (ret != EOK) {
+                    DEBUG(SSSDBG_OP_FAILURE,
+                          "sysdb_attrs_add_time_t failed.\n");
+                    goto done;
+                }
             }
 
             gid = 0;
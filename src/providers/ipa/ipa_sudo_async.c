@@ -1081,15 +1081,24 @@ ipa_sudo_refresh_done(struct tevent_req *subreq)
     }
     in_transaction = true;
 
-    ret = sysdb_sudo_purge(state->domain, state->delete_filter,
-                           state->rules, state->num_rules);
-    if (ret != EOK) {
-        goto done;
-    }
+    if (state->delete_filter != NULL) {
+        /* write only rules that differ from the cached ones */
+        ret = sysdb_sudo_sync(state->domain, state->delete_filter,
+                              state->rules, state->num_rules, NULL);
+        if (ret != EOK) {
+            goto done;
+        }
+    } else {
+        ret = sysdb_sudo_purge(state->domain, NULL,
+                               state->rules, state->num_rules);
+        if (ret != EOK) {
+            goto done;
+        }
 
-    ret = sysdb_sudo_store(state->domain, state->rules, state->num_rules);
-    if (ret != EOK) {
-        goto done;
+        ret = sysdb_sudo_store(state->domain, state->rules, state->num_rules);
+        if (ret != EOK) {
+            goto done;
+        }
     }
 
     ret = sysdb_transaction_commit(state->sysdb);
@@ -34,6 +34,7 @@
 
 #include "util/util.h"
 #include "util/crypto/sss_crypto.h"
+#include "util/sss_crypt_pool.h"
 #include "util/find_uid.h"
 #include "util/auth_utils.h"
 #include "db/sysdb.h"
@@ -245,36 +246,118 @@ done:
 }
 
 
-static void krb5_auth_cache_creds(struct krb5_ctx *krb5_ctx,
-                                  struct sss_domain_info *domain,
-                                  struct confdb_ctx *cdb,
-                                  struct pam_data *pd, uid_t uid,
-                                  int *pam_status, int *dp_err)
+/* Offline authentication in the backend is rare, one helper thread is
+ * enough to keep the hashing out of the event loop. */
+#define KRB5_CRYPT_POOL_WORKERS 1
+
+struct krb5_auth_cache_creds_state {
+    struct krb5_ctx *krb5_ctx;
+    struct sss_domain_info *domain;
+    struct pam_data *pd;
+    uid_t uid;
+
+    int pam_status;
+    int dp_err;
+};
+
+static void krb5_auth_cache_creds_done(struct tevent_req *subreq);
+
+/* Checks the password against the cached credentials and, if it matches,
+ * queues the user for delayed online authentication. The password hash is
+ * computed by helper threads so the backend is not blocked. */
+static struct tevent_req *
+krb5_auth_cache_creds_send(TALLOC_CTX *mem_ctx,
+                           struct tevent_context *ev,
+                           struct krb5_ctx *krb5_ctx,
+                           struct sss_domain_info *domain,
+                           struct confdb_ctx *cdb,
+                           struct pam_data *pd,
+                           uid_t uid)
 {
+    struct krb5_auth_cache_creds_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
     const char *password = NULL;
     errno_t ret;
 
+    req = tevent_req_create(mem_ctx, &state,
+                            struct krb5_auth_cache_creds_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_req_create() failed\n");
+        return NULL;
+    }
+
+    state->krb5_ctx = krb5_ctx;
+    state->domain = domain;
+    state->pd = pd;
+    state->uid = uid;
+    state->pam_status = PAM_SYSTEM_ERR;
+    state->dp_err = DP_ERR_OK;
+
     ret = sss_authtok_get_password(pd->authtok, &password, NULL);
     if (ret != EOK) {
         DEBUG(SSSDBG_FATAL_FAILURE,
               "Failed to get password [%d] %s. Delayed authentication is only "
               "available for password authentication (single factor).\n",
               ret, strerror(ret));
-        *pam_status = PAM_SYSTEM_ERR;
-        *dp_err = DP_ERR_OK;
-        return;
+        ret = EOK;
+        goto immediately;
+    }
+
+    if (krb5_ctx->crypt_pool == NULL) {
+        ret = sss_crypt_pool_init(krb5_ctx, ev, KRB5_CRYPT_POOL_WORKERS,
+                                  &krb5_ctx->crypt_pool);
+        if (ret != EOK) {
+            /* Not fatal, the hash is computed in the main thread then. */
+            DEBUG(SSSDBG_MINOR_FAILURE, "sss_crypt_pool_init failed.\n");
+            krb5_ctx->crypt_pool = NULL;
+        }
+    }
+
+    subreq = sysdb_cache_auth_send(state, ev, krb5_ctx->crypt_pool, domain,
+                                   pd->user, password, cdb, true);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto immediately;
     }
 
-    ret = sysdb_cache_auth(domain, pd->user,
-                           password, cdb, true, NULL, NULL);
+    tevent_req_set_callback(subreq, krb5_auth_cache_creds_done, req);
+
+    return req;
+
+immediately:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else {
+        tevent_req_error(req, ret);
+    }
+    tevent_req_post(req, ev);
+
+    return req;
+}
+
+static void krb5_auth_cache_creds_done(struct tevent_req *subreq)
+{
+    struct krb5_auth_cache_creds_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct krb5_auth_cache_creds_state);
+
+    ret = sysdb_cache_auth_recv(subreq, NULL, NULL);
+    talloc_zfree(subreq);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Offline authentication failed\n");
-        *pam_status = cached_login_pam_status(ret);
-        *dp_err = DP_ERR_OK;
+        state->pam_status = cached_login_pam_status(ret);
+        state->dp_err = DP_ERR_OK;
+        tevent_req_done(req);
         return;
     }
 
-    ret = add_user_to_delayed_online_authentication(krb5_ctx, domain, pd, uid);
+    ret = add_user_to_delayed_online_authentication(state->krb5_ctx,
+                                                    state->domain,
+                                                    state->pd, state->uid);
     if (ret == ENOTSUP) {
         /* This error is not fatal */
         DEBUG(SSSDBG_MINOR_FAILURE, "Delayed authentication not supported\n");
@@ -283,8 +366,25 @@ static void krb5_auth_cache_creds(struct krb5_ctx *krb5_ctx,
         DEBUG(SSSDBG_CRIT_FAILURE,
               "add_user_to_delayed_online_authentication failed.\n");
     }
-    *pam_status = PAM_AUTHINFO_UNAVAIL;
-    *dp_err = DP_ERR_OFFLINE;
+    state->pam_status = PAM_AUTHINFO_UNAVAIL;
+    state->dp_err = DP_ERR_OFFLINE;
+
+    tevent_req_done(req);
+}
+
+static errno_t krb5_auth_cache_creds_recv(struct tevent_req *req,
+                                          int *_pam_status,
+                                          int *_dp_err)
+{
+    struct krb5_auth_cache_creds_state *state;
+    state = tevent_req_data(req, struct krb5_auth_cache_creds_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_pam_status = state->pam_status;
+    *_dp_err = state->dp_err;
+
+    return EOK;
 }
 
 static errno_t krb5_auth_prepare_ccache_name(struct krb5child_req *kr,
@@ -446,6 +546,7 @@ struct krb5_auth_state {
 
 static void krb5_auth_resolve_done(struct tevent_req *subreq);
 static void krb5_auth_done(struct tevent_req *subreq);
+static void krb5_auth_cache_creds_checked(struct tevent_req *subreq);
 
 struct tevent_req *krb5_auth_send(TALLOC_CTX *mem_ctx,
                                   struct tevent_context *ev,
@@ -1135,11 +1236,20 @@ static void krb5_auth_done(struct tevent_req *subreq)
                             KRB5_STORE_PASSWORD_IF_OFFLINE)
                 && sss_authtok_get_type(pd->authtok)
                             == SSS_AUTHTOK_TYPE_PASSWORD) {
-            krb5_auth_cache_creds(state->kr->krb5_ctx,
-                                  state->domain,
-                                  state->be_ctx->cdb,
-                                  state->pd, state->kr->uid,
-                                  &state->pam_status, &state->dp_err);
+            subreq = krb5_auth_cache_creds_send(state, state->ev,
+                                                state->kr->krb5_ctx,
+                                                state->domain,
+                                                state->be_ctx->cdb,
+                                                state->pd, state->kr->uid);
+            if (subreq == NULL) {
+                DEBUG(SSSDBG_CRIT_FAILURE,
+                      "krb5_auth_cache_creds_send failed.\n");
+                ret = ENOMEM;
+                goto done;
+            }
+            tevent_req_set_callback(subreq, krb5_auth_cache_creds_checked,
+                                    req);
+            return;
         } else {
             DEBUG(SSSDBG_CONF_SETTINGS,
                   "Backend is marked offline, retry later!\n");
@@ -1189,6 +1299,27 @@ done:
 
 }
 
+static void krb5_auth_cache_creds_checked(struct tevent_req *subreq)
+{
+    struct krb5_auth_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct krb5_auth_state);
+
+    ret = krb5_auth_cache_creds_recv(subreq, &state->pam_status,
+                                     &state->dp_err);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Offline authentication failed\n");
+        state->pam_status = PAM_SYSTEM_ERR;
+        state->dp_err = DP_ERR_OK;
+    }
+
+    tevent_req_done(req);
+}
+
 int krb5_auth_recv(struct tevent_req *req, int *pam_status, int *dp_err)
 {
     struct krb5_auth_state *state = tevent_req_data(req, struct krb5_auth_state);
@@ -145,6 +145,9 @@ struct krb5_ctx {
     const char *fast_principal;
 
     bool canonicalize;
+
+    /* Created on first use, see krb5_auth_cache_creds_send() */
+    struct sss_crypt_pool *crypt_pool;
 };
 
 struct remove_info_files_ctx {
@@ -330,6 +330,12 @@ errno_t init_delayed_online_authentication(struct krb5_ctx *krb5_ctx,
     int ret;
     hash_table_t *tmp_table;
 
+    ret = find_uid_tracker_setup(be_ctx, ev);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Active users will be found by scanning "
+              "/proc\n");
+    }
+
     ret = get_uid_table(krb5_ctx, &tmp_table);
     if (ret != EOK) {
         if (ret == ENOSYS) {
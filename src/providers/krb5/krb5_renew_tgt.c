@@ -31,6 +31,17 @@
 
 #define INITIAL_TGT_TABLE_SIZE 10
 
+/* Renewals are spread over this fraction of the remaining lifetime of the
+ * ticket, so that tickets obtained at the same time, e.g. after a reboot,
+ * do not hit the KDC all at once. */
+#define RENEW_JITTER_DIVISOR 10
+
+struct renew_stats {
+    uint64_t renewals;
+    uint64_t lag_total;
+    time_t lag_max;
+};
+
 struct renew_tgt_ctx {
     hash_table_t *tgt_table;
     struct be_ctx *be_ctx;
@@ -38,9 +49,24 @@ struct renew_tgt_ctx {
     struct krb5_ctx *krb5_ctx;
     time_t timer_interval;
     struct tevent_timer *te;
+    time_t te_due;
+    /* Renewal items waiting for renewal, a binary min-heap ordered by
+     * start_renew_at. Items with a running renewal request are not in the
+     * queue. */
+    struct renew_data **queue;
+    size_t queue_len;
+    size_t queue_size;
+    struct renew_stats stats;
 };
 
+/* queue_idx of renewal items which are not in the queue */
+#define RENEW_NOT_QUEUED SIZE_MAX
+
 struct renew_data {
+    struct renew_tgt_ctx *renew_tgt_ctx;
+    size_t queue_idx;
+
+    const char *upn;
     const char *ccfile;
     time_t start_time;
     time_t lifetime;
@@ -57,6 +83,146 @@ struct auth_data {
     hash_key_t key;
 };
 
+static void renew_queue_set(struct renew_tgt_ctx *renew_tgt_ctx,
+                            size_t idx, struct renew_data *renew_data)
+{
+    renew_tgt_ctx->queue[idx] = renew_data;
+    renew_data->queue_idx = idx;
+}
+
+static void renew_queue_up(struct renew_tgt_ctx *renew_tgt_ctx, size_t idx)
+{
+    struct renew_data *renew_data = renew_tgt_ctx->queue[idx];
+    size_t parent;
+
+    while (idx > 0) {
+        parent = (idx - 1) / 2;
+        if (renew_tgt_ctx->queue[parent]->start_renew_at
+                <= renew_data->start_renew_at) {
+            break;
+        }
+        renew_queue_set(renew_tgt_ctx, idx, renew_tgt_ctx->queue[parent]);
+        idx = parent;
+    }
+
+    renew_queue_set(renew_tgt_ctx, idx, renew_data);
+}
+
+static void renew_queue_down(struct renew_tgt_ctx *renew_tgt_ctx, size_t idx)
+{
+    struct renew_data *renew_data = renew_tgt_ctx->queue[idx];
+    size_t child;
+
+    while ((child = 2 * idx + 1) < renew_tgt_ctx->queue_len) {
+        if (child + 1 < renew_tgt_ctx->queue_len
+                && renew_tgt_ctx->queue[child + 1]->start_renew_at
+                    < renew_tgt_ctx->queue[child]->start_renew_at) {
+            child++;
+        }
+        if (renew_data->start_renew_at
+                <= renew_tgt_ctx->queue[child]->start_renew_at) {
+            break;
+        }
+        renew_queue_set(renew_tgt_ctx, idx, renew_tgt_ctx->queue[child]);
+        idx = child;
+    }
+
+    renew_queue_set(renew_tgt_ctx, idx, renew_data);
+}
+
+static void renew_queue_remove(struct renew_data *renew_data)
+{
+    struct renew_tgt_ctx *renew_tgt_ctx = renew_data->renew_tgt_ctx;
+    size_t idx = renew_data->queue_idx;
+
+    if (idx == RENEW_NOT_QUEUED) {
+        return;
+    }
+
+    renew_data->queue_idx = RENEW_NOT_QUEUED;
+    renew_tgt_ctx->queue_len--;
+    if (idx == renew_tgt_ctx->queue_len) {
+        return;
+    }
+
+    /* Move the last item into the hole and restore the heap order */
+    renew_queue_set(renew_tgt_ctx, idx,
+                    renew_tgt_ctx->queue[renew_tgt_ctx->queue_len]);
+    renew_queue_down(renew_tgt_ctx, idx);
+    renew_queue_up(renew_tgt_ctx, renew_tgt_ctx->queue[idx]->queue_idx);
+}
+
+static errno_t renew_queue_add(struct renew_tgt_ctx *renew_tgt_ctx,
+                               struct renew_data *renew_data)
+{
+    struct renew_data **queue;
+    size_t size;
+
+    renew_queue_remove(renew_data);
+
+    if (renew_tgt_ctx->queue_len == renew_tgt_ctx->queue_size) {
+        size = renew_tgt_ctx->queue_size == 0 ? INITIAL_TGT_TABLE_SIZE
+                                              : 2 * renew_tgt_ctx->queue_size;
+        queue = talloc_realloc(renew_tgt_ctx, renew_tgt_ctx->queue,
+                               struct renew_data *, size);
+        if (queue == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "talloc_realloc failed.\n");
+            return ENOMEM;
+        }
+        renew_tgt_ctx->queue = queue;
+        renew_tgt_ctx->queue_size = size;
+    }
+
+    renew_queue_set(renew_tgt_ctx, renew_tgt_ctx->queue_len, renew_data);
+    renew_tgt_ctx->queue_len++;
+    renew_queue_up(renew_tgt_ctx, renew_data->queue_idx);
+
+    return EOK;
+}
+
+static struct renew_data *
+renew_queue_first(struct renew_tgt_ctx *renew_tgt_ctx)
+{
+    return renew_tgt_ctx->queue_len > 0 ? renew_tgt_ctx->queue[0] : NULL;
+}
+
+/* The queue might be freed before the renewal items, so forget them
+ * first. */
+static int renew_tgt_ctx_destructor(struct renew_tgt_ctx *renew_tgt_ctx)
+{
+    size_t i;
+
+    for (i = 0; i < renew_tgt_ctx->queue_len; i++) {
+        renew_tgt_ctx->queue[i]->queue_idx = RENEW_NOT_QUEUED;
+    }
+    renew_tgt_ctx->queue_len = 0;
+
+    return 0;
+}
+
+static int renew_data_destructor(struct renew_data *renew_data)
+{
+    renew_queue_remove(renew_data);
+    return 0;
+}
+
+/* Give back the pam data to the renewal item to be able to retry after the
+ * renewal interval. The item is due again only then, otherwise the next
+ * scheduled renewal would retry it immediately. */
+static void renew_give_back(struct auth_data *auth_data)
+{
+    struct renew_data *renew_data = auth_data->renew_data;
+    errno_t ret;
+
+    renew_data->pd = talloc_steal(renew_data, auth_data->pd);
+    renew_data->start_renew_at = time(NULL)
+                                 + renew_data->renew_tgt_ctx->timer_interval;
+    ret = renew_queue_add(renew_data->renew_tgt_ctx, renew_data);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to queue [%s] for renewal.\n",
+              renew_data->ccfile);
+    }
+}
 
 static void renew_tgt_done(struct tevent_req *req);
 static void renew_tgt(struct tevent_context *ev, struct tevent_timer *te,
@@ -70,10 +236,7 @@ static void renew_tgt(struct tevent_context *ev, struct tevent_timer *te,
                                auth_data->krb5_ctx);
     if (req == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "krb5_auth_send failed.\n");
-/* Give back the pam data to the renewal item to be able to retry at the next
- * time the renewals re run. */
-        auth_data->renew_data->pd = talloc_steal(auth_data->renew_data,
-                                                 auth_data->pd);
+        renew_give_back(auth_data);
         talloc_free(auth_data);
         return;
     }
@@ -96,8 +259,7 @@ static void renew_tgt_done(struct tevent_req *req)
         DEBUG(SSSDBG_CRIT_FAILURE, "krb5_auth request failed.\n");
         if (auth_data->renew_data != NULL) {
             DEBUG(SSSDBG_FUNC_DATA, "Giving back pam data.\n");
-            auth_data->renew_data->pd = talloc_steal(auth_data->renew_data,
-                                                     auth_data->pd);
+            renew_give_back(auth_data);
         }
     } else {
         switch (pam_status) {
@@ -135,8 +297,7 @@ static void renew_tgt_done(struct tevent_req *req)
                           auth_data->pd->user);
                 if (auth_data->renew_data != NULL) {
                     DEBUG(SSSDBG_FUNC_DATA, "Giving back pam data.\n");
-                    auth_data->renew_data->pd = talloc_steal(auth_data->renew_data,
-                                                             auth_data->pd);
+                    renew_give_back(auth_data);
                 }
                 break;
             default:
@@ -156,34 +317,37 @@ static void renew_tgt_done(struct tevent_req *req)
 static errno_t renew_all_tgts(struct renew_tgt_ctx *renew_tgt_ctx)
 {
     int ret;
-    hash_entry_t *entries;
-    unsigned long count;
-    size_t c;
     time_t now;
+    time_t lag;
     struct auth_data *auth_data;
     struct renew_data *renew_data;
-    struct tevent_timer *te = NULL;
-
-    ret = hash_entries(renew_tgt_ctx->tgt_table, &count, &entries);
-    if (ret != HASH_SUCCESS) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "hash_entries failed.\n");
-        return ENOMEM;
-    }
+    struct tevent_timer *te;
+    hash_key_t key;
 
     now = time(NULL);
 
-    for (c = 0; c < count; c++) {
-        renew_data = talloc_get_type(entries[c].value.ptr, struct renew_data);
+    /* Only the items at the head of the queue are due */
+    while ((renew_data = renew_queue_first(renew_tgt_ctx)) != NULL
+            && renew_data->start_renew_at <= now) {
+        renew_queue_remove(renew_data);
+        te = NULL;
+
+        lag = now - renew_data->start_renew_at;
+        renew_tgt_ctx->stats.renewals++;
+        renew_tgt_ctx->stats.lag_total += lag;
+        if (lag > renew_tgt_ctx->stats.lag_max) {
+            renew_tgt_ctx->stats.lag_max = lag;
+        }
+
         DEBUG(SSSDBG_TRACE_ALL,
-              "Checking [%s] for renewal at [%.24s].\n", renew_data->ccfile,
-                  ctime(&renew_data->start_renew_at));
-        /* If renew_data->pd == NULL a renewal request for this data is
-         * currently running so we skip it. */
-        if (renew_data->start_renew_at < now && renew_data->pd != NULL) {
-            auth_data = talloc_zero(renew_tgt_ctx, struct auth_data);
-            if (auth_data == NULL) {
-                DEBUG(SSSDBG_CRIT_FAILURE, "talloc_zero failed.\n");
-            } else {
+              "Renewing [%s], due at [%.24s], lag [%ld]s.\n",
+              renew_data->ccfile, ctime(&renew_data->start_renew_at),
+              (long) lag);
+
+        auth_data = talloc_zero(renew_tgt_ctx, struct auth_data);
+        if (auth_data == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "talloc_zero failed.\n");
+        } else {
 /* We need to steal the pam_data here, because a successful renewal of the
  * ticket might add a new renewal item to the list with the same key (upn).
  * This would delete renew_data and all its children. But we cannot be sure
@@ -193,39 +357,45 @@ static errno_t renew_all_tgts(struct renew_tgt_ctx *renew_tgt_ctx)
  * renewal process is finished. In the case of an error during renewal we
  * might want to steal the pam_data back to renew_data before freeing
  * auth_data to allow a new renewal attempt. */
-                auth_data->pd = talloc_move(auth_data, &renew_data->pd);
-                auth_data->krb5_ctx = renew_tgt_ctx->krb5_ctx;
-                auth_data->be_ctx = renew_tgt_ctx->be_ctx;
-                auth_data->table = renew_tgt_ctx->tgt_table;
-                auth_data->renew_data = renew_data;
-                auth_data->key.type = entries[c].key.type;
-                auth_data->key.str = talloc_strdup(auth_data,
-                                                   entries[c].key.str);
-                if (auth_data->key.str == NULL) {
-                    DEBUG(SSSDBG_CRIT_FAILURE, "talloc_strdup failed.\n");
-                } else {
-                    te = tevent_add_timer(renew_tgt_ctx->ev,
-                                          auth_data, tevent_timeval_current(),
-                                          renew_tgt, auth_data);
-                    if (te == NULL) {
-                        DEBUG(SSSDBG_CRIT_FAILURE,
-                              "tevent_add_timer failed.\n");
-                    }
+            auth_data->pd = talloc_move(auth_data, &renew_data->pd);
+            auth_data->krb5_ctx = renew_tgt_ctx->krb5_ctx;
+            auth_data->be_ctx = renew_tgt_ctx->be_ctx;
+            auth_data->table = renew_tgt_ctx->tgt_table;
+            auth_data->renew_data = renew_data;
+            auth_data->key.type = HASH_KEY_STRING;
+            auth_data->key.str = talloc_strdup(auth_data, renew_data->upn);
+            if (auth_data->key.str == NULL) {
+                DEBUG(SSSDBG_CRIT_FAILURE, "talloc_strdup failed.\n");
+            } else {
+                te = tevent_add_timer(renew_tgt_ctx->ev,
+                                      auth_data, tevent_timeval_current(),
+                                      renew_tgt, auth_data);
+                if (te == NULL) {
+                    DEBUG(SSSDBG_CRIT_FAILURE, "tevent_add_timer failed.\n");
                 }
             }
+        }
 
-            if (auth_data == NULL || te == NULL) {
-                DEBUG(SSSDBG_CRIT_FAILURE,
-                      "Failed to renew TGT in [%s].\n", renew_data->ccfile);
-                ret = hash_delete(renew_tgt_ctx->tgt_table, &entries[c].key);
-                if (ret != HASH_SUCCESS) {
-                    DEBUG(SSSDBG_CRIT_FAILURE, "hash_delete failed.\n");
-                }
+        if (auth_data == NULL || te == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Failed to renew TGT in [%s].\n", renew_data->ccfile);
+            talloc_free(auth_data);
+            key.type = HASH_KEY_STRING;
+            key.str = discard_const_p(char, renew_data->upn);
+            ret = hash_delete(renew_tgt_ctx->tgt_table, &key);
+            if (ret != HASH_SUCCESS) {
+                DEBUG(SSSDBG_CRIT_FAILURE, "hash_delete failed.\n");
             }
         }
     }
 
-    talloc_free(entries);
+    if (renew_tgt_ctx->stats.renewals > 0) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "[%"PRIu64"] renewals so far, average lag [%"PRIu64"]s, "
+              "maximum lag [%ld]s.\n", renew_tgt_ctx->stats.renewals,
+              renew_tgt_ctx->stats.lag_total / renew_tgt_ctx->stats.renewals,
+              (long) renew_tgt_ctx->stats.lag_max);
+    }
 
     return EOK;
 }
@@ -261,9 +431,48 @@ static void renew_tgt_timer_handler(struct tevent_context *ev,
     renew_handler(renew_tgt_ctx);
 }
 
+/* Arm the renewal timer for the first item in the queue, but check at least
+ * every timer_interval seconds. */
+static errno_t renew_schedule(struct renew_tgt_ctx *renew_tgt_ctx)
+{
+    struct renew_data *first;
+    struct tevent_timer *te;
+    time_t due;
+
+    due = time(NULL) + renew_tgt_ctx->timer_interval;
+    first = renew_queue_first(renew_tgt_ctx);
+    if (first != NULL && first->start_renew_at < due) {
+        due = first->start_renew_at;
+    }
+
+    if (renew_tgt_ctx->te != NULL) {
+        if (renew_tgt_ctx->te_due <= due) {
+            DEBUG(SSSDBG_TRACE_LIBS,
+                  "There is an active renewal timer, doing nothing.\n");
+            return EOK;
+        }
+    }
+
+    DEBUG(SSSDBG_TRACE_LIBS, "Adding new renew timer for [%.24s].\n",
+          ctime(&due));
+
+    te = tevent_add_timer(renew_tgt_ctx->ev, renew_tgt_ctx,
+                          tevent_timeval_set(due, 0),
+                          renew_tgt_timer_handler, renew_tgt_ctx);
+    if (te == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_add_timer failed.\n");
+        return ENOMEM;
+    }
+
+    talloc_free(renew_tgt_ctx->te);
+    renew_tgt_ctx->te = te;
+    renew_tgt_ctx->te_due = due;
+
+    return EOK;
+}
+
 static void renew_handler(struct renew_tgt_ctx *renew_tgt_ctx)
 {
-    struct timeval next;
     int ret;
 
     if (be_is_offline(renew_tgt_ctx->be_ctx)) {
@@ -280,21 +489,8 @@ static void renew_handler(struct renew_tgt_ctx *renew_tgt_ctx)
         return;
     }
 
-    if (renew_tgt_ctx->te != NULL) {
-        DEBUG(SSSDBG_TRACE_LIBS,
-              "There is an active renewal timer, doing nothing.\n");
-        return;
-    }
-
-    DEBUG(SSSDBG_TRACE_LIBS, "Adding new renew timer.\n");
-
-    next = tevent_timeval_current_ofs(renew_tgt_ctx->timer_interval,
-                                      0);
-    renew_tgt_ctx->te = tevent_add_timer(renew_tgt_ctx->ev, renew_tgt_ctx,
-                                         next, renew_tgt_timer_handler,
-                                         renew_tgt_ctx);
-    if (renew_tgt_ctx->te == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_add_timer failed.\n");
+    ret = renew_schedule(renew_tgt_ctx);
+    if (ret != EOK) {
         sss_log(SSS_LOG_ERR, "Disabling automatic TGT renewal.");
         talloc_zfree(renew_tgt_ctx);
     }
@@ -476,13 +672,13 @@ errno_t init_renew_tgt(struct krb5_ctx *krb5_ctx, struct be_ctx *be_ctx,
                        struct tevent_context *ev, time_t renew_intv)
 {
     int ret;
-    struct timeval next;
 
     krb5_ctx->renew_tgt_ctx = talloc_zero(krb5_ctx, struct renew_tgt_ctx);
     if (krb5_ctx->renew_tgt_ctx == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "talloc_zero failed.\n");
         return ENOMEM;
     }
+    talloc_set_destructor(krb5_ctx->renew_tgt_ctx, renew_tgt_ctx_destructor);
 
     ret = sss_hash_create_ex(krb5_ctx->renew_tgt_ctx, INITIAL_TGT_TABLE_SIZE,
                              &krb5_ctx->renew_tgt_ctx->tgt_table, 0, 0, 0, 0,
@@ -503,14 +699,8 @@ errno_t init_renew_tgt(struct krb5_ctx *krb5_ctx, struct be_ctx *be_ctx,
               "Failed to read ccache files, continuing ...\n");
     }
 
-    next = tevent_timeval_current_ofs(krb5_ctx->renew_tgt_ctx->timer_interval,
-                                      0);
-    krb5_ctx->renew_tgt_ctx->te = tevent_add_timer(ev, krb5_ctx->renew_tgt_ctx,
-                                                   next, renew_tgt_timer_handler,
-                                                   krb5_ctx->renew_tgt_ctx);
-    if (krb5_ctx->renew_tgt_ctx->te == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_add_timer failed.\n");
-        ret = ENOMEM;
+    ret = renew_schedule(krb5_ctx->renew_tgt_ctx);
+    if (ret != EOK) {
         goto fail;
     }
 
@@ -549,6 +739,7 @@ errno_t add_tgt_to_renew_table(struct krb5_ctx *krb5_ctx, const char *ccfile,
     hash_key_t key;
     hash_value_t value;
     struct renew_data *renew_data = NULL;
+    time_t jitter;
 
     if (krb5_ctx->renew_tgt_ctx == NULL) {
         DEBUG(SSSDBG_TRACE_LIBS ,"Renew context not initialized, "
@@ -579,6 +770,17 @@ errno_t add_tgt_to_renew_table(struct krb5_ctx *krb5_ctx, const char *ccfile,
         goto done;
     }
 
+    renew_data->renew_tgt_ctx = krb5_ctx->renew_tgt_ctx;
+    renew_data->queue_idx = RENEW_NOT_QUEUED;
+    talloc_set_destructor(renew_data, renew_data_destructor);
+
+    renew_data->upn = talloc_strdup(renew_data, upn);
+    if (renew_data->upn == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "talloc_strdup failed.\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
     if (ccfile[0] == '/') {
         renew_data->ccfile = talloc_asprintf(renew_data, "FILE:%s", ccfile);
         if (renew_data->ccfile == NULL) {
@@ -594,6 +796,11 @@ errno_t add_tgt_to_renew_table(struct krb5_ctx *krb5_ctx, const char *ccfile,
     renew_data->lifetime = tgtt->endtime;
     renew_data->start_renew_at = (time_t) (tgtt->starttime +
                                         0.5 *(tgtt->endtime - tgtt->starttime));
+    jitter = (tgtt->endtime - renew_data->start_renew_at)
+                / RENEW_JITTER_DIVISOR;
+    if (jitter > 0) {
+        renew_data->start_renew_at += sss_rand() % jitter;
+    }
 
     ret = copy_pam_data(renew_data, pd, &renew_data->pd);
     if (ret != EOK) {
@@ -611,6 +818,11 @@ errno_t add_tgt_to_renew_table(struct krb5_ctx *krb5_ctx, const char *ccfile,
 
     renew_data->pd->cmd = SSS_CMD_RENEW;
 
+    ret = renew_queue_add(krb5_ctx->renew_tgt_ctx, renew_data);
+    if (ret != EOK) {
+        goto done;
+    }
+
     value.type = HASH_VALUE_PTR;
     value.ptr = renew_data;
 
@@ -625,6 +837,15 @@ errno_t add_tgt_to_renew_table(struct krb5_ctx *krb5_ctx, const char *ccfile,
           "Added [%s] for renewal at [%.24s].\n", renew_data->ccfile,
                                            ctime(&renew_data->start_renew_at));
 
+    /* Renew earlier than currently scheduled if needed, unless the timer is
+     * disabled because we are offline */
+    if (krb5_ctx->renew_tgt_ctx->te != NULL) {
+        ret = renew_schedule(krb5_ctx->renew_tgt_ctx);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Failed to reschedule renewal timer.\n");
+        }
+    }
+
     ret = EOK;
 
 done:
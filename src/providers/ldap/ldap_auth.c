@@ -605,6 +605,256 @@ done:
     return ret;
 }
 
+/* ==Authentication-Connection-Pool======================================= */
+
+/* Connections used only to bind as users who are being authenticated are
+ * kept open for a while, so that the next user can be authenticated without
+ * a new TCP connection and TLS handshake. A bind replaces the authentication
+ * state of the connection, so nothing is carried over from one user to the
+ * next. */
+
+struct sdap_auth_pool_conn {
+    struct sdap_auth_pool_conn *prev;
+    struct sdap_auth_pool_conn *next;
+
+    struct sdap_auth_pool *pool;
+    struct sdap_service *service;
+    char *uri;
+    struct sdap_handle *sh;
+};
+
+struct sdap_auth_pool {
+    struct sdap_auth_pool_conn *conns;
+    int num_conns;
+
+    /* new connections including the TLS handshake */
+    uint64_t connects;
+    /* binds on a pooled connection, each one saved a handshake */
+    uint64_t reused;
+    /* connections that could not be returned to the pool */
+    uint64_t discarded;
+    /* pooled connections closed after being idle */
+    uint64_t expired;
+};
+
+static int sdap_auth_pool_conn_destructor(struct sdap_auth_pool_conn *conn)
+{
+    DLIST_REMOVE(conn->pool->conns, conn);
+    conn->pool->num_conns--;
+
+    return 0;
+}
+
+static void sdap_auth_pool_flush(struct sdap_auth_ctx *ctx, const char *uri);
+
+/* Going offline or switching to another server means the pooled
+ * connections either do not work anymore or point to a server we do not
+ * want to use. */
+static void sdap_auth_pool_be_offline_cb(void *pvt)
+{
+    struct sdap_auth_ctx *ctx = talloc_get_type(pvt, struct sdap_auth_ctx);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Closing pooled authentication connections, "
+          "going offline\n");
+    sdap_auth_pool_flush(ctx, NULL);
+}
+
+static void sdap_auth_pool_fo_reconnect_cb(void *pvt)
+{
+    struct sdap_auth_ctx *ctx = talloc_get_type(pvt, struct sdap_auth_ctx);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Closing pooled authentication connections, "
+          "reconnecting to another server\n");
+    sdap_auth_pool_flush(ctx, NULL);
+}
+
+static struct sdap_auth_pool *sdap_auth_pool_get_ctx(struct sdap_auth_ctx *ctx)
+{
+    struct sdap_auth_pool *pool;
+    errno_t ret;
+
+    if (dp_opt_get_int(ctx->opts->basic, SDAP_AUTH_POOL_SIZE) <= 0) {
+        return NULL;
+    }
+
+    if (ctx->pool != NULL) {
+        return ctx->pool;
+    }
+
+    pool = talloc_zero(ctx, struct sdap_auth_pool);
+    if (pool == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create connection pool\n");
+        return NULL;
+    }
+
+    ret = be_add_offline_cb(pool, ctx->be, sdap_auth_pool_be_offline_cb,
+                            ctx, NULL);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "be_add_offline_cb failed.\n");
+        talloc_free(pool);
+        return NULL;
+    }
+
+    ret = be_add_reconnect_cb(pool, ctx->be, sdap_auth_pool_fo_reconnect_cb,
+                              ctx, NULL);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "be_add_reconnect_cb failed.\n");
+        talloc_free(pool);
+        return NULL;
+    }
+
+    ctx->pool = pool;
+    return ctx->pool;
+}
+
+static void sdap_auth_pool_debug(struct sdap_auth_pool *pool)
+{
+    DEBUG(SSSDBG_TRACE_FUNC, "Authentication connections: %d pooled, "
+          "%"PRIu64" established, %"PRIu64" reused, %"PRIu64" discarded, "
+          "%"PRIu64" expired\n", pool->num_conns, pool->connects,
+          pool->reused, pool->discarded, pool->expired);
+}
+
+static struct sdap_handle *
+sdap_auth_pool_take(TALLOC_CTX *mem_ctx,
+                     struct sdap_auth_ctx *ctx,
+                     struct sdap_service *service,
+                     char **_uri)
+{
+    struct sdap_auth_pool_conn *conn;
+    struct sdap_auth_pool_conn *next;
+    struct sdap_auth_pool *pool;
+    struct sdap_handle *sh;
+
+    pool = sdap_auth_pool_get_ctx(ctx);
+    if (pool == NULL || service->uri == NULL) {
+        return NULL;
+    }
+
+    for (conn = pool->conns; conn != NULL; conn = next) {
+        next = conn->next;
+
+        if (!conn->sh->connected) {
+            /* closed by the server while idle */
+            pool->discarded++;
+            talloc_free(conn);
+            continue;
+        }
+
+        if (conn->service != service) {
+            continue;
+        }
+
+        if (strcmp(conn->uri, service->uri) != 0) {
+            /* fail over moved to another server meanwhile */
+            pool->discarded++;
+            talloc_free(conn);
+            continue;
+        }
+
+        sh = talloc_steal(mem_ctx, conn->sh);
+        *_uri = talloc_steal(mem_ctx, conn->uri);
+        talloc_free(conn);
+
+        pool->reused++;
+        sdap_auth_pool_debug(pool);
+        return sh;
+    }
+
+    return NULL;
+}
+
+static void sdap_auth_pool_idle(struct tevent_context *ev,
+                                struct tevent_timer *te,
+                                struct timeval tv,
+                                void *pvt)
+{
+    struct sdap_auth_pool_conn *conn;
+
+    conn = talloc_get_type(pvt, struct sdap_auth_pool_conn);
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Closing idle connection to [%s]\n",
+          conn->uri);
+
+    conn->pool->expired++;
+    talloc_free(conn);
+}
+
+static errno_t sdap_auth_pool_put(struct sdap_auth_ctx *ctx,
+                                  struct sdap_service *service,
+                                  const char *uri,
+                                  struct sdap_handle *sh)
+{
+    struct sdap_auth_pool_conn *conn;
+    struct sdap_auth_pool *pool;
+    struct tevent_timer *te;
+    int idle_timeout;
+
+    pool = sdap_auth_pool_get_ctx(ctx);
+    if (pool == NULL) {
+        return EINVAL;
+    }
+
+    if (uri == NULL || !sh->connected
+            || pool->num_conns
+                >= dp_opt_get_int(ctx->opts->basic, SDAP_AUTH_POOL_SIZE)) {
+        pool->discarded++;
+        return EBUSY;
+    }
+
+    conn = talloc_zero(pool, struct sdap_auth_pool_conn);
+    if (conn == NULL) {
+        return ENOMEM;
+    }
+
+    conn->pool = pool;
+    conn->service = service;
+    conn->uri = talloc_strdup(conn, uri);
+    if (conn->uri == NULL) {
+        talloc_free(conn);
+        return ENOMEM;
+    }
+
+    idle_timeout = dp_opt_get_int(ctx->opts->basic,
+                                  SDAP_AUTH_POOL_IDLE_TIMEOUT);
+    if (idle_timeout > 0) {
+        te = tevent_add_timer(ctx->be->ev, conn,
+                              tevent_timeval_current_ofs(idle_timeout, 0),
+                              sdap_auth_pool_idle, conn);
+        if (te == NULL) {
+            talloc_free(conn);
+            return ENOMEM;
+        }
+    }
+
+    conn->sh = talloc_steal(conn, sh);
+    DLIST_ADD(pool->conns, conn);
+    pool->num_conns++;
+    talloc_set_destructor(conn, sdap_auth_pool_conn_destructor);
+
+    return EOK;
+}
+
+/* The server went away, the other connections to it are most likely gone
+ * as well. If uri is NULL, all pooled connections are closed. */
+static void sdap_auth_pool_flush(struct sdap_auth_ctx *ctx, const char *uri)
+{
+    struct sdap_auth_pool_conn *conn;
+    struct sdap_auth_pool_conn *next;
+
+    if (ctx->pool == NULL) {
+        return;
+    }
+
+    for (conn = ctx->pool->conns; conn != NULL; conn = next) {
+        next = conn->next;
+        if (uri == NULL || strcmp(conn->uri, uri) == 0) {
+            ctx->pool->discarded++;
+            talloc_free(conn);
+        }
+    }
+}
+
 /* ==Authenticate-User==================================================== */
 
 struct auth_state {
@@ -613,26 +863,33 @@ struct auth_state {
     const char *username;
     struct sss_auth_token *authtok;
     struct sdap_service *sdap_service;
+    bool use_pool;
 
     struct sdap_handle *sh;
+    char *uri;
+    bool pooled;
 
     char *dn;
     enum pwexpire pw_expire_type;
     void *pw_expire_data;
 };
 
+static bool auth_reuse_conn(struct tevent_req *req);
 static struct tevent_req *auth_connect_send(struct tevent_req *req);
 static void auth_get_dn_done(struct tevent_req *subreq);
 static void auth_do_bind(struct tevent_req *req);
 static void auth_connect_done(struct tevent_req *subreq);
 static void auth_bind_user_done(struct tevent_req *subreq);
 
+/* If use_pool is true the caller must not ask auth_recv() for the
+ * connection, it may be handed over to the next authentication. */
 static struct tevent_req *auth_send(TALLOC_CTX *memctx,
                                     struct tevent_context *ev,
                                     struct sdap_auth_ctx *ctx,
                                     const char *username,
                                     struct sss_auth_token *authtok,
-                                    bool try_chpass_service)
+                                    bool try_chpass_service,
+                                    bool use_pool)
 {
     struct tevent_req *req;
     struct auth_state *state;
@@ -657,6 +914,7 @@ static struct tevent_req *auth_send(TALLOC_CTX *memctx,
     state->ctx = ctx;
     state->username = username;
     state->authtok = authtok;
+    state->use_pool = use_pool;
     if (try_chpass_service && ctx->chpass_service != NULL &&
         ctx->chpass_service->name != NULL) {
         state->sdap_service = ctx->chpass_service;
@@ -676,6 +934,14 @@ static struct tevent_req *auth_send(TALLOC_CTX *memctx,
         goto fail;
     }
 
+    if (auth_reuse_conn(req)) {
+        auth_do_bind(req);
+        if (!tevent_req_is_in_progress(req)) {
+            tevent_req_post(req, ev);
+        }
+        return req;
+    }
+
     if (auth_connect_send(req) == NULL) {
         ret = ENOMEM;
         goto fail;
@@ -689,6 +955,63 @@ fail:
     return req;
 }
 
+/* Only connections that are not authenticated on their own and are
+ * protected by TLS are pooled. */
+static bool auth_can_pool(struct auth_state *state)
+{
+    return state->use_pool && state->dn != NULL
+        && !dp_opt_get_bool(state->ctx->opts->basic, SDAP_DISABLE_AUTH_TLS);
+}
+
+static bool auth_reuse_conn(struct tevent_req *req)
+{
+    struct auth_state *state = tevent_req_data(req, struct auth_state);
+
+    if (!auth_can_pool(state)) {
+        return false;
+    }
+
+    state->sh = sdap_auth_pool_take(state, state->ctx, state->sdap_service,
+                                    &state->uri);
+    if (state->sh == NULL) {
+        return false;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Reusing connection to [%s] to authenticate "
+          "[%s]\n", state->uri, state->username);
+    state->pooled = true;
+    return true;
+}
+
+static void auth_release_conn(struct auth_state *state,
+                              errno_t ret,
+                              struct sdap_ppolicy_data *ppolicy)
+{
+    struct sdap_auth_pool *pool;
+
+    if (!auth_can_pool(state) || state->sh == NULL) {
+        return;
+    }
+
+    pool = sdap_auth_pool_get_ctx(state->ctx);
+    if (pool == NULL) {
+        return;
+    }
+
+    /* Only a plain success or wrong password leaves the connection in a
+     * well-known state. With a password policy response the server may
+     * restrict what the connection is allowed to do. */
+    if ((ret != EOK && ret != ERR_AUTH_FAILED) || ppolicy != NULL) {
+        pool->discarded++;
+        return;
+    }
+
+    if (sdap_auth_pool_put(state->ctx, state->sdap_service, state->uri,
+                           state->sh) == EOK) {
+        state->sh = NULL;
+    }
+}
+
 static struct tevent_req *auth_connect_send(struct tevent_req *req)
 {
     struct tevent_req *subreq;
@@ -784,6 +1107,7 @@ static void auth_connect_done(struct tevent_req *subreq)
                                                     struct auth_state);
     int ret;
 
+    state->pooled = false;
     ret = sdap_cli_connect_recv(subreq, state, NULL, &state->sh, NULL);
     talloc_zfree(subreq);
     if (ret != EOK) {
@@ -813,6 +1137,14 @@ static void auth_connect_done(struct tevent_req *subreq)
         return;
     }
 
+    if (auth_can_pool(state)) {
+        talloc_free(state->uri);
+        state->uri = talloc_strdup(state, state->sdap_service->uri);
+        if (state->ctx->pool != NULL) {
+            state->ctx->pool->connects++;
+        }
+    }
+
     if (state->dn == NULL) {
         /* The cached user entry was missing the bind DN. Need to look
          * it up based on user name in order to perform the bind */
@@ -891,15 +1223,29 @@ static void auth_bind_user_done(struct tevent_req *subreq)
         break;
     case ETIMEDOUT:
     case ERR_NETWORK_IO:
+        if (state->pooled) {
+            DEBUG(SSSDBG_TRACE_FUNC, "Pooled connection to [%s] failed\n",
+                  state->uri);
+            sdap_auth_pool_flush(state->ctx, state->uri);
+        }
+
+        /* The broken connection must neither be pooled nor linger until
+         * the request is done. */
+        auth_release_conn(state, ret, ppolicy);
+        talloc_zfree(state->sh);
+        state->pooled = false;
+
         if (auth_connect_send(req) == NULL) {
             tevent_req_error(req, ENOMEM);
         }
         return;
     default:
+        auth_release_conn(state, ret, ppolicy);
         tevent_req_error(req, ret);
         return;
     }
 
+    auth_release_conn(state, ret, ppolicy);
     tevent_req_done(req);
 }
 
@@ -961,7 +1307,7 @@ sdap_pam_auth_handler_send(TALLOC_CTX *mem_ctx,
     switch (pd->cmd) {
     case SSS_PAM_AUTHENTICATE:
         subreq = auth_send(state, params->ev, auth_ctx,
-                           pd->user, pd->authtok, false);
+                           pd->user, pd->authtok, false, true);
         if (subreq == NULL) {
             pd->pam_status = PAM_SYSTEM_ERR;
             goto immediately;
@@ -971,7 +1317,7 @@ sdap_pam_auth_handler_send(TALLOC_CTX *mem_ctx,
         break;
     case SSS_PAM_CHAUTHTOK_PRELIM:
         subreq = auth_send(state, params->ev, auth_ctx,
-                           pd->user, pd->authtok, true);
+                           pd->user, pd->authtok, true, false);
         if (subreq == NULL) {
             pd->pam_status = PAM_SYSTEM_ERR;
             goto immediately;
@@ -1291,7 +1637,7 @@ sdap_pam_chpass_handler_send(TALLOC_CTX *mem_ctx,
     }
 
     subreq = auth_send(state, params->ev, auth_ctx,
-                       pd->user, pd->authtok, true);
+                       pd->user, pd->authtok, true, false);
     if (subreq == NULL) {
         pd->pam_status = PAM_SYSTEM_ERR;
         goto immediately;
@@ -47,6 +47,13 @@ extern int ldap_child_debug_fd;
 
 struct sdap_id_ctx;
 
+struct sdap_id_conn_stats {
+    uint64_t lookups;
+    uint64_t found;
+    uint64_t total_usec;
+    uint64_t max_usec;
+};
+
 struct sdap_id_conn_ctx {
     struct sdap_id_ctx *id_ctx;
 
@@ -59,6 +66,8 @@ struct sdap_id_conn_ctx {
     bool ignore_mark_offline;
     /* do not fall back to user lookups for mpg domains on this connection */
     bool no_mpg_user_fallback;
+    /* latency of account lookups done on this connection */
+    struct sdap_id_conn_stats stats;
 };
 
 struct sdap_id_ctx {
@@ -83,11 +92,16 @@ struct sdap_id_ctx {
     struct timeval last_purge;
 };
 
+struct sdap_auth_pool;
+
 struct sdap_auth_ctx {
     struct be_ctx *be;
     struct sdap_options *opts;
     struct sdap_service *service;
     struct sdap_service *chpass_service;
+
+    /* Idle connections for user binds, see ldap_auth_pool_size */
+    struct sdap_auth_pool *pool;
 };
 
 struct tevent_req *
@@ -269,9 +283,17 @@ errno_t ldap_id_enumeration_recv(struct tevent_req *req);
 errno_t ldap_id_setup_cleanup(struct sdap_id_ctx *id_ctx,
                               struct sdap_domain *sdom);
 
+/* Remove expired entries from the cache in one go */
 errno_t ldap_id_cleanup(struct sdap_id_ctx *id_ctx,
                         struct sdap_domain *sdom);
 
+/* Same as ldap_id_cleanup(), but return to the event loop regularly */
+struct tevent_req *ldap_id_cleanup_send(TALLOC_CTX *mem_ctx,
+                                        struct tevent_context *ev,
+                                        struct sdap_id_ctx *ctx,
+                                        struct sdap_domain *sdom);
+errno_t ldap_id_cleanup_recv(struct tevent_req *req);
+
 struct tevent_req *groups_get_send(TALLOC_CTX *memctx,
                                    struct tevent_context *ev,
                                    struct sdap_id_ctx *ctx,
@@ -38,16 +38,18 @@ struct ldap_id_cleanup_ctx {
     struct sdap_domain *sdom;
 };
 
-static errno_t ldap_cleanup_task(TALLOC_CTX *mem_ctx,
-                                 struct tevent_context *ev,
-                                 struct be_ctx *be_ctx,
-                                 struct be_ptask *be_ptask,
-                                 void *pvt)
+static struct tevent_req *
+ldap_cleanup_task_send(TALLOC_CTX *mem_ctx,
+                       struct tevent_context *ev,
+                       struct be_ctx *be_ctx,
+                       struct be_ptask *be_ptask,
+                       void *pvt)
 {
     struct ldap_id_cleanup_ctx *cleanup_ctx = NULL;
 
     cleanup_ctx = talloc_get_type(pvt, struct ldap_id_cleanup_ctx);
-    return ldap_id_cleanup(cleanup_ctx->ctx, cleanup_ctx->sdom);
+    return ldap_id_cleanup_send(mem_ctx, ev, cleanup_ctx->ctx,
+                                cleanup_ctx->sdom);
 }
 
 errno_t ldap_id_setup_cleanup(struct sdap_id_ctx *id_ctx,
@@ -67,6 +69,14 @@ errno_t ldap_id_setup_cleanup(struct sdap_id_ctx *id_ctx,
         goto done;
     }
 
+    /* cleanup_users() needs to know which users are logged in, avoid
+     * scanning /proc every time if possible. */
+    ret = find_uid_tracker_setup(id_ctx->be, id_ctx->be->ev);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Active users will be found by scanning "
+              "/proc\n");
+    }
+
     /* Run the first one in a couple of seconds so that we have time to
      * finish initializations first. */
     first_delay = 10;
@@ -85,12 +95,12 @@ errno_t ldap_id_setup_cleanup(struct sdap_id_ctx *id_ctx,
         return ENOMEM;
     }
 
-    ret = be_ptask_create_sync(id_ctx, id_ctx->be, period, first_delay,
-                               5 /* enabled delay */, 0 /* random offset */,
-                               period /* timeout */, 0,
-                               ldap_cleanup_task, cleanup_ctx, name,
-                               BE_PTASK_OFFLINE_SKIP,
-                               &id_ctx->task);
+    ret = be_ptask_create(id_ctx, id_ctx->be, period, first_delay,
+                          5 /* enabled delay */, 0 /* random offset */,
+                          period /* timeout */, 0,
+                          ldap_cleanup_task_send, ldap_id_cleanup_recv,
+                          cleanup_ctx, name, BE_PTASK_OFFLINE_SKIP,
+                          &id_ctx->task);
     if (ret != EOK) {
         DEBUG(SSSDBG_FATAL_FAILURE, "Unable to initialize cleanup periodic "
                                      "task for %s\n", sdom->dom->name);
@@ -108,57 +118,416 @@ done:
     return ret;
 }
 
-static int cleanup_users(struct sdap_options *opts,
-                         struct sss_domain_info *dom);
-static int cleanup_groups(TALLOC_CTX *memctx,
-                          struct sysdb_ctx *sysdb,
-                          struct sss_domain_info *domain);
+/* ==Cleanup-Sweep======================================================== */
+
+/* The cache of a large domain can contain hundreds of thousands of expired
+ * entries. Instead of removing all of them in one transaction, the sweep
+ * removes them in chunks, oldest first. The asynchronous sweep processes
+ * chunks only for a limited time and then returns to the event loop, so
+ * that lookups are not blocked while the cleanup is running. */
+
+/* Number of entries processed in one sysdb transaction */
+#define CLEANUP_CHUNK_SIZE 50
+/* How long one slice of the sweep may keep the event loop busy */
+#define CLEANUP_SLICE_USEC (50 * 1000)
+/* Pause between two slices to let the event loop serve other requests */
+#define CLEANUP_PAUSE_USEC (10 * 1000)
+
+enum cleanup_phase {
+    CLEANUP_PHASE_USERS,
+    CLEANUP_PHASE_GROUPS,
+    CLEANUP_PHASE_DONE,
+};
 
-errno_t ldap_id_cleanup(struct sdap_id_ctx *ctx,
-                        struct sdap_domain *sdom)
+struct cleanup_sweep {
+    struct sdap_id_ctx *ctx;
+    struct sss_domain_info *dom;
+
+    enum cleanup_phase phase;
+    bool phase_started;
+    /* slice in which the candidates of the current phase were found */
+    unsigned int phase_slice;
+    unsigned int slices;
+
+    /* candidates of the current phase, ordered by expiration time */
+    struct ldb_message **msgs;
+    size_t count;
+    size_t next;
+
+    hash_table_t *uid_table;
+
+    struct timeval start;
+    size_t users_found;
+    size_t users_deleted;
+    size_t groups_found;
+    size_t groups_deleted;
+};
+
+static int search_expired_users(TALLOC_CTX *mem_ctx,
+                                struct sdap_options *opts,
+                                struct sss_domain_info *dom,
+                                size_t *_count,
+                                struct ldb_message ***_msgs);
+static int search_expired_groups(TALLOC_CTX *mem_ctx,
+                                 struct sss_domain_info *domain,
+                                 size_t *_count,
+                                 struct ldb_message ***_msgs);
+static int cleanup_user(struct cleanup_sweep *sweep,
+                        struct ldb_message *msg);
+static int cleanup_group(struct cleanup_sweep *sweep,
+                         struct ldb_message *msg);
+
+static int cleanup_cmp_expire(const void *a, const void *b)
 {
-    int ret, tret;
-    bool in_transaction = false;
-    TALLOC_CTX *tmp_ctx;
+    struct ldb_message *msg_a = *(struct ldb_message * const *) a;
+    struct ldb_message *msg_b = *(struct ldb_message * const *) b;
+    uint64_t expire_a;
+    uint64_t expire_b;
+
+    expire_a = ldb_msg_find_attr_as_uint64(msg_a, SYSDB_CACHE_EXPIRE, 0);
+    expire_b = ldb_msg_find_attr_as_uint64(msg_b, SYSDB_CACHE_EXPIRE, 0);
+
+    if (expire_a < expire_b) {
+        return -1;
+    } else if (expire_a > expire_b) {
+        return 1;
+    }
 
-    tmp_ctx = talloc_new(NULL);
-    if (tmp_ctx == NULL) {
-        return ENOMEM;
+    return 0;
+}
+
+static errno_t cleanup_sweep_start_phase(struct cleanup_sweep *sweep)
+{
+    errno_t ret;
+
+    talloc_zfree(sweep->msgs);
+    sweep->count = 0;
+    sweep->next = 0;
+
+    switch (sweep->phase) {
+    case CLEANUP_PHASE_USERS:
+        ret = search_expired_users(sweep, sweep->ctx->opts, sweep->dom,
+                                   &sweep->count, &sweep->msgs);
+        if (ret != EOK) {
+            return ret;
+        }
+        DEBUG(SSSDBG_FUNC_DATA, "Found %zu expired user entries!\n",
+              sweep->count);
+        sweep->users_found = sweep->count;
+
+        if (sweep->count > 0) {
+            ret = get_uid_table(sweep, &sweep->uid_table);
+            /* get_uid_table returns ENOSYS on non-Linux platforms. We
+             * proceed with the cleanup in that case
+             */
+            if (ret != EOK && ret != ENOSYS) {
+                DEBUG(SSSDBG_CRIT_FAILURE, "get_uid_table failed: %d\n", ret);
+                return ret;
+            }
+        }
+        break;
+    case CLEANUP_PHASE_GROUPS:
+        /* Groups are searched only now because removing users marks their
+         * groups as expired. */
+        ret = search_expired_groups(sweep, sweep->dom,
+                                    &sweep->count, &sweep->msgs);
+        if (ret != EOK) {
+            return ret;
+        }
+        DEBUG(SSSDBG_FUNC_DATA, "Found %zu expired group entries!\n",
+              sweep->count);
+        sweep->groups_found = sweep->count;
+        break;
+    case CLEANUP_PHASE_DONE:
+        break;
     }
 
-    ret = sysdb_transaction_start(sdom->dom->sysdb);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
-        goto done;
+    if (sweep->count > 1) {
+        qsort(sweep->msgs, sweep->count, sizeof(struct ldb_message *),
+              cleanup_cmp_expire);
     }
-    in_transaction = true;
 
-    ret = cleanup_users(ctx->opts, sdom->dom);
-    if (ret && ret != ENOENT) {
-        goto done;
+    sweep->phase_started = true;
+    sweep->phase_slice = sweep->slices;
+    return EOK;
+}
+
+/* Process the next chunk of candidates */
+static errno_t cleanup_sweep_step(struct cleanup_sweep *sweep)
+{
+    struct sysdb_ctx *sysdb = sweep->dom->sysdb;
+    bool in_transaction = false;
+    size_t end;
+    errno_t ret;
+    errno_t tret;
+
+    if (!sweep->phase_started) {
+        return cleanup_sweep_start_phase(sweep);
     }
 
-    ret = cleanup_groups(tmp_ctx, sdom->dom->sysdb, sdom->dom);
-    if (ret) {
-        goto done;
+    if (sweep->next < sweep->count) {
+        ret = sysdb_transaction_start(sysdb);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
+            goto done;
+        }
+        in_transaction = true;
+
+        end = MIN(sweep->next + CLEANUP_CHUNK_SIZE, sweep->count);
+        for (; sweep->next < end; sweep->next++) {
+            if (sweep->phase == CLEANUP_PHASE_USERS) {
+                ret = cleanup_user(sweep, sweep->msgs[sweep->next]);
+            } else {
+                ret = cleanup_group(sweep, sweep->msgs[sweep->next]);
+            }
+            if (ret != EOK) {
+                goto done;
+            }
+        }
+
+        ret = sysdb_transaction_commit(sysdb);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
+            goto done;
+        }
+        in_transaction = false;
     }
 
-    ret = sysdb_transaction_commit(sdom->dom->sysdb);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
-        goto done;
+    if (sweep->next == sweep->count) {
+        sweep->phase++;
+        sweep->phase_started = false;
+        talloc_zfree(sweep->msgs);
+        talloc_zfree(sweep->uid_table);
     }
-    in_transaction = false;
 
-    ctx->last_purge = tevent_timeval_current();
     ret = EOK;
+
 done:
     if (in_transaction) {
-        tret = sysdb_transaction_cancel(sdom->dom->sysdb);
+        tret = sysdb_transaction_cancel(sysdb);
         if (tret != EOK) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Could not cancel transaction\n");
         }
     }
+
+    return ret;
+}
+
+static void cleanup_sweep_finish(struct cleanup_sweep *sweep)
+{
+    struct timeval now;
+    long duration;
+
+    now = tevent_timeval_current();
+    sweep->ctx->last_purge = now;
+
+    duration = (now.tv_sec - sweep->start.tv_sec) * 1000
+               + (now.tv_usec - sweep->start.tv_usec) / 1000;
+
+    DEBUG(SSSDBG_FUNC_DATA, "Cleanup of [%s] finished in %ld ms in %u "
+          "slices: removed %zu of %zu expired users and %zu of %zu expired "
+          "groups\n", sweep->dom->name, duration, sweep->slices,
+          sweep->users_deleted, sweep->users_found,
+          sweep->groups_deleted, sweep->groups_found);
+}
+
+static errno_t cleanup_sweep_init(TALLOC_CTX *mem_ctx,
+                                  struct sdap_id_ctx *ctx,
+                                  struct sdap_domain *sdom,
+                                  struct cleanup_sweep **_sweep)
+{
+    struct cleanup_sweep *sweep;
+
+    sweep = talloc_zero(mem_ctx, struct cleanup_sweep);
+    if (sweep == NULL) {
+        return ENOMEM;
+    }
+
+    sweep->ctx = ctx;
+    sweep->dom = sdom->dom;
+    sweep->phase = CLEANUP_PHASE_USERS;
+    sweep->start = tevent_timeval_current();
+
+    *_sweep = sweep;
+    return EOK;
+}
+
+errno_t ldap_id_cleanup(struct sdap_id_ctx *ctx,
+                        struct sdap_domain *sdom)
+{
+    struct cleanup_sweep *sweep;
+    errno_t ret;
+
+    ret = cleanup_sweep_init(NULL, ctx, sdom, &sweep);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    while (sweep->phase != CLEANUP_PHASE_DONE) {
+        ret = cleanup_sweep_step(sweep);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    cleanup_sweep_finish(sweep);
+    ret = EOK;
+
+done:
+    talloc_free(sweep);
+    return ret;
+}
+
+struct ldap_id_cleanup_state {
+    struct tevent_context *ev;
+    struct cleanup_sweep *sweep;
+};
+
+static void ldap_id_cleanup_slice(struct tevent_context *ev,
+                                  struct tevent_timer *te,
+                                  struct timeval current_time,
+                                  void *pvt);
+
+struct tevent_req *ldap_id_cleanup_send(TALLOC_CTX *mem_ctx,
+                                        struct tevent_context *ev,
+                                        struct sdap_id_ctx *ctx,
+                                        struct sdap_domain *sdom)
+{
+    struct ldap_id_cleanup_state *state;
+    struct tevent_timer *te;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct ldap_id_cleanup_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    state->ev = ev;
+
+    ret = cleanup_sweep_init(state, ctx, sdom, &state->sweep);
+    if (ret != EOK) {
+        goto immediately;
+    }
+
+    te = tevent_add_timer(ev, state, tevent_timeval_current(),
+                          ldap_id_cleanup_slice, req);
+    if (te == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    return req;
+
+immediately:
+    tevent_req_error(req, ret);
+    tevent_req_post(req, ev);
+    return req;
+}
+
+static void ldap_id_cleanup_slice(struct tevent_context *ev,
+                                  struct tevent_timer *te,
+                                  struct timeval current_time,
+                                  void *pvt)
+{
+    struct ldap_id_cleanup_state *state;
+    struct cleanup_sweep *sweep;
+    struct tevent_req *req;
+    struct timeval deadline;
+    struct timeval now;
+    errno_t ret;
+
+    req = talloc_get_type(pvt, struct tevent_req);
+    state = tevent_req_data(req, struct ldap_id_cleanup_state);
+    sweep = state->sweep;
+
+    sweep->slices++;
+    deadline = tevent_timeval_current_ofs(0, CLEANUP_SLICE_USEC);
+
+    do {
+        ret = cleanup_sweep_step(sweep);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Cleanup of [%s] failed [%d]: %s\n",
+                  sweep->dom->name, ret, sss_strerror(ret));
+            tevent_req_error(req, ret);
+            return;
+        }
+
+        if (sweep->phase == CLEANUP_PHASE_DONE) {
+            cleanup_sweep_finish(sweep);
+            tevent_req_done(req);
+            return;
+        }
+
+        now = tevent_timeval_current();
+    } while (tevent_timeval_compare(&now, &deadline) < 0);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Cleanup of [%s]: %zu of %zu expired %s "
+          "processed, %zu users and %zu groups removed so far\n",
+          sweep->dom->name, sweep->next, sweep->count,
+          sweep->phase == CLEANUP_PHASE_USERS ? "users" : "groups",
+          sweep->users_deleted, sweep->groups_deleted);
+
+    te = tevent_add_timer(ev, state,
+                          tevent_timeval_current_ofs(0, CLEANUP_PAUSE_USEC),
+                          ldap_id_cleanup_slice, req);
+    if (te == NULL) {
+        tevent_req_error(req, ENOMEM);
+        return;
+    }
+}
+
+errno_t ldap_id_cleanup_recv(struct tevent_req *req)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
+/* The sweep can span several iterations of the event loop. An entry found
+ * in an earlier one might have been refreshed or removed meanwhile. */
+static errno_t cleanup_candidate_valid(struct cleanup_sweep *sweep,
+                                       struct ldb_message *candidate,
+                                       const char *name,
+                                       bool *_valid)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char *attrs[] = { SYSDB_CACHE_EXPIRE, NULL };
+    struct ldb_message *msg;
+    errno_t ret;
+
+    if (sweep->phase_slice == sweep->slices) {
+        *_valid = true;
+        return EOK;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    if (sweep->phase == CLEANUP_PHASE_USERS) {
+        ret = sysdb_search_user_by_name(tmp_ctx, sweep->dom, name, attrs,
+                                        &msg);
+    } else {
+        ret = sysdb_search_group_by_name(tmp_ctx, sweep->dom, name, attrs,
+                                         &msg);
+    }
+    if (ret == ENOENT) {
+        *_valid = false;
+        ret = EOK;
+        goto done;
+    } else if (ret != EOK) {
+        goto done;
+    }
+
+    *_valid = ldb_dn_compare(msg->dn, candidate->dn) == 0
+              && ldb_msg_find_attr_as_uint64(msg, SYSDB_CACHE_EXPIRE, 0)
+                 == ldb_msg_find_attr_as_uint64(candidate, SYSDB_CACHE_EXPIRE,
+                                                0);
+    ret = EOK;
+
+done:
     talloc_free(tmp_ctx);
     return ret;
 }
@@ -172,21 +541,22 @@ static int cleanup_users_logged_in(hash_table_t *table,
 static errno_t expire_memberof_target_groups(struct sss_domain_info *dom,
                                              struct ldb_message *user);
 
-static int cleanup_users(struct sdap_options *opts,
-                         struct sss_domain_info *dom)
+static int search_expired_users(TALLOC_CTX *mem_ctx,
+                                struct sdap_options *opts,
+                                struct sss_domain_info *dom,
+                                size_t *_count,
+                                struct ldb_message ***_msgs)
 {
     TALLOC_CTX *tmpctx;
-    const char *attrs[] = { SYSDB_NAME, SYSDB_UIDNUM, SYSDB_MEMBEROF, NULL };
+    const char *attrs[] = { SYSDB_NAME, SYSDB_UIDNUM, SYSDB_MEMBEROF,
+                            SYSDB_CACHE_EXPIRE, NULL };
     time_t now = time(NULL);
     char *subfilter = NULL;
     char *ts_subfilter = NULL;
     int account_cache_expiration;
-    hash_table_t *uid_table;
     struct ldb_message **msgs;
     size_t count;
-    const char *name;
     int ret;
-    int i;
 
     tmpctx = talloc_new(NULL);
     if (!tmpctx) {
@@ -236,74 +606,81 @@ static int cleanup_users(struct sdap_options *opts,
                                           attrs, &count, &msgs);
     if (ret == ENOENT) {
         count = 0;
+        msgs = NULL;
     } else if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "sysdb_search_users failed: %d\n", ret);
         goto done;
     }
-    DEBUG(SSSDBG_FUNC_DATA, "Found %zu expired user entries!\n", count);
 
-    if (count == 0) {
-        ret = EOK;
-        goto done;
-    }
+    *_count = count;
+    *_msgs = talloc_steal(mem_ctx, msgs);
+    ret = EOK;
 
-    ret = get_uid_table(tmpctx, &uid_table);
-    /* get_uid_table returns ENOSYS on non-Linux platforms. We proceed with
-     * the cleanup in that case
-     */
-    if (ret != EOK && ret != ENOSYS) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "get_uid_table failed: %d\n", ret);
-        goto done;
-    }
+done:
+    talloc_zfree(tmpctx);
+    return ret;
+}
 
-    for (i = 0; i < count; i++) {
-        name = ldb_msg_find_attr_as_string(msgs[i], SYSDB_NAME, NULL);
-        if (!name) {
-            DEBUG(SSSDBG_OP_FAILURE, "Entry %s has no Name Attribute ?!?\n",
-                       ldb_dn_get_linearized(msgs[i]->dn));
-            ret = EFAULT;
-            goto done;
-        }
-        DEBUG(SSSDBG_TRACE_ALL, "Processing user %s\n", name);
-
-        if (uid_table) {
-            ret = cleanup_users_logged_in(uid_table, msgs[i]);
-            if (ret == EOK) {
-                /* If the user is logged in, proceed to the next one */
-                DEBUG(SSSDBG_FUNC_DATA,
-                      "User %s is still logged in or a dummy entry, "
-                          "keeping data\n", name);
-                continue;
-            } else if (ret != ENOENT) {
-                DEBUG(SSSDBG_CRIT_FAILURE,
-                      "Cannot check if user is logged in: %d\n", ret);
-                goto done;
-            }
-        }
+static int cleanup_user(struct cleanup_sweep *sweep,
+                        struct ldb_message *msg)
+{
+    const char *name;
+    bool valid;
+    int ret;
 
-        /* If not logged in or cannot check the table, delete him */
-        DEBUG(SSSDBG_TRACE_ALL, "About to delete user %s\n", name);
-        ret = sysdb_delete_user(dom, name, 0);
-        if (ret) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "sysdb_delete_user failed: %d\n", ret);
-            goto done;
-        }
+    name = ldb_msg_find_attr_as_string(msg, SYSDB_NAME, NULL);
+    if (!name) {
+        DEBUG(SSSDBG_OP_FAILURE, "Entry %s has no Name Attribute ?!?\n",
+                   ldb_dn_get_linearized(msg->dn));
+        return EFAULT;
+    }
+    DEBUG(SSSDBG_TRACE_ALL, "Processing user %s\n", name);
 
-        /* Mark all groups of which user was a member as expired in cache,
-         * so that its ghost/member attributes are refreshed on next
-         * request. */
-        ret = expire_memberof_target_groups(dom, msgs[i]);
-        if (ret != EOK && ret != ENOENT) {
+    ret = cleanup_candidate_valid(sweep, msg, name, &valid);
+    if (ret != EOK) {
+        return ret;
+    } else if (!valid) {
+        DEBUG(SSSDBG_TRACE_ALL, "User %s was refreshed, keeping data\n",
+              name);
+        return EOK;
+    }
+
+    if (sweep->uid_table) {
+        ret = cleanup_users_logged_in(sweep->uid_table, msg);
+        if (ret == EOK) {
+            /* If the user is logged in, proceed to the next one */
+            DEBUG(SSSDBG_FUNC_DATA,
+                  "User %s is still logged in or a dummy entry, "
+                      "keeping data\n", name);
+            return EOK;
+        } else if (ret != ENOENT) {
             DEBUG(SSSDBG_CRIT_FAILURE,
-                  "expire_memberof_target_groups failed: [%d]:%s\n",
-                  ret, sss_strerror(ret));
-            goto done;
+                  "Cannot check if user is logged in: %d\n", ret);
+            return ret;
         }
     }
 
-done:
-    talloc_zfree(tmpctx);
-    return ret;
+    /* If not logged in or cannot check the table, delete him */
+    DEBUG(SSSDBG_TRACE_ALL, "About to delete user %s\n", name);
+    ret = sysdb_delete_user(sweep->dom, name, 0);
+    if (ret) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "sysdb_delete_user failed: %d\n", ret);
+        return ret;
+    }
+    sweep->users_deleted++;
+
+    /* Mark all groups of which user was a member as expired in cache,
+     * so that its ghost/member attributes are refreshed on next
+     * request. */
+    ret = expire_memberof_target_groups(sweep->dom, msg);
+    if (ret != EOK && ret != ENOENT) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "expire_memberof_target_groups failed: [%d]:%s\n",
+              ret, sss_strerror(ret));
+        return ret;
+    }
+
+    return EOK;
 }
 
 static errno_t expire_memberof_target_groups(struct sss_domain_info *dom,
@@ -375,27 +752,22 @@ static int cleanup_users_logged_in(hash_table_t *table,
 
 /* ==Group-Cleanup-Process================================================ */
 
-static int cleanup_groups(TALLOC_CTX *memctx,
-                          struct sysdb_ctx *sysdb,
-                          struct sss_domain_info *domain)
+static int search_expired_groups(TALLOC_CTX *mem_ctx,
+                                 struct sss_domain_info *domain,
+                                 size_t *_count,
+                                 struct ldb_message ***_msgs)
 {
     TALLOC_CTX *tmpctx;
-    const char *attrs[] = { SYSDB_NAME, SYSDB_GIDNUM, NULL };
+    const char *attrs[] = { SYSDB_NAME, SYSDB_GIDNUM, SYSDB_CACHE_EXPIRE,
+                            NULL };
     time_t now = time(NULL);
     char *subfilter;
     char *ts_subfilter;
-    const char *dn;
-    gid_t gid;
     struct ldb_message **msgs;
     size_t count;
-    struct ldb_message **u_msgs;
-    size_t u_count;
     int ret;
-    int i;
-    const char *posix;
-    struct ldb_dn *base_dn;
 
-    tmpctx = talloc_new(memctx);
+    tmpctx = talloc_new(NULL);
     if (!tmpctx) {
         return ENOMEM;
     }
@@ -420,99 +792,131 @@ static int cleanup_groups(TALLOC_CTX *memctx,
                                            ts_subfilter, attrs, &count, &msgs);
     if (ret == ENOENT) {
         count = 0;
+        msgs = NULL;
     } else if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "sysdb_search_groups failed: %d\n", ret);
         goto done;
     }
 
-    DEBUG(SSSDBG_FUNC_DATA, "Found %zu expired group entries!\n", count);
+    *_count = count;
+    *_msgs = talloc_steal(mem_ctx, msgs);
+    ret = EOK;
+
+done:
+    talloc_zfree(tmpctx);
+    return ret;
+}
+
+static int cleanup_group(struct cleanup_sweep *sweep,
+                         struct ldb_message *msg)
+{
+    TALLOC_CTX *tmpctx;
+    /* Only the existence of members matters */
+    const char *u_attrs[] = { SYSDB_NAME, NULL };
+    char *subfilter;
+    char *sanitized_dn;
+    const char *dn;
+    const char *name;
+    const char *posix;
+    gid_t gid;
+    struct ldb_message **u_msgs;
+    size_t u_count;
+    struct ldb_dn *base_dn;
+    bool valid;
+    int ret;
+
+    tmpctx = talloc_new(NULL);
+    if (!tmpctx) {
+        return ENOMEM;
+    }
+
+    name = ldb_msg_find_attr_as_string(msg, SYSDB_NAME, NULL);
+    if (!name) {
+        DEBUG(SSSDBG_OP_FAILURE, "Entry %s has no Name Attribute ?!?\n",
+                  ldb_dn_get_linearized(msg->dn));
+        ret = EFAULT;
+        goto done;
+    }
 
-    if (count == 0) {
+    ret = cleanup_candidate_valid(sweep, msg, name, &valid);
+    if (ret != EOK) {
+        goto done;
+    } else if (!valid) {
+        DEBUG(SSSDBG_TRACE_ALL, "Group %s was refreshed, keeping data\n",
+              name);
         ret = EOK;
         goto done;
     }
 
-    for (i = 0; i < count; i++) {
-        char *sanitized_dn;
-
-        dn = ldb_dn_get_linearized(msgs[i]->dn);
-        if (!dn) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "Cannot linearize DN!\n");
-            ret = EFAULT;
-            goto done;
-        }
-
-        /* sanitize dn */
-        ret = sss_filter_sanitize(tmpctx, dn, &sanitized_dn);
-        if (ret != EOK) {
-            DEBUG(SSSDBG_MINOR_FAILURE,
-                  "sss_filter_sanitize failed: %s:[%d]\n",
-                  sss_strerror(ret), ret);
-            goto done;
-        }
-
-        posix = ldb_msg_find_attr_as_string(msgs[i], SYSDB_POSIX, NULL);
-        if (!posix || strcmp(posix, "TRUE") == 0) {
-            /* Search for users that are members of this group, or
-             * that have this group as their primary GID.
-             * Include subdomain users as well.
-             */
-            gid = (gid_t) ldb_msg_find_attr_as_uint(msgs[i], SYSDB_GIDNUM, 0);
-            subfilter = talloc_asprintf(tmpctx, "(&(%s=%s)(|(%s=%s)(%s=%lu)))",
-                                        SYSDB_OBJECTCATEGORY, SYSDB_USER_CLASS,
-                                        SYSDB_MEMBEROF, sanitized_dn,
-                                        SYSDB_GIDNUM, (long unsigned) gid);
-        } else {
-            subfilter = talloc_asprintf(tmpctx, "(%s=%s)", SYSDB_MEMBEROF,
-                                        sanitized_dn);
-        }
-        talloc_zfree(sanitized_dn);
+    dn = ldb_dn_get_linearized(msg->dn);
+    if (!dn) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot linearize DN!\n");
+        ret = EFAULT;
+        goto done;
+    }
 
-        if (!subfilter) {
-            DEBUG(SSSDBG_OP_FAILURE, "Failed to build filter\n");
-            ret = ENOMEM;
-            goto done;
-        }
+    /* sanitize dn */
+    ret = sss_filter_sanitize(tmpctx, dn, &sanitized_dn);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "sss_filter_sanitize failed: %s:[%d]\n",
+              sss_strerror(ret), ret);
+        goto done;
+    }
 
-        base_dn = sysdb_base_dn(sysdb, tmpctx);
-        if (base_dn == NULL) {
-            DEBUG(SSSDBG_OP_FAILURE, "Failed to build base dn\n");
-            ret = ENOMEM;
-            goto done;
-        }
+    posix = ldb_msg_find_attr_as_string(msg, SYSDB_POSIX, NULL);
+    if (!posix || strcmp(posix, "TRUE") == 0) {
+        /* Search for users that are members of this group, or
+         * that have this group as their primary GID.
+         * Include subdomain users as well.
+         */
+        gid = (gid_t) ldb_msg_find_attr_as_uint(msg, SYSDB_GIDNUM, 0);
+        subfilter = talloc_asprintf(tmpctx, "(&(%s=%s)(|(%s=%s)(%s=%lu)))",
+                                    SYSDB_OBJECTCATEGORY, SYSDB_USER_CLASS,
+                                    SYSDB_MEMBEROF, sanitized_dn,
+                                    SYSDB_GIDNUM, (long unsigned) gid);
+    } else {
+        subfilter = talloc_asprintf(tmpctx, "(%s=%s)", SYSDB_MEMBEROF,
+                                    sanitized_dn);
+    }
+    talloc_zfree(sanitized_dn);
 
-        DEBUG(SSSDBG_TRACE_LIBS, "Searching with: %s\n", subfilter);
+    if (!subfilter) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to build filter\n");
+        ret = ENOMEM;
+        goto done;
+    }
 
-        ret = sysdb_search_entry(tmpctx, sysdb, base_dn,
-                                 LDB_SCOPE_SUBTREE, subfilter, NULL,
-                                 &u_count, &u_msgs);
-        if (ret == ENOENT) {
-            const char *name;
+    base_dn = sysdb_base_dn(sweep->dom->sysdb, tmpctx);
+    if (base_dn == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to build base dn\n");
+        ret = ENOMEM;
+        goto done;
+    }
 
-            name = ldb_msg_find_attr_as_string(msgs[i], SYSDB_NAME, NULL);
-            if (!name) {
-                DEBUG(SSSDBG_OP_FAILURE, "Entry %s has no Name Attribute ?!?\n",
-                          ldb_dn_get_linearized(msgs[i]->dn));
-                ret = EFAULT;
-                goto done;
-            }
+    DEBUG(SSSDBG_TRACE_LIBS, "Searching with: %s\n", subfilter);
 
-            DEBUG(SSSDBG_TRACE_INTERNAL, "About to delete group %s\n", name);
-            ret = sysdb_delete_group(domain, name, 0);
-            if (ret) {
-                DEBUG(SSSDBG_OP_FAILURE, "Group delete returned %d (%s)\n",
-                          ret, strerror(ret));
-                goto done;
-            }
-        } else if (ret != EOK) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Failed to search sysdb using %s: [%d] %s\n",
-                  subfilter, ret, sss_strerror(ret));
+    ret = sysdb_search_entry(tmpctx, sweep->dom->sysdb, base_dn,
+                             LDB_SCOPE_SUBTREE, subfilter, u_attrs,
+                             &u_count, &u_msgs);
+    if (ret == ENOENT) {
+        DEBUG(SSSDBG_TRACE_INTERNAL, "About to delete group %s\n", name);
+        ret = sysdb_delete_group(sweep->dom, name, 0);
+        if (ret) {
+            DEBUG(SSSDBG_OP_FAILURE, "Group delete returned %d (%s)\n",
+                      ret, strerror(ret));
             goto done;
         }
-        talloc_zfree(u_msgs);
+        sweep->groups_deleted++;
+    } else if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Failed to search sysdb using %s: [%d] %s\n",
+              subfilter, ret, sss_strerror(ret));
+        goto done;
     }
 
+    ret = EOK;
+
 done:
     talloc_zfree(tmpctx);
     return ret;
@@ -74,7 +74,7 @@ static errno_t ldap_init_auth_ctx(TALLOC_CTX *mem_ctx,
 {
     struct sdap_auth_ctx *auth_ctx;
 
-    auth_ctx = talloc(mem_ctx, struct sdap_auth_ctx);
+    auth_ctx = talloc_zero(mem_ctx, struct sdap_auth_ctx);
     if (auth_ctx == NULL) {
         return ENOMEM;
     }
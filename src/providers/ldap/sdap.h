@@ -238,6 +238,10 @@ enum sdap_basic_opt {
     SDAP_MAX_ID,
     SDAP_PWDLOCKOUT_DN,
     SDAP_WILDCARD_LIMIT,
+    SDAP_AUTH_POOL_SIZE,
+    SDAP_AUTH_POOL_IDLE_TIMEOUT,
+    SDAP_ACCESS_FILTER_CACHE_TIMEOUT,
+    SDAP_ACCESS_PPOLICY_CACHE_TIMEOUT,
 
     SDAP_OPTS_BASIC /* opts counter */
 };
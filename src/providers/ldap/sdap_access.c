@@ -58,6 +58,7 @@ static errno_t perform_pwexpire_policy(TALLOC_CTX *mem_ctx,
 static errno_t sdap_save_user_cache_bool(struct sss_domain_info *domain,
                                          const char *username,
                                          const char *attr_name,
+                                         const char *time_attr_name,
                                          bool value);
 
 static errno_t sdap_get_basedn_user_entry(struct ldb_message *user_entry,
@@ -99,6 +100,10 @@ static errno_t sdap_access_host(struct ldb_message *user_entry);
 
 errno_t sdap_access_rhost(struct ldb_message *user_entry, char *rhost);
 
+bool sdap_access_cached_result_valid(struct ldb_message *user_entry,
+                                     const char *time_attr,
+                                     int timeout);
+
 enum sdap_access_control_type {
     SDAP_ACCESS_CONTROL_FILTER,
     SDAP_ACCESS_CONTROL_PPOLICY_LOCK,
@@ -828,6 +833,10 @@ struct sdap_access_filter_req_ctx {
 };
 
 static errno_t sdap_access_decide_offline(bool cached_ac);
+static bool sdap_access_use_cached(enum sdap_access_control_type type,
+                                   struct ldb_message *user_entry,
+                                   const char *time_attr,
+                                   int timeout);
 static int sdap_access_filter_retry(struct tevent_req *req);
 static void sdap_access_ppolicy_connect_done(struct tevent_req *subreq);
 static errno_t sdap_access_ppolicy_get_lockout_step(struct tevent_req *req);
@@ -882,6 +891,14 @@ static struct tevent_req *sdap_access_filter_send(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    if (sdap_access_use_cached(SDAP_ACCESS_CONTROL_FILTER, user_entry,
+                               SYSDB_LDAP_ACCESS_FILTER_TIME,
+                               dp_opt_get_int(state->opts->basic,
+                                          SDAP_ACCESS_FILTER_CACHE_TIMEOUT))) {
+        ret = sdap_access_decide_offline(state->cached_access);
+        goto done;
+    }
+
     ret = sdap_get_basedn_user_entry(user_entry, state->username,
                                      &state->basedn);
     if (ret != EOK) {
@@ -958,6 +975,99 @@ static errno_t sdap_access_decide_offline(bool cached_ac)
     }
 }
 
+static const char *sdap_access_control_type_str[] = {
+    [SDAP_ACCESS_CONTROL_FILTER] = "filter",
+    [SDAP_ACCESS_CONTROL_PPOLICY_LOCK] = "ppolicy",
+};
+
+static struct {
+    uint64_t hits;
+    uint64_t misses;
+} sdap_access_cache_stats[SDAP_ACCESS_CONTROL_PPOLICY_LOCK + 1];
+
+/* Time of the last change of the user entry on the server */
+static errno_t sdap_access_user_modstamp(struct ldb_message *user_entry,
+                                         time_t *_modstamp)
+{
+    const char *modstamp;
+    errno_t ret;
+
+    modstamp = ldb_msg_find_attr_as_string(user_entry, SYSDB_ORIG_MODSTAMP,
+                                           NULL);
+    if (modstamp == NULL) {
+        return ENOENT;
+    }
+
+    /* Active Directory uses fractions of seconds */
+    ret = sss_utc_to_time_t(modstamp, "%Y%m%d%H%M%SZ", _modstamp);
+    if (ret != EOK) {
+        ret = sss_utc_to_time_t(modstamp, "%Y%m%d%H%M%S.0Z", _modstamp);
+    }
+
+    return ret;
+}
+
+/* true => the result of the last online check stored in the user entry is
+ * recent enough to be used instead of asking the server again */
+bool sdap_access_cached_result_valid(struct ldb_message *user_entry,
+                                     const char *time_attr,
+                                     int timeout)
+{
+    time_t stored;
+    time_t changed;
+    time_t now;
+    errno_t ret;
+
+    if (timeout <= 0) {
+        return false;
+    }
+
+    now = time(NULL);
+    stored = ldb_msg_find_attr_as_uint64(user_entry, time_attr, 0);
+    if (stored == 0 || stored > now || now - stored >= timeout) {
+        return false;
+    }
+
+    /* The user entry was refreshed meanwhile and has changed on the server
+     * after the result was stored. If the server does not provide the time
+     * of the last change, any refresh invalidates the result. */
+    ret = sdap_access_user_modstamp(user_entry, &changed);
+    if (ret != EOK) {
+        changed = ldb_msg_find_attr_as_uint64(user_entry, SYSDB_LAST_UPDATE,
+                                              0);
+    }
+
+    return changed < stored;
+}
+
+static bool sdap_access_use_cached(enum sdap_access_control_type type,
+                                   struct ldb_message *user_entry,
+                                   const char *time_attr,
+                                   int timeout)
+{
+    bool use_cached;
+
+    if (timeout <= 0) {
+        return false;
+    }
+
+    use_cached = sdap_access_cached_result_valid(user_entry, time_attr,
+                                                 timeout);
+    if (use_cached) {
+        sdap_access_cache_stats[type].hits++;
+    } else {
+        sdap_access_cache_stats[type].misses++;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "%s the cached %s result; %"PRIu64" hits, "
+          "%"PRIu64" misses\n", use_cached ? "Using" : "Not using",
+          sdap_access_control_type_str[type],
+          sdap_access_cache_stats[type].hits,
+          sdap_access_cache_stats[type].misses);
+
+    return use_cached;
+}
+
 static int sdap_access_filter_retry(struct tevent_req *req)
 {
     struct sdap_access_filter_req_ctx *state =
@@ -1103,7 +1213,8 @@ static void sdap_access_filter_done(struct tevent_req *subreq)
     }
 
     tret = sdap_save_user_cache_bool(state->domain, state->username,
-                                     SYSDB_LDAP_ACCESS_FILTER, found);
+                                     SYSDB_LDAP_ACCESS_FILTER,
+                                     SYSDB_LDAP_ACCESS_FILTER_TIME, found);
     if (tret != EOK) {
         /* Failing to save to the cache is non-fatal.
          * Just return the result.
@@ -1212,6 +1323,7 @@ static errno_t sdap_access_service(struct pam_data *pd,
 static errno_t sdap_save_user_cache_bool(struct sss_domain_info *domain,
                                          const char *username,
                                          const char *attr_name,
+                                         const char *time_attr_name,
                                          bool value)
 {
     errno_t ret;
@@ -1230,6 +1342,12 @@ static errno_t sdap_save_user_cache_bool(struct sss_domain_info *domain,
         goto done;
     }
 
+    ret = sysdb_attrs_add_time_t(attrs, time_attr_name, time(NULL));
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Could not set up attrs\n");
+        goto done;
+    }
+
     ret = sysdb_set_user_attr(domain, username, attrs, SYSDB_MOD_REP);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to set user access attribute\n");
@@ -1454,6 +1572,14 @@ sdap_access_ppolicy_send(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    if (sdap_access_use_cached(SDAP_ACCESS_CONTROL_PPOLICY_LOCK, user_entry,
+                               SYSDB_LDAP_ACCESS_CACHED_LOCKOUT_TIME,
+                               dp_opt_get_int(state->opts->basic,
+                                         SDAP_ACCESS_PPOLICY_CACHE_TIMEOUT))) {
+        ret = sdap_access_decide_offline(state->cached_access);
+        goto done;
+    }
+
     ret = sdap_get_basedn_user_entry(user_entry, state->username,
                                      &state->basedn);
     if (ret != EOK) {
@@ -1731,6 +1857,7 @@ static void sdap_access_ppolicy_get_lockout_done(struct tevent_req *subreq)
               "- storing 'access granted' in sysdb.\n");
         tret = sdap_save_user_cache_bool(state->domain, state->username,
                                          SYSDB_LDAP_ACCESS_CACHED_LOCKOUT,
+                                         SYSDB_LDAP_ACCESS_CACHED_LOCKOUT_TIME,
                                          true);
         if (tret != EOK) {
             /* Failing to save to the cache is non-fatal.
@@ -1997,6 +2124,7 @@ static void sdap_access_ppolicy_step_done(struct tevent_req *subreq)
      */
     tret = sdap_save_user_cache_bool(state->domain, state->username,
                                      SYSDB_LDAP_ACCESS_CACHED_LOCKOUT,
+                                     SYSDB_LDAP_ACCESS_CACHED_LOCKOUT_TIME,
                                      !locked);
 
     if (tret != EOK) {
@@ -33,6 +33,9 @@
  */
 #define SYSDB_LDAP_ACCESS_FILTER "ldap_access_filter_allow"
 #define SYSDB_LDAP_ACCESS_CACHED_LOCKOUT "ldap_access_lockout_allow"
+/* Time when the cached values above were stored */
+#define SYSDB_LDAP_ACCESS_FILTER_TIME "ldap_access_filter_time"
+#define SYSDB_LDAP_ACCESS_CACHED_LOCKOUT_TIME "ldap_access_lockout_time"
 /* names of ppolicy attributes */
 #define SYSDB_LDAP_ACCESS_LOCKED_TIME "pwdAccountLockedTime"
 #define SYSDB_LDAP_ACESS_LOCKOUT_DURATION "pwdLockoutDuration"
@@ -28,6 +28,7 @@
 #include "util/sss_ldap.h"
 #include "util/strtonum.h"
 #include "providers/ldap/sdap_async_private.h"
+#include "providers/ldap/sdap_tls_session.h"
 #include "providers/ldap/ldap_common.h"
 
 /* ==Connect-to-LDAP-Server=============================================== */
@@ -106,6 +107,14 @@ struct tevent_req *sdap_connect_send(TALLOC_CTX *memctx,
     state->sh->page_size = dp_opt_get_int(state->opts->basic,
                                           SDAP_PAGE_SIZE);
 
+    /* Must be in place before the first TLS handshake, including the one
+     * of ldaps:// connections in sss_ldap_init_send() */
+    ret = sdap_tls_session_cache_setup();
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to set up TLS session cache "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+    }
+
     timeout = dp_opt_get_int(state->opts->basic, SDAP_NETWORK_TIMEOUT);
 
     subreq = sss_ldap_init_send(state, ev, state->uri, sockaddr,
@@ -161,6 +170,11 @@ static void sdap_sys_connect_done(struct tevent_req *subreq)
         return;
     }
 
+    if (ldap_tls_inplace(state->sh->ldap)) {
+        /* ldaps:// */
+        sdap_tls_session_handshake_done(state->sh->ldap);
+    }
+
     ret = setup_ldap_connection_callbacks(state->sh, state->ev);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
@@ -419,11 +433,13 @@ static void sdap_connect_done(struct sdap_op *op,
                                  "Check for certificate issues.");
         }
 
+        sdap_tls_session_forget(state->sh->ldap);
         state->result = ret;
         tevent_req_error(req, EIO);
         return;
     }
 
+    sdap_tls_session_handshake_done(state->sh->ldap);
     tevent_req_done(req);
 }
 
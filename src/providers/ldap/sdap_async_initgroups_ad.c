@@ -251,6 +251,20 @@ done:
     return ret;
 }
 
+/* SIDs looked up by a single search */
+#define SDAP_AD_RESOLVE_SIDS_BATCH 50
+/* Searches that run at the same time */
+#define SDAP_AD_RESOLVE_SIDS_PARALLEL 4
+
+struct sdap_ad_resolve_sids_batch {
+    struct tevent_req *req;
+    struct sdap_domain *sdom;
+    struct sdap_id_op *op;
+    const char **sids;
+    size_t num_sids;
+    char *filter;
+};
+
 struct sdap_ad_resolve_sids_state {
     struct tevent_context *ev;
     struct sdap_id_ctx *id_ctx;
@@ -258,11 +272,39 @@ struct sdap_ad_resolve_sids_state {
     struct sdap_options *opts;
     struct sss_domain_info *domain;
     char **sids;
+    const char **attrs;
+
+    struct sdap_ad_resolve_sids_batch *batches;
+    size_t num_batches;
+    size_t next_batch;
+    size_t active;
+
+    /* SIDs the batched searches did not find, looked up one by one */
+    const char **missing_sids;
+    struct sdap_domain **missing_sdoms;
+    size_t num_missing;
 
     const char *current_sid;
-    int index;
+    size_t index;
+
+    struct timeval start;
+    struct timeval batches_done;
+    size_t num_domains;
 };
 
+static errno_t sdap_ad_resolve_sids_batches(struct tevent_req *req);
+static void sdap_ad_resolve_sids_issue(struct tevent_req *req);
+static errno_t
+sdap_ad_resolve_sids_batch_connect(struct sdap_ad_resolve_sids_batch *batch);
+static void sdap_ad_resolve_sids_connect_done(struct tevent_req *subreq);
+static void sdap_ad_resolve_sids_search_done(struct tevent_req *subreq);
+static void
+sdap_ad_resolve_sids_add_missing(struct sdap_ad_resolve_sids_state *state,
+                                 struct sdap_ad_resolve_sids_batch *batch,
+                                 bool searched);
+static void sdap_ad_resolve_sids_batch_done(struct tevent_req *req,
+                                            struct sdap_ad_resolve_sids_batch *batch,
+                                            bool searched);
 static errno_t sdap_ad_resolve_sids_step(struct tevent_req *req);
 static void sdap_ad_resolve_sids_done(struct tevent_req *subreq);
 
@@ -293,17 +335,28 @@ sdap_ad_resolve_sids_send(TALLOC_CTX *mem_ctx,
     state->domain = get_domains_head(domain);
     state->sids = sids;
     state->index = 0;
+    state->start = tevent_timeval_current();
 
     if (state->sids == NULL || state->sids[0] == NULL) {
         ret = EOK;
         goto immediately;
     }
 
-    ret = sdap_ad_resolve_sids_step(req);
-    if (ret != EAGAIN) {
+    ret = sdap_ad_resolve_sids_batches(req);
+    if (ret != EOK) {
         goto immediately;
     }
 
+    sdap_ad_resolve_sids_issue(req);
+    if (state->active == 0) {
+        /* no search could be started, look the SIDs up one by one */
+        state->batches_done = tevent_timeval_current();
+        ret = sdap_ad_resolve_sids_step(req);
+        if (ret != EAGAIN) {
+            goto immediately;
+        }
+    }
+
     return req;
 
 immediately:
@@ -317,36 +370,380 @@ immediately:
     return req;
 }
 
-static errno_t sdap_ad_resolve_sids_step(struct tevent_req *req)
+struct sdap_ad_resolve_sids_bucket {
+    struct sdap_domain *sdom;
+    const char **sids;
+    size_t num_sids;
+};
+
+/* Group the SIDs by the domain they belong to and split them into batches.
+ * The batches of different domains are interleaved so that the searches
+ * running at the same time go to different domains. */
+static errno_t sdap_ad_resolve_sids_batches(struct tevent_req *req)
 {
-    struct sdap_ad_resolve_sids_state *state = NULL;
-    struct tevent_req *subreq = NULL;
-    struct sdap_domain *sdap_domain = NULL;
-    struct sss_domain_info *domain = NULL;
+    struct sdap_ad_resolve_sids_state *state;
+    struct sdap_ad_resolve_sids_bucket *buckets = NULL;
+    struct sdap_ad_resolve_sids_batch *batch;
+    struct sss_domain_info *domain;
+    struct sdap_domain *sdom;
+    const char *member_filter[2];
+    const char *sid_attr;
+    char *oc_list;
+    char *sid_filter;
+    char *clean_sid;
+    size_t num_buckets = 0;
+    size_t num_sids;
+    size_t offset;
+    size_t i;
+    size_t j;
+    size_t k;
+    errno_t ret;
 
     state = tevent_req_data(req, struct sdap_ad_resolve_sids_state);
 
-    do {
-        state->current_sid = state->sids[state->index];
-        if (state->current_sid == NULL) {
-            return EOK;
-        }
-        state->index++;
+    for (num_sids = 0; state->sids[num_sids] != NULL; num_sids++);
 
+    for (i = 0; i < num_sids; i++) {
         domain = sss_get_domain_by_sid_ldap_fallback(state->domain,
-                                                     state->current_sid);
-
+                                                     state->sids[i]);
         if (domain == NULL) {
             DEBUG(SSSDBG_MINOR_FAILURE, "SID %s does not belong to any known "
-                                         "domain\n", state->current_sid);
+                                         "domain\n", state->sids[i]);
+            continue;
+        }
+
+        sdom = sdap_domain_get(state->opts, domain);
+        if (sdom == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "SDAP domain does not exist?\n");
+            return ERR_INTERNAL;
+        }
+
+        for (j = 0; j < num_buckets && buckets[j].sdom != sdom; j++);
+        if (j == num_buckets) {
+            buckets = talloc_realloc(state, buckets,
+                                     struct sdap_ad_resolve_sids_bucket,
+                                     num_buckets + 1);
+            if (buckets == NULL) {
+                return ENOMEM;
+            }
+
+            buckets[j].sdom = sdom;
+            buckets[j].num_sids = 0;
+            buckets[j].sids = talloc_zero_array(buckets, const char *,
+                                                num_sids + 1);
+            if (buckets[j].sids == NULL) {
+                return ENOMEM;
+            }
+            num_buckets++;
+        }
+
+        buckets[j].sids[buckets[j].num_sids] = state->sids[i];
+        buckets[j].num_sids++;
+    }
+
+    state->num_domains = num_buckets;
+
+    state->batches = talloc_zero_array(state,
+                                       struct sdap_ad_resolve_sids_batch,
+                                       num_sids / SDAP_AD_RESOLVE_SIDS_BATCH
+                                       + num_buckets);
+    state->missing_sids = talloc_zero_array(state, const char *,
+                                            num_sids + 1);
+    state->missing_sdoms = talloc_zero_array(state, struct sdap_domain *,
+                                             num_sids + 1);
+    if (state->batches == NULL || state->missing_sids == NULL
+            || state->missing_sdoms == NULL) {
+        return ENOMEM;
+    }
+
+    oc_list = sdap_make_oc_list(state, state->opts->group_map);
+    if (oc_list == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to create objectClass list.\n");
+        return ENOMEM;
+    }
+
+    /* only the groups themselves are needed, not their members */
+    member_filter[0] = state->opts->group_map[SDAP_AT_GROUP_MEMBER].name;
+    member_filter[1] = NULL;
+
+    ret = build_attrs_from_map(state, state->opts->group_map, SDAP_OPTS_GROUP,
+                               member_filter, &state->attrs, NULL);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    sid_attr = state->opts->group_map[SDAP_AT_GROUP_OBJECTSID].name;
+
+    for (offset = 0; offset < num_sids; offset += SDAP_AD_RESOLVE_SIDS_BATCH) {
+        for (j = 0; j < num_buckets; j++) {
+            if (offset >= buckets[j].num_sids) {
+                continue;
+            }
+
+            batch = &state->batches[state->num_batches];
+            batch->req = req;
+            batch->sdom = buckets[j].sdom;
+            batch->sids = &buckets[j].sids[offset];
+            batch->num_sids = MIN(buckets[j].num_sids - offset,
+                                  SDAP_AD_RESOLVE_SIDS_BATCH);
+
+            sid_filter = talloc_strdup(state->batches, "");
+            if (sid_filter == NULL) {
+                return ENOMEM;
+            }
+
+            for (k = 0; k < batch->num_sids; k++) {
+                ret = sss_filter_sanitize(sid_filter, batch->sids[k],
+                                          &clean_sid);
+                if (ret != EOK) {
+                    return ret;
+                }
+
+                sid_filter = talloc_asprintf_append_buffer(sid_filter,
+                                                           "(%s=%s)", sid_attr,
+                                                           clean_sid);
+                if (sid_filter == NULL) {
+                    return ENOMEM;
+                }
+            }
+
+            batch->filter = talloc_asprintf(state->batches,
+                                            "(&(|%s)(%s)(%s=*))",
+                                            sid_filter, oc_list,
+                    state->opts->group_map[SDAP_AT_GROUP_NAME].name);
+            talloc_free(sid_filter);
+            if (batch->filter == NULL) {
+                return ENOMEM;
+            }
+
+            state->num_batches++;
+        }
+    }
+
+    /* buckets own the SID lists the batches point to */
+    talloc_steal(state->batches, buckets);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Resolving %zu SIDs from %zu domains with "
+          "%zu searches\n", num_sids, num_buckets, state->num_batches);
+
+    return EOK;
+}
+
+static void sdap_ad_resolve_sids_issue(struct tevent_req *req)
+{
+    struct sdap_ad_resolve_sids_state *state;
+    struct sdap_ad_resolve_sids_batch *batch;
+    errno_t ret;
+
+    state = tevent_req_data(req, struct sdap_ad_resolve_sids_state);
+
+    while (state->active < SDAP_AD_RESOLVE_SIDS_PARALLEL
+            && state->next_batch < state->num_batches) {
+        batch = &state->batches[state->next_batch];
+        state->next_batch++;
+
+        batch->op = sdap_id_op_create(state->batches,
+                                      state->conn->conn_cache);
+        if (batch->op == NULL) {
+            ret = ENOMEM;
+        } else {
+            ret = sdap_ad_resolve_sids_batch_connect(batch);
         }
-    } while (domain == NULL);
 
-    sdap_domain = sdap_domain_get(state->opts, domain);
-    if (sdap_domain == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "SDAP domain does not exist?\n");
-        return ERR_INTERNAL;
+        if (ret != EOK) {
+            /* the SIDs will be looked up one by one */
+            DEBUG(SSSDBG_MINOR_FAILURE, "Unable to search for %zu SIDs "
+                  "[%d]: %s\n", batch->num_sids, ret, sss_strerror(ret));
+            sdap_ad_resolve_sids_add_missing(state, batch, false);
+            continue;
+        }
+
+        state->active++;
     }
+}
+
+static errno_t
+sdap_ad_resolve_sids_batch_connect(struct sdap_ad_resolve_sids_batch *batch)
+{
+    struct tevent_req *subreq;
+    errno_t ret;
+
+    subreq = sdap_id_op_connect_send(batch->op, batch->op, &ret);
+    if (subreq == NULL) {
+        return ret;
+    }
+
+    tevent_req_set_callback(subreq, sdap_ad_resolve_sids_connect_done, batch);
+    return EOK;
+}
+
+static void sdap_ad_resolve_sids_connect_done(struct tevent_req *subreq)
+{
+    struct sdap_ad_resolve_sids_state *state;
+    struct sdap_ad_resolve_sids_batch *batch;
+    int dp_error;
+    errno_t ret;
+
+    batch = tevent_req_callback_data(subreq, struct sdap_ad_resolve_sids_batch);
+    state = tevent_req_data(batch->req, struct sdap_ad_resolve_sids_state);
+
+    ret = sdap_id_op_connect_recv(subreq, &dp_error);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        goto fail;
+    }
+
+    subreq = sdap_get_groups_send(batch->op, state->ev, batch->sdom,
+                                  state->opts, sdap_id_op_handle(batch->op),
+                                  state->attrs, batch->filter,
+                                  dp_opt_get_int(state->opts->basic,
+                                                 SDAP_SEARCH_TIMEOUT),
+                                  SDAP_LOOKUP_SINGLE, true);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto fail;
+    }
+
+    tevent_req_set_callback(subreq, sdap_ad_resolve_sids_search_done, batch);
+    return;
+
+fail:
+    DEBUG(SSSDBG_MINOR_FAILURE, "Unable to search for %zu SIDs [%d]: %s\n",
+          batch->num_sids, ret, sss_strerror(ret));
+    state->active--;
+    sdap_ad_resolve_sids_batch_done(batch->req, batch, false);
+}
+
+static void sdap_ad_resolve_sids_search_done(struct tevent_req *subreq)
+{
+    struct sdap_ad_resolve_sids_state *state;
+    struct sdap_ad_resolve_sids_batch *batch;
+    int dp_error;
+    errno_t ret;
+
+    batch = tevent_req_callback_data(subreq, struct sdap_ad_resolve_sids_batch);
+    state = tevent_req_data(batch->req, struct sdap_ad_resolve_sids_state);
+
+    ret = sdap_get_groups_recv(subreq, NULL, NULL);
+    talloc_zfree(subreq);
+    if (ret == ENOENT) {
+        /* none of the SIDs was found */
+        ret = EOK;
+    }
+
+    ret = sdap_id_op_done(batch->op, ret, &dp_error);
+    if (dp_error == DP_ERR_OK && ret != EOK) {
+        /* retry */
+        ret = sdap_ad_resolve_sids_batch_connect(batch);
+        if (ret == EOK) {
+            return;
+        }
+    }
+
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to search for %zu SIDs [%d]: "
+              "%s\n", batch->num_sids, ret, sss_strerror(ret));
+    }
+
+    state->active--;
+    sdap_ad_resolve_sids_batch_done(batch->req, batch, ret == EOK);
+}
+
+static void
+sdap_ad_resolve_sids_add_missing(struct sdap_ad_resolve_sids_state *state,
+                                 struct sdap_ad_resolve_sids_batch *batch,
+                                 bool searched)
+{
+    struct ldb_message *msg;
+    const char *attrs[] = { SYSDB_NAME, NULL };
+    size_t i;
+    errno_t ret;
+
+    /* The groups found by the search were saved to the cache */
+    for (i = 0; i < batch->num_sids; i++) {
+        if (searched) {
+            ret = sysdb_search_group_by_sid_str(state, batch->sdom->dom,
+                                                batch->sids[i], attrs, &msg);
+            if (ret == EOK) {
+                talloc_free(msg);
+                continue;
+            }
+        }
+
+        state->missing_sids[state->num_missing] = batch->sids[i];
+        state->missing_sdoms[state->num_missing] = batch->sdom;
+        state->num_missing++;
+    }
+
+    talloc_zfree(batch->op);
+}
+
+static void sdap_ad_resolve_sids_batch_done(struct tevent_req *req,
+                                            struct sdap_ad_resolve_sids_batch *batch,
+                                            bool searched)
+{
+    struct sdap_ad_resolve_sids_state *state;
+    errno_t ret;
+
+    state = tevent_req_data(req, struct sdap_ad_resolve_sids_state);
+
+    sdap_ad_resolve_sids_add_missing(state, batch, searched);
+
+    sdap_ad_resolve_sids_issue(req);
+    if (state->active > 0) {
+        return;
+    }
+
+    /* All batches are done, look up the rest one by one. This also covers
+     * groups outside of the search bases and user private groups. */
+    state->batches_done = tevent_timeval_current();
+
+    DEBUG(SSSDBG_TRACE_FUNC, "%zu SIDs were not found by batched searches\n",
+          state->num_missing);
+
+    ret = sdap_ad_resolve_sids_step(req);
+    if (ret == EAGAIN) {
+        return;
+    }
+
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static void sdap_ad_resolve_sids_log_timing(struct sdap_ad_resolve_sids_state *state)
+{
+    struct timeval now = tevent_timeval_current();
+
+    DEBUG(SSSDBG_FUNC_DATA, "Resolved SIDs from %zu domains: %zu batched "
+          "searches took %ld ms, %zu single lookups took %ld ms\n",
+          state->num_domains, state->num_batches,
+          (long) ((state->batches_done.tv_sec - state->start.tv_sec) * 1000
+                  + (state->batches_done.tv_usec - state->start.tv_usec) / 1000),
+          state->num_missing,
+          (long) ((now.tv_sec - state->batches_done.tv_sec) * 1000
+                  + (now.tv_usec - state->batches_done.tv_usec) / 1000));
+}
+
+static errno_t sdap_ad_resolve_sids_step(struct tevent_req *req)
+{
+    struct sdap_ad_resolve_sids_state *state = NULL;
+    struct tevent_req *subreq = NULL;
+    struct sdap_domain *sdap_domain = NULL;
+
+    state = tevent_req_data(req, struct sdap_ad_resolve_sids_state);
+
+    if (state->index >= state->num_missing) {
+        sdap_ad_resolve_sids_log_timing(state);
+        return EOK;
+    }
+
+    state->current_sid = state->missing_sids[state->index];
+    sdap_domain = state->missing_sdoms[state->index];
+    state->index++;
 
     subreq = groups_get_send(state, state->ev, state->id_ctx, sdap_domain,
                              state->conn, state->current_sid,
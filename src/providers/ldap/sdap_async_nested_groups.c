@@ -393,12 +393,15 @@ static errno_t sdap_nested_group_sysdb_search(struct sss_domain_info *domain,
                                               bool user)
 {
     static const char *attrs[] = {SYSDB_CACHE_EXPIRE,
+                                  SYSDB_LAST_UPDATE,
                                   SYSDB_UIDNUM,
                                   NULL};
     struct ldb_message **msgs = NULL;
     size_t count;
     time_t now = time(NULL);
     uint64_t expire;
+    enum sysdb_cache_gen_type gen_type;
+    uint32_t generation;
     uid_t uid;
     errno_t ret;
 
@@ -437,6 +440,18 @@ static errno_t sdap_nested_group_sysdb_search(struct sss_domain_info *domain,
         goto done;
     }
 
+    gen_type = user ? SYSDB_CACHE_GEN_USERS : SYSDB_CACHE_GEN_GROUPS;
+    ret = sysdb_get_cache_generation_cached(domain, gen_type, &generation);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (sysdb_is_older_than_generation(msgs[0], gen_type, generation)) {
+        /* invalidated together with all other objects of this type */
+        ret = EAGAIN;
+        goto done;
+    }
+
     /* valid object */
     ret = EOK;
 
@@ -624,17 +624,25 @@ static void sdap_sudo_refresh_done(struct tevent_req *subreq)
     }
     in_transaction = true;
 
-    /* purge cache */
-    ret = sysdb_sudo_purge(state->domain, state->delete_filter,
-                           rules, rules_count);
-    if (ret != EOK) {
-        goto done;
-    }
+    if (state->delete_filter != NULL) {
+        /* write only rules that differ from the cached ones */
+        ret = sysdb_sudo_sync(state->domain, state->delete_filter,
+                              rules, rules_count, NULL);
+        if (ret != EOK) {
+            goto done;
+        }
+    } else {
+        /* purge cache */
+        ret = sysdb_sudo_purge(state->domain, NULL, rules, rules_count);
+        if (ret != EOK) {
+            goto done;
+        }
 
-    /* store rules */
-    ret = sysdb_sudo_store(state->domain, rules, rules_count);
-    if (ret != EOK) {
-        goto done;
+        /* store rules */
+        ret = sysdb_sudo_store(state->domain, rules, rules_count);
+        if (ret != EOK) {
+            goto done;
+        }
     }
 
     /* commit transaction */
@@ -0,0 +1,314 @@
+/*
+    SSSD
+
+    LDAP TLS session cache
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <string.h>
+
+#ifdef HAVE_LIBCRYPTO
+#include <openssl/ssl.h>
+#endif
+
+#include "util/util.h"
+#include "providers/ldap/sdap_tls_session.h"
+
+#if defined(HAVE_LIBCRYPTO) && defined(LDAP_OPT_X_TLS_CONNECT_CB)
+
+/* There is usually only a handful of servers per domain */
+#define SDAP_TLS_SESSION_MAX 64
+
+struct sdap_tls_session {
+    struct sdap_tls_session *prev;
+    struct sdap_tls_session *next;
+
+    char *uri;
+    SSL_SESSION *session;
+};
+
+static struct {
+    TALLOC_CTX *mem_ctx;
+    struct sdap_tls_session *sessions;
+    int ex_index;
+    bool setup_done;
+    bool enabled;
+    struct sdap_tls_session_stats stats;
+} sdap_tls_cache = { NULL, NULL, -1, false, false, { 0, 0, 0 } };
+
+static int sdap_tls_session_destructor(struct sdap_tls_session *s)
+{
+    DLIST_REMOVE(sdap_tls_cache.sessions, s);
+    sdap_tls_cache.stats.cached--;
+    SSL_SESSION_free(s->session);
+
+    return 0;
+}
+
+static struct sdap_tls_session *sdap_tls_session_lookup(const char *uri)
+{
+    struct sdap_tls_session *s;
+
+    DLIST_FOR_EACH(s, sdap_tls_cache.sessions) {
+        if (strcmp(s->uri, uri) == 0) {
+            return s;
+        }
+    }
+
+    return NULL;
+}
+
+/* Takes over the reference to session on success */
+static errno_t sdap_tls_session_store(const char *uri, SSL_SESSION *session)
+{
+    struct sdap_tls_session *s;
+    struct sdap_tls_session *last;
+
+    if (sdap_tls_cache.mem_ctx == NULL) {
+        sdap_tls_cache.mem_ctx = talloc_named_const(NULL, 0,
+                                                    "sdap_tls_cache");
+        if (sdap_tls_cache.mem_ctx == NULL) {
+            return ENOMEM;
+        }
+    }
+
+    s = sdap_tls_session_lookup(uri);
+    if (s != NULL) {
+        SSL_SESSION_free(s->session);
+        s->session = session;
+        DLIST_PROMOTE(sdap_tls_cache.sessions, s);
+        return EOK;
+    }
+
+    if (sdap_tls_cache.stats.cached >= SDAP_TLS_SESSION_MAX) {
+        /* drop the least recently used session */
+        for (last = sdap_tls_cache.sessions;
+             last->next != NULL;
+             last = last->next);
+        talloc_free(last);
+    }
+
+    s = talloc_zero(sdap_tls_cache.mem_ctx, struct sdap_tls_session);
+    if (s == NULL) {
+        return ENOMEM;
+    }
+
+    s->uri = talloc_strdup(s, uri);
+    if (s->uri == NULL) {
+        talloc_free(s);
+        return ENOMEM;
+    }
+
+    s->session = session;
+    DLIST_ADD(sdap_tls_cache.sessions, s);
+    sdap_tls_cache.stats.cached++;
+    talloc_set_destructor(s, sdap_tls_session_destructor);
+
+    return EOK;
+}
+
+static void sdap_tls_session_free_uri(void *parent, void *ptr,
+                                      CRYPTO_EX_DATA *ad, int idx,
+                                      long argl, void *argp)
+{
+    free(ptr);
+}
+
+/* With TLS 1.3 the server sends the session ticket only after the handshake,
+ * so the session is stored whenever OpenSSL announces a new one. */
+static int sdap_tls_session_new_cb(SSL *ssl, SSL_SESSION *session)
+{
+    const char *uri;
+    errno_t ret;
+
+    uri = SSL_get_ex_data(ssl, sdap_tls_cache.ex_index);
+    if (uri == NULL || !SSL_SESSION_is_resumable(session)) {
+        return 0;
+    }
+
+    ret = sdap_tls_session_store(uri, session);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to cache TLS session for [%s] "
+              "[%d]: %s\n", uri, ret, sss_strerror(ret));
+        return 0;
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Cached TLS session for [%s]\n", uri);
+
+    /* We keep the reference */
+    return 1;
+}
+
+/* Called by libldap after the SSL object was created, before the handshake */
+static int sdap_tls_session_connect_cb(LDAP *ld, void *_ssl,
+                                       void *_ctx, void *arg)
+{
+    SSL_CTX *ctx = _ctx;
+    SSL *ssl = _ssl;
+    struct sdap_tls_session *s;
+    char *ldap_uri = NULL;
+    char *uri;
+    int lret;
+
+    if (!sdap_tls_cache.enabled) {
+        return 0;
+    }
+
+    lret = ldap_get_option(ld, LDAP_OPT_URI, &ldap_uri);
+    if (lret != LDAP_OPT_SUCCESS || ldap_uri == NULL) {
+        return 0;
+    }
+
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT
+                                        | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, sdap_tls_session_new_cb);
+
+    uri = strdup(ldap_uri);
+    if (uri != NULL && SSL_set_ex_data(ssl, sdap_tls_cache.ex_index,
+                                       uri) != 1) {
+        free(uri);
+    }
+
+    s = sdap_tls_session_lookup(ldap_uri);
+    if (s != NULL && SSL_set_session(ssl, s->session) == 1) {
+        DEBUG(SSSDBG_TRACE_INTERNAL, "Trying to resume TLS session with "
+              "[%s]\n", ldap_uri);
+    }
+
+    ldap_memfree(ldap_uri);
+    return 0;
+}
+
+errno_t sdap_tls_session_cache_setup(void)
+{
+    char *package = NULL;
+    int lret;
+
+    if (sdap_tls_cache.setup_done) {
+        return EOK;
+    }
+    sdap_tls_cache.setup_done = true;
+
+    lret = ldap_get_option(NULL, LDAP_OPT_X_TLS_PACKAGE, &package);
+    if (lret != LDAP_OPT_SUCCESS || package == NULL
+            || strcmp(package, "OpenSSL") != 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "LDAP library does not use OpenSSL, "
+              "TLS sessions will not be resumed\n");
+        ldap_memfree(package);
+        return EOK;
+    }
+    ldap_memfree(package);
+
+    if (sdap_tls_cache.ex_index == -1) {
+        sdap_tls_cache.ex_index = SSL_get_ex_new_index(0, NULL, NULL, NULL,
+                                                   sdap_tls_session_free_uri);
+        if (sdap_tls_cache.ex_index == -1) {
+            return ENOMEM;
+        }
+    }
+
+    lret = ldap_set_option(NULL, LDAP_OPT_X_TLS_CONNECT_CB,
+                           (void *)sdap_tls_session_connect_cb);
+    if (lret != LDAP_OPT_SUCCESS) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to set TLS connect callback: %s\n",
+              sss_ldap_err2string(lret));
+        return EOK;
+    }
+
+    sdap_tls_cache.enabled = true;
+    return EOK;
+}
+
+void sdap_tls_session_handshake_done(LDAP *ldap)
+{
+    SSL *ssl = NULL;
+    int lret;
+
+    if (!sdap_tls_cache.enabled) {
+        return;
+    }
+
+    lret = ldap_get_option(ldap, LDAP_OPT_X_TLS_SSL_CTX, &ssl);
+    if (lret != LDAP_OPT_SUCCESS || ssl == NULL) {
+        return;
+    }
+
+    if (SSL_session_reused(ssl)) {
+        sdap_tls_cache.stats.resumed++;
+    } else {
+        sdap_tls_cache.stats.full++;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "TLS session %s; %"PRIu64" full handshakes, "
+          "%"PRIu64" resumed\n", SSL_session_reused(ssl) ? "resumed" : "new",
+          sdap_tls_cache.stats.full, sdap_tls_cache.stats.resumed);
+}
+
+void sdap_tls_session_forget(LDAP *ldap)
+{
+    struct sdap_tls_session *s;
+    char *ldap_uri = NULL;
+    int lret;
+
+    if (!sdap_tls_cache.enabled) {
+        return;
+    }
+
+    lret = ldap_get_option(ldap, LDAP_OPT_URI, &ldap_uri);
+    if (lret != LDAP_OPT_SUCCESS || ldap_uri == NULL) {
+        return;
+    }
+
+    s = sdap_tls_session_lookup(ldap_uri);
+    if (s != NULL) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Dropping TLS session for [%s]\n", ldap_uri);
+        talloc_free(s);
+    }
+
+    ldap_memfree(ldap_uri);
+}
+
+void sdap_tls_session_get_stats(struct sdap_tls_session_stats *_stats)
+{
+    *_stats = sdap_tls_cache.stats;
+}
+
+#else /* HAVE_LIBCRYPTO && LDAP_OPT_X_TLS_CONNECT_CB */
+
+errno_t sdap_tls_session_cache_setup(void)
+{
+    return EOK;
+}
+
+void sdap_tls_session_handshake_done(LDAP *ldap)
+{
+    return;
+}
+
+void sdap_tls_session_forget(LDAP *ldap)
+{
+    return;
+}
+
+void sdap_tls_session_get_stats(struct sdap_tls_session_stats *_stats)
+{
+    memset(_stats, 0, sizeof(*_stats));
+}
+
+#endif /* HAVE_LIBCRYPTO && LDAP_OPT_X_TLS_CONNECT_CB */
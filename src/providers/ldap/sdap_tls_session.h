@@ -0,0 +1,53 @@
+/*
+    SSSD
+
+    LDAP TLS session cache
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SDAP_TLS_SESSION_H_
+#define _SDAP_TLS_SESSION_H_
+
+#include "util/util.h"
+#include "util/sss_ldap.h"
+
+struct sdap_tls_session_stats {
+    /* handshakes that negotiated a new session */
+    uint64_t full;
+    /* handshakes that resumed a cached session */
+    uint64_t resumed;
+    /* sessions currently cached */
+    uint64_t cached;
+};
+
+/* Make new TLS connections resume the last session established with the
+ * same server. The cache is shared by all LDAP connections of the process,
+ * as is the TLS configuration set by setup_tls_config(). It is only
+ * available when the LDAP library uses OpenSSL, otherwise this is a no-op.
+ * Calling it more than once is harmless. */
+errno_t sdap_tls_session_cache_setup(void);
+
+/* Account for the TLS handshake that has just finished on ldap */
+void sdap_tls_session_handshake_done(LDAP *ldap);
+
+/* Drop the session cached for the server ldap is connected to, e.g.
+ * because the handshake failed */
+void sdap_tls_session_forget(LDAP *ldap);
+
+void sdap_tls_session_get_stats(struct sdap_tls_session_stats *_stats);
+
+#endif /* _SDAP_TLS_SESSION_H_ */
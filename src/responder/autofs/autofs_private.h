@@ -34,6 +34,9 @@ struct autofs_ctx {
     int neg_timeout;
 
     hash_table_t *maps;
+
+    /* Memory cache of map entries read directly by the clients. */
+    struct sss_mc_ctx *mc_ctx;
 };
 
 struct autofs_cmd_ctx {
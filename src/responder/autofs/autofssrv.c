@@ -27,6 +27,7 @@
 #include "responder/common/responder.h"
 #include "providers/data_provider.h"
 #include "responder/autofs/autofs_private.h"
+#include "responder/nss/nsssrv_mmap_cache.h"
 #include "sss_iface/sss_iface_async.h"
 #include "util/sss_ptr_hash.h"
 
@@ -42,13 +43,76 @@ autofs_get_config(struct autofs_ctx *actx,
     return ret;
 }
 
+static errno_t
+autofs_memcache_init(struct autofs_ctx *actx,
+                     struct confdb_ctx *cdb)
+{
+    int memcache_timeout;
+    uid_t uid;
+    gid_t gid;
+    errno_t ret;
+
+    ret = confdb_get_int(cdb, CONFDB_AUTOFS_CONF_ENTRY,
+                         CONFDB_MEMCACHE_TIMEOUT, 300,
+                         &memcache_timeout);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get 'memcache_timeout' option from confdb.\n");
+        return ret;
+    }
+
+    if (memcache_timeout == 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS,
+              "Fast in-memory cache will not be initialized.\n");
+        return EOK;
+    }
+
+    /* The memory cache files are owned by the sssd user, see the nss
+     * responder. */
+    ret = sss_user_by_name_or_uid(SSSD_USER, &uid, &gid);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot get info on "SSSD_USER", "
+              "autofs mmap cache is DISABLED\n");
+        return EOK;
+    }
+
+    ret = sss_mmap_cache_init(actx, "autofs", uid, gid, SSS_MC_AUTOFS,
+                              SSS_MC_CACHE_ELEMENTS, (time_t)memcache_timeout,
+                              &actx->mc_ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "autofs mmap cache is DISABLED\n");
+    }
+
+    return EOK;
+}
+
 static errno_t
 autofs_clean_hash_table(TALLOC_CTX *mem_ctx,
                        struct sbus_request *sbus_req,
                        struct autofs_ctx *actx)
 {
+    struct stat stat_buf;
+    errno_t ret;
+
     autofs_orphan_maps(actx);
 
+    if (actx->mc_ctx == NULL) {
+        return EOK;
+    }
+
+    /* sss_cache removes the memory cache file when it cannot expire its
+     * records in place, create a new one so that clients can use it again */
+    ret = stat(SSS_NSS_MCACHE_DIR"/autofs", &stat_buf);
+    if (ret == -1 && errno == ENOENT) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Recreating autofs memory cache.\n");
+        ret = sss_mmap_cache_reinit(actx, -1, -1, -1, -1, &actx->mc_ctx);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "autofs mmap cache invalidation failed\n");
+            return ret;
+        }
+    }
+
     return EOK;
 }
 
@@ -142,6 +206,12 @@ autofs_process_init(TALLOC_CTX *mem_ctx,
         goto fail;
     }
 
+    ret = autofs_memcache_init(autofs_ctx, cdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Cannot initialize the memory cache\n");
+        goto fail;
+    }
+
     ret = schedule_get_domains_task(rctx, rctx->ev, rctx, NULL);
     if (ret != EOK) {
         DEBUG(SSSDBG_FATAL_FAILURE, "schedule_get_domains_tasks failed.\n");
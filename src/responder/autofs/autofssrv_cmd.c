@@ -27,6 +27,7 @@
 #include "responder/common/responder_packet.h"
 #include "responder/common/cache_req/cache_req.h"
 #include "responder/autofs/autofs_private.h"
+#include "responder/nss/nsssrv_mmap_cache.h"
 #include "db/sysdb.h"
 #include "db/sysdb_autofs.h"
 #include "confdb/confdb.h"
@@ -132,12 +133,81 @@ autofs_fill_entry(struct ldb_message *entry, struct sss_packet *packet, size_t *
     return EOK;
 }
 
+static void
+autofs_mc_store_entry(struct autofs_ctx *autofs_ctx,
+                      const char *mapname,
+                      const char *key,
+                      const char *value)
+{
+    struct sized_string map_str;
+    struct sized_string key_str;
+    struct sized_string value_str;
+    errno_t ret;
+
+    if (autofs_ctx->mc_ctx == NULL || value == NULL) {
+        return;
+    }
+
+    to_sized_string(&map_str, mapname);
+    to_sized_string(&key_str, key);
+    to_sized_string(&value_str, value);
+
+    ret = sss_mmap_cache_autofs_store(&autofs_ctx->mc_ctx, &map_str,
+                                      &key_str, &value_str);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Failed to store %s:%s in the memory "
+              "cache [%d]: %s\n", mapname, key, ret, sss_strerror(ret));
+    }
+}
+
+/* Replace all memory cache entries of the map with the current result. */
+static void
+autofs_mc_store_map(struct autofs_ctx *autofs_ctx,
+                    const char *mapname,
+                    struct autofs_enum_ctx *enum_ctx)
+{
+    struct sized_string map_str;
+    struct ldb_message *entry;
+    const char *key;
+    const char *value;
+    unsigned int i;
+
+    if (autofs_ctx->mc_ctx == NULL) {
+        return;
+    }
+
+    to_sized_string(&map_str, mapname);
+    (void)sss_mmap_cache_autofs_invalidate_map(autofs_ctx->mc_ctx, &map_str);
+
+    if (!enum_ctx->found) {
+        return;
+    }
+
+    /* First result is the map object, next results are map entries. */
+    for (i = 1; i < enum_ctx->result->count; i++) {
+        entry = enum_ctx->result->msgs[i];
+        key = ldb_msg_find_attr_as_string(entry, SYSDB_AUTOFS_ENTRY_KEY, NULL);
+        value = ldb_msg_find_attr_as_string(entry, SYSDB_AUTOFS_ENTRY_VALUE,
+                                            NULL);
+        if (key == NULL || value == NULL) {
+            continue;
+        }
+
+        autofs_mc_store_entry(autofs_ctx, mapname, key, value);
+    }
+}
+
 void
 autofs_orphan_maps(struct autofs_ctx *autofs_ctx)
 {
     /* It will automatically decrease the refcount of enum_ctx through
      * delete callback. */
     sss_ptr_hash_delete_all(autofs_ctx->maps, false);
+
+    /* Clients must not read entries of the orphaned maps either. */
+    if (autofs_ctx->mc_ctx != NULL) {
+        sss_mmap_cache_reset(autofs_ctx->mc_ctx);
+    }
 }
 
 static void
@@ -350,6 +420,9 @@ static void autofs_setent_done(struct tevent_req *subreq)
 
     state->enum_ctx->ready = true;
 
+    autofs_mc_store_map(state->autofs_ctx, state->enum_ctx->key,
+                        state->enum_ctx);
+
     /* Make the enumeration context disappear with maps table. */
     talloc_steal(state->autofs_ctx->maps, state->enum_ctx);
 
@@ -904,6 +977,7 @@ sss_autofs_cmd_getautomntbyname_done(struct tevent_req *req)
 {
     struct cache_req_result *result;
     struct autofs_cmd_ctx *cmd_ctx;
+    const char *value;
     errno_t ret;
 
     cmd_ctx = tevent_req_callback_data(req, struct autofs_cmd_ctx);
@@ -924,6 +998,13 @@ sss_autofs_cmd_getautomntbyname_done(struct tevent_req *req)
         return;
     }
 
+    if (result != NULL && result->count > 0) {
+        value = ldb_msg_find_attr_as_string(result->msgs[0],
+                                            SYSDB_AUTOFS_ENTRY_VALUE, NULL);
+        autofs_mc_store_entry(cmd_ctx->autofs_ctx, cmd_ctx->mapname,
+                              cmd_ctx->keyname, value);
+    }
+
     sss_cmd_done(cmd_ctx->cli_ctx, NULL);
 }
 
@@ -28,7 +28,9 @@ enum cache_object_status {
     CACHE_OBJECT_VALID,
     CACHE_OBJECT_EXPIRED,
     CACHE_OBJECT_MISSING,
-    CACHE_OBJECT_MIDPOINT
+    CACHE_OBJECT_MIDPOINT,
+    /* Expired, but still within the grace period. */
+    CACHE_OBJECT_STALE
 };
 
 /**
@@ -23,6 +23,7 @@
 #include <tevent.h>
 
 #include "util/util.h"
+#include "util/sss_ptr_hash.h"
 #include "responder/common/cache_req/cache_req_private.h"
 #include "responder/common/cache_req/cache_req_plugin.h"
 #include "db/sysdb.h"
@@ -257,6 +258,104 @@ done:
     return ret;
 }
 
+static enum sysdb_cache_gen_type
+cache_req_generation_type(struct cache_req *cr,
+                          struct ldb_message *msg)
+{
+    const char *category;
+
+    switch (cr->data->type) {
+    case CACHE_REQ_USER_BY_NAME:
+    case CACHE_REQ_USER_BY_UPN:
+    case CACHE_REQ_USER_BY_ID:
+    case CACHE_REQ_USER_BY_CERT:
+    case CACHE_REQ_USER_BY_FILTER:
+    case CACHE_REQ_ENUM_USERS:
+        return SYSDB_CACHE_GEN_USERS;
+    case CACHE_REQ_INITGROUPS:
+    case CACHE_REQ_INITGROUPS_BY_UPN:
+        return SYSDB_CACHE_GEN_INITGROUPS;
+    case CACHE_REQ_GROUP_BY_NAME:
+    case CACHE_REQ_GROUP_BY_ID:
+    case CACHE_REQ_GROUP_BY_FILTER:
+    case CACHE_REQ_ENUM_GROUPS:
+        return SYSDB_CACHE_GEN_GROUPS;
+    case CACHE_REQ_OBJECT_BY_SID:
+    case CACHE_REQ_OBJECT_BY_NAME:
+    case CACHE_REQ_OBJECT_BY_ID:
+        category = ldb_msg_find_attr_as_string(msg, SYSDB_OBJECTCATEGORY,
+                                               NULL);
+        if (category == NULL) {
+            break;
+        } else if (strcmp(category, SYSDB_USER_CLASS) == 0) {
+            return SYSDB_CACHE_GEN_USERS;
+        } else if (strcmp(category, SYSDB_GROUP_CLASS) == 0) {
+            return SYSDB_CACHE_GEN_GROUPS;
+        }
+        break;
+    case CACHE_REQ_ENUM_SVC:
+    case CACHE_REQ_SVC_BY_NAME:
+    case CACHE_REQ_SVC_BY_PORT:
+        return SYSDB_CACHE_GEN_SERVICES;
+    case CACHE_REQ_NETGROUP_BY_NAME:
+        return SYSDB_CACHE_GEN_NETGROUPS;
+    case CACHE_REQ_HOST_BY_NAME:
+        return SYSDB_CACHE_GEN_SSH_HOSTS;
+    case CACHE_REQ_AUTOFS_MAP_ENTRIES:
+    case CACHE_REQ_AUTOFS_MAP_BY_NAME:
+    case CACHE_REQ_AUTOFS_ENTRY_BY_NAME:
+        return SYSDB_CACHE_GEN_AUTOFS;
+    case CACHE_REQ_SENTINEL:
+        break;
+    }
+
+    return SYSDB_CACHE_GEN_SENTINEL;
+}
+
+/* Objects that were cached before their type was invalidated as a whole
+ * (sss_cache -E and friends) are expired regardless of their own
+ * expiration timestamp. */
+static bool
+cache_req_generation_expired(struct cache_req *cr,
+                             struct ldb_message *msg)
+{
+    enum sysdb_cache_gen_type type;
+    uint32_t generation;
+    errno_t ret;
+
+    type = cache_req_generation_type(cr, msg);
+    if (type == SYSDB_CACHE_GEN_SENTINEL) {
+        return false;
+    }
+
+    ret = sysdb_get_cache_generation_cached(cr->domain, type, &generation);
+    if (ret != EOK) {
+        CACHE_REQ_DEBUG(SSSDBG_MINOR_FAILURE, cr,
+                        "Unable to read cache generation [%d]: %s\n",
+                        ret, sss_strerror(ret));
+        return false;
+    }
+
+    return sysdb_is_older_than_generation(msg, type, generation);
+}
+
+/* Expired objects may still be returned for a while if the administrator
+ * prefers a fast answer over an up to date one. Objects that were
+ * invalidated on purpose (sss_cache sets the expiration to the epoch) are
+ * far beyond any grace period. */
+static bool
+cache_req_within_grace(struct cache_req *cr,
+                       time_t expire)
+{
+    int grace = cr->rctx->cache_stale_grace;
+
+    if (grace <= 0 || expire == 0) {
+        return false;
+    }
+
+    return expire + grace >= time(NULL);
+}
+
 static enum cache_object_status
 cache_req_expiration_status(struct cache_req *cr,
                             struct ldb_result *result)
@@ -272,10 +371,18 @@ cache_req_expiration_status(struct cache_req *cr,
                                          cr->plugin->attr_expiration, 0);
 
     ret = sss_cmd_check_cache(result->msgs[0], cr->midpoint, expire);
+    if (ret != ENOENT && cache_req_generation_expired(cr, result->msgs[0])) {
+        CACHE_REQ_DEBUG(SSSDBG_TRACE_FUNC, cr,
+                        "[%s] was invalidated by a newer cache generation\n",
+                        cr->debugobj);
+        return CACHE_OBJECT_EXPIRED;
+    }
     if (ret == EOK) {
         return CACHE_OBJECT_VALID;
     } else if (ret == EAGAIN) {
         return CACHE_OBJECT_MIDPOINT;
+    } else if (cache_req_within_grace(cr, expire)) {
+        return CACHE_OBJECT_STALE;
     }
 
     return CACHE_OBJECT_EXPIRED;
@@ -284,7 +391,6 @@ cache_req_expiration_status(struct cache_req *cr,
 struct cache_req_search_state {
     /* input data */
     struct tevent_context *ev;
-    struct resp_ctx *rctx;
     struct cache_req *cr;
 
     /* output data */
@@ -294,7 +400,6 @@ struct cache_req_search_state {
 
 static errno_t cache_req_search_dp(struct tevent_req *req,
                                    enum cache_object_status status);
-static void cache_req_search_oob_done(struct tevent_req *subreq);
 static void cache_req_search_done(struct tevent_req *subreq);
 
 struct tevent_req *
@@ -387,6 +492,85 @@ done:
     return req;
 }
 
+struct cache_req_refresh {
+    struct resp_ctx *rctx;
+    const char *key;
+    struct timeval start;
+};
+
+static void cache_req_search_oob_done(struct tevent_req *subreq);
+
+/* Out of band update. The calling function returns the cached object
+ * immediately, so the data provider request must not be a child of the
+ * search request. Many clients usually ask for the same object when it
+ * expires, only the first one sends the request and the others join it. */
+static void cache_req_search_oob(struct cache_req_search_state *state)
+{
+    struct cache_req *cr = state->cr;
+    struct resp_ctx *rctx = cr->rctx;
+    struct cache_req_refresh *refresh;
+    struct tevent_req *subreq;
+    errno_t ret;
+
+    refresh = talloc_zero(rctx->cache_refreshes != NULL ?
+                              (TALLOC_CTX *)rctx->cache_refreshes :
+                              (TALLOC_CTX *)rctx,
+                          struct cache_req_refresh);
+    if (refresh == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    refresh->rctx = rctx;
+    refresh->start = tevent_timeval_current();
+    refresh->key = talloc_asprintf(refresh, "%s:%s:%s", cr->reqname,
+                                   cr->domain->name, cr->debugobj);
+    if (refresh->key == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    if (rctx->cache_refreshes != NULL
+            && sss_ptr_hash_has_key(rctx->cache_refreshes, refresh->key)) {
+        CACHE_REQ_DEBUG(SSSDBG_TRACE_FUNC, cr,
+                        "Update of [%s] is already running\n",
+                        cr->debugobj);
+        rctx->cache_refresh_stats.coalesced++;
+        ret = EOK;
+        goto done;
+    }
+
+    subreq = cr->plugin->dp_send_fn(refresh, cr, cr->data, cr->domain,
+                                    state->result);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    if (rctx->cache_refreshes != NULL) {
+        /* The key is removed when refresh is freed. */
+        ret = sss_ptr_hash_add(rctx->cache_refreshes, refresh->key, refresh,
+                               struct cache_req_refresh);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    tevent_req_set_callback(subreq, cache_req_search_oob_done, refresh);
+    rctx->cache_refresh_stats.started++;
+    refresh = NULL;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        /* This is non-fatal, so we'll continue here */
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to send out-of-band data "
+              "provider request [%d]: %s\n", ret, sss_strerror(ret));
+    }
+
+    talloc_free(refresh);
+}
+
 static errno_t cache_req_search_dp(struct tevent_req *req,
                                    enum cache_object_status status)
 {
@@ -398,26 +582,20 @@ static errno_t cache_req_search_dp(struct tevent_req *req,
 
     switch (status) {
     case CACHE_OBJECT_MIDPOINT:
-        /* Out of band update. The calling function will return the cached
-         * entry immediately. We need to use rctx so the request is not
-         * removed when state is freed. */
-
         CACHE_REQ_DEBUG(SSSDBG_TRACE_FUNC, state->cr,
                         "Performing midpoint cache update of [%s]\n",
                         state->cr->debugobj);
 
-        subreq = state->cr->plugin->dp_send_fn(state->rctx, state->cr,
-                                               state->cr->data,
-                                               state->cr->domain,
-                                               state->result);
-        if (subreq == NULL) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "Out of memory sending out-of-band "
-                                       "data provider request\n");
-            /* This is non-fatal, so we'll continue here */
-        } else {
-            tevent_req_set_callback(subreq, cache_req_search_oob_done, req);
-        }
+        cache_req_search_oob(state);
+        ret = EOK;
+        break;
+    case CACHE_OBJECT_STALE:
+        CACHE_REQ_DEBUG(SSSDBG_TRACE_FUNC, state->cr,
+                        "Returning expired [%s] from cache while it is "
+                        "being updated\n", state->cr->debugobj);
 
+        state->cr->rctx->cache_refresh_stats.stale_served++;
+        cache_req_search_oob(state);
         ret = EOK;
         break;
     case CACHE_OBJECT_EXPIRED:
@@ -453,10 +631,33 @@ static errno_t cache_req_search_dp(struct tevent_req *req,
 
 static void cache_req_search_oob_done(struct tevent_req *subreq)
 {
-    DEBUG(SSSDBG_TRACE_INTERNAL, "Out of band request finished\n");
+    struct cache_req_refresh_stats *stats;
+    struct cache_req_refresh *refresh;
+    struct timeval now;
+    uint64_t latency;
+
+    refresh = tevent_req_callback_data(subreq, struct cache_req_refresh);
     talloc_zfree(subreq);
 
-    return;
+    now = tevent_timeval_current();
+    latency = (now.tv_sec - refresh->start.tv_sec) * 1000
+              + (now.tv_usec - refresh->start.tv_usec) / 1000;
+
+    stats = &refresh->rctx->cache_refresh_stats;
+    stats->finished++;
+    stats->latency_total_ms += latency;
+    stats->latency_max_ms = MAX(stats->latency_max_ms, latency);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Out of band update of [%s] finished in "
+          "%"PRIu64" ms; %"PRIu64" expired objects returned, "
+          "%"PRIu64" updates sent, %"PRIu64" joined, "
+          "average %"PRIu64" ms, maximum %"PRIu64" ms\n",
+          refresh->key, latency, stats->stale_served,
+          stats->started, stats->coalesced,
+          stats->latency_total_ms / stats->finished,
+          stats->latency_max_ms);
+
+    talloc_free(refresh);
 }
 
 static void cache_req_search_done(struct tevent_req *subreq)
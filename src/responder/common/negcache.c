@@ -24,6 +24,7 @@
 #include "tdb.h"
 #include "util/util.h"
 #include "util/nss_dl_load.h"
+#include "shared/murmurhash3.h"
 #include "confdb/confdb.h"
 #include "responder/common/negcache_files.h"
 #include "responder/common/responder.h"
@@ -42,11 +43,32 @@
 #define NC_DOMAIN_ACCT_LOCATE_PREFIX NC_ENTRY_PREFIX"DOM_LOCATE"
 #define NC_DOMAIN_ACCT_LOCATE_TYPE_PREFIX NC_ENTRY_PREFIX"DOM_LOCATE_TYPE"
 
+/* The bloom filter remembers every key stored in the negative cache, most
+ * lookups are for existing objects and can skip the tdb right away. Deleted
+ * keys are not removed from the filter, it is rebuilt from the tdb once too
+ * many keys were added since the last rebuild. */
+#define NC_BLOOM_BITS (1 << 16)
+#define NC_BLOOM_HASHES 4
+#define NC_BLOOM_MAX_KEYS (NC_BLOOM_BITS / 8)
+
+/* Never grow the timeout of a repeatedly missing key beyond
+ * timeout << NC_MAX_STREAK */
+#define NC_MAX_STREAK 16
+
+struct sss_nc_bloom {
+    uint8_t bits[NC_BLOOM_BITS / 8];
+    uint32_t keys;
+    uint32_t rebuild_at;
+};
+
 struct sss_nc_ctx {
     struct tdb_context *tdb;
     uint32_t timeout;
     uint32_t local_timeout;
+    uint32_t max_timeout;
     struct sss_nss_ops ops;
+    struct sss_nc_bloom bloom;
+    struct sss_nc_stats stats;
 };
 
 typedef int (*ncache_set_byname_fn_t)(struct sss_nc_ctx *, bool,
@@ -116,6 +138,8 @@ int sss_ncache_init(TALLOC_CTX *memctx, uint32_t timeout,
 
     ctx->timeout = timeout;
     ctx->local_timeout = local_timeout;
+    ctx->max_timeout = timeout;
+    ctx->bloom.rebuild_at = NC_BLOOM_MAX_KEYS;
 
     *_ctx = ctx;
     return EOK;
@@ -126,13 +150,146 @@ uint32_t sss_ncache_get_timeout(struct sss_nc_ctx *ctx)
     return ctx->timeout;
 }
 
+void sss_ncache_set_max_timeout(struct sss_nc_ctx *ctx, uint32_t max_timeout)
+{
+    ctx->max_timeout = MAX(max_timeout, ctx->timeout);
+}
+
+void sss_ncache_get_stats(struct sss_nc_ctx *ctx, struct sss_nc_stats *_stats)
+{
+    *_stats = ctx->stats;
+}
+
+/* Entries are stored as "<expiration>" or "<expiration>/<streak>", where
+ * streak is the number of times in a row the key was found missing. */
+static bool sss_ncache_parse_entry(TDB_DATA data,
+                                   unsigned long long int *_timestamp,
+                                   unsigned long int *_streak)
+{
+    unsigned long long int timestamp;
+    unsigned long int streak = 0;
+    char *ep;
+
+    if (data.dptr == NULL || data.dsize == 0
+            || data.dptr[data.dsize - 1] != '\0') {
+        return false;
+    }
+
+    errno = 0;
+    timestamp = strtoull((const char *)data.dptr, &ep, 10);
+    if (errno != 0) {
+        return false;
+    }
+
+    if (*ep == '/') {
+        streak = strtoul(ep + 1, &ep, 10);
+        if (errno != 0) {
+            return false;
+        }
+    }
+
+    if (*ep != '\0') {
+        return false;
+    }
+
+    *_timestamp = timestamp;
+    *_streak = streak;
+    return true;
+}
+
+static void sss_ncache_bloom_hash(TDB_DATA key, uint32_t *_h1, uint32_t *_h2)
+{
+    *_h1 = murmurhash3((const char *)key.dptr, key.dsize, 0x5cc0ffee);
+    *_h2 = murmurhash3((const char *)key.dptr, key.dsize, 0x0b100d) | 1;
+}
+
+static void sss_ncache_bloom_add(struct sss_nc_bloom *bloom, TDB_DATA key)
+{
+    uint32_t h1;
+    uint32_t h2;
+    uint32_t bit;
+    int i;
+
+    sss_ncache_bloom_hash(key, &h1, &h2);
+    for (i = 0; i < NC_BLOOM_HASHES; i++) {
+        bit = (h1 + i * h2) % NC_BLOOM_BITS;
+        bloom->bits[bit / 8] |= 1 << (bit % 8);
+    }
+
+    bloom->keys++;
+}
+
+static bool sss_ncache_bloom_check(struct sss_nc_bloom *bloom, TDB_DATA key)
+{
+    uint32_t h1;
+    uint32_t h2;
+    uint32_t bit;
+    int i;
+
+    sss_ncache_bloom_hash(key, &h1, &h2);
+    for (i = 0; i < NC_BLOOM_HASHES; i++) {
+        bit = (h1 + i * h2) % NC_BLOOM_BITS;
+        if ((bloom->bits[bit / 8] & (1 << (bit % 8))) == 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static int bloom_add_key(struct tdb_context *tdb,
+                         TDB_DATA key, TDB_DATA data, void *state)
+{
+    sss_ncache_bloom_add(state, key);
+    return 0;
+}
+
+static void sss_ncache_bloom_rebuild(struct sss_nc_ctx *ctx)
+{
+    int ret;
+
+    memset(&ctx->bloom, 0, sizeof(ctx->bloom));
+
+    ret = tdb_traverse_read(ctx->tdb, bloom_add_key, &ctx->bloom);
+    if (ret < 0) {
+        /* Every key may be present, the filter is just not useful now. */
+        memset(ctx->bloom.bits, 0xff, sizeof(ctx->bloom.bits));
+    }
+
+    /* When the tdb itself holds too many keys for the filter, rebuilding it
+     * on every insert would not help anybody. */
+    ctx->bloom.rebuild_at = MAX(NC_BLOOM_MAX_KEYS, ctx->bloom.keys * 2);
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Negative cache filter rebuilt with %"PRIu32
+          " keys\n", ctx->bloom.keys);
+
+    /* The filter is rebuilt on every reset, a good time to tell how well it
+     * and the cache work. */
+    DEBUG(SSSDBG_TRACE_FUNC, "Negative cache lookups: %"PRIu64", answered "
+          "by the filter: %"PRIu64", filter false positives: %"PRIu64", "
+          "hits: %"PRIu64"\n", ctx->stats.lookups, ctx->stats.filtered,
+          ctx->stats.false_positives, ctx->stats.hits);
+}
+
+static void sss_ncache_bloom_store(struct sss_nc_ctx *ctx, TDB_DATA key)
+{
+    if (ctx->bloom.keys >= ctx->bloom.rebuild_at) {
+        /* The new key is already in the tdb */
+        sss_ncache_bloom_rebuild(ctx);
+        return;
+    }
+
+    sss_ncache_bloom_add(&ctx->bloom, key);
+}
+
 static int sss_ncache_check_str(struct sss_nc_ctx *ctx, char *str)
 {
     TDB_DATA key;
     TDB_DATA data;
     unsigned long long int timestamp;
+    unsigned long int streak;
     bool expired = false;
-    char *ep;
+    time_t now;
     int ret;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Checking negative cache for [%s]\n", str);
@@ -142,16 +299,22 @@ static int sss_ncache_check_str(struct sss_nc_ctx *ctx, char *str)
     ret = string_to_tdb_data(str, &key);
     if (ret != EOK) goto done;
 
+    ctx->stats.lookups++;
+    if (!sss_ncache_bloom_check(&ctx->bloom, key)) {
+        ctx->stats.filtered++;
+        ret = ENOENT;
+        goto done;
+    }
+
     data = tdb_fetch(ctx->tdb, key);
 
     if (!data.dptr) {
+        ctx->stats.false_positives++;
         ret = ENOENT;
         goto done;
     }
 
-    errno = 0;
-    timestamp = strtoull((const char *)data.dptr, &ep, 10);
-    if (errno != 0 || *ep != '\0') {
+    if (!sss_ncache_parse_entry(data, &timestamp, &streak)) {
         /* Malformed entry, remove it and return no entry */
         expired = true;
         goto done;
@@ -159,16 +322,26 @@ static int sss_ncache_check_str(struct sss_nc_ctx *ctx, char *str)
 
     if (timestamp == 0) {
         /* a 0 timestamp means this is a permanent entry */
+        ctx->stats.hits++;
         ret = EEXIST;
         goto done;
     }
 
-    if (timestamp >= time(NULL)) {
+    now = time(NULL);
+    if (timestamp >= now) {
         /* still valid */
+        ctx->stats.hits++;
         ret = EEXIST;
         goto done;
     }
 
+    /* Keep the expired entry for a while so that the streak is not lost if
+     * the key is found missing again soon. */
+    if (ctx->max_timeout > ctx->timeout && timestamp + ctx->max_timeout >= now) {
+        ret = ENOENT;
+        goto done;
+    }
+
     expired = true;
 
 done:
@@ -182,6 +355,45 @@ done:
     return ret;
 }
 
+/* A key that keeps being missing is probably not going to appear any time
+ * soon, double its timeout every time it is found missing again. Only a
+ * lookup after the entry expired counts, storing the key again while the
+ * entry is still valid keeps the streak. The streak is lost when the entry
+ * is reset or once it expired more than max_timeout seconds ago. */
+static unsigned long int sss_ncache_get_streak(struct sss_nc_ctx *ctx,
+                                               TDB_DATA key)
+{
+    unsigned long long int timestamp;
+    unsigned long long int now;
+    unsigned long int streak;
+    TDB_DATA data;
+    bool valid;
+
+    if (ctx->max_timeout <= ctx->timeout) {
+        return 0;
+    }
+
+    data = tdb_fetch(ctx->tdb, key);
+    if (data.dptr == NULL) {
+        return 0;
+    }
+
+    valid = sss_ncache_parse_entry(data, &timestamp, &streak);
+    free(data.dptr);
+    if (!valid || timestamp == 0) {
+        return 0;
+    }
+
+    now = time(NULL);
+    if (timestamp >= now) {
+        return streak;
+    } else if (timestamp + ctx->max_timeout < now) {
+        return 0;
+    }
+
+    return MIN(streak + 1, NC_MAX_STREAK);
+}
+
 static int sss_ncache_set_str(struct sss_nc_ctx *ctx, char *str,
                               bool permanent, bool use_local_negative)
 {
@@ -189,6 +401,7 @@ static int sss_ncache_set_str(struct sss_nc_ctx *ctx, char *str,
     TDB_DATA data;
     char *timest;
     unsigned long long int timell;
+    unsigned long int streak = 0;
     int ret;
 
     ret = string_to_tdb_data(str, &key);
@@ -204,10 +417,16 @@ static int sss_ncache_set_str(struct sss_nc_ctx *ctx, char *str,
             if (ctx->timeout == 0) {
                 return EOK;
             }
-            timell = ctx->timeout;
+            streak = sss_ncache_get_streak(ctx, key);
+            timell = MIN((unsigned long long int)ctx->timeout << streak,
+                         ctx->max_timeout);
         }
         timell += (unsigned long long int)time(NULL);
-        timest = talloc_asprintf(ctx, "%llu", timell);
+        if (streak > 0) {
+            timest = talloc_asprintf(ctx, "%llu/%lu", timell, streak);
+        } else {
+            timest = talloc_asprintf(ctx, "%llu", timell);
+        }
     }
     if (!timest) return ENOMEM;
 
@@ -222,8 +441,11 @@ static int sss_ncache_set_str(struct sss_nc_ctx *ctx, char *str,
         DEBUG(SSSDBG_CRIT_FAILURE, "Negative cache failed to set entry: [%s]\n",
                   tdb_errorstr(ctx->tdb));
         ret = EFAULT;
+        goto done;
     }
 
+    sss_ncache_bloom_store(ctx, key);
+
 done:
     talloc_free(timest);
     return ret;
@@ -862,8 +1084,8 @@ static int delete_permanent(struct tdb_context *tdb,
                             TDB_DATA key, TDB_DATA data, void *state)
 {
     unsigned long long int timestamp;
+    unsigned long int streak;
     bool remove_key = false;
-    char *ep;
 
     if (strncmp((char *)key.dptr,
                 NC_ENTRY_PREFIX, sizeof(NC_ENTRY_PREFIX) - 1) != 0) {
@@ -871,9 +1093,7 @@ static int delete_permanent(struct tdb_context *tdb,
         return 0;
     }
 
-    errno = 0;
-    timestamp = strtoull((const char *)data.dptr, &ep, 10);
-    if (errno != 0 || *ep != '\0') {
+    if (!sss_ncache_parse_entry(data, &timestamp, &streak)) {
         /* Malformed entry, remove it */
         remove_key = true;
         goto done;
@@ -900,6 +1120,7 @@ int sss_ncache_reset_permanent(struct sss_nc_ctx *ctx)
     if (ret < 0)
         return EIO;
 
+    sss_ncache_bloom_rebuild(ctx);
     return EOK;
 }
 
@@ -934,6 +1155,7 @@ static int sss_ncache_reset_pfx(struct sss_nc_ctx *ctx,
         }
     }
 
+    sss_ncache_bloom_rebuild(ctx);
     return EOK;
 }
 
@@ -24,12 +24,29 @@
 
 struct sss_nc_ctx;
 
+struct sss_nc_stats {
+    uint64_t lookups;
+    /* lookups answered by the bloom filter without touching the tdb */
+    uint64_t filtered;
+    /* lookups the bloom filter let through but the tdb did not know */
+    uint64_t false_positives;
+    /* lookups that found a valid negative entry */
+    uint64_t hits;
+};
+
 /* init the in memory negative cache */
 int sss_ncache_init(TALLOC_CTX *memctx, uint32_t timeout,
                     uint32_t local_timeout, struct sss_nc_ctx **_ctx);
 
 uint32_t sss_ncache_get_timeout(struct sss_nc_ctx *ctx);
 
+/* Keys found missing again soon after their entry expired get twice the
+ * previous timeout, up to max_timeout. The default max_timeout is the
+ * timeout passed to sss_ncache_init(), i.e. no growth. */
+void sss_ncache_set_max_timeout(struct sss_nc_ctx *ctx, uint32_t max_timeout);
+
+void sss_ncache_get_stats(struct sss_nc_ctx *ctx, struct sss_nc_stats *_stats);
+
 /* check if the user is expired according to the passed in time to live */
 int sss_ncache_check_user(struct sss_nc_ctx *ctx, struct sss_domain_info *dom,
                           const char *name);
@@ -97,6 +97,21 @@ struct be_conn {
     char *bus_name;
     char *sbus_address;
     struct sbus_connection *conn;
+
+    /* Binary IPC for account lookups, NULL if dp_binary_ipc is disabled */
+    struct sss_fast_client *fast;
+    /* Do not try to reconnect the binary IPC before this time */
+    time_t fast_retry;
+};
+
+/* Background refreshes of expired and midpoint cache entries */
+struct cache_req_refresh_stats {
+    uint64_t stale_served;      /* expired entries returned from the cache */
+    uint64_t started;           /* refreshes sent to the data provider */
+    uint64_t coalesced;         /* refreshes that joined a running one */
+    uint64_t finished;          /* refreshes that returned */
+    uint64_t latency_total_ms;  /* sum of the latency of finished ones */
+    uint64_t latency_max_ms;    /* the slowest finished one */
 };
 
 struct resp_ctx {
@@ -149,6 +164,13 @@ struct resp_ctx {
 
     uint32_t cache_req_num;
 
+    /* Expired entries are returned for this many seconds after they
+     * expire while they are refreshed in the background. */
+    int cache_stale_grace;
+    /* Running background refreshes by object, see cache_req_search.c */
+    hash_table_t *cache_refreshes;
+    struct cache_req_refresh_stats cache_refresh_stats;
+
     void *pvt_ctx;
 
     bool shutting_down;
@@ -216,6 +238,10 @@ int sss_process_init(TALLOC_CTX *mem_ctx,
 
 int sss_dp_get_domain_conn(struct resp_ctx *rctx, const char *domain,
                            struct be_conn **_conn);
+
+/* Connects the binary IPC to the data provider if it is enabled and not
+ * connected yet. Failures are not fatal, sbus is used instead. */
+void sss_dp_fast_connect(struct be_conn *be_conn);
 struct sss_domain_info *
 responder_get_domain(struct resp_ctx *rctx, const char *domain);
 
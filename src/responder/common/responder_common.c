@@ -41,7 +41,9 @@
 #include "responder/common/responder_packet.h"
 #include "providers/data_provider.h"
 #include "util/util_creds.h"
+#include "util/sss_ptr_hash.h"
 #include "sss_iface/sss_iface_async.h"
+#include "sss_iface/sss_iface_fast.h"
 
 #ifdef HAVE_SYSTEMD
 #include <systemd/sd-daemon.h>
@@ -812,11 +814,55 @@ sss_dp_on_reconnect(struct sbus_connection *conn,
     tevent_req_set_callback(req, sss_dp_init_done, be_conn);
 }
 
+/* Seconds between attempts to connect the binary IPC */
+#define SSS_DP_FAST_RETRY_INTERVAL 5
+
+void sss_dp_fast_connect(struct be_conn *be_conn)
+{
+    char *path;
+    time_t now;
+    errno_t ret;
+
+    if (!be_conn->domain->dp_binary_ipc
+            || sss_fast_client_is_connected(be_conn->fast)) {
+        return;
+    }
+
+    now = time(NULL);
+    if (now < be_conn->fast_retry) {
+        return;
+    }
+    be_conn->fast_retry = now + SSS_DP_FAST_RETRY_INTERVAL;
+
+    talloc_zfree(be_conn->fast);
+
+    path = talloc_asprintf(be_conn, SSS_BACKEND_FAST_ADDRESS,
+                           get_domains_head(be_conn->domain)->name);
+    if (path == NULL) {
+        return;
+    }
+
+    ret = sss_fast_client_connect(be_conn, be_conn->rctx->ev, path,
+                                  &be_conn->fast);
+    talloc_free(path);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to connect to DP over binary "
+              "IPC [%d]: %s, using sbus\n", ret, sss_strerror(ret));
+        return;
+    }
+
+    be_conn->fast_retry = 0;
+    DEBUG(SSSDBG_TRACE_FUNC, "Connected to DP over binary IPC\n");
+}
+
 static void
 sss_dp_init_done(struct tevent_req *req)
 {
+    struct be_conn *be_conn;
     errno_t ret;
 
+    be_conn = tevent_req_callback_data(req, struct be_conn);
+
     ret = sbus_call_dp_client_Register_recv(req);
     talloc_zfree(req);
 
@@ -826,6 +872,8 @@ sss_dp_init_done(struct tevent_req *req)
     }
 
     DEBUG(SSSDBG_TRACE_FUNC, "Client is registered with DP\n");
+
+    sss_dp_fast_connect(be_conn);
 }
 
 int create_pipe_fd(const char *sock_name, int *_fd, mode_t umaskval)
@@ -1121,6 +1169,7 @@ static errno_t responder_init_ncache(TALLOC_CTX *mem_ctx,
                                      struct sss_nc_ctx **ncache)
 {
     uint32_t neg_timeout;
+    uint32_t neg_timeout_max;
     uint32_t locals_timeout;
     int tmp_value;
     int ret;
@@ -1143,6 +1192,25 @@ static errno_t responder_init_ncache(TALLOC_CTX *mem_ctx,
 
     neg_timeout = tmp_value;
 
+    /* neg_timeout_max, like neg_timeout it is read from the [nss] section
+     * for all responders */
+    ret = confdb_get_int(cdb, CONFDB_NSS_CONF_ENTRY,
+                         CONFDB_NSS_ENTRY_NEG_TIMEOUT_MAX,
+                         0, &tmp_value);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Fatal failure of setup negative cache timeout.\n");
+        ret = ENOENT;
+        goto done;
+    }
+
+    if (tmp_value < 0) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    neg_timeout_max = tmp_value;
+
     /* local_timeout */
     ret = confdb_get_int(cdb, CONFDB_NSS_CONF_ENTRY,
                          CONFDB_RESPONDER_LOCAL_NEG_TIMEOUT,
@@ -1170,6 +1238,8 @@ static errno_t responder_init_ncache(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    sss_ncache_set_max_timeout(*ncache, neg_timeout_max);
+
     ret = EOK;
 
 done:
@@ -1280,6 +1350,12 @@ int sss_process_init(TALLOC_CTX *mem_ctx,
 
     talloc_set_destructor((TALLOC_CTX*)rctx, sss_responder_ctx_destructor);
 
+    ret = sss_packet_pool_init(rctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Unable to create packet pool\n");
+        goto fail;
+    }
+
     ret = confdb_get_int(rctx->cdb, rctx->confdb_service_path,
                          CONFDB_RESPONDER_CLI_IDLE_TIMEOUT,
                          CONFDB_RESPONDER_CLI_IDLE_DEFAULT_TIMEOUT,
@@ -1314,6 +1390,29 @@ int sss_process_init(TALLOC_CTX *mem_ctx,
               ret, sss_strerror(ret));
     }
 
+    ret = confdb_get_int(rctx->cdb, rctx->confdb_service_path,
+                         CONFDB_RESPONDER_ENTRY_CACHE_GRACE_PERIOD,
+                         CONFDB_RESPONDER_ENTRY_CACHE_GRACE_PERIOD_DEFAULT,
+                         &rctx->cache_stale_grace);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot get the entry cache grace period [%d]: %s\n",
+               ret, sss_strerror(ret));
+        goto fail;
+    }
+
+    if (rctx->cache_stale_grace < 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "grace period can't be set to negative "
+              "value, disabling it\n");
+        rctx->cache_stale_grace = 0;
+    }
+
+    rctx->cache_refreshes = sss_ptr_hash_create(rctx, NULL, NULL);
+    if (rctx->cache_refreshes == NULL) {
+        ret = ENOMEM;
+        goto fail;
+    }
+
     ret = confdb_get_int(rctx->cdb, rctx->confdb_service_path,
                          CONFDB_RESPONDER_GET_DOMAINS_TIMEOUT,
                          GET_DOMAINS_DEFAULT_TIMEOUT, &rctx->domains_timeout);
@@ -26,6 +26,7 @@
 #include "responder/common/responder_packet.h"
 #include "responder/common/responder.h"
 #include "providers/data_provider.h"
+#include "sss_iface/sss_iface_fast.h"
 
 static errno_t
 sss_dp_account_files_params(struct sss_domain_info *dom,
@@ -160,11 +161,20 @@ sss_dp_get_account_filter(TALLOC_CTX *mem_ctx,
 }
 
 struct sss_dp_get_account_state {
+    struct be_conn *be_conn;
+    uint32_t dp_flags;
+    uint32_t entry_type;
+    const char *filter;
+    const char *domain;
+    const char *extra;
+
     uint16_t dp_error;
     uint32_t error;
     const char *error_message;
 };
 
+static void sss_dp_get_account_fast_done(struct tevent_req *subreq);
+static errno_t sss_dp_get_account_sbus(struct tevent_req *req);
 static void sss_dp_get_account_done(struct tevent_req *subreq);
 
 struct tevent_req *
@@ -262,16 +272,38 @@ sss_dp_get_account_send(TALLOC_CTX *mem_ctx,
           dom->name, entry_type, be_req2str(entry_type),
           filter, extra == NULL ? "-" : extra);
 
-    subreq = sbus_call_dp_dp_getAccountInfo_send(state, be_conn->conn,
-                 be_conn->bus_name, SSS_BUS_PATH, dp_flags,
-                 entry_type, filter, dom->name, extra);
+    state->be_conn = be_conn;
+    state->dp_flags = dp_flags;
+    state->entry_type = entry_type;
+    state->filter = filter;
+    state->domain = dom->name;
+    state->extra = talloc_strdup(state, extra);
+    if (extra != NULL && state->extra == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* The connection is lost when the backend restarts, reconnect it
+     * lazily. */
+    sss_dp_fast_connect(be_conn);
+    if (!sss_fast_client_is_connected(be_conn->fast)) {
+        ret = sss_dp_get_account_sbus(req);
+        if (ret == EOK) {
+            ret = EAGAIN;
+        }
+        goto done;
+    }
+
+    subreq = sss_fast_dp_getAccountInfo_send(state, be_conn->fast, dp_flags,
+                                             entry_type, filter, dom->name,
+                                             extra);
     if (subreq == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
         ret = ENOMEM;
         goto done;
     }
 
-    tevent_req_set_callback(subreq, sss_dp_get_account_done, req);
+    tevent_req_set_callback(subreq, sss_dp_get_account_fast_done, req);
 
     ret = EAGAIN;
 
@@ -287,6 +319,60 @@ done:
     return req;
 }
 
+static void sss_dp_get_account_fast_done(struct tevent_req *subreq)
+{
+    struct sss_dp_get_account_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sss_dp_get_account_state);
+
+    ret = sss_fast_dp_getAccountInfo_recv(state, subreq, &state->dp_error,
+                                          &state->error,
+                                          &state->error_message);
+    talloc_zfree(subreq);
+    if (ret == ENOTCONN) {
+        /* The request is resent over sbus. The data provider does not
+         * chain it with the original lookup, which keeps running and
+         * only updates the cache, so the back end may be asked twice. */
+        DEBUG(SSSDBG_MINOR_FAILURE, "Binary IPC connection lost, "
+              "retrying over sbus\n");
+        ret = sss_dp_get_account_sbus(req);
+        if (ret != EOK) {
+            tevent_req_error(req, ret);
+        }
+        return;
+    } else if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
+static errno_t sss_dp_get_account_sbus(struct tevent_req *req)
+{
+    struct sss_dp_get_account_state *state;
+    struct tevent_req *subreq;
+
+    state = tevent_req_data(req, struct sss_dp_get_account_state);
+
+    subreq = sbus_call_dp_dp_getAccountInfo_send(state, state->be_conn->conn,
+                 state->be_conn->bus_name, SSS_BUS_PATH, state->dp_flags,
+                 state->entry_type, state->filter, state->domain,
+                 state->extra);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        return ENOMEM;
+    }
+
+    tevent_req_set_callback(subreq, sss_dp_get_account_done, req);
+
+    return EOK;
+}
+
 static void sss_dp_get_account_done(struct tevent_req *subreq)
 {
     struct sss_dp_get_account_state *state;
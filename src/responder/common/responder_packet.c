@@ -21,6 +21,7 @@
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <string.h>
 #include <errno.h>
 #include <talloc.h>
@@ -30,9 +31,33 @@
 
 #define SSSSRV_PACKET_MEM_SIZE 512
 
+/* Maximum number of buffers kept by the packet pool and the largest buffer
+ * that is returned to it. Bigger buffers are freed right away. */
+#define SSS_PACKET_POOL_SIZE 16
+#define SSS_PACKET_POOL_MAX_BUFSIZE (1024 * 1024)
+
+/* Maximum number of body fragments that can be added to a packet. */
+#define SSS_PACKET_MAX_FRAGMENTS 8
+
+struct sss_packet_pool {
+    uint8_t *buffers[SSS_PACKET_POOL_SIZE];
+    size_t sizes[SSS_PACKET_POOL_SIZE];
+    size_t num_buffers;
+
+    struct sss_packet_pool_stats stats;
+};
+
+/* Each responder is a separate process with a single event loop, so one
+ * pool per process is one pool per responder. */
+static struct sss_packet_pool *packet_pool = NULL;
+
 struct sss_packet {
     size_t memsize;
 
+    /* size of the allocated buffer, a pooled buffer may be larger than
+     * memsize which also limits how much data is received */
+    size_t bufsize;
+
     /* Structure of the buffer:
     * Bytes    Content
     * ---------------------------------
@@ -46,6 +71,12 @@ struct sss_packet {
 
     /* io pointer */
     size_t iop;
+
+    /* Data sent after buffer without being copied into it. The packet
+     * length in the header includes the length of the fragments. */
+    struct iovec frags[SSS_PACKET_MAX_FRAGMENTS];
+    size_t num_frags;
+    size_t frags_len;
 };
 
 /* Offsets to data in sss_packet's buffer */
@@ -59,6 +90,124 @@ static void sss_packet_set_cmd(struct sss_packet *packet,
                                enum sss_cli_command cmd);
 static uint32_t sss_packet_get_len(struct sss_packet *packet);
 
+static int sss_packet_pool_destructor(struct sss_packet_pool *pool)
+{
+    if (packet_pool == pool) {
+        packet_pool = NULL;
+    }
+
+    return 0;
+}
+
+int sss_packet_pool_init(TALLOC_CTX *mem_ctx)
+{
+    struct sss_packet_pool *pool;
+
+    if (packet_pool != NULL) {
+        return EOK;
+    }
+
+    pool = talloc_zero(mem_ctx, struct sss_packet_pool);
+    if (pool == NULL) {
+        return ENOMEM;
+    }
+
+    talloc_set_destructor(pool, sss_packet_pool_destructor);
+    packet_pool = pool;
+
+    return EOK;
+}
+
+void sss_packet_pool_get_stats(struct sss_packet_pool_stats *stats)
+{
+    if (packet_pool == NULL) {
+        memset(stats, 0, sizeof(struct sss_packet_pool_stats));
+        return;
+    }
+
+    *stats = packet_pool->stats;
+}
+
+/* Returns the smallest pooled buffer that can hold size bytes or allocates
+ * a new one. */
+static uint8_t *sss_packet_buffer_get(struct sss_packet *packet,
+                                      size_t size,
+                                      size_t *_bufsize)
+{
+    uint8_t *buffer;
+    size_t best;
+    size_t i;
+
+    if (packet_pool != NULL) {
+        best = packet_pool->num_buffers;
+        for (i = 0; i < packet_pool->num_buffers; i++) {
+            if (packet_pool->sizes[i] < size) {
+                continue;
+            }
+
+            if (best == packet_pool->num_buffers
+                    || packet_pool->sizes[i] < packet_pool->sizes[best]) {
+                best = i;
+            }
+        }
+
+        if (best != packet_pool->num_buffers) {
+            buffer = talloc_steal(packet, packet_pool->buffers[best]);
+            *_bufsize = packet_pool->sizes[best];
+
+            packet_pool->num_buffers--;
+            packet_pool->buffers[best] =
+                packet_pool->buffers[packet_pool->num_buffers];
+            packet_pool->sizes[best] =
+                packet_pool->sizes[packet_pool->num_buffers];
+            packet_pool->stats.hits++;
+            return buffer;
+        }
+
+        packet_pool->stats.misses++;
+    }
+
+    buffer = talloc_size(packet, size);
+    if (buffer == NULL) {
+        return NULL;
+    }
+
+    *_bufsize = size;
+    return buffer;
+}
+
+static int sss_packet_destructor(struct sss_packet *packet)
+{
+    size_t used;
+
+    if (packet_pool == NULL
+            || packet->buffer == NULL
+            || packet->bufsize > SSS_PACKET_POOL_MAX_BUFSIZE
+            || packet_pool->num_buffers == SSS_PACKET_POOL_SIZE) {
+        return 0;
+    }
+
+    /* Packets may contain passwords, do not keep any data around. */
+    used = sss_packet_get_len(packet) - packet->frags_len;
+    if (used < packet->iop) {
+        used = packet->iop;
+    }
+    if (used > packet->memsize) {
+        used = packet->memsize;
+    }
+    sss_erase_mem_securely(packet->buffer, used);
+
+    packet_pool->buffers[packet_pool->num_buffers] =
+        talloc_steal(packet_pool, packet->buffer);
+    packet_pool->sizes[packet_pool->num_buffers] = packet->bufsize;
+    packet_pool->num_buffers++;
+    packet_pool->stats.recycled++;
+
+    packet->buffer = NULL;
+
+    return 0;
+}
+
 /*
  * Allocate a new packet structure
  *
@@ -70,22 +219,24 @@ int sss_packet_new(TALLOC_CTX *mem_ctx, size_t size,
                    struct sss_packet **rpacket)
 {
     struct sss_packet *packet;
+    size_t memsize;
 
-    packet = talloc(mem_ctx, struct sss_packet);
+    packet = talloc_zero(mem_ctx, struct sss_packet);
     if (!packet) return ENOMEM;
 
     if (size) {
         int n = (size + SSS_NSS_HEADER_SIZE) / SSSSRV_PACKET_MEM_SIZE;
-        packet->memsize = (n + 1) * SSSSRV_PACKET_MEM_SIZE;
+        memsize = (n + 1) * SSSSRV_PACKET_MEM_SIZE;
     } else {
-        packet->memsize = SSSSRV_PACKET_MEM_SIZE;
+        memsize = SSSSRV_PACKET_MEM_SIZE;
     }
 
-    packet->buffer = talloc_size(packet, packet->memsize);
+    packet->buffer = sss_packet_buffer_get(packet, memsize, &packet->bufsize);
     if (!packet->buffer) {
         talloc_free(packet);
         return ENOMEM;
     }
+    packet->memsize = memsize;
     memset(packet->buffer, 0, SSS_NSS_HEADER_SIZE);
 
     sss_packet_set_len(packet, size + SSS_NSS_HEADER_SIZE);
@@ -93,54 +244,82 @@ int sss_packet_new(TALLOC_CTX *mem_ctx, size_t size,
 
     packet->iop = 0;
 
+    talloc_set_destructor(packet, sss_packet_destructor);
+
     *rpacket = packet;
 
     return EOK;
 }
 
-/* grows a packet size only in SSSSRV_PACKET_MEM_SIZE chunks */
-int sss_packet_grow(struct sss_packet *packet, size_t size)
+/* makes sure at least size more bytes fit into the packet without
+ * changing its length; the buffer grows at least twice at a time so
+ * building large replies piece by piece stays linear */
+int sss_packet_reserve(struct sss_packet *packet, size_t size)
 {
     size_t totlen, len;
     uint8_t *newmem;
     uint32_t packet_len;
 
-    if (size == 0) {
-        return EOK;
+    if (packet->num_frags != 0) {
+        /* The body can not be extended once fragments were added. */
+        return EINVAL;
     }
 
-    totlen = packet->memsize;
     packet_len = sss_packet_get_len(packet);
 
     len = packet_len + size;
 
     /* make sure we do not overflow */
+    if (len < packet_len || len > UINT32_MAX) {
+        return EINVAL;
+    }
+
+    if (len <= packet->memsize) {
+        return EOK;
+    }
+
+    totlen = packet->memsize * 2;
     if (totlen < len) {
-        int n = len / SSSSRV_PACKET_MEM_SIZE + 1;
-        totlen += n * SSSSRV_PACKET_MEM_SIZE;
-        if (totlen < len) {
-            return EINVAL;
-        }
+        totlen = len;
+    }
+    totlen = (totlen / SSSSRV_PACKET_MEM_SIZE + 1) * SSSSRV_PACKET_MEM_SIZE;
+    if (totlen < len) {
+        return EINVAL;
     }
 
-    if (totlen > packet->memsize) {
+    if (totlen > packet->bufsize) {
         newmem = talloc_realloc_size(packet, packet->buffer, totlen);
         if (!newmem) {
             return ENOMEM;
         }
 
-        packet->memsize = totlen;
+        packet->bufsize = totlen;
+        packet->buffer = newmem;
+    }
+
+    packet->memsize = totlen;
 
-        /* re-set pointers if realloc had to move memory */
-        if (newmem != packet->buffer) {
-            packet->buffer = newmem;
-        }
+    return EOK;
+}
+
+int sss_packet_grow(struct sss_packet *packet, size_t size)
+{
+    uint32_t packet_len;
+    int ret;
+
+    if (size == 0) {
+        return EOK;
     }
 
+    ret = sss_packet_reserve(packet, size);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    packet_len = sss_packet_get_len(packet);
     packet_len += size;
     sss_packet_set_len(packet, packet_len);
 
-
     return 0;
 }
 
@@ -151,6 +330,8 @@ int sss_packet_shrink(struct sss_packet *packet, size_t size)
     size_t newlen;
     size_t oldlen = sss_packet_get_len(packet);
 
+    if (packet->num_frags != 0) return EINVAL;
+
     if (size > oldlen) return EINVAL;
 
     newlen = oldlen - size;
@@ -164,6 +345,8 @@ int sss_packet_set_size(struct sss_packet *packet, size_t size)
 {
     size_t newlen;
 
+    if (packet->num_frags != 0) return EINVAL;
+
     newlen = SSS_NSS_HEADER_SIZE + size;
 
     /* make sure we do not overflow */
@@ -174,6 +357,36 @@ int sss_packet_set_size(struct sss_packet *packet, size_t size)
     return 0;
 }
 
+int sss_packet_append_fragment(struct sss_packet *packet,
+                               uint8_t *data, size_t len)
+{
+    uint32_t packet_len;
+
+    if (len == 0) {
+        return EOK;
+    }
+
+    if (packet->num_frags == SSS_PACKET_MAX_FRAGMENTS) {
+        return ENOSPC;
+    }
+
+    packet_len = sss_packet_get_len(packet);
+    if (packet_len + len < packet_len || packet_len + len > UINT32_MAX) {
+        return EINVAL;
+    }
+
+    talloc_steal(packet, data);
+
+    packet->frags[packet->num_frags].iov_base = data;
+    packet->frags[packet->num_frags].iov_len = len;
+    packet->num_frags++;
+    packet->frags_len += len;
+
+    sss_packet_set_len(packet, packet_len + len);
+
+    return EOK;
+}
+
 int sss_packet_recv(struct sss_packet *packet, int fd)
 {
     size_t rb;
@@ -239,9 +452,51 @@ int sss_packet_recv(struct sss_packet *packet, int fd)
     return EOK;
 }
 
+/* Sends the header and inline body followed by all fragments with a single
+ * sendmsg() call, starting at the io pointer. */
+static ssize_t sss_packet_sendmsg(struct sss_packet *packet, int fd)
+{
+    struct iovec iov[SSS_PACKET_MAX_FRAGMENTS + 1];
+    struct msghdr msg;
+    size_t inline_len;
+    size_t skip;
+    size_t i;
+    int n = 0;
+
+    inline_len = sss_packet_get_len(packet) - packet->frags_len;
+    skip = packet->iop;
+
+    if (skip < inline_len) {
+        iov[n].iov_base = packet->buffer + skip;
+        iov[n].iov_len = inline_len - skip;
+        n++;
+        skip = 0;
+    } else {
+        skip -= inline_len;
+    }
+
+    for (i = 0; i < packet->num_frags; i++) {
+        if (skip >= packet->frags[i].iov_len) {
+            skip -= packet->frags[i].iov_len;
+            continue;
+        }
+
+        iov[n].iov_base = (uint8_t *)packet->frags[i].iov_base + skip;
+        iov[n].iov_len = packet->frags[i].iov_len - skip;
+        n++;
+        skip = 0;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = n;
+
+    return sendmsg(fd, &msg, 0);
+}
+
 int sss_packet_send(struct sss_packet *packet, int fd)
 {
-    size_t rb;
+    ssize_t rb;
     size_t len;
     void *buf;
 
@@ -250,11 +505,15 @@ int sss_packet_send(struct sss_packet *packet, int fd)
         return EINVAL;
     }
 
-    buf = packet->buffer + packet->iop;
-    len = sss_packet_get_len(packet) - packet->iop;
-
     errno = 0;
-    rb = send(fd, buf, len, 0);
+    if (packet->num_frags == 0) {
+        buf = packet->buffer + packet->iop;
+        len = sss_packet_get_len(packet) - packet->iop;
+
+        rb = send(fd, buf, len, 0);
+    } else {
+        rb = sss_packet_sendmsg(packet, fd);
+    }
 
     if (rb == -1) {
         if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
@@ -297,7 +556,8 @@ uint32_t sss_packet_get_status(struct sss_packet *packet)
 void sss_packet_get_body(struct sss_packet *packet, uint8_t **body, size_t *blen)
 {
     *body = packet->buffer + SSS_PACKET_BODY_OFFSET;
-    *blen = sss_packet_get_len(packet) - SSS_NSS_HEADER_SIZE;
+    *blen = sss_packet_get_len(packet) - SSS_NSS_HEADER_SIZE
+                - packet->frags_len;
 }
 
 void sss_packet_set_error(struct sss_packet *packet, int error)
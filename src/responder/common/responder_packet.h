@@ -29,12 +29,29 @@
 
 struct sss_packet;
 
+struct sss_packet_pool_stats {
+    uint64_t hits;      /* buffers taken from the pool */
+    uint64_t misses;    /* buffers that had to be allocated */
+    uint64_t recycled;  /* buffers returned to the pool */
+};
+
+/* Keep buffers of freed packets for reuse by new packets. The pool is
+ * shared by all packets of the process and lives as long as mem_ctx. */
+int sss_packet_pool_init(TALLOC_CTX *mem_ctx);
+void sss_packet_pool_get_stats(struct sss_packet_pool_stats *stats);
+
 int sss_packet_new(TALLOC_CTX *mem_ctx, size_t size,
                    enum sss_cli_command cmd,
                    struct sss_packet **rpacket);
+int sss_packet_reserve(struct sss_packet *packet, size_t size);
 int sss_packet_grow(struct sss_packet *packet, size_t size);
 int sss_packet_shrink(struct sss_packet *packet, size_t size);
 int sss_packet_set_size(struct sss_packet *packet, size_t size);
+/* Append data to the packet body without copying it, the packet takes
+ * ownership of @data. The data is sent after the body returned by
+ * sss_packet_get_body() and the body can not be changed in size anymore. */
+int sss_packet_append_fragment(struct sss_packet *packet,
+                               uint8_t *data, size_t len);
 int sss_packet_recv(struct sss_packet *packet, int fd);
 int sss_packet_send(struct sss_packet *packet, int fd);
 enum sss_cli_command sss_packet_get_cmd(struct sss_packet *packet);
@@ -600,7 +600,18 @@ ifp_groups_group_get(TALLOC_CTX *mem_ctx,
     }
 
     if (_group != NULL) {
-        ret = ifp_groups_get_from_cache(mem_ctx, domain, key, _group);
+        ret = ifp_snapshot_get(mem_ctx, ctx, sbus_req, _group);
+        if (ret == ENOENT) {
+            ret = ifp_groups_get_from_cache(mem_ctx, domain, key, _group);
+            if (ret == EOK) {
+                ret = ifp_snapshot_store(ctx, sbus_req, *_group);
+                if (ret != EOK) {
+                    DEBUG(SSSDBG_MINOR_FAILURE, "Unable to store group "
+                          "snapshot [%d]: %s\n", ret, sss_strerror(ret));
+                    ret = EOK;
+                }
+            }
+        }
     }
 
     talloc_free(key);
@@ -623,7 +634,11 @@ struct resolv_ghosts_state {
 
     struct sss_domain_info *domain;
     const char **ghosts;
+    int num_ghosts;
     int index;
+    int active;
+    int resolved;
+    int limit;
 };
 
 static void resolv_ghosts_group_done(struct tevent_req *subreq);
@@ -701,6 +716,9 @@ static void resolv_ghosts_group_done(struct tevent_req *subreq)
     req = tevent_req_callback_data(subreq, struct tevent_req);
     state = tevent_req_data(req, struct resolv_ghosts_state);
 
+    /* The group was just refreshed, do not read the old snapshot. */
+    ifp_snapshot_invalidate(state->ctx, state->sbus_req->path);
+
     ret = ifp_groups_group_get(state, state->sbus_req, state->ctx,
                                &state->domain, &group);
     if (ret != EOK) {
@@ -719,7 +737,21 @@ static void resolv_ghosts_group_done(struct tevent_req *subreq)
         goto done;
     }
 
+    /* Resolve only a part of the members if requested, the rest will be
+     * resolved by subsequent calls. Only resolved members count towards
+     * the limit, members that can not be resolved stay in the list and
+     * must not block the others. */
+    state->num_ghosts = el->num_values;
+    state->limit = state->ctx->resolve_members_limit;
+    if (state->limit > 0 && state->num_ghosts > state->limit) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Group has %d unresolved members, "
+              "resolving only %d of them\n", state->num_ghosts,
+              state->limit);
+    }
+
     state->index = 0;
+    state->active = 0;
+    state->resolved = 0;
     ret = resolv_ghosts_step(req);
 
 done:
@@ -737,22 +769,31 @@ errno_t resolv_ghosts_step(struct tevent_req *req)
 
     state = tevent_req_data(req, struct resolv_ghosts_state);
 
-    if (state->ghosts[state->index] == NULL) {
-        return EOK;
-    }
+    /* Keep up to resolve_members_concurrency lookups in progress but do not
+     * start more of them than is needed to reach the limit. */
+    while (state->index < state->num_ghosts
+            && state->active < state->ctx->resolve_members_concurrency
+            && (state->limit <= 0
+                    || state->resolved + state->active < state->limit)) {
+        subreq = cache_req_user_by_name_send(state, state->ev,
+                                             state->ctx->rctx,
+                                             state->ctx->rctx->ncache, 0,
+                                             CACHE_REQ_ANY_DOM,
+                                             state->domain->name,
+                                             state->ghosts[state->index]);
+        if (subreq == NULL) {
+            return ENOMEM;
+        }
 
-    subreq = cache_req_user_by_name_send(state, state->ev, state->ctx->rctx,
-                                         state->ctx->rctx->ncache, 0,
-                                         CACHE_REQ_ANY_DOM,
-                                         state->domain->name,
-                                         state->ghosts[state->index]);
-    if (subreq == NULL) {
-        return ENOMEM;
-    }
+        tevent_req_set_callback(subreq, resolv_ghosts_done, req);
 
-    tevent_req_set_callback(subreq, resolv_ghosts_done, req);
+        state->index++;
+        state->active++;
+    }
 
-    state->index++;
+    if (state->active == 0) {
+        return EOK;
+    }
 
     return EAGAIN;
 }
@@ -768,7 +809,19 @@ static void resolv_ghosts_done(struct tevent_req *subreq)
 
     ret = cache_req_user_by_name_recv(state, subreq, NULL);
     talloc_zfree(subreq);
-    if (ret != EOK) {
+    state->active--;
+
+    /* Resolved ghost user becomes a regular member of the group. */
+    ifp_snapshot_invalidate(state->ctx, state->sbus_req->path);
+
+    if (ret == EOK) {
+        state->resolved++;
+    } else if (ret == ENOENT) {
+        /* The user was removed from the server, there is nothing to
+         * resolve. Continue with the other members. */
+        DEBUG(SSSDBG_TRACE_FUNC, "Ghost member was not found, skipping\n");
+    } else {
+        /* The remaining lookups are freed together with this request. */
         goto done;
     }
 
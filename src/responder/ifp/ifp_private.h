@@ -42,6 +42,11 @@ struct ifp_ctx {
     struct sbus_connection *sysbus;
     const char **user_whitelist;
     uint32_t wildcard_limit;
+    int resolve_members_concurrency;
+    int resolve_members_limit;
+
+    /* Short-lived copies of recently read objects, indexed by object path. */
+    hash_table_t *snapshots;
 };
 
 errno_t
@@ -132,4 +137,28 @@ errno_t ifp_ldb_el_output_name(struct resp_ctx *rctx,
 char *ifp_format_name_attr(TALLOC_CTX *mem_ctx, struct ifp_ctx *ifp_ctx,
                            const char *in_name, struct sss_domain_info *dom);
 
+/* Object snapshots
+ *
+ * Each D-Bus property is read by a separate getter, which would otherwise
+ * look the object up in the cache over and over again during a single
+ * GetAll call or when a client reads several properties in a row. Object
+ * read from sysdb is therefore remembered for the rest of the GetAll call
+ * and for IFP_SNAPSHOT_TIMEOUT seconds. */
+#define IFP_SNAPSHOT_TIMEOUT 1
+#define IFP_SNAPSHOT_MAX 1024
+
+errno_t ifp_snapshot_init(struct ifp_ctx *ifp_ctx);
+
+/* Returns ENOENT if there is no snapshot of the sbus_req->path object. */
+errno_t ifp_snapshot_get(TALLOC_CTX *mem_ctx,
+                         struct ifp_ctx *ifp_ctx,
+                         struct sbus_request *sbus_req,
+                         struct ldb_message **_msg);
+
+errno_t ifp_snapshot_store(struct ifp_ctx *ifp_ctx,
+                           struct sbus_request *sbus_req,
+                           struct ldb_message *msg);
+
+void ifp_snapshot_invalidate(struct ifp_ctx *ifp_ctx, const char *path);
+
 #endif /* _IFPSRV_PRIVATE_H_ */
@@ -1110,7 +1110,18 @@ ifp_users_user_get(TALLOC_CTX *mem_ctx,
     }
 
     if (_user != NULL) {
-        ret = ifp_users_get_from_cache(mem_ctx, domain, key, _user);
+        ret = ifp_snapshot_get(mem_ctx, ifp_ctx, sbus_req, _user);
+        if (ret == ENOENT) {
+            ret = ifp_users_get_from_cache(mem_ctx, domain, key, _user);
+            if (ret == EOK) {
+                ret = ifp_snapshot_store(ifp_ctx, sbus_req, *_user);
+                if (ret != EOK) {
+                    DEBUG(SSSDBG_MINOR_FAILURE, "Unable to store user "
+                          "snapshot [%d]: %s\n", ret, sss_strerror(ret));
+                    ret = EOK;
+                }
+            }
+        }
     }
 
     talloc_free(key);
@@ -1211,7 +1222,8 @@ ifp_users_get_as_uint32(struct sbus_request *sbus_req,
 }
 
 struct ifp_users_user_update_groups_list_state {
-    int dummy;
+    struct ifp_ctx *ctx;
+    const char *path;
 };
 
 static void ifp_users_user_update_groups_list_done(struct tevent_req *subreq);
@@ -1236,6 +1248,13 @@ ifp_users_user_update_groups_list_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
+    state->ctx = ctx;
+    state->path = talloc_strdup(state, sbus_req->path);
+    if (state->path == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
     ret = ifp_users_user_get(state, sbus_req, ctx, &domain, &user);
     if (ret != EOK) {
         goto done;
@@ -1282,6 +1301,10 @@ static void ifp_users_user_update_groups_list_done(struct tevent_req *subreq)
 
     ret = cache_req_initgr_by_name_recv(state, subreq, NULL);
     talloc_zfree(subreq);
+
+    /* Group memberships were refreshed. */
+    ifp_snapshot_invalidate(state->ctx, state->path);
+
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
@@ -252,6 +252,33 @@ int ifp_process_init(TALLOC_CTX *mem_ctx,
         }
     }
 
+    ret = confdb_get_int(ifp_ctx->rctx->cdb, CONFDB_IFP_CONF_ENTRY,
+                         CONFDB_IFP_RESOLVE_MEMBERS_CONCURRENCY,
+                         CONFDB_DEFAULT_IFP_RESOLVE_MEMBERS_CONCURRENCY,
+                         &ifp_ctx->resolve_members_concurrency);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get member resolution concurrency\n");
+        goto fail;
+    }
+
+    if (ifp_ctx->resolve_members_concurrency <= 0) {
+        ifp_ctx->resolve_members_concurrency = 1;
+    }
+
+    ret = confdb_get_int(ifp_ctx->rctx->cdb, CONFDB_IFP_CONF_ENTRY,
+                         CONFDB_IFP_RESOLVE_MEMBERS_LIMIT, 0,
+                         &ifp_ctx->resolve_members_limit);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Failed to get member resolution limit\n");
+        goto fail;
+    }
+
+    ret = ifp_snapshot_init(ifp_ctx);
+    if (ret != EOK) {
+        goto fail;
+    }
+
     /* Connect to the D-BUS system bus and set up methods */
     ret = sysbus_init(ifp_ctx, ifp_ctx->rctx->ev, IFP_BUS,
                       ifp_ctx, &ifp_ctx->sysbus);
@@ -24,6 +24,7 @@
 #include <sys/param.h>
 
 #include "db/sysdb.h"
+#include "util/sss_ptr_hash.h"
 #include "responder/ifp/ifp_private.h"
 
 #define IFP_USER_DEFAULT_ATTRS {SYSDB_NAME, SYSDB_UIDNUM,   \
@@ -451,3 +452,170 @@ done:
     talloc_free(tmp_ctx);
     return ret_name;
 }
+
+struct ifp_snapshot {
+    hash_table_t *table;
+    const char *path;
+    struct ldb_message *msg;
+};
+
+static void ifp_snapshot_expire(struct tevent_context *ev,
+                                struct tevent_timer *te,
+                                struct timeval tv,
+                                void *pvt)
+{
+    struct ifp_snapshot *snapshot;
+
+    snapshot = talloc_get_type(pvt, struct ifp_snapshot);
+
+    DEBUG(SSSDBG_TRACE_ALL, "Snapshot of %s expired\n", snapshot->path);
+
+    /* This will also free the snapshot. */
+    sss_ptr_hash_delete(snapshot->table, snapshot->path, true);
+}
+
+errno_t ifp_snapshot_init(struct ifp_ctx *ifp_ctx)
+{
+    ifp_ctx->snapshots = sss_ptr_hash_create(ifp_ctx, NULL, NULL);
+    if (ifp_ctx->snapshots == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create snapshot table\n");
+        return ENOMEM;
+    }
+
+    return EOK;
+}
+
+errno_t ifp_snapshot_get(TALLOC_CTX *mem_ctx,
+                         struct ifp_ctx *ifp_ctx,
+                         struct sbus_request *sbus_req,
+                         struct ldb_message **_msg)
+{
+    struct ifp_snapshot *snapshot;
+    struct ldb_message *msg;
+    struct ldb_message *copy;
+    errno_t ret;
+
+    msg = sbus_request_batch_get(sbus_req, struct ldb_message);
+    if (msg == NULL) {
+        if (ifp_ctx->snapshots == NULL) {
+            return ENOENT;
+        }
+
+        snapshot = sss_ptr_hash_lookup(ifp_ctx->snapshots, sbus_req->path,
+                                       struct ifp_snapshot);
+        if (snapshot == NULL) {
+            return ENOENT;
+        }
+
+        msg = snapshot->msg;
+
+        /* Keep serving the same object to the rest of this GetAll call
+         * even if the snapshot expires in the meantime. */
+        if (sbus_req->batch != NULL) {
+            copy = ldb_msg_copy(NULL, msg);
+            if (copy == NULL) {
+                return ENOMEM;
+            }
+
+            ret = sbus_request_batch_set(sbus_req, copy);
+            if (ret != EOK) {
+                talloc_free(copy);
+                return ret;
+            }
+
+            msg = copy;
+        }
+    }
+
+    *_msg = ldb_msg_copy(mem_ctx, msg);
+    if (*_msg == NULL) {
+        return ENOMEM;
+    }
+
+    DEBUG(SSSDBG_TRACE_ALL, "Using snapshot of %s\n", sbus_req->path);
+
+    return EOK;
+}
+
+errno_t ifp_snapshot_store(struct ifp_ctx *ifp_ctx,
+                           struct sbus_request *sbus_req,
+                           struct ldb_message *msg)
+{
+    struct ifp_snapshot *snapshot;
+    struct tevent_timer *te;
+    struct ldb_message *copy;
+    errno_t ret;
+
+    if (sbus_req->batch != NULL) {
+        copy = ldb_msg_copy(NULL, msg);
+        if (copy == NULL) {
+            return ENOMEM;
+        }
+
+        ret = sbus_request_batch_set(sbus_req, copy);
+        if (ret != EOK) {
+            talloc_free(copy);
+            return ret;
+        }
+    }
+
+    if (ifp_ctx->snapshots == NULL) {
+        return EOK;
+    }
+
+    /* Replace the previous snapshot if there is any. */
+    ifp_snapshot_invalidate(ifp_ctx, sbus_req->path);
+
+    if (hash_count(ifp_ctx->snapshots) >= IFP_SNAPSHOT_MAX) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Too many snapshots, not storing %s\n",
+              sbus_req->path);
+        return EOK;
+    }
+
+    snapshot = talloc_zero(ifp_ctx->snapshots, struct ifp_snapshot);
+    if (snapshot == NULL) {
+        return ENOMEM;
+    }
+
+    snapshot->table = ifp_ctx->snapshots;
+    snapshot->path = talloc_strdup(snapshot, sbus_req->path);
+    snapshot->msg = ldb_msg_copy(snapshot, msg);
+    if (snapshot->path == NULL || snapshot->msg == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    te = tevent_add_timer(ifp_ctx->rctx->ev, snapshot,
+                          tevent_timeval_current_ofs(IFP_SNAPSHOT_TIMEOUT, 0),
+                          ifp_snapshot_expire, snapshot);
+    if (te == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sss_ptr_hash_add(ifp_ctx->snapshots, snapshot->path, snapshot,
+                           struct ifp_snapshot);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to store snapshot [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(snapshot);
+    }
+
+    return ret;
+}
+
+void ifp_snapshot_invalidate(struct ifp_ctx *ifp_ctx, const char *path)
+{
+    if (ifp_ctx->snapshots == NULL || path == NULL) {
+        return;
+    }
+
+    sss_ptr_hash_delete(ifp_ctx->snapshots, path, true);
+}
@@ -92,6 +92,11 @@ typedef enum kcm_opcode {
     KCM_OP_GET_NTLM_USER_LIST,
 
     KCM_OP_SENTINEL,            /* SSSD addition, not in the MIT header */
+
+    /* MIT extensions */
+    KCM_OP_MIT_EXTENSION_BASE = 13000,
+    KCM_OP_GET_CRED_LIST,       /* (name) -> (count, count*{len, cred}) */
+    KCM_OP_MIT_EXTENSION_SENTINEL
 } kcm_opcode;
 
 #endif /* KCM_H */
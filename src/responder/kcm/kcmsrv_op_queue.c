@@ -30,6 +30,11 @@ struct kcm_ops_queue_entry {
 
     struct kcm_ops_queue *queue;
 
+    /* read-only operations may run concurrently with each other */
+    bool readonly;
+    bool running;
+    struct timeval queued;
+
     struct kcm_ops_queue_entry *next;
     struct kcm_ops_queue_entry *prev;
 };
@@ -40,11 +45,17 @@ struct kcm_ops_queue {
     struct kcm_ops_queue_ctx *qctx;
 
     struct kcm_ops_queue_entry *head;
+    /* number of entries in the queue */
+    uint32_t depth;
+    /* number of mutating operations in the queue */
+    uint32_t writers;
 };
 
 struct kcm_ops_queue_ctx {
     /* UID:kcm_ops_queue */
     hash_table_t *wait_queue_hash;
+
+    struct kcm_ops_queue_stats stats;
 };
 
 /*
@@ -113,22 +124,82 @@ void queue_removal_cb(struct tevent_context *ctx,
     talloc_free(kq);
 }
 
+static void kcm_op_queue_entry_start(struct kcm_ops_queue_entry *entry)
+{
+    struct kcm_ops_queue_stats *stats = &entry->queue->qctx->stats;
+    struct timeval now;
+    uint64_t wait_ms;
+
+    entry->running = true;
+
+    now = tevent_timeval_current();
+    wait_ms = (now.tv_sec - entry->queued.tv_sec) * 1000
+              + (now.tv_usec - entry->queued.tv_usec) / 1000;
+
+    stats->waited++;
+    stats->wait_time_total_ms += wait_ms;
+    if (wait_ms > stats->wait_time_max_ms) {
+        stats->wait_time_max_ms = wait_ms;
+    }
+
+    DEBUG(SSSDBG_TRACE_LIBS, "Request waited %"PRIu64" ms in the queue "
+          "of %"SPRIuid"\n", wait_ms, entry->queue->uid);
+}
+
+/*
+ * The running entries always form the beginning of the queue: either a
+ * single mutating operation or any number of read-only operations.
+ */
+static struct kcm_ops_queue_entry *
+kcm_op_queue_next_runnable(struct kcm_ops_queue *kq)
+{
+    struct kcm_ops_queue_entry *entry;
+
+    DLIST_FOR_EACH(entry, kq->head) {
+        if (!entry->readonly) {
+            /* A mutating operation waits for everything in front of it */
+            if (entry == kq->head && !entry->running) {
+                return entry;
+            }
+            return NULL;
+        }
+
+        if (!entry->running) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+static void kcm_op_queue_run(struct kcm_ops_queue *kq)
+{
+    struct kcm_ops_queue_entry *entry;
+
+    /* Marking the request as done runs its callback which may modify the
+     * queue, so look up the next entry again every time */
+    while ((entry = kcm_op_queue_next_runnable(kq)) != NULL) {
+        kcm_op_queue_entry_start(entry);
+        tevent_req_done(entry->req);
+    }
+}
+
 static int kcm_op_queue_entry_destructor(struct kcm_ops_queue_entry *entry)
 {
-    struct kcm_ops_queue_entry *next_entry;
     struct tevent_immediate *imm;
 
     if (entry == NULL) {
         return 1;
     }
 
-    /* Take the next entry from the queue */
-    next_entry = entry->next;
-
     /* Remove the current entry from the queue */
     DLIST_REMOVE(entry->queue->head, entry);
+    entry->queue->depth--;
+    if (!entry->readonly) {
+        entry->queue->writers--;
+    }
 
-    if (next_entry == NULL) {
+    if (entry->queue->head == NULL) {
         /* If there was no other entry, schedule removal of the queue. Do it
          * in another tevent tick to avoid issues with callbacks invoking
          * the destructor while another request is touching the queue
@@ -142,8 +213,8 @@ static int kcm_op_queue_entry_destructor(struct kcm_ops_queue_entry *entry)
         return 0;
     }
 
-    /* Otherwise, mark the current head as done to run the next request */
-    tevent_req_done(next_entry->req);
+    /* Otherwise, run the next requests */
+    kcm_op_queue_run(entry->queue);
     return 0;
 }
 
@@ -214,22 +285,26 @@ struct kcm_op_queue_state {
 };
 
 static errno_t kcm_op_queue_add_req(struct kcm_ops_queue *kq,
-                                    struct tevent_req *req);
+                                    struct tevent_req *req,
+                                    bool readonly);
 
 /*
  * Enqueue a request.
  *
  * If the request queue /for the given ID/ is empty, that is, if this
  * request is the first one in the queue, run the request immediately.
+ * A read-only request also runs immediately if there are only read-only
+ * requests in the queue.
  *
- * Otherwise just add it to the queue and wait until the previous request
- * finishes and only at that point mark the current request as done, which
+ * Otherwise just add it to the queue and wait until the previous requests
+ * finish and only at that point mark the current request as done, which
  * will trigger calling the recv function and allow the request to continue.
  */
 struct tevent_req *kcm_op_queue_send(TALLOC_CTX *mem_ctx,
                                      struct tevent_context *ev,
                                      struct kcm_ops_queue_ctx *qctx,
-                                     struct cli_creds *client)
+                                     struct cli_creds *client,
+                                     bool readonly)
 {
     errno_t ret;
     struct tevent_req *req;
@@ -255,10 +330,10 @@ struct tevent_req *kcm_op_queue_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = kcm_op_queue_add_req(kq, req);
+    ret = kcm_op_queue_add_req(kq, req, readonly);
     if (ret == EOK) {
         DEBUG(SSSDBG_TRACE_LIBS,
-              "Queue was empty, running the request immediately\n");
+              "Nothing to wait for, running the request immediately\n");
         goto immediate;
     } else if (ret != EAGAIN) {
         DEBUG(SSSDBG_OP_FAILURE,
@@ -280,11 +355,13 @@ immediate:
 }
 
 static errno_t kcm_op_queue_add_req(struct kcm_ops_queue *kq,
-                                    struct tevent_req *req)
+                                    struct tevent_req *req,
+                                    bool readonly)
 {
     errno_t ret;
     struct kcm_op_queue_state *state = tevent_req_data(req,
                                                 struct kcm_op_queue_state);
+    struct kcm_ops_queue_stats *stats = &kq->qctx->stats;
 
     state->entry = talloc_zero(kq->qctx->wait_queue_hash, struct kcm_ops_queue_entry);
     if (state->entry == NULL) {
@@ -292,10 +369,15 @@ static errno_t kcm_op_queue_add_req(struct kcm_ops_queue *kq,
     }
     state->entry->req = req;
     state->entry->queue = kq;
+    state->entry->readonly = readonly;
+    state->entry->queued = tevent_timeval_current();
     talloc_set_destructor(state->entry, kcm_op_queue_entry_destructor);
 
-    if (kq->head == NULL) {
-        /* First entry, will run callback at once */
+    if (kq->head == NULL || (readonly && kq->writers == 0)) {
+        /* Nothing to wait for, will run callback at once. Only read-only
+         * operations can be running in the latter case. */
+        state->entry->running = true;
+        stats->immediate++;
         ret = EOK;
     } else {
         /* Will wait for the previous callbacks to finish */
@@ -303,6 +385,16 @@ static errno_t kcm_op_queue_add_req(struct kcm_ops_queue *kq,
     }
 
     DLIST_ADD_END(kq->head, state->entry, struct kcm_ops_queue_entry *);
+    kq->depth++;
+    if (!readonly) {
+        kq->writers++;
+    }
+
+    stats->queued++;
+    if (kq->depth > stats->max_depth) {
+        stats->max_depth = kq->depth;
+    }
+
     return ret;
 }
 
@@ -324,3 +416,9 @@ errno_t kcm_op_queue_recv(struct tevent_req *req,
     *_entry = talloc_steal(mem_ctx, state->entry);
     return EOK;
 }
+
+void kcm_ops_queue_get_stats(struct kcm_ops_queue_ctx *qctx,
+                             struct kcm_ops_queue_stats *_stats)
+{
+    *_stats = qctx->stats;
+}
@@ -66,6 +66,9 @@ struct kcm_op {
     const char *name;
     kcm_srv_send_method fn_send;
     kcm_srv_recv_method fn_recv;
+    /* does not modify any ccache, can run concurrently with other
+     * read-only operations of the same client */
+    bool readonly;
 };
 
 struct kcm_cmd_state {
@@ -162,7 +165,7 @@ struct tevent_req *kcm_cmd_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    subreq = kcm_op_queue_send(state, ev, qctx, client);
+    subreq = kcm_op_queue_send(state, ev, qctx, client, op->readonly);
     if (subreq == NULL) {
         ret = ENOMEM;
         goto immediate;
@@ -1278,6 +1281,144 @@ static void kcm_op_get_cred_by_uuid_getbyname_done(struct tevent_req *subreq)
     tevent_req_done(req);
 }
 
+/* (name) -> (count, count*{len, cred}) */
+static void kcm_op_get_cred_list_getbyname_done(struct tevent_req *subreq);
+
+static struct tevent_req *
+kcm_op_get_cred_list_send(TALLOC_CTX *mem_ctx,
+                          struct tevent_context *ev,
+                          struct kcm_op_ctx *op_ctx)
+{
+    struct tevent_req *req = NULL;
+    struct tevent_req *subreq = NULL;
+    struct kcm_op_common_state *state = NULL;
+    errno_t ret;
+    const char *name;
+
+    req = tevent_req_create(mem_ctx, &state, struct kcm_op_common_state);
+    if (req == NULL) {
+        return NULL;
+    }
+    state->op_ctx = op_ctx;
+
+    ret = sss_iobuf_read_stringz(op_ctx->input, &name);
+    if (ret != EOK) {
+        goto immediate;
+    }
+    DEBUG(SSSDBG_TRACE_LIBS, "Returning all creds for %s\n", name);
+
+    subreq = kcm_ccdb_getbyname_send(state, ev,
+                                     op_ctx->kcm_data->db,
+                                     op_ctx->client,
+                                     name);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto immediate;
+    }
+    tevent_req_set_callback(subreq, kcm_op_get_cred_list_getbyname_done, req);
+    return req;
+
+immediate:
+    tevent_req_error(req, ret);
+    tevent_req_post(req, ev);
+    return req;
+}
+
+static void kcm_op_get_cred_list_getbyname_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct kcm_op_common_state *state = tevent_req_data(req,
+                                                struct kcm_op_common_state);
+    errno_t ret;
+    struct kcm_ccache *cc;
+    struct kcm_cred *crd;
+    struct sss_iobuf *cred_blob;
+    uint32_t count;
+    size_t reply_size;
+
+    ret = kcm_ccdb_getbyname_recv(subreq, state, &cc);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot get ccache by name [%d]: %s\n",
+              ret, sss_strerror(ret));
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    if (cc == NULL) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "No credentials by that name\n");
+        state->op_ret = ERR_NO_MATCHING_CREDS;
+        tevent_req_done(req);
+        return;
+    }
+
+    /* Size the reply first so that we never send a truncated list */
+    count = 0;
+    reply_size = sizeof(uint32_t);
+    for (crd = kcm_cc_get_cred(cc);
+         crd != NULL;
+         crd = kcm_cc_next_cred(crd)) {
+        cred_blob = kcm_cred_get_creds(crd);
+        if (cred_blob == NULL) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Credentials lack the creds blob, skipping\n");
+            continue;
+        }
+
+        reply_size += sizeof(uint32_t) + sss_iobuf_get_size(cred_blob);
+        count++;
+    }
+
+    if (reply_size > sss_iobuf_get_capacity(state->op_ctx->reply)) {
+        /* The client falls back to GET_CRED_UUID_LIST and GET_CRED_BY_UUID
+         * which return the credentials one by one */
+        DEBUG(SSSDBG_TRACE_FUNC, "%"PRIu32" credentials do not fit into "
+              "a single reply (%zu bytes)\n", count, reply_size);
+        state->op_ret = ERR_KCM_OP_NOT_IMPLEMENTED;
+        tevent_req_done(req);
+        return;
+    }
+
+    ret = sss_iobuf_write_uint32(state->op_ctx->reply, htobe32(count));
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    for (crd = kcm_cc_get_cred(cc);
+         crd != NULL;
+         crd = kcm_cc_next_cred(crd)) {
+        cred_blob = kcm_cred_get_creds(crd);
+        if (cred_blob == NULL) {
+            continue;
+        }
+
+        ret = sss_iobuf_write_uint32(state->op_ctx->reply,
+                                     htobe32(sss_iobuf_get_size(cred_blob)));
+        if (ret != EOK) {
+            tevent_req_error(req, ret);
+            return;
+        }
+
+        ret = sss_iobuf_write_len(state->op_ctx->reply,
+                                  sss_iobuf_get_data(cred_blob),
+                                  sss_iobuf_get_size(cred_blob));
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot write ccache blob [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            tevent_req_error(req, ret);
+            return;
+        }
+    }
+
+    DEBUG(SSSDBG_TRACE_LIBS, "Returning %"PRIu32" credentials\n", count);
+    state->op_ret = EOK;
+    tevent_req_done(req);
+}
+
 /* (name, flags, credtag) -> () */
 /* FIXME */
 static struct tevent_req *
@@ -2119,37 +2260,44 @@ static errno_t kcm_op_set_kdc_offset_recv(struct tevent_req *req,
 }
 
 static struct kcm_op kcm_optable[] = {
-    { "NOOP",                NULL, NULL },
-    { "GET_NAME",            NULL, NULL },
-    { "RESOLVE",             NULL, NULL },
-    { "GEN_NEW",             kcm_op_gen_new_send, NULL },
-    { "INITIALIZE",          kcm_op_initialize_send, kcm_op_initialize_recv },
-    { "DESTROY",             kcm_op_destroy_send, NULL },
-    { "STORE",               kcm_op_store_send, kcm_op_store_recv },
-    { "RETRIEVE",            NULL, NULL },
-    { "GET_PRINCIPAL",       kcm_op_get_principal_send, NULL },
-    { "GET_CRED_UUID_LIST",  kcm_op_get_cred_uuid_list_send, NULL },
-    { "GET_CRED_BY_UUID",    kcm_op_get_cred_by_uuid_send, NULL },
-    { "REMOVE_CRED",         kcm_op_remove_cred_send, NULL },
-    { "SET_FLAGS",           NULL, NULL },
-    { "CHOWN",               NULL, NULL },
-    { "CHMOD",               NULL, NULL },
-    { "GET_INITIAL_TICKET",  NULL, NULL },
-    { "GET_TICKET",          NULL, NULL },
-    { "MOVE_CACHE",          NULL, NULL },
-    { "GET_CACHE_UUID_LIST", kcm_op_get_cache_uuid_list_send, NULL },
-    { "GET_CACHE_BY_UUID",   kcm_op_get_cache_by_uuid_send, NULL },
-    { "GET_DEFAULT_CACHE",   kcm_op_get_default_ccache_send, kcm_op_get_default_ccache_recv },
-    { "SET_DEFAULT_CACHE",   kcm_op_set_default_ccache_send, kcm_op_set_default_ccache_recv },
-    { "GET_KDC_OFFSET",      kcm_op_get_kdc_offset_send, NULL },
-    { "SET_KDC_OFFSET",      kcm_op_set_kdc_offset_send, kcm_op_set_kdc_offset_recv },
-    { "ADD_NTLM_CRED",       NULL, NULL },
-    { "HAVE_NTLM_CRED",      NULL, NULL },
-    { "DEL_NTLM_CRED",       NULL, NULL },
-    { "DO_NTLM_AUTH",        NULL, NULL },
-    { "GET_NTLM_USER_LIST",  NULL, NULL },
-
-    { NULL, NULL, NULL }
+    { "NOOP",                NULL, NULL, false },
+    { "GET_NAME",            NULL, NULL, false },
+    { "RESOLVE",             NULL, NULL, false },
+    { "GEN_NEW",             kcm_op_gen_new_send, NULL, false },
+    { "INITIALIZE",          kcm_op_initialize_send, kcm_op_initialize_recv, false },
+    { "DESTROY",             kcm_op_destroy_send, NULL, false },
+    { "STORE",               kcm_op_store_send, kcm_op_store_recv, false },
+    { "RETRIEVE",            NULL, NULL, false },
+    { "GET_PRINCIPAL",       kcm_op_get_principal_send, NULL, true },
+    { "GET_CRED_UUID_LIST",  kcm_op_get_cred_uuid_list_send, NULL, true },
+    { "GET_CRED_BY_UUID",    kcm_op_get_cred_by_uuid_send, NULL, true },
+    { "REMOVE_CRED",         kcm_op_remove_cred_send, NULL, false },
+    { "SET_FLAGS",           NULL, NULL, false },
+    { "CHOWN",               NULL, NULL, false },
+    { "CHMOD",               NULL, NULL, false },
+    { "GET_INITIAL_TICKET",  NULL, NULL, false },
+    { "GET_TICKET",          NULL, NULL, false },
+    { "MOVE_CACHE",          NULL, NULL, false },
+    { "GET_CACHE_UUID_LIST", kcm_op_get_cache_uuid_list_send, NULL, true },
+    { "GET_CACHE_BY_UUID",   kcm_op_get_cache_by_uuid_send, NULL, true },
+    { "GET_DEFAULT_CACHE",   kcm_op_get_default_ccache_send, kcm_op_get_default_ccache_recv, true },
+    { "SET_DEFAULT_CACHE",   kcm_op_set_default_ccache_send, kcm_op_set_default_ccache_recv, false },
+    { "GET_KDC_OFFSET",      kcm_op_get_kdc_offset_send, NULL, true },
+    { "SET_KDC_OFFSET",      kcm_op_set_kdc_offset_send, kcm_op_set_kdc_offset_recv, false },
+    { "ADD_NTLM_CRED",       NULL, NULL, false },
+    { "HAVE_NTLM_CRED",      NULL, NULL, false },
+    { "DEL_NTLM_CRED",       NULL, NULL, false },
+    { "DO_NTLM_AUTH",        NULL, NULL, false },
+    { "GET_NTLM_USER_LIST",  NULL, NULL, false },
+
+    { NULL, NULL, NULL, false }
+};
+
+/* MIT extensions, see src/include/kcm.h in the krb5 sources */
+static struct kcm_op kcm_mit_optable[] = {
+    { "GET_CRED_LIST",       kcm_op_get_cred_list_send, NULL, true },
+
+    { NULL, NULL, NULL, false }
 };
 
 struct kcm_op *kcm_get_opt(uint16_t opcode)
@@ -2159,11 +2307,15 @@ struct kcm_op *kcm_get_opt(uint16_t opcode)
     DEBUG(SSSDBG_TRACE_INTERNAL,
           "The client requested operation %"PRIu16"\n", opcode);
 
-    if (opcode >= KCM_OP_SENTINEL) {
+    if (opcode > KCM_OP_MIT_EXTENSION_BASE
+            && opcode < KCM_OP_MIT_EXTENSION_SENTINEL) {
+        op = &kcm_mit_optable[opcode - KCM_OP_MIT_EXTENSION_BASE - 1];
+    } else if (opcode < KCM_OP_SENTINEL) {
+        op = &kcm_optable[opcode];
+    } else {
         return NULL;
     }
 
-    op = &kcm_optable[opcode];
     if (op->fn_recv == NULL) {
         op->fn_recv = kcm_op_common_recv;
     }
@@ -82,21 +82,39 @@ int kcm_connection_setup(struct cli_ctx *cctx);
 krb5_error_code sss2krb5_error(errno_t err);
 
 /* We enqueue all requests by the same UID to avoid concurrency issues
- * especially when performing multiple round-trips to sssd-secrets. In
- * future, we should relax the queue to allow multiple read-only operations
- * if no write operations are in progress.
+ * especially when performing multiple round-trips to sssd-secrets.
+ * Read-only operations run concurrently as long as no operation that
+ * modifies the ccaches was enqueued before them, mutating operations run
+ * alone and in order.
  */
 struct kcm_ops_queue_entry;
 
+struct kcm_ops_queue_stats {
+    /* requests enqueued */
+    uint64_t queued;
+    /* requests that did not have to wait */
+    uint64_t immediate;
+    /* requests that had to wait for others to finish */
+    uint64_t waited;
+    uint64_t wait_time_total_ms;
+    uint64_t wait_time_max_ms;
+    /* the largest number of requests in a single queue */
+    uint32_t max_depth;
+};
+
 struct kcm_ops_queue_ctx *kcm_ops_queue_create(TALLOC_CTX *mem_ctx);
 
 struct tevent_req *kcm_op_queue_send(TALLOC_CTX *mem_ctx,
                                      struct tevent_context *ev,
                                      struct kcm_ops_queue_ctx *qctx,
-                                     struct cli_creds *client);
+                                     struct cli_creds *client,
+                                     bool readonly);
 
 errno_t kcm_op_queue_recv(struct tevent_req *req,
                           TALLOC_CTX *mem_ctx,
                           struct kcm_ops_queue_entry **_entry);
 
+void kcm_ops_queue_get_stats(struct kcm_ops_queue_ctx *qctx,
+                             struct kcm_ops_queue_stats *_stats);
+
 #endif /* __KCMSRV_PVT_H__ */
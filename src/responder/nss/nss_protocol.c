@@ -98,6 +98,33 @@ done:
     nss_protocol_done(cli_ctx, ret);
 }
 
+/* cache_req checks the object against a cache generation that may be
+ * SYSDB_CACHE_GEN_REFRESH seconds old. If sss_cache invalidated the object
+ * in the meantime, it has also moved the memory cache to a new generation,
+ * and the record would be valid there. */
+bool nss_protocol_mc_store_allowed(struct sss_domain_info *domain,
+                                   enum sysdb_cache_gen_type type,
+                                   struct ldb_message *msg)
+{
+    uint32_t generation;
+    errno_t ret;
+
+    ret = sysdb_refresh_cache_generation(domain, type, &generation);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to read cache generation "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+        return false;
+    }
+
+    if (sysdb_is_older_than_generation(msg, type, generation)) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Object was invalidated, it will not be "
+              "stored in the memory cache\n");
+        return false;
+    }
+
+    return true;
+}
+
 errno_t
 nss_protocol_parse_name(struct cli_ctx *cli_ctx, const char **_rawname)
 {
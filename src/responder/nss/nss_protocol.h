@@ -84,6 +84,14 @@ void nss_protocol_reply(struct cli_ctx *cli_ctx,
                         struct cache_req_result *result,
                         nss_protocol_fill_packet_fn fill_fn);
 
+/**
+ * Check that the object was not invalidated by sss_cache before it is
+ * stored in the memory cache.
+ */
+bool nss_protocol_mc_store_allowed(struct sss_domain_info *domain,
+                                   enum sysdb_cache_gen_type type,
+                                   struct ldb_message *msg);
+
 /* Parse input packet. */
 
 errno_t
@@ -20,6 +20,9 @@
 
 #include "responder/nss/nss_protocol.h"
 
+/* Expected size of one group entry without members in the reply. */
+#define NSS_GRENT_SIZE_HINT 64
+
 static errno_t
 nss_get_grent(TALLOC_CTX *mem_ctx,
               struct nss_ctx *nss_ctx,
@@ -225,6 +228,12 @@ nss_protocol_fill_grent(struct nss_ctx *nss_ctx,
         return ret;
     }
 
+    /* Size the buffer for all entries at once. */
+    ret = sss_packet_reserve(packet, result->count * NSS_GRENT_SIZE_HINT);
+    if (ret != EOK) {
+        goto done;
+    }
+
     rp = 2 * sizeof(uint32_t);
 
     num_results = 0;
@@ -277,7 +286,10 @@ nss_protocol_fill_grent(struct nss_ctx *nss_ctx,
         /* Do not store entry in memory cache during enumeration or when
          * requested. */
         if (!cmd_ctx->enumeration
-                && (cmd_ctx->flags & SSS_NSS_EX_FLAG_INVALIDATE_CACHE) == 0) {
+                && (cmd_ctx->flags & SSS_NSS_EX_FLAG_INVALIDATE_CACHE) == 0
+                && nss_protocol_mc_store_allowed(result->domain,
+                                                 SYSDB_CACHE_GEN_GROUPS,
+                                                 msg)) {
             members = (char *)&body[rp_members];
             members_size = body_len - rp_members;
             ret = sss_mmap_cache_gr_store(&nss_ctx->grp_mc_ctx, name, &pwfield,
@@ -406,7 +418,10 @@ nss_protocol_fill_initgr(struct nss_ctx *nss_ctx,
     }
 
     if (nss_ctx->initgr_mc_ctx
-                && (cmd_ctx->flags & SSS_NSS_EX_FLAG_INVALIDATE_CACHE) == 0) {
+                && (cmd_ctx->flags & SSS_NSS_EX_FLAG_INVALIDATE_CACHE) == 0
+                && nss_protocol_mc_store_allowed(domain,
+                                                 SYSDB_CACHE_GEN_INITGROUPS,
+                                                 result->msgs[0])) {
         to_sized_string(&rawname, cmd_ctx->rawname);
         to_sized_string(&unique_name, result->lookup_name);
 
@@ -21,6 +21,9 @@
 #include "responder/nss/nss_protocol.h"
 #include "util/sss_nss.h"
 
+/* Expected size of one passwd entry in the reply. */
+#define NSS_PWENT_SIZE_HINT 128
+
 static uint32_t
 nss_get_gid(struct sss_domain_info *domain,
             struct ldb_message *msg)
@@ -261,6 +264,12 @@ nss_protocol_fill_pwent(struct nss_ctx *nss_ctx,
         return ret;
     }
 
+    /* Size the buffer for all entries at once. */
+    ret = sss_packet_reserve(packet, result->count * NSS_PWENT_SIZE_HINT);
+    if (ret != EOK) {
+        goto done;
+    }
+
     rp = 2 * sizeof(uint32_t);
 
     num_results = 0;
@@ -303,7 +312,10 @@ nss_protocol_fill_pwent(struct nss_ctx *nss_ctx,
         /* Do not store entry in memory cache during enumeration or when
          * requested. */
         if (!cmd_ctx->enumeration
-                && (cmd_ctx->flags & SSS_NSS_EX_FLAG_INVALIDATE_CACHE) == 0) {
+                && (cmd_ctx->flags & SSS_NSS_EX_FLAG_INVALIDATE_CACHE) == 0
+                && nss_protocol_mc_store_allowed(result->domain,
+                                                 SYSDB_CACHE_GEN_USERS,
+                                                 msg)) {
             ret = sss_mmap_cache_pw_store(&nss_ctx->pwd_mc_ctx, name, &pwfield,
                                           uid, gid, &gecos, &homedir, &shell);
             if (ret != EOK) {
@@ -34,6 +34,12 @@
 #define SSS_AVG_GROUP_PAYLOAD (MC_SLOT_SIZE * 3)
 /* average place for 40 supplementary groups + 2 names */
 #define SSS_AVG_INITGROUP_PAYLOAD (MC_SLOT_SIZE * 5)
+/* home directory map entry (auto.home, user, -rw server:/home/user) */
+#define SSS_AVG_AUTOFS_PAYLOAD (MC_SLOT_SIZE * 3)
+/* a handful of rules with a few attributes each */
+#define SSS_AVG_SUDO_PAYLOAD (MC_SLOT_SIZE * 64)
+/* a single sudo reply must not take more than this part of the data table */
+#define SSS_MC_SUDO_MAX_SHARE 16
 
 #define MC_NEXT_BARRIER(val) ((((val) + 1) & 0x00ffffff) | 0xf0000000)
 
@@ -482,6 +488,12 @@ static errno_t sss_mc_get_strs_offset(struct sss_mc_ctx *mcc,
     case SSS_MC_INITGROUPS:
         *_offset = offsetof(struct sss_mc_initgr_data, gids);
         return EOK;
+    case SSS_MC_AUTOFS:
+        *_offset = offsetof(struct sss_mc_autofs_data, strs);
+        return EOK;
+    case SSS_MC_SUDO:
+        *_offset = offsetof(struct sss_mc_sudo_data, strs);
+        return EOK;
     default:
         DEBUG(SSSDBG_FATAL_FAILURE, "Unknown memory cache type.\n");
         return EINVAL;
@@ -502,6 +514,12 @@ static errno_t sss_mc_get_strs_len(struct sss_mc_ctx *mcc,
     case SSS_MC_INITGROUPS:
         *_len = ((struct sss_mc_initgr_data *)&rec->data)->data_len;
         return EOK;
+    case SSS_MC_AUTOFS:
+        *_len = ((struct sss_mc_autofs_data *)&rec->data)->strs_len;
+        return EOK;
+    case SSS_MC_SUDO:
+        *_len = ((struct sss_mc_sudo_data *)&rec->data)->strs_len;
+        return EOK;
     default:
         DEBUG(SSSDBG_FATAL_FAILURE, "Unknown memory cache type.\n");
         return EINVAL;
@@ -641,7 +659,7 @@ static errno_t sss_mc_get_record(struct sss_mc_ctx **_mcc,
     rec->len = rec_len;
     rec->next1 = MC_INVALID_VAL;
     rec->next2 = MC_INVALID_VAL;
-    rec->padding = MC_INVALID_VAL;
+    rec->generation = MC_INVALID_VAL;
     MC_LOWER_BARRIER(rec);
 
     /* and now mark slots as used */
@@ -659,8 +677,12 @@ static inline void sss_mmap_set_rec_header(struct sss_mc_ctx *mcc,
                                            const char *key1, size_t key1_len,
                                            const char *key2, size_t key2_len)
 {
+    struct sss_mc_header *h = (struct sss_mc_header *)mcc->mmap_base;
+
     rec->len = len;
     rec->expire = time(NULL) + ttl;
+    /* sss_cache may bump the generation at any time to expire all records */
+    rec->generation = *(volatile uint32_t *)&h->generation;
     rec->hash1 = sss_mc_hash(mcc, key1, key1_len);
     rec->hash2 = sss_mc_hash(mcc, key2, key2_len);
 }
@@ -1056,6 +1078,306 @@ errno_t sss_mmap_cache_initgr_invalidate(struct sss_mc_ctx *mcc,
     return sss_mmap_cache_invalidate(mcc, name);
 }
 
+/***************************************************************************
+ * autofs map
+ ***************************************************************************/
+
+/* Entries are looked up by map name and key together. Neither of them can
+ * contain a new line since autofs maps are line oriented, so it is used to
+ * separate them. The map name alone is the second key so that a whole map
+ * can be invalidated when it is refreshed. */
+static errno_t sss_mc_autofs_lookup_key(TALLOC_CTX *mem_ctx,
+                                        struct sized_string *map,
+                                        struct sized_string *key,
+                                        struct sized_string *_lookup)
+{
+    char *str;
+
+    if (memchr(map->str, '\n', map->len) != NULL
+            || memchr(key->str, '\n', key->len) != NULL) {
+        return EINVAL;
+    }
+
+    str = talloc_asprintf(mem_ctx, "%s\n%s", map->str, key->str);
+    if (str == NULL) {
+        return ENOMEM;
+    }
+
+    to_sized_string(_lookup, str);
+    return EOK;
+}
+
+errno_t sss_mmap_cache_autofs_store(struct sss_mc_ctx **_mcc,
+                                    struct sized_string *map,
+                                    struct sized_string *key,
+                                    struct sized_string *value)
+{
+    struct sss_mc_ctx *mcc = *_mcc;
+    struct sss_mc_rec *rec;
+    struct sss_mc_autofs_data *data;
+    struct sized_string lookup;
+    size_t data_len;
+    size_t rec_len;
+    size_t pos;
+    int ret;
+
+    if (mcc == NULL) {
+        /* cache not initialized? */
+        return EINVAL;
+    }
+
+    ret = sss_mc_autofs_lookup_key(NULL, map, key, &lookup);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    data_len = lookup.len + map->len + value->len;
+    rec_len = sizeof(struct sss_mc_rec) +
+              sizeof(struct sss_mc_autofs_data) +
+              data_len;
+    if (rec_len > mcc->dt_size) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sss_mc_get_record(_mcc, rec_len, &lookup, &rec);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    data = (struct sss_mc_autofs_data *)rec->data;
+    pos = 0;
+
+    MC_RAISE_BARRIER(rec);
+
+    /* header */
+    sss_mmap_set_rec_header(mcc, rec, rec_len, mcc->valid_time_slot,
+                            lookup.str, lookup.len, map->str, map->len);
+
+    /* autofs struct */
+    data->strs_len = data_len;
+    data->name = MC_PTR_DIFF(&data->strs[pos], data);
+    memcpy(&data->strs[pos], lookup.str, lookup.len);
+    pos += lookup.len;
+    data->map = MC_PTR_DIFF(&data->strs[pos], data);
+    memcpy(&data->strs[pos], map->str, map->len);
+    pos += map->len;
+    data->value = MC_PTR_DIFF(&data->strs[pos], data);
+    memcpy(&data->strs[pos], value->str, value->len);
+    pos += value->len;
+
+    MC_LOWER_BARRIER(rec);
+
+    /* finally chain the rec in the hash table */
+    sss_mmap_chain_in_rec(mcc, rec);
+
+    ret = EOK;
+
+done:
+    talloc_free(discard_const(lookup.str));
+    return ret;
+}
+
+errno_t sss_mmap_cache_autofs_invalidate_map(struct sss_mc_ctx *mcc,
+                                             struct sized_string *map)
+{
+    struct sss_mc_rec *rec;
+    struct sss_mc_autofs_data *data;
+    uint32_t hash;
+    uint32_t slot;
+    uint32_t next;
+    size_t offset;
+    bool found = false;
+
+    if (mcc == NULL) {
+        /* cache not initialized? */
+        return EINVAL;
+    }
+
+    hash = sss_mc_hash(mcc, map->str, map->len);
+
+    slot = mcc->hash_table[hash];
+    while (slot != MC_INVALID_VAL) {
+        if (!MC_SLOT_WITHIN_BOUNDS(slot, mcc->dt_size)) {
+            DEBUG(SSSDBG_FATAL_FAILURE, "Corrupted memcache.\n");
+            sss_mc_save_corrupted(mcc);
+            sss_mmap_cache_reset(mcc);
+            return ENOENT;
+        }
+
+        rec = MC_SLOT_TO_PTR(mcc->data_table, slot, struct sss_mc_rec);
+        data = (struct sss_mc_autofs_data *)(&rec->data);
+
+        /* invalidating the record unlinks it from the chain */
+        next = sss_mc_next_slot_with_hash(rec, hash);
+
+        offset = offsetof(struct sss_mc_autofs_data, strs);
+        if (rec->hash2 == hash
+                && data->map >= offset
+                && data->map + map->len <= offset + data->strs_len
+                && memcmp((char *)data + data->map,
+                          map->str, map->len) == 0) {
+            sss_mc_invalidate_rec(mcc, rec);
+            found = true;
+        }
+
+        slot = next;
+    }
+
+    return found ? EOK : ENOENT;
+}
+
+/***************************************************************************
+ * sudo rules
+ ***************************************************************************/
+
+/* The reply depends on the command, the uid and the user name sent by the
+ * client, so all of them make up the lookup key. The user name is the last
+ * part so it cannot be confused with the numeric ones even if it contains a
+ * new line. The user name alone is the second key so that all replies of
+ * a user can be invalidated at once. */
+static errno_t sss_mc_sudo_lookup_key(TALLOC_CTX *mem_ctx,
+                                      uint32_t command,
+                                      uid_t uid,
+                                      struct sized_string *user,
+                                      struct sized_string *_lookup)
+{
+    char *str;
+
+    str = talloc_asprintf(mem_ctx, "%"PRIu32"\n%"SPRIuid"\n%s",
+                          command, uid, user->str);
+    if (str == NULL) {
+        return ENOMEM;
+    }
+
+    to_sized_string(_lookup, str);
+    return EOK;
+}
+
+errno_t sss_mmap_cache_sudo_store(struct sss_mc_ctx **_mcc,
+                                  uint32_t command,
+                                  uid_t uid,
+                                  struct sized_string *user,
+                                  uint8_t *reply,
+                                  size_t reply_len)
+{
+    struct sss_mc_ctx *mcc = *_mcc;
+    struct sss_mc_rec *rec;
+    struct sss_mc_sudo_data *data;
+    struct sized_string lookup;
+    size_t data_len;
+    size_t rec_len;
+    size_t pos;
+    int ret;
+
+    if (mcc == NULL) {
+        /* cache not initialized? */
+        return EINVAL;
+    }
+
+    ret = sss_mc_sudo_lookup_key(NULL, command, uid, user, &lookup);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    data_len = lookup.len + user->len + reply_len;
+    rec_len = sizeof(struct sss_mc_rec) +
+              sizeof(struct sss_mc_sudo_data) +
+              data_len;
+    /* Do not let a single huge rule set evict everybody else. */
+    if (rec_len > mcc->dt_size / SSS_MC_SUDO_MAX_SHARE) {
+        ret = E2BIG;
+        goto done;
+    }
+
+    ret = sss_mc_get_record(_mcc, rec_len, &lookup, &rec);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    data = (struct sss_mc_sudo_data *)rec->data;
+    pos = 0;
+
+    MC_RAISE_BARRIER(rec);
+
+    /* header */
+    sss_mmap_set_rec_header(mcc, rec, rec_len, mcc->valid_time_slot,
+                            lookup.str, lookup.len, user->str, user->len);
+
+    /* sudo struct */
+    data->strs_len = data_len;
+    data->name = MC_PTR_DIFF(&data->strs[pos], data);
+    memcpy(&data->strs[pos], lookup.str, lookup.len);
+    pos += lookup.len;
+    data->user = MC_PTR_DIFF(&data->strs[pos], data);
+    memcpy(&data->strs[pos], user->str, user->len);
+    pos += user->len;
+    data->reply = MC_PTR_DIFF(&data->strs[pos], data);
+    data->reply_len = reply_len;
+    memcpy(&data->strs[pos], reply, reply_len);
+    pos += reply_len;
+
+    MC_LOWER_BARRIER(rec);
+
+    /* finally chain the rec in the hash table */
+    sss_mmap_chain_in_rec(mcc, rec);
+
+    ret = EOK;
+
+done:
+    talloc_free(discard_const(lookup.str));
+    return ret;
+}
+
+errno_t sss_mmap_cache_sudo_invalidate_user(struct sss_mc_ctx *mcc,
+                                            struct sized_string *user)
+{
+    struct sss_mc_rec *rec;
+    struct sss_mc_sudo_data *data;
+    uint32_t hash;
+    uint32_t slot;
+    uint32_t next;
+    size_t offset;
+    bool found = false;
+
+    if (mcc == NULL) {
+        /* cache not initialized? */
+        return EINVAL;
+    }
+
+    hash = sss_mc_hash(mcc, user->str, user->len);
+
+    slot = mcc->hash_table[hash];
+    while (slot != MC_INVALID_VAL) {
+        if (!MC_SLOT_WITHIN_BOUNDS(slot, mcc->dt_size)) {
+            DEBUG(SSSDBG_FATAL_FAILURE, "Corrupted memcache.\n");
+            sss_mc_save_corrupted(mcc);
+            sss_mmap_cache_reset(mcc);
+            return ENOENT;
+        }
+
+        rec = MC_SLOT_TO_PTR(mcc->data_table, slot, struct sss_mc_rec);
+        data = (struct sss_mc_sudo_data *)(&rec->data);
+
+        /* invalidating the record unlinks it from the chain */
+        next = sss_mc_next_slot_with_hash(rec, hash);
+
+        offset = offsetof(struct sss_mc_sudo_data, strs);
+        if (rec->hash2 == hash
+                && data->user >= offset
+                && data->user + user->len <= offset + data->strs_len
+                && memcmp((char *)data + data->user,
+                          user->str, user->len) == 0) {
+            sss_mc_invalidate_rec(mcc, rec);
+            found = true;
+        }
+
+        slot = next;
+    }
+
+    return found ? EOK : ENOENT;
+}
+
 /***************************************************************************
  * initialization
  ***************************************************************************/
@@ -1101,6 +1423,7 @@ static errno_t sss_mc_set_recycled(int fd)
 static errno_t sss_mc_create_file(struct sss_mc_ctx *mc_ctx)
 {
     mode_t old_mask;
+    mode_t mode;
     int ofd;
     int ret, uret;
     useconds_t t = 50000;
@@ -1136,12 +1459,20 @@ static errno_t sss_mc_create_file(struct sss_mc_ctx *mc_ctx)
                                   mc_ctx->file, ret, strerror(ret));
     }
 
+    /* Sudo rules are only read by sudo running as root, everything else
+     * must be readable by everyone. */
+    if (mc_ctx->type == SSS_MC_SUDO) {
+        mode = S_IRUSR|S_IWUSR;
+    } else {
+        mode = S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH;
+    }
+
     /* temporarily relax umask as we need the file to be readable
      * by everyone for now */
     old_mask = umask(0022);
 
     errno = 0;
-    mc_ctx->fd = open(mc_ctx->file, O_CREAT | O_EXCL | O_RDWR, 0644);
+    mc_ctx->fd = open(mc_ctx->file, O_CREAT | O_EXCL | O_RDWR, mode);
     umask(old_mask);
     if (mc_ctx->fd == -1) {
         ret = errno;
@@ -1162,7 +1493,7 @@ static errno_t sss_mc_create_file(struct sss_mc_ctx *mc_ctx)
         return ret;
     }
 
-    ret = fchmod(mc_ctx->fd, S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH);
+    ret = fchmod(mc_ctx->fd, mode);
     if (ret == -1) {
         ret = errno;
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to chmod mmap file %s: %d(%s)\n",
@@ -1213,7 +1544,7 @@ static void sss_mc_header_update(struct sss_mc_ctx *mc_ctx, int status)
         h->major_vno = SSS_MC_MAJOR_VNO;
         h->minor_vno = SSS_MC_MINOR_VNO;
         h->seed = mc_ctx->seed;
-        h->reserved = 0;
+        h->generation = 0;
     }
     h->status = status;
     MC_LOWER_BARRIER(h);
@@ -1268,6 +1599,12 @@ errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
     case SSS_MC_INITGROUPS:
         payload = SSS_AVG_INITGROUP_PAYLOAD;
         break;
+    case SSS_MC_AUTOFS:
+        payload = SSS_AVG_AUTOFS_PAYLOAD;
+        break;
+    case SSS_MC_SUDO:
+        payload = SSS_AVG_SUDO_PAYLOAD;
+        break;
     default:
         return EINVAL;
     }
@@ -31,6 +31,8 @@ enum sss_mc_type {
     SSS_MC_PASSWD,
     SSS_MC_GROUP,
     SSS_MC_INITGROUPS,
+    SSS_MC_AUTOFS,
+    SSS_MC_SUDO,
 };
 
 errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
@@ -71,6 +73,24 @@ errno_t sss_mmap_cache_gr_invalidate_gid(struct sss_mc_ctx *mcc, gid_t gid);
 errno_t sss_mmap_cache_initgr_invalidate(struct sss_mc_ctx *mcc,
                                          struct sized_string *name);
 
+errno_t sss_mmap_cache_autofs_store(struct sss_mc_ctx **_mcc,
+                                    struct sized_string *map,
+                                    struct sized_string *key,
+                                    struct sized_string *value);
+
+errno_t sss_mmap_cache_autofs_invalidate_map(struct sss_mc_ctx *mcc,
+                                             struct sized_string *map);
+
+errno_t sss_mmap_cache_sudo_store(struct sss_mc_ctx **_mcc,
+                                  uint32_t command,
+                                  uid_t uid,
+                                  struct sized_string *user,
+                                  uint8_t *reply,
+                                  size_t reply_len);
+
+errno_t sss_mmap_cache_sudo_invalidate_user(struct sss_mc_ctx *mcc,
+                                            struct sized_string *user);
+
 errno_t sss_mmap_cache_reinit(TALLOC_CTX *mem_ctx,
                               uid_t uid, gid_t gid,
                               size_t n_elem,
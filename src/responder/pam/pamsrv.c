@@ -49,6 +49,7 @@
 #define NO_DOMAINS_ARE_PUBLIC "none"
 #define DEFAULT_ALLOWED_UIDS ALL_UIDS_ALLOWED
 #define DEFAULT_PAM_CERT_AUTH false
+#define DEFAULT_PAM_OFFLINE_AUTH_WORKERS 2
 #ifdef HAVE_NSS
 #define DEFAULT_PAM_CERT_DB_PATH SYSCONFDIR"/pki/nssdb"
 #else
@@ -168,6 +169,7 @@ static int pam_process_init(TALLOC_CTX *mem_ctx,
     int ret;
     int id_timeout;
     int fd_limit;
+    int offline_auth_workers;
 
     pam_cmds = get_pam_cmds();
     ret = sss_process_init(mem_ctx, ev, cdb,
@@ -254,6 +256,32 @@ static int pam_process_init(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    /* Set up the helper threads for offline authentication */
+    ret = confdb_get_int(pctx->rctx->cdb,
+                         CONFDB_PAM_CONF_ENTRY,
+                         CONFDB_PAM_OFFLINE_AUTH_WORKERS,
+                         DEFAULT_PAM_OFFLINE_AUTH_WORKERS,
+                         &offline_auth_workers);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to read the number of offline authentication workers\n");
+        goto done;
+    }
+
+    if (offline_auth_workers < 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "Invalid value [%d] of %s, "
+              "hashes will be computed in the main thread\n",
+              offline_auth_workers, CONFDB_PAM_OFFLINE_AUTH_WORKERS);
+        offline_auth_workers = 0;
+    }
+
+    ret = sss_crypt_pool_init(pctx, rctx->ev, offline_auth_workers,
+                              &pctx->crypt_pool);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "sss_crypt_pool_init failed.\n");
+        goto done;
+    }
+
     /* Check if there is a prompting configuration */
     pctx->prompting_config_sections = NULL;
     pctx->num_prompting_config_sections = 0;
@@ -27,6 +27,7 @@
 #include "responder/common/responder.h"
 #include "responder/common/cache_req/cache_req.h"
 #include "lib/certmap/sss_certmap.h"
+#include "util/sss_crypt_pool.h"
 
 struct pam_auth_req;
 
@@ -54,6 +55,9 @@ struct pam_ctx {
 
     char **prompting_config_sections;
     int num_prompting_config_sections;
+
+    /* Helper threads computing password hashes for offline authentication */
+    struct sss_crypt_pool *crypt_pool;
 };
 
 struct pam_auth_req {
@@ -68,6 +72,9 @@ struct pam_auth_req {
     bool is_uid_trusted;
     void *data;
     bool use_cached_auth;
+    /* whether the running cached authentication was started before
+     * contacting the backend because of cached_auth_timeout */
+    bool cached_auth_first;
     /* whether cached authentication was tried and failed */
     bool cached_auth_failed;
 
@@ -687,6 +687,7 @@ static errno_t get_password_for_cache_auth(struct sss_auth_token *authtok,
 static int pam_forwarder(struct cli_ctx *cctx, int pam_cmd);
 static void pam_handle_cached_login(struct pam_auth_req *preq, int ret,
                                     time_t expire_date, time_t delayed_until, bool cached_auth);
+static void pam_cached_auth_done(struct tevent_req *req);
 
 /*
  * Add a request to add a variable to the PAM user environment, containing the
@@ -788,8 +789,6 @@ static void pam_reply(struct pam_auth_req *preq)
     struct pam_data *pd;
     struct pam_ctx *pctx;
     uint32_t user_info_type;
-    time_t exp_date = -1;
-    time_t delay_until = -1;
     char* pam_account_expired_message;
     char* pam_account_locked_message;
     int pam_verbosity;
@@ -843,10 +842,10 @@ static void pam_reply(struct pam_auth_req *preq)
                 (preq->domain->cache_credentials == true) &&
                 (pd->offline_auth == false)) {
                 const char *password = NULL;
-                bool use_cached_auth;
+                struct tevent_req *req;
 
                 /* backup value of preq->use_cached_auth*/
-                use_cached_auth = preq->use_cached_auth;
+                preq->cached_auth_first = preq->use_cached_auth;
                 /* set to false to avoid entering this branch when pam_reply()
                  * is recursively called from pam_handle_cached_login() */
                 preq->use_cached_auth = false;
@@ -868,13 +867,17 @@ static void pam_reply(struct pam_auth_req *preq)
                     goto done;
                 }
 
-                ret = sysdb_cache_auth(preq->domain,
-                                       pd->user, password,
-                                       pctx->rctx->cdb, false,
-                                       &exp_date, &delay_until);
-
-                pam_handle_cached_login(preq, ret, exp_date, delay_until,
-                                        use_cached_auth);
+                /* The password hash is computed by the crypto pool helper
+                 * threads, the reply is sent from pam_cached_auth_done() */
+                req = sysdb_cache_auth_send(preq, cctx->ev, pctx->crypt_pool,
+                                            preq->domain, pd->user, password,
+                                            pctx->rctx->cdb, false);
+                if (req == NULL) {
+                    DEBUG(SSSDBG_CRIT_FAILURE,
+                          "sysdb_cache_auth_send failed.\n");
+                    goto done;
+                }
+                tevent_req_set_callback(req, pam_cached_auth_done, preq);
                 return;
             }
             break;
@@ -1154,6 +1157,22 @@ static void pam_handle_cached_login(struct pam_auth_req *preq, int ret,
     return;
 }
 
+static void pam_cached_auth_done(struct tevent_req *req)
+{
+    struct pam_auth_req *preq;
+    time_t exp_date = -1;
+    time_t delay_until = -1;
+    int ret;
+
+    preq = tevent_req_callback_data(req, struct pam_auth_req);
+
+    ret = sysdb_cache_auth_recv(req, &exp_date, &delay_until);
+    talloc_zfree(req);
+
+    pam_handle_cached_login(preq, ret, exp_date, delay_until,
+                            preq->cached_auth_first);
+}
+
 static void pam_forwarder_cb(struct tevent_req *req);
 static void pam_forwarder_cert_cb(struct tevent_req *req);
 static int pam_check_user_search(struct pam_auth_req *preq);
@@ -24,10 +24,56 @@
 #include "confdb/confdb.h"
 #include "responder/common/responder.h"
 #include "responder/sudo/sudosrv_private.h"
+#include "responder/nss/nsssrv_mmap_cache.h"
 #include "providers/data_provider.h"
 #include "responder/common/negcache.h"
 #include "sss_iface/sss_iface_async.h"
 
+static errno_t sudo_memcache_init(struct sudo_ctx *sudo_ctx,
+                                  struct confdb_ctx *cdb)
+{
+    int memcache_timeout;
+    uid_t uid;
+    gid_t gid;
+    errno_t ret;
+
+    ret = confdb_get_int(cdb, CONFDB_SUDO_CONF_ENTRY,
+                         CONFDB_MEMCACHE_TIMEOUT,
+                         CONFDB_DEFAULT_SUDO_MEMCACHE_TIMEOUT,
+                         &memcache_timeout);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get 'memcache_timeout' option from confdb.\n");
+        return ret;
+    }
+
+    /* The reply depends on the current time when time restrictions
+     * are applied, it cannot be reused. */
+    if (memcache_timeout == 0 || sudo_ctx->timed) {
+        DEBUG(SSSDBG_CONF_SETTINGS,
+              "Fast in-memory cache will not be initialized.\n");
+        return EOK;
+    }
+
+    /* The memory cache files are owned by the sssd user, see the nss
+     * responder. */
+    ret = sss_user_by_name_or_uid(SSSD_USER, &uid, &gid);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot get info on "SSSD_USER", "
+              "sudo mmap cache is DISABLED\n");
+        return EOK;
+    }
+
+    ret = sss_mmap_cache_init(sudo_ctx, "sudo", uid, gid, SSS_MC_SUDO,
+                              SUDO_MC_CACHE_ELEMENTS,
+                              (time_t)memcache_timeout, &sudo_ctx->mc_ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "sudo mmap cache is DISABLED\n");
+    }
+
+    return EOK;
+}
+
 int sudo_process_init(TALLOC_CTX *mem_ctx,
                       struct tevent_context *ev,
                       struct confdb_ctx *cdb,
@@ -102,6 +148,12 @@ int sudo_process_init(TALLOC_CTX *mem_ctx,
         goto fail;
     }
 
+    ret = sudo_memcache_init(sudo_ctx, cdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Cannot initialize the memory cache\n");
+        goto fail;
+    }
+
     ret = schedule_get_domains_task(rctx, rctx->ev, rctx, NULL);
     if (ret != EOK) {
         DEBUG(SSSDBG_FATAL_FAILURE, "schedule_get_domains_tasks failed.\n");
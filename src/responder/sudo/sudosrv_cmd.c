@@ -26,6 +26,7 @@
 #include "responder/common/responder.h"
 #include "responder/common/responder_packet.h"
 #include "responder/sudo/sudosrv_private.h"
+#include "responder/nss/nsssrv_mmap_cache.h"
 #include "db/sysdb_sudo.h"
 #include "sss_client/sss_cli.h"
 #include "responder/common/negcache.h"
@@ -35,8 +36,6 @@ static errno_t sudosrv_cmd_send_reply(struct sudo_cmd_ctx *cmd_ctx,
                                       size_t response_len)
 {
     errno_t ret;
-    uint8_t *packet_body = NULL;
-    size_t packet_len = 0;
     struct cli_ctx *cli_ctx = cmd_ctx->cli_ctx;
     struct cli_protocol *pctx;
     TALLOC_CTX *tmp_ctx;
@@ -56,14 +55,14 @@ static errno_t sudosrv_cmd_send_reply(struct sudo_cmd_ctx *cmd_ctx,
         goto done;
     }
 
-    ret = sss_packet_grow(pctx->creq->out, response_len);
+    /* The rules may be large, send them without copying. */
+    ret = sss_packet_append_fragment(pctx->creq->out, response_body,
+                                     response_len);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "Unable to create response: %s\n", strerror(ret));
         goto done;
     }
-    sss_packet_get_body(pctx->creq->out, &packet_body, &packet_len);
-    memcpy(packet_body, response_body, response_len);
 
     sss_packet_set_error(pctx->creq->out, EOK);
     sss_cmd_done(cmd_ctx->cli_ctx, cmd_ctx);
@@ -75,6 +74,48 @@ done:
     return ret;
 }
 
+static void sudosrv_mc_store_reply(struct sudo_cmd_ctx *cmd_ctx,
+                                   uint8_t *response_body,
+                                   size_t response_len)
+{
+    struct sudo_ctx *sudo_ctx = cmd_ctx->sudo_ctx;
+    struct cli_protocol *pctx;
+    struct sized_string user;
+    errno_t ret;
+
+    if (sudo_ctx->mc_ctx == NULL) {
+        return;
+    }
+
+    pctx = talloc_get_type(cmd_ctx->cli_ctx->protocol_ctx,
+                           struct cli_protocol);
+
+    /* The client looks the reply up by exactly what it has sent to us. */
+    to_sized_string(&user, cmd_ctx->rawname);
+    ret = sss_mmap_cache_sudo_store(&sudo_ctx->mc_ctx,
+                                    sss_packet_get_cmd(pctx->creq->in),
+                                    cmd_ctx->uid, &user,
+                                    response_body, response_len);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Failed to store rules of %s in the "
+              "memory cache [%d]: %s\n", cmd_ctx->rawname,
+              ret, sss_strerror(ret));
+    }
+}
+
+static void sudosrv_mc_invalidate_user(struct sudo_cmd_ctx *cmd_ctx)
+{
+    struct sized_string user;
+
+    if (cmd_ctx->sudo_ctx->mc_ctx == NULL || cmd_ctx->rawname == NULL) {
+        return;
+    }
+
+    to_sized_string(&user, cmd_ctx->rawname);
+    (void)sss_mmap_cache_sudo_invalidate_user(cmd_ctx->sudo_ctx->mc_ctx,
+                                              &user);
+}
+
 static errno_t sudosrv_cmd_send_error(TALLOC_CTX *mem_ctx,
                                       struct sudo_cmd_ctx *cmd_ctx,
                                       uint32_t error)
@@ -135,6 +176,8 @@ errno_t sudosrv_cmd_reply(struct sudo_cmd_ctx *cmd_ctx, int ret)
             return EFAULT;
         }
 
+        sudosrv_mc_store_reply(cmd_ctx, response_body, response_len);
+
         ret = sudosrv_cmd_send_reply(cmd_ctx, response_body, response_len);
         break;
 
@@ -153,6 +196,10 @@ errno_t sudosrv_cmd_reply(struct sudo_cmd_ctx *cmd_ctx, int ret)
      */
 
     default:
+        /* The user must not keep getting the old rules from the memory
+         * cache either. */
+        sudosrv_mc_invalidate_user(cmd_ctx);
+
         /* send error */
         ret = sudosrv_cmd_send_error(cmd_ctx, cmd_ctx, ret);
         break;
@@ -30,6 +30,9 @@
 
 #define SSS_SUDO_ERROR_OK 0
 
+/* users running sudo on this host, rules and defaults for each */
+#define SUDO_MC_CACHE_ELEMENTS 2000
+
 enum sss_dp_sudo_type {
     SSS_DP_SUDO_REFRESH_RULES,
     SSS_DP_SUDO_FULL_REFRESH
@@ -49,6 +52,9 @@ struct sudo_ctx {
     bool timed;
     bool inverse_order;
     int threshold;
+
+    /* Memory cache of replies read directly by libsss_sudo. */
+    struct sss_mc_ctx *mc_ctx;
 };
 
 struct sudo_cmd_ctx {
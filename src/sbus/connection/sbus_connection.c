@@ -114,6 +114,11 @@ sbus_connection_data_init(struct sbus_connection *conn)
         goto fail;
     }
 
+    conn->arenas = sbus_request_arenas_init(conn);
+    if (conn->arenas == NULL) {
+        goto fail;
+    }
+
     return EOK;
 
 fail:
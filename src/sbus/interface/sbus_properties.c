@@ -396,13 +396,14 @@ struct sbus_properties_get_state {
 static void sbus_properties_get_done(struct tevent_req *subreq);
 
 static struct tevent_req *
-sbus_properties_get_send(TALLOC_CTX *mem_ctx,
-                         struct tevent_context *ev,
-                         struct sbus_request *sbus_req,
-                         struct sbus_router *router,
-                         const char *interface_name,
-                         const char *property_name,
-                         DBusMessageIter *write_iterator)
+sbus_properties_read_send(TALLOC_CTX *mem_ctx,
+                          struct tevent_context *ev,
+                          struct sbus_request *sbus_req,
+                          struct sbus_router *router,
+                          const char *interface_name,
+                          const char *property_name,
+                          struct sbus_request_batch *batch,
+                          DBusMessageIter *write_iterator)
 {
     struct sbus_properties_get_state *state;
     const struct sbus_property *property;
@@ -435,6 +436,8 @@ sbus_properties_get_send(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    property_req->batch = batch;
+
     state->iter.root = write_iterator;
     ret = sbus_open_variant(state->iter.root, &state->iter.variant,
                             property->type);
@@ -496,6 +499,20 @@ done:
     tevent_req_done(req);
 }
 
+static struct tevent_req *
+sbus_properties_get_send(TALLOC_CTX *mem_ctx,
+                         struct tevent_context *ev,
+                         struct sbus_request *sbus_req,
+                         struct sbus_router *router,
+                         const char *interface_name,
+                         const char *property_name,
+                         DBusMessageIter *write_iterator)
+{
+    return sbus_properties_read_send(mem_ctx, ev, sbus_req, router,
+                                     interface_name, property_name,
+                                     NULL, write_iterator);
+}
+
 static errno_t
 sbus_properties_get_recv(TALLOC_CTX *mem_ctx,
                          struct tevent_req *req)
@@ -510,6 +527,7 @@ struct sbus_properties_getall_state {
     struct sbus_router *router;
     struct sbus_request *sbus_req;
     const char *interface_name;
+    struct sbus_request_batch *batch;
 
     struct {
         DBusMessageIter *root;
@@ -570,6 +588,14 @@ sbus_properties_getall_send(TALLOC_CTX *mem_ctx,
     state->properties = iface->properties;
     state->iter.root = write_iterator;
 
+    /* All properties are read from the same object so let the getters
+     * share data that they would otherwise have to obtain repeatedly. */
+    state->batch = sbus_request_batch_create(state);
+    if (state->batch == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
     /* Open array of <key, value> pairs. */
     ret = sbus_open_dict(state->iter.root, &state->iter.dict);
     if (ret != EOK) {
@@ -637,9 +663,10 @@ sdap_properties_getall_next(struct tevent_req *req)
         return ret;
     }
 
-    subreq = sbus_properties_get_send(state, state->ev, state->sbus_req,
-                                      state->router, state->interface_name,
-                                      property->name, &state->dummy.write_iter);
+    subreq = sbus_properties_read_send(state, state->ev, state->sbus_req,
+                                       state->router, state->interface_name,
+                                       property->name, state->batch,
+                                       &state->dummy.write_iter);
     if (subreq == NULL) {
         return ENOMEM;
     }
@@ -108,6 +108,33 @@ fail:
     return NULL;
 }
 
+struct sbus_request_batch *
+sbus_request_batch_create(TALLOC_CTX *mem_ctx)
+{
+    return talloc_zero(mem_ctx, struct sbus_request_batch);
+}
+
+errno_t sbus_request_batch_set(struct sbus_request *sbus_req, void *data)
+{
+    if (sbus_req->batch == NULL) {
+        return ENOENT;
+    }
+
+    talloc_zfree(sbus_req->batch->data);
+    sbus_req->batch->data = talloc_steal(sbus_req->batch, data);
+
+    return EOK;
+}
+
+void *_sbus_request_batch_get(struct sbus_request *sbus_req)
+{
+    if (sbus_req->batch == NULL) {
+        return NULL;
+    }
+
+    return sbus_req->batch->data;
+}
+
 static errno_t
 sbus_request_prepare_reply(TALLOC_CTX *mem_ctx,
                            enum sbus_request_type type,
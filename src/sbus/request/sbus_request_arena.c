@@ -0,0 +1,86 @@
+/*
+    SSSD
+
+    sbus - memory arenas for incoming requests
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+
+#include "util/util.h"
+#include "util/dlinklist.h"
+#include "sbus/sbus_private.h"
+
+struct sbus_request_arenas *
+sbus_request_arenas_init(TALLOC_CTX *mem_ctx)
+{
+    return talloc_zero(mem_ctx, struct sbus_request_arenas);
+}
+
+struct sbus_request_arena *
+sbus_request_arena_get(struct sbus_connection *conn)
+{
+    struct sbus_request_arenas *arenas = conn->arenas;
+    struct sbus_request_arena *arena;
+
+    arena = arenas->idle;
+    if (arena != NULL) {
+        DLIST_REMOVE(arenas->idle, arena);
+        arenas->num_idle--;
+        arenas->stats.reused++;
+        arena->uses++;
+        return arena;
+    }
+
+    arena = talloc_pooled_object(arenas, struct sbus_request_arena,
+                                 SBUS_REQUEST_ARENA_OBJECTS,
+                                 SBUS_REQUEST_ARENA_SIZE);
+    if (arena == NULL) {
+        return NULL;
+    }
+
+    arena->uses = 1;
+    arena->prev = NULL;
+    arena->next = NULL;
+    arenas->stats.created++;
+
+    return arena;
+}
+
+void
+sbus_request_arena_put(struct sbus_connection *conn,
+                       struct sbus_request_arena *arena)
+{
+    struct sbus_request_arenas *arenas = conn->arenas;
+
+    if (arena == NULL) {
+        return;
+    }
+
+    if (conn->disconnecting
+            || arenas->num_idle >= SBUS_REQUEST_ARENAS_MAX
+            || arena->uses >= SBUS_REQUEST_ARENA_MAX_USES) {
+        talloc_free(arena);
+        return;
+    }
+
+    /* The pool is rewound once the last object allocated from it is freed. */
+    talloc_free_children(arena);
+
+    DLIST_ADD(arenas->idle, arena);
+    arenas->num_idle++;
+}
@@ -50,6 +50,7 @@ sbus_message_meta_read(DBusMessage *message,
 }
 
 struct sbus_issue_request_state {
+    struct sbus_request_arena *arena;
     struct sbus_connection *conn;
     DBusMessageIter message_iter;
     DBusMessage *message;
@@ -59,8 +60,7 @@ struct sbus_issue_request_state {
 static void sbus_issue_request_done(struct tevent_req *subreq);
 
 static errno_t
-sbus_issue_request(TALLOC_CTX *mem_ctx,
-                   struct sbus_message_meta *meta,
+sbus_issue_request(struct sbus_message_meta *meta,
                    struct sbus_connection *conn,
                    DBusMessage *message,
                    enum sbus_request_type type,
@@ -68,15 +68,25 @@ sbus_issue_request(TALLOC_CTX *mem_ctx,
                    const struct sbus_handler *handler)
 {
     struct sbus_issue_request_state *state;
+    struct sbus_request_arena *arena;
     struct sbus_request *request;
     struct tevent_req *subreq;
     errno_t ret;
 
-    state = talloc_zero(mem_ctx, struct sbus_issue_request_state);
+    /* Everything allocated while the request is processed, including the
+     * decoded arguments, lives in a reusable arena of the connection. */
+    arena = sbus_request_arena_get(conn);
+    if (arena == NULL) {
+        return ENOMEM;
+    }
+
+    state = talloc_zero(arena, struct sbus_issue_request_state);
     if (state == NULL) {
+        sbus_request_arena_put(conn, arena);
         return ENOMEM;
     }
 
+    state->arena = arena;
     state->conn = conn;
     state->message = dbus_message_ref(message);
     state->type = type;
@@ -112,7 +122,7 @@ sbus_issue_request(TALLOC_CTX *mem_ctx,
 
 done:
     if (ret != EOK) {
-        talloc_free(state);
+        sbus_request_arena_put(conn, arena);
     }
 
     return ret;
@@ -159,7 +169,7 @@ done:
         sbus_connection_free(state->conn);
     }
 
-    talloc_free(state);
+    sbus_request_arena_put(state->conn, state->arena);
 }
 
 DBusHandlerResult
@@ -200,7 +210,7 @@ sbus_method_handler(struct sbus_connection *conn,
 
     sbus_annotation_warn(iface, method);
 
-    ret = sbus_issue_request(conn, meta, conn, message, SBUS_REQUEST_METHOD,
+    ret = sbus_issue_request(meta, conn, message, SBUS_REQUEST_METHOD,
                              &method->invoker, &method->handler);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to issue request [%d]: %s\n",
@@ -244,8 +254,7 @@ sbus_signal_handler(struct sbus_connection *conn,
     }
 
     DLIST_FOR_EACH(item, list) {
-        ret = sbus_issue_request(conn, meta, conn, message,
-                                 SBUS_REQUEST_SIGNAL,
+        ret = sbus_issue_request(meta, conn, message, SBUS_REQUEST_SIGNAL,
                                  &item->listener->invoker,
                                  &item->listener->handler);
         if (ret != EOK) {
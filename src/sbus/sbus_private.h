@@ -93,6 +93,7 @@ struct sbus_connection {
     struct sbus_reconnect *reconnect;
     struct sbus_router *router;
     struct sbus_watch *watch;
+    struct sbus_request_arenas *arenas;
 
     /**
      * Connection private data.
@@ -489,6 +490,53 @@ void
 sbus_requests_terminate_all(hash_table_t *table,
                             errno_t error);
 
+/* Large enough for the request, invoker state and arguments of a typical
+ * call. Anything that does not fit is allocated with malloc() as usual. */
+#define SBUS_REQUEST_ARENA_SIZE 8192
+#define SBUS_REQUEST_ARENA_OBJECTS 64
+
+/* Idle arenas kept per connection. */
+#define SBUS_REQUEST_ARENAS_MAX 16
+
+/* Memory that a handler steals out of an arena keeps the pool from being
+ * rewound until it is freed. Replacing arenas from time to time makes sure
+ * such an arena does not stay in the cache forever. */
+#define SBUS_REQUEST_ARENA_MAX_USES 1024
+
+/* Memory arena of a single incoming request. It is a talloc pool that
+ * is rewound when the request is finished and reused for another one. */
+struct sbus_request_arena {
+    unsigned int uses;
+
+    struct sbus_request_arena *prev;
+    struct sbus_request_arena *next;
+};
+
+/* Arenas of a connection that are not used by any request. */
+struct sbus_request_arenas {
+    struct sbus_request_arena *idle;
+    unsigned int num_idle;
+
+    struct {
+        uint64_t created;
+        uint64_t reused;
+    } stats;
+};
+
+/* Initialize arena cache of a connection. */
+struct sbus_request_arenas *
+sbus_request_arenas_init(TALLOC_CTX *mem_ctx);
+
+/* Get memory arena for a new incoming request. */
+struct sbus_request_arena *
+sbus_request_arena_get(struct sbus_connection *conn);
+
+/* Return the arena once the request is finished. Everything that is still
+ * allocated on it is freed. */
+void
+sbus_request_arena_put(struct sbus_connection *conn,
+                       struct sbus_request_arena *arena);
+
 /* Create new sbus request. */
 struct sbus_request *
 sbus_request_create(TALLOC_CTX *mem_ctx,
@@ -499,6 +547,15 @@ sbus_request_create(TALLOC_CTX *mem_ctx,
                     const char *member,
                     const char *path);
 
+/* Data shared between property getters of a single GetAll call. */
+struct sbus_request_batch {
+    void *data;
+};
+
+/* Create new batch for GetAll property requests. */
+struct sbus_request_batch *
+sbus_request_batch_create(TALLOC_CTX *mem_ctx);
+
 /* Run an incoming request handler. */
 struct tevent_req *
 sbus_incoming_request_send(TALLOC_CTX *mem_ctx,
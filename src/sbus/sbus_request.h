@@ -29,6 +29,7 @@
 #include "sbus/sbus_opath.h"
 
 struct sbus_connection;
+struct sbus_request_batch;
 
 /**
  * There are several cases when the sender id cannot be resolved but the
@@ -114,8 +115,40 @@ struct sbus_request {
      * Object path of an sbus object.
      */
     const char *path;
+
+    /**
+     * Data shared between all property getters that are invoked by a single
+     * org.freedesktop.DBus.Properties.GetAll call, NULL otherwise.
+     *
+     * @see sbus_request_batch_get
+     */
+    struct sbus_request_batch *batch;
 };
 
+/**
+ * Store @data in the request batch so it can be reused by other property
+ * getters invoked by the same GetAll call. The data is stolen by the batch
+ * and replaces any previously stored data. If this request is not a part
+ * of GetAll, the data is left untouched and ENOENT is returned.
+ *
+ * @param sbus_req          An sbus request.
+ * @param data              Talloc allocated data.
+ *
+ * @return EOK on success, ENOENT if there is no batch, other errno code
+ *         on failure.
+ */
+errno_t sbus_request_batch_set(struct sbus_request *sbus_req, void *data);
+
+void *_sbus_request_batch_get(struct sbus_request *sbus_req);
+
+/**
+ * Return data that were previously stored in the request batch with
+ * @sbus_request_batch_set or NULL if there are no such data or if they
+ * are not of the given talloc type.
+ */
+#define sbus_request_batch_get(sbus_req, type) \
+    talloc_get_type(_sbus_request_batch_get(sbus_req), type)
+
 /**
  * Await a finish of an outgoing sbus request.
  *
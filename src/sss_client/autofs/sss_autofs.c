@@ -23,6 +23,7 @@
 
 #include "sss_client/autofs/sss_autofs_private.h"
 #include "sss_client/sss_cli.h"
+#include "sss_client/nss_mc.h"
 
 /* Historically, autofs map names were just file names. Direct key names
  * may be full directory paths
@@ -381,6 +382,12 @@ _sss_getautomntbyname_r(const char *key, char **value, void *context)
         goto out;
     }
 
+    /* Try the memory cache first, it is maintained by the responder */
+    ret = sss_nss_mc_getautomntbyname(ctx->mapname, name_len, key, key_len,
+                                      value);
+    if (ret == 0) {
+        goto out;
+    }
 
     data_len = sizeof(uint32_t) +            /* mapname len */
                name_len + 1 +                /* mapname\0   */
@@ -90,4 +90,14 @@ errno_t sss_nss_mc_initgroups_dyn(const char *name, size_t name_len,
                                   gid_t group, long int *start, long int *size,
                                   gid_t **groups, long int limit);
 
+/* autofs db */
+errno_t sss_nss_mc_getautomntbyname(const char *mapname, size_t mapname_len,
+                                    const char *key, size_t key_len,
+                                    char **_value);
+
+/* sudo rules */
+errno_t sss_nss_mc_get_sudo_reply(uint32_t command, uid_t uid,
+                                  const char *user, size_t user_len,
+                                  uint8_t **_reply, size_t *_reply_len);
+
 #endif /* _NSS_MC_H_ */
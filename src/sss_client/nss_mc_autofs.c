@@ -0,0 +1,171 @@
+/*
+ * System Security Services Daemon. Autofs client interface
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* AUTOFS map lookups using mmap cache */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <time.h>
+#include "nss_mc.h"
+
+static struct sss_cli_mc_ctx autofs_mc_ctx = { UNINITIALIZED, -1, 0, NULL, 0,
+                                               NULL, 0, NULL, 0, 0 };
+
+static errno_t sss_nss_mc_parse_autofs(struct sss_mc_rec *rec,
+                                       char **_value)
+{
+    struct sss_mc_autofs_data *data;
+    const size_t strs_offset = offsetof(struct sss_mc_autofs_data, strs);
+    const char *value;
+    size_t max_len;
+    size_t len;
+    time_t expire;
+
+    /* additional checks before filling result*/
+    expire = rec->expire;
+    if (expire < time(NULL)) {
+        /* entry is now invalid */
+        return EINVAL;
+    }
+
+    data = (struct sss_mc_autofs_data *)rec->data;
+
+    /* Integrity check
+     * - data->value cannot point outside strings
+     * - value must be zero-terminated within strings */
+    if (data->value < strs_offset
+            || data->value >= strs_offset + data->strs_len) {
+        return EINVAL;
+    }
+
+    value = (const char *)data + data->value;
+    max_len = strs_offset + data->strs_len - data->value;
+    len = strnlen(value, max_len);
+    if (len == max_len) {
+        return EINVAL;
+    }
+
+    *_value = malloc(len + 1);
+    if (*_value == NULL) {
+        return ENOMEM;
+    }
+    memcpy(*_value, value, len + 1);
+
+    return 0;
+}
+
+errno_t sss_nss_mc_getautomntbyname(const char *mapname, size_t mapname_len,
+                                    const char *key, size_t key_len,
+                                    char **_value)
+{
+    struct sss_mc_rec *rec = NULL;
+    struct sss_mc_autofs_data *data;
+    const size_t strs_offset = offsetof(struct sss_mc_autofs_data, strs);
+    char *lookup = NULL;
+    size_t lookup_len;
+    char *rec_name;
+    uint32_t hash;
+    uint32_t slot;
+    int ret;
+
+    /* The responder never stores entries with a new line in the map name
+     * or key, see sss_mmap_cache_autofs_store(). */
+    if (memchr(mapname, '\n', mapname_len) != NULL
+            || memchr(key, '\n', key_len) != NULL) {
+        return ENOENT;
+    }
+
+    ret = sss_nss_mc_get_ctx("autofs", &autofs_mc_ctx);
+    if (ret) {
+        return ret;
+    }
+
+    lookup_len = mapname_len + 1 + key_len;
+    lookup = malloc(lookup_len + 1);
+    if (lookup == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    memcpy(lookup, mapname, mapname_len);
+    lookup[mapname_len] = '\n';
+    memcpy(lookup + mapname_len + 1, key, key_len);
+    lookup[lookup_len] = '\0';
+
+    /* hashes are calculated including the NULL terminator */
+    hash = sss_nss_mc_hash(&autofs_mc_ctx, lookup, lookup_len + 1);
+    slot = autofs_mc_ctx.hash_table[hash];
+
+    /* If slot is not within the bounds of mmapped region and
+     * it's value is not MC_INVALID_VAL, then the cache is
+     * probably corrupted. */
+    while (MC_SLOT_WITHIN_BOUNDS(slot, autofs_mc_ctx.dt_size)) {
+        /* free record from previous iteration */
+        free(rec);
+        rec = NULL;
+
+        ret = sss_nss_mc_get_record(&autofs_mc_ctx, slot, &rec);
+        if (ret) {
+            goto done;
+        }
+
+        /* check record matches what we are searching for */
+        if (hash != rec->hash1) {
+            /* if lookup key hash does not match we can skip this
+             * immediately */
+            slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+            continue;
+        }
+
+        data = (struct sss_mc_autofs_data *)rec->data;
+        /* Integrity check
+         * - data->name cannot point outside strings
+         * - all strings must be within copy of record */
+        if (data->name < strs_offset
+            || data->name >= strs_offset + data->strs_len
+            || data->strs_len > rec->len) {
+            ret = ENOENT;
+            goto done;
+        }
+
+        rec_name = (char *)data + data->name;
+        if (lookup_len < strs_offset + data->strs_len - data->name
+                && memcmp(lookup, rec_name, lookup_len + 1) == 0) {
+            break;
+        }
+
+        slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+    }
+
+    if (!MC_SLOT_WITHIN_BOUNDS(slot, autofs_mc_ctx.dt_size)) {
+        ret = ENOENT;
+        goto done;
+    }
+
+    ret = sss_nss_mc_parse_autofs(rec, _value);
+
+done:
+    free(lookup);
+    free(rec);
+    __sync_sub_and_fetch(&autofs_mc_ctx.active_threads, 1);
+    return ret;
+}
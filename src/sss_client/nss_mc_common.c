@@ -254,6 +254,14 @@ uint32_t sss_nss_mc_hash(struct sss_cli_mc_ctx *ctx,
     return murmurhash3(key, len, ctx->seed) % MC_HT_ELEMS(ctx->ht_size);
 }
 
+static uint32_t sss_nss_mc_generation(struct sss_cli_mc_ctx *ctx)
+{
+    struct sss_mc_header *h = (struct sss_mc_header *)ctx->mmap_base;
+
+    /* single aligned 32bit value, no barriers needed */
+    return *(volatile uint32_t *)&h->generation;
+}
+
 errno_t sss_nss_mc_get_record(struct sss_cli_mc_ctx *ctx,
                               uint32_t slot, struct sss_mc_rec **_rec)
 {
@@ -313,6 +321,13 @@ errno_t sss_nss_mc_get_record(struct sss_cli_mc_ctx *ctx,
         goto done;
     }
 
+    /* Records added before the whole cache was invalidated (by bumping
+     * the generation in the header) must not be used anymore. Expire our
+     * private copy so the caller falls back to the responder. */
+    if (copy_rec->generation != sss_nss_mc_generation(ctx)) {
+        copy_rec->expire = 0;
+    }
+
     *_rec = copy_rec;
     ret = 0;
 
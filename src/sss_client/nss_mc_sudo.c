@@ -0,0 +1,166 @@
+/*
+ * System Security Services Daemon. Sudo client interface
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* SUDO rules lookups using mmap cache */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <time.h>
+#include "nss_mc.h"
+
+static struct sss_cli_mc_ctx sudo_mc_ctx = { UNINITIALIZED, -1, 0, NULL, 0,
+                                             NULL, 0, NULL, 0, 0 };
+
+static errno_t sss_nss_mc_parse_sudo(struct sss_mc_rec *rec,
+                                     uint8_t **_reply,
+                                     size_t *_reply_len)
+{
+    struct sss_mc_sudo_data *data;
+    const size_t strs_offset = offsetof(struct sss_mc_sudo_data, strs);
+    time_t expire;
+
+    /* additional checks before filling result*/
+    expire = rec->expire;
+    if (expire < time(NULL)) {
+        /* entry is now invalid */
+        return EINVAL;
+    }
+
+    data = (struct sss_mc_sudo_data *)rec->data;
+
+    /* Integrity check
+     * - the whole reply must be within strings */
+    if (data->reply < strs_offset
+            || data->reply_len > data->strs_len
+            || data->reply - strs_offset > data->strs_len - data->reply_len) {
+        return EINVAL;
+    }
+
+    *_reply = malloc(data->reply_len);
+    if (*_reply == NULL) {
+        return ENOMEM;
+    }
+    memcpy(*_reply, (uint8_t *)data + data->reply, data->reply_len);
+    *_reply_len = data->reply_len;
+
+    return 0;
+}
+
+errno_t sss_nss_mc_get_sudo_reply(uint32_t command, uid_t uid,
+                                  const char *user, size_t user_len,
+                                  uint8_t **_reply, size_t *_reply_len)
+{
+    struct sss_mc_rec *rec = NULL;
+    struct sss_mc_sudo_data *data;
+    const size_t strs_offset = offsetof(struct sss_mc_sudo_data, strs);
+    char prefix[32];
+    char *lookup = NULL;
+    size_t prefix_len;
+    size_t lookup_len;
+    char *rec_name;
+    uint32_t hash;
+    uint32_t slot;
+    int ret;
+
+    ret = sss_nss_mc_get_ctx("sudo", &sudo_mc_ctx);
+    if (ret) {
+        return ret;
+    }
+
+    /* see sss_mc_sudo_lookup_key() in the responder */
+    ret = snprintf(prefix, sizeof(prefix), "%u\n%u\n",
+                   (unsigned int)command, (unsigned int)uid);
+    if (ret < 0 || ret >= sizeof(prefix)) {
+        ret = EINVAL;
+        goto done;
+    }
+    prefix_len = ret;
+
+    lookup_len = prefix_len + user_len;
+    lookup = malloc(lookup_len + 1);
+    if (lookup == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    memcpy(lookup, prefix, prefix_len);
+    memcpy(lookup + prefix_len, user, user_len);
+    lookup[lookup_len] = '\0';
+
+    /* hashes are calculated including the NULL terminator */
+    hash = sss_nss_mc_hash(&sudo_mc_ctx, lookup, lookup_len + 1);
+    slot = sudo_mc_ctx.hash_table[hash];
+
+    /* If slot is not within the bounds of mmapped region and
+     * it's value is not MC_INVALID_VAL, then the cache is
+     * probably corrupted. */
+    while (MC_SLOT_WITHIN_BOUNDS(slot, sudo_mc_ctx.dt_size)) {
+        /* free record from previous iteration */
+        free(rec);
+        rec = NULL;
+
+        ret = sss_nss_mc_get_record(&sudo_mc_ctx, slot, &rec);
+        if (ret) {
+            goto done;
+        }
+
+        /* check record matches what we are searching for */
+        if (hash != rec->hash1) {
+            /* if lookup key hash does not match we can skip this
+             * immediately */
+            slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+            continue;
+        }
+
+        data = (struct sss_mc_sudo_data *)rec->data;
+        /* Integrity check
+         * - data->name cannot point outside strings
+         * - all strings must be within copy of record */
+        if (data->name < strs_offset
+            || data->name >= strs_offset + data->strs_len
+            || data->strs_len > rec->len) {
+            ret = ENOENT;
+            goto done;
+        }
+
+        rec_name = (char *)data + data->name;
+        if (lookup_len < strs_offset + data->strs_len - data->name
+                && memcmp(lookup, rec_name, lookup_len + 1) == 0) {
+            break;
+        }
+
+        slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+    }
+
+    if (!MC_SLOT_WITHIN_BOUNDS(slot, sudo_mc_ctx.dt_size)) {
+        ret = ENOENT;
+        goto done;
+    }
+
+    ret = sss_nss_mc_parse_sudo(rec, _reply, _reply_len);
+
+done:
+    free(lookup);
+    free(rec);
+    __sync_sub_and_fetch(&sudo_mc_ctx.active_threads, 1);
+    return ret;
+}
@@ -27,6 +27,7 @@
 
 #include "util/util.h"
 #include "sss_client/sss_cli.h"
+#include "sss_client/nss_mc.h"
 #include "sss_client/sudo/sss_sudo.h"
 #include "sss_client/sudo/sss_sudo_private.h"
 
@@ -56,6 +57,14 @@ static int sss_sudo_send_recv_generic(enum sss_cli_command command,
     int errnop = 0;
     int ret = 0;
 
+    /* try the memory cache first, it holds the very same reply */
+
+    ret = sss_nss_mc_get_sudo_reply(command, uid, username, strlen(username),
+                                    &reply_buf, &reply_len);
+    if (ret == EOK) {
+        goto parse;
+    }
+
     /* create query */
 
     ret = sss_sudo_create_query(uid, username, &query_buf, &query_len);
@@ -76,6 +85,7 @@ static int sss_sudo_send_recv_generic(enum sss_cli_command command,
         goto done;
     }
 
+parse:
     /* parse structure */
 
     ret = sss_sudo_parse_response((const char*)reply_buf, reply_len,
@@ -0,0 +1,816 @@
+/*
+    SSSD
+
+    Binary IPC between responders and the data provider
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <dhash.h>
+
+#include "util/util.h"
+#include "sbus/sbus_message.h"
+#include "sss_iface/sss_iface_fast.h"
+
+/* How much is read from the socket at once */
+#define SSS_FAST_READ_CHUNK 65536
+
+/* Frames sent with a single system call */
+#define SSS_FAST_MAX_IOV 64
+
+struct sss_fast_frame {
+    struct sss_fast_frame *prev;
+    struct sss_fast_frame *next;
+
+    uint8_t *data;
+    size_t len;
+    size_t written;
+};
+
+struct sss_fast_conn {
+    struct tevent_context *ev;
+    struct tevent_fd *fde;
+
+    uint8_t *rbuf;
+    size_t rbuf_size;
+    size_t rbuf_len;
+
+    struct sss_fast_frame *out;
+
+    sss_fast_frame_fn frame_fn;
+    sss_fast_close_fn close_fn;
+    void *data;
+};
+
+static void sss_fast_conn_close(struct sss_fast_conn *conn, errno_t error)
+{
+    DEBUG(SSSDBG_TRACE_FUNC, "Closing connection [%d]: %s\n",
+          error, sss_strerror(error));
+
+    /* closes the socket */
+    talloc_zfree(conn->fde);
+
+    while (conn->out != NULL) {
+        talloc_free(conn->out);
+    }
+
+    if (conn->close_fn != NULL) {
+        conn->close_fn(conn, error, conn->data);
+    }
+}
+
+static int sss_fast_frame_destructor(struct sss_fast_frame *frame)
+{
+    struct sss_fast_conn *conn;
+
+    conn = talloc_get_type(talloc_parent(frame), struct sss_fast_conn);
+    if (conn != NULL) {
+        DLIST_REMOVE(conn->out, frame);
+    }
+
+    return 0;
+}
+
+/* Returns EAGAIN if there is nothing more to read at the moment */
+static errno_t sss_fast_conn_read(struct sss_fast_conn *conn)
+{
+    uint8_t *rbuf;
+    ssize_t len;
+    size_t pos;
+    uint32_t body_len;
+    uint32_t serial;
+    uint32_t code;
+    size_t p;
+
+    if (conn->rbuf_size - conn->rbuf_len < SSS_FAST_READ_CHUNK) {
+        rbuf = talloc_realloc(conn, conn->rbuf, uint8_t,
+                              conn->rbuf_len + SSS_FAST_READ_CHUNK);
+        if (rbuf == NULL) {
+            return ENOMEM;
+        }
+        conn->rbuf = rbuf;
+        conn->rbuf_size = conn->rbuf_len + SSS_FAST_READ_CHUNK;
+    }
+
+    errno = 0;
+    len = read(tevent_fd_get_fd(conn->fde), conn->rbuf + conn->rbuf_len,
+               conn->rbuf_size - conn->rbuf_len);
+    if (len == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return EAGAIN;
+        }
+        return errno;
+    } else if (len == 0) {
+        return EPIPE;
+    }
+
+    conn->rbuf_len += len;
+
+    /* Dispatch all complete frames */
+    pos = 0;
+    while (conn->rbuf_len - pos >= SSS_FAST_HEADER_LEN) {
+        p = pos;
+        SAFEALIGN_COPY_UINT32(&body_len, conn->rbuf + p, &p);
+        SAFEALIGN_COPY_UINT32(&serial, conn->rbuf + p, &p);
+        SAFEALIGN_COPY_UINT32(&code, conn->rbuf + p, &p);
+
+        if (body_len > SSS_FAST_MAX_BODY_LEN) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Frame is too large [%"PRIu32"]\n",
+                  body_len);
+            return EBADMSG;
+        }
+
+        if (conn->rbuf_len - p < body_len) {
+            break;
+        }
+
+        conn->frame_fn(conn, serial, code, conn->rbuf + p, body_len,
+                       conn->data);
+        pos = p + body_len;
+    }
+
+    if (pos > 0) {
+        memmove(conn->rbuf, conn->rbuf + pos, conn->rbuf_len - pos);
+        conn->rbuf_len -= pos;
+    }
+
+    return EOK;
+}
+
+static errno_t sss_fast_conn_write(struct sss_fast_conn *conn)
+{
+    struct iovec iov[SSS_FAST_MAX_IOV];
+    struct msghdr msg;
+    struct sss_fast_frame *frame;
+    struct sss_fast_frame *next;
+    ssize_t len;
+    int count;
+
+    count = 0;
+    DLIST_FOR_EACH(frame, conn->out) {
+        if (count == SSS_FAST_MAX_IOV) {
+            break;
+        }
+
+        iov[count].iov_base = frame->data + frame->written;
+        iov[count].iov_len = frame->len - frame->written;
+        count++;
+    }
+
+    if (count == 0) {
+        TEVENT_FD_NOT_WRITEABLE(conn->fde);
+        return EOK;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+
+    /* A responder that went away must not kill us with SIGPIPE */
+    errno = 0;
+    len = sendmsg(tevent_fd_get_fd(conn->fde), &msg, MSG_NOSIGNAL);
+    if (len == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return EOK;
+        }
+        return errno;
+    }
+
+    for (frame = conn->out; frame != NULL && len > 0; frame = next) {
+        next = frame->next;
+
+        if (frame->len - frame->written > len) {
+            frame->written += len;
+            break;
+        }
+
+        len -= frame->len - frame->written;
+        talloc_free(frame);
+    }
+
+    if (conn->out == NULL) {
+        TEVENT_FD_NOT_WRITEABLE(conn->fde);
+    }
+
+    return EOK;
+}
+
+static void sss_fast_conn_handler(struct tevent_context *ev,
+                                  struct tevent_fd *fde,
+                                  uint16_t flags,
+                                  void *ptr)
+{
+    struct sss_fast_conn *conn = talloc_get_type(ptr, struct sss_fast_conn);
+    errno_t ret;
+
+    if (flags & TEVENT_FD_WRITE) {
+        ret = sss_fast_conn_write(conn);
+        if (ret != EOK) {
+            sss_fast_conn_close(conn, ret);
+            return;
+        }
+    }
+
+    if (flags & TEVENT_FD_READ) {
+        ret = sss_fast_conn_read(conn);
+        if (ret != EOK && ret != EAGAIN) {
+            sss_fast_conn_close(conn, ret);
+            return;
+        }
+    }
+}
+
+errno_t sss_fast_conn_create(TALLOC_CTX *mem_ctx,
+                             struct tevent_context *ev,
+                             int fd,
+                             sss_fast_frame_fn frame_fn,
+                             sss_fast_close_fn close_fn,
+                             void *data,
+                             struct sss_fast_conn **_conn)
+{
+    struct sss_fast_conn *conn;
+    errno_t ret;
+
+    conn = talloc_zero(mem_ctx, struct sss_fast_conn);
+    if (conn == NULL) {
+        close(fd);
+        return ENOMEM;
+    }
+
+    conn->ev = ev;
+    conn->frame_fn = frame_fn;
+    conn->close_fn = close_fn;
+    conn->data = data;
+
+    ret = sss_fd_nonblocking(fd);
+    if (ret != EOK) {
+        close(fd);
+        talloc_free(conn);
+        return ret;
+    }
+
+    conn->fde = tevent_add_fd(ev, conn, fd, TEVENT_FD_READ,
+                              sss_fast_conn_handler, conn);
+    if (conn->fde == NULL) {
+        close(fd);
+        talloc_free(conn);
+        return ENOMEM;
+    }
+    tevent_fd_set_auto_close(conn->fde);
+
+    *_conn = conn;
+    return EOK;
+}
+
+errno_t sss_fast_conn_send(struct sss_fast_conn *conn,
+                           uint32_t serial,
+                           uint32_t code,
+                           const uint8_t *body,
+                           size_t body_len)
+{
+    struct sss_fast_frame *frame;
+    size_t p = 0;
+
+    if (conn->fde == NULL) {
+        return ENOTCONN;
+    }
+
+    if (body_len > SSS_FAST_MAX_BODY_LEN) {
+        return EMSGSIZE;
+    }
+
+    frame = talloc_zero(conn, struct sss_fast_frame);
+    if (frame == NULL) {
+        return ENOMEM;
+    }
+
+    frame->len = SSS_FAST_HEADER_LEN + body_len;
+    frame->data = talloc_size(frame, frame->len);
+    if (frame->data == NULL) {
+        talloc_free(frame);
+        return ENOMEM;
+    }
+
+    SAFEALIGN_SET_UINT32(frame->data + p, body_len, &p);
+    SAFEALIGN_SET_UINT32(frame->data + p, serial, &p);
+    SAFEALIGN_SET_UINT32(frame->data + p, code, &p);
+    if (body_len > 0) {
+        safealign_memcpy(frame->data + p, body, body_len, &p);
+    }
+
+    DLIST_ADD_END(conn->out, frame, struct sss_fast_frame *);
+    talloc_set_destructor(frame, sss_fast_frame_destructor);
+
+    TEVENT_FD_WRITEABLE(conn->fde);
+
+    return EOK;
+}
+
+static size_t sss_fast_string_len(const char *str)
+{
+    return (str == NULL ? 0 : strlen(str)) + 1;
+}
+
+/* NULL is sent as an empty string, as D-Bus does */
+static void sss_fast_set_string(uint8_t *buf, const char *str, size_t *_p)
+{
+    if (str == NULL) {
+        str = "";
+    }
+
+    safealign_memcpy(buf + *_p, str, strlen(str) + 1, _p);
+}
+
+static errno_t sss_fast_get_string(const uint8_t *body,
+                                   size_t body_len,
+                                   size_t *_p,
+                                   const char **_str)
+{
+    const uint8_t *end;
+
+    if (*_p >= body_len) {
+        return EBADMSG;
+    }
+
+    end = memchr(body + *_p, '\0', body_len - *_p);
+    if (end == NULL) {
+        return EBADMSG;
+    }
+
+    *_str = (const char *)(body + *_p);
+    *_p = end + 1 - body;
+
+    return EOK;
+}
+
+errno_t sss_fast_account_req_pack(TALLOC_CTX *mem_ctx,
+                                  struct sss_fast_account_req *req,
+                                  uint8_t **_body,
+                                  size_t *_body_len)
+{
+    uint8_t *body;
+    size_t len;
+    size_t p = 0;
+
+    len = 2 * sizeof(uint32_t) + sss_fast_string_len(req->filter)
+          + sss_fast_string_len(req->domain)
+          + sss_fast_string_len(req->extra);
+
+    body = talloc_size(mem_ctx, len);
+    if (body == NULL) {
+        return ENOMEM;
+    }
+
+    SAFEALIGN_SET_UINT32(body + p, req->dp_flags, &p);
+    SAFEALIGN_SET_UINT32(body + p, req->entry_type, &p);
+    sss_fast_set_string(body, req->filter, &p);
+    sss_fast_set_string(body, req->domain, &p);
+    sss_fast_set_string(body, req->extra, &p);
+
+    *_body = body;
+    *_body_len = len;
+
+    return EOK;
+}
+
+errno_t sss_fast_account_req_unpack(const uint8_t *body,
+                                    size_t body_len,
+                                    struct sss_fast_account_req *_req)
+{
+    size_t p = 0;
+    errno_t ret;
+
+    if (body_len < 2 * sizeof(uint32_t)) {
+        return EBADMSG;
+    }
+
+    SAFEALIGN_COPY_UINT32(&_req->dp_flags, body + p, &p);
+    SAFEALIGN_COPY_UINT32(&_req->entry_type, body + p, &p);
+
+    ret = sss_fast_get_string(body, body_len, &p, &_req->filter);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sss_fast_get_string(body, body_len, &p, &_req->domain);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sss_fast_get_string(body, body_len, &p, &_req->extra);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return EOK;
+}
+
+errno_t sss_fast_account_reply_pack(TALLOC_CTX *mem_ctx,
+                                    uint16_t dp_error,
+                                    uint32_t error,
+                                    const char *error_message,
+                                    uint8_t **_body,
+                                    size_t *_body_len)
+{
+    uint8_t *body;
+    size_t len;
+    size_t p = 0;
+
+    len = 2 * sizeof(uint32_t) + sss_fast_string_len(error_message);
+
+    body = talloc_size(mem_ctx, len);
+    if (body == NULL) {
+        return ENOMEM;
+    }
+
+    SAFEALIGN_SET_UINT32(body + p, dp_error, &p);
+    SAFEALIGN_SET_UINT32(body + p, error, &p);
+    sss_fast_set_string(body, error_message, &p);
+
+    *_body = body;
+    *_body_len = len;
+
+    return EOK;
+}
+
+static errno_t sss_fast_account_reply_unpack(TALLOC_CTX *mem_ctx,
+                                             const uint8_t *body,
+                                             size_t body_len,
+                                             uint16_t *_dp_error,
+                                             uint32_t *_error,
+                                             const char **_error_message)
+{
+    const char *error_message;
+    uint32_t dp_error;
+    size_t p = 0;
+    errno_t ret;
+
+    if (body_len < 2 * sizeof(uint32_t)) {
+        return EBADMSG;
+    }
+
+    SAFEALIGN_COPY_UINT32(&dp_error, body + p, &p);
+    SAFEALIGN_COPY_UINT32(_error, body + p, &p);
+
+    ret = sss_fast_get_string(body, body_len, &p, &error_message);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    *_error_message = talloc_strdup(mem_ctx, error_message);
+    if (*_error_message == NULL) {
+        return ENOMEM;
+    }
+
+    *_dp_error = dp_error;
+
+    return EOK;
+}
+
+struct sss_fast_client {
+    struct tevent_context *ev;
+    struct sss_fast_conn *conn;
+    hash_table_t *calls;
+    uint32_t serial;
+};
+
+struct sss_fast_dp_getAccountInfo_state {
+    struct sss_fast_client *client;
+    uint32_t serial;
+    bool pending;
+
+    uint16_t dp_error;
+    uint32_t error;
+    const char *error_message;
+};
+
+static void sss_fast_client_call_remove(struct sss_fast_client *client,
+                                        uint32_t serial)
+{
+    hash_key_t key;
+
+    key.type = HASH_KEY_ULONG;
+    key.ul = serial;
+
+    hash_delete(client->calls, &key);
+}
+
+static void sss_fast_client_frame(struct sss_fast_conn *conn,
+                                  uint32_t serial,
+                                  uint32_t code,
+                                  const uint8_t *body,
+                                  size_t body_len,
+                                  void *data)
+{
+    struct sss_fast_dp_getAccountInfo_state *state;
+    struct sss_fast_client *client;
+    struct tevent_req *req;
+    hash_key_t key;
+    hash_value_t value;
+    errno_t ret;
+    int hret;
+
+    client = talloc_get_type(data, struct sss_fast_client);
+
+    key.type = HASH_KEY_ULONG;
+    key.ul = serial;
+
+    hret = hash_lookup(client->calls, &key, &value);
+    if (hret != HASH_SUCCESS) {
+        /* the caller is not interested anymore */
+        DEBUG(SSSDBG_TRACE_INTERNAL, "No request for serial %"PRIu32"\n",
+              serial);
+        return;
+    }
+
+    req = talloc_get_type(value.ptr, struct tevent_req);
+    state = tevent_req_data(req, struct sss_fast_dp_getAccountInfo_state);
+
+    hash_delete(client->calls, &key);
+    state->pending = false;
+
+    /* Do not run the callbacks while the connection is reading */
+    tevent_req_defer_callback(req, client->ev);
+
+    if (code != EOK) {
+        tevent_req_error(req, code);
+        return;
+    }
+
+    ret = sss_fast_account_reply_unpack(state, body, body_len,
+                                        &state->dp_error, &state->error,
+                                        &state->error_message);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Malformed reply [%d]: %s\n",
+              ret, sss_strerror(ret));
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static void sss_fast_client_close(struct sss_fast_conn *conn,
+                                  errno_t error,
+                                  void *data)
+{
+    struct sss_fast_dp_getAccountInfo_state *state;
+    struct sss_fast_client *client;
+    struct tevent_req *req;
+    hash_value_t *values;
+    unsigned long count;
+    unsigned long i;
+    int hret;
+
+    client = talloc_get_type(data, struct sss_fast_client);
+
+    DEBUG(SSSDBG_MINOR_FAILURE, "Lost connection to the data provider "
+          "[%d]: %s\n", error, sss_strerror(error));
+
+    hret = hash_values(client->calls, &count, &values);
+    if (hret != HASH_SUCCESS) {
+        count = 0;
+        values = NULL;
+    }
+
+    for (i = 0; i < count; i++) {
+        req = talloc_get_type(values[i].ptr, struct tevent_req);
+        state = tevent_req_data(req, struct sss_fast_dp_getAccountInfo_state);
+
+        sss_fast_client_call_remove(client, state->serial);
+        state->pending = false;
+
+        tevent_req_defer_callback(req, client->ev);
+        tevent_req_error(req, ENOTCONN);
+    }
+
+    free(values);
+
+    talloc_zfree(client->conn);
+}
+
+errno_t sss_fast_client_create(TALLOC_CTX *mem_ctx,
+                               struct tevent_context *ev,
+                               int fd,
+                               struct sss_fast_client **_client)
+{
+    struct sss_fast_client *client;
+    errno_t ret;
+
+    client = talloc_zero(mem_ctx, struct sss_fast_client);
+    if (client == NULL) {
+        close(fd);
+        return ENOMEM;
+    }
+
+    client->ev = ev;
+
+    ret = sss_hash_create(client, 0, &client->calls);
+    if (ret != EOK) {
+        close(fd);
+        talloc_free(client);
+        return ret;
+    }
+
+    ret = sss_fast_conn_create(client, ev, fd, sss_fast_client_frame,
+                               sss_fast_client_close, client, &client->conn);
+    if (ret != EOK) {
+        talloc_free(client);
+        return ret;
+    }
+
+    *_client = client;
+    return EOK;
+}
+
+errno_t sss_fast_client_connect(TALLOC_CTX *mem_ctx,
+                                struct tevent_context *ev,
+                                const char *path,
+                                struct sss_fast_client **_client)
+{
+    struct sockaddr_un addr;
+    errno_t ret;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        return EINVAL;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        return errno;
+    }
+
+    /* The socket is local, connect() does not block */
+    ret = connect(fd, (struct sockaddr *) &addr, sizeof(addr));
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to connect to [%s] [%d]: %s\n",
+              path, ret, sss_strerror(ret));
+        close(fd);
+        return ret;
+    }
+
+    return sss_fast_client_create(mem_ctx, ev, fd, _client);
+}
+
+bool sss_fast_client_is_connected(struct sss_fast_client *client)
+{
+    return client != NULL && client->conn != NULL;
+}
+
+static int
+sss_fast_dp_getAccountInfo_destructor(struct sss_fast_dp_getAccountInfo_state *state)
+{
+    if (state->pending) {
+        sss_fast_client_call_remove(state->client, state->serial);
+    }
+
+    return 0;
+}
+
+/* Called also when the request expires, a late reply must not find it. */
+static void
+sss_fast_dp_getAccountInfo_cleanup(struct tevent_req *req,
+                                   enum tevent_req_state req_state)
+{
+    struct sss_fast_dp_getAccountInfo_state *state;
+    state = tevent_req_data(req, struct sss_fast_dp_getAccountInfo_state);
+
+    if (state->pending) {
+        sss_fast_client_call_remove(state->client, state->serial);
+        state->pending = false;
+    }
+}
+
+struct tevent_req *
+sss_fast_dp_getAccountInfo_send(TALLOC_CTX *mem_ctx,
+                                struct sss_fast_client *client,
+                                uint32_t dp_flags,
+                                uint32_t entry_type,
+                                const char *filter,
+                                const char *domain,
+                                const char *extra)
+{
+    struct sss_fast_dp_getAccountInfo_state *state;
+    struct sss_fast_account_req args;
+    struct tevent_req *req;
+    hash_key_t key;
+    hash_value_t value;
+    uint8_t *body;
+    size_t body_len;
+    errno_t ret;
+    int hret;
+
+    req = tevent_req_create(mem_ctx, &state,
+                            struct sss_fast_dp_getAccountInfo_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->client = client;
+
+    if (client->conn == NULL) {
+        ret = ENOTCONN;
+        goto done;
+    }
+
+    args.dp_flags = dp_flags;
+    args.entry_type = entry_type;
+    args.filter = filter;
+    args.domain = domain;
+    args.extra = extra;
+
+    ret = sss_fast_account_req_pack(state, &args, &body, &body_len);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    state->serial = ++client->serial;
+
+    ret = sss_fast_conn_send(client->conn, state->serial,
+                             SSS_FAST_DP_GET_ACCOUNT_INFO, body, body_len);
+    talloc_free(body);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    key.type = HASH_KEY_ULONG;
+    key.ul = state->serial;
+    value.type = HASH_VALUE_PTR;
+    value.ptr = req;
+
+    hret = hash_enter(client->calls, &key, &value);
+    if (hret != HASH_SUCCESS) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    state->pending = true;
+    talloc_set_destructor(state, sss_fast_dp_getAccountInfo_destructor);
+    tevent_req_set_cleanup_fn(req, sss_fast_dp_getAccountInfo_cleanup);
+
+    /* Use the same timeout as the D-Bus calls */
+    if (!tevent_req_set_endtime(req, client->ev,
+                                tevent_timeval_current_ofs(
+                                    SBUS_MESSAGE_TIMEOUT / 1000, 0))) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, client->ev);
+    }
+
+    return req;
+}
+
+errno_t
+sss_fast_dp_getAccountInfo_recv(TALLOC_CTX *mem_ctx,
+                                struct tevent_req *req,
+                                uint16_t *_dp_error,
+                                uint32_t *_error,
+                                const char **_error_message)
+{
+    struct sss_fast_dp_getAccountInfo_state *state;
+    state = tevent_req_data(req, struct sss_fast_dp_getAccountInfo_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_dp_error = state->dp_error;
+    *_error = state->error;
+    *_error_message = talloc_steal(mem_ctx, state->error_message);
+
+    return EOK;
+}
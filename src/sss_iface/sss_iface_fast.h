@@ -0,0 +1,144 @@
+/*
+    SSSD
+
+    Binary IPC between responders and the data provider
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SSS_IFACE_FAST_H_
+#define _SSS_IFACE_FAST_H_
+
+#include "config.h"
+
+#include <stdint.h>
+#include <talloc.h>
+#include <tevent.h>
+
+#include "util/util.h"
+
+/* The data provider listens on this socket if dp_binary_ipc is enabled. */
+#define SSS_BACKEND_FAST_ADDRESS PIPE_PATH "/private/fast-dp_%s"
+
+/* Every frame starts with three 32-bit integers in host byte order: the
+ * length of the body that follows, a serial number chosen by the client
+ * and a code. The code is the method for requests and an errno for
+ * replies. Replies carry the serial of their request, so any number of
+ * requests can be in progress on one connection. */
+#define SSS_FAST_HEADER_LEN (3 * sizeof(uint32_t))
+
+/* Larger frames close the connection */
+#define SSS_FAST_MAX_BODY_LEN (1024 * 1024)
+
+enum sss_fast_method {
+    SSS_FAST_DP_GET_ACCOUNT_INFO = 1,
+};
+
+struct sss_fast_conn;
+
+/* Called for every frame received. The body is only valid during the
+ * call. The callback must not free the connection. */
+typedef void (*sss_fast_frame_fn)(struct sss_fast_conn *conn,
+                                  uint32_t serial,
+                                  uint32_t code,
+                                  const uint8_t *body,
+                                  size_t body_len,
+                                  void *data);
+
+/* Called when the connection was closed by the peer or failed. The file
+ * descriptor is already closed, the callback may free the connection. */
+typedef void (*sss_fast_close_fn)(struct sss_fast_conn *conn,
+                                  errno_t error,
+                                  void *data);
+
+/* Take over the connected socket fd. It is closed when the connection is
+ * freed. */
+errno_t sss_fast_conn_create(TALLOC_CTX *mem_ctx,
+                             struct tevent_context *ev,
+                             int fd,
+                             sss_fast_frame_fn frame_fn,
+                             sss_fast_close_fn close_fn,
+                             void *data,
+                             struct sss_fast_conn **_conn);
+
+/* Queue a frame. All frames queued before the socket becomes writable are
+ * sent with a single system call. */
+errno_t sss_fast_conn_send(struct sss_fast_conn *conn,
+                           uint32_t serial,
+                           uint32_t code,
+                           const uint8_t *body,
+                           size_t body_len);
+
+/* Arguments of sssd.dataprovider.getAccountInfo. Unpacked strings point
+ * into the frame body. */
+struct sss_fast_account_req {
+    uint32_t dp_flags;
+    uint32_t entry_type;
+    const char *filter;
+    const char *domain;
+    const char *extra;
+};
+
+errno_t sss_fast_account_req_pack(TALLOC_CTX *mem_ctx,
+                                  struct sss_fast_account_req *req,
+                                  uint8_t **_body,
+                                  size_t *_body_len);
+
+errno_t sss_fast_account_req_unpack(const uint8_t *body,
+                                    size_t body_len,
+                                    struct sss_fast_account_req *_req);
+
+errno_t sss_fast_account_reply_pack(TALLOC_CTX *mem_ctx,
+                                    uint16_t dp_error,
+                                    uint32_t error,
+                                    const char *error_message,
+                                    uint8_t **_body,
+                                    size_t *_body_len);
+
+/* Client side of the connection */
+struct sss_fast_client;
+
+errno_t sss_fast_client_create(TALLOC_CTX *mem_ctx,
+                               struct tevent_context *ev,
+                               int fd,
+                               struct sss_fast_client **_client);
+
+errno_t sss_fast_client_connect(TALLOC_CTX *mem_ctx,
+                                struct tevent_context *ev,
+                                const char *path,
+                                struct sss_fast_client **_client);
+
+bool sss_fast_client_is_connected(struct sss_fast_client *client);
+
+/* Fails with ENOTCONN if the connection is lost before the reply arrives,
+ * the request can then be sent over D-Bus instead. */
+struct tevent_req *
+sss_fast_dp_getAccountInfo_send(TALLOC_CTX *mem_ctx,
+                                struct sss_fast_client *client,
+                                uint32_t dp_flags,
+                                uint32_t entry_type,
+                                const char *filter,
+                                const char *domain,
+                                const char *extra);
+
+errno_t
+sss_fast_dp_getAccountInfo_recv(TALLOC_CTX *mem_ctx,
+                                struct tevent_req *req,
+                                uint16_t *_dp_error,
+                                uint32_t *_error,
+                                const char **_error_message);
+
+#endif /* _SSS_IFACE_FAST_H_ */
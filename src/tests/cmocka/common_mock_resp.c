@@ -21,6 +21,7 @@
 */
 
 #include "util/util.h"
+#include "util/sss_ptr_hash.h"
 #include "tests/cmocka/common_mock_resp.h"
 
 /* Mock a responder context */
@@ -42,6 +43,12 @@ mock_rctx(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
+    rctx->cache_refreshes = sss_ptr_hash_create(rctx, NULL, NULL);
+    if (rctx->cache_refreshes == NULL) {
+        talloc_free(rctx);
+        return NULL;
+    }
+
     rctx->ev = ev;
     rctx->domains = domains;
     rctx->pvt_ctx = pvt_ctx;
@@ -0,0 +1,356 @@
+/*
+    Copyright (C) 2026 Red Hat
+
+    SSSD tests - Data Provider binary IPC server
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <setjmp.h>
+#include <sys/socket.h>
+#include <cmocka.h>
+#include <popt.h>
+
+#include "tests/common.h"
+
+/* Functions from the tested file are used directly */
+#include "providers/data_provider/dp_fast.c"
+
+#define TEST_DOMAIN "example.com"
+#define TEST_NUM_LOOKUPS 32
+
+struct test_lookup_state {
+    uint32_t entry_type;
+    const char *filter;
+    const char *domain;
+    const char *extra;
+
+    /* Arguments as they were when the lookup started */
+    char *orig_filter;
+    char *orig_domain;
+    char *orig_extra;
+};
+
+struct test_dp_fast_ctx {
+    struct tevent_context *ev;
+    struct data_provider *provider;
+    struct dp_fast_server *server;
+    struct dp_fast_client *dp_client;
+    struct sss_fast_client *client;
+    int client_fd;
+
+    /* Lookups started by the server */
+    struct tevent_req *lookups[TEST_NUM_LOOKUPS];
+    size_t num_lookups;
+
+    /* Calls of the current test */
+    size_t num_sent;
+    size_t num_done;
+    errno_t error;
+};
+
+static struct test_dp_fast_ctx *test_ctx;
+
+struct tevent_req *
+dp_get_account_info_send(TALLOC_CTX *mem_ctx,
+                         struct tevent_context *ev,
+                         struct sbus_request *sbus_req,
+                         struct data_provider *provider,
+                         uint32_t dp_flags,
+                         uint32_t entry_type,
+                         const char *filter,
+                         const char *domain,
+                         const char *extra)
+{
+    struct test_lookup_state *state;
+    struct tevent_req *req;
+
+    req = tevent_req_create(mem_ctx, &state, struct test_lookup_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    assert_true(test_ctx->num_lookups < TEST_NUM_LOOKUPS);
+
+    /* Keep the pointers like the real lookup does */
+    state->entry_type = entry_type;
+    state->filter = filter;
+    state->domain = domain;
+    state->extra = extra;
+
+    state->orig_filter = talloc_strdup(state, filter);
+    state->orig_domain = talloc_strdup(state, domain);
+    state->orig_extra = talloc_strdup(state, extra);
+    assert_non_null(state->orig_filter);
+    assert_non_null(state->orig_domain);
+    assert_non_null(state->orig_extra);
+
+    test_ctx->lookups[test_ctx->num_lookups] = req;
+    test_ctx->num_lookups++;
+
+    /* Finished by the test once all requests were read */
+    return req;
+}
+
+errno_t
+dp_get_account_info_recv(TALLOC_CTX *mem_ctx,
+                         struct tevent_req *req,
+                         uint16_t *_dp_error,
+                         uint32_t *_error,
+                         const char **_err_msg)
+{
+    struct test_lookup_state *state;
+
+    state = tevent_req_data(req, struct test_lookup_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    /* Reply with the entry type as error and the filter as error message,
+     * as the lookup sees them now */
+    *_dp_error = 0;
+    *_error = state->entry_type;
+    *_err_msg = talloc_strdup(mem_ctx, state->filter);
+    if (*_err_msg == NULL) {
+        return ENOMEM;
+    }
+
+    return EOK;
+}
+
+static int test_dp_fast_setup(void **state)
+{
+    struct dp_fast_client *dp_client;
+    int sv[2];
+    errno_t ret;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct test_dp_fast_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->ev = tevent_context_init(test_ctx);
+    assert_non_null(test_ctx->ev);
+
+    test_ctx->provider = talloc_zero(test_ctx, struct data_provider);
+    assert_non_null(test_ctx->provider);
+    test_ctx->provider->ev = test_ctx->ev;
+
+    /* The same as dp_fast_init() and dp_fast_accept() without the
+     * listening socket */
+    test_ctx->server = talloc_zero(test_ctx->provider, struct dp_fast_server);
+    assert_non_null(test_ctx->server);
+    test_ctx->server->provider = test_ctx->provider;
+
+    ret = sss_hash_create(test_ctx->server, 0, &test_ctx->server->calls);
+    assert_int_equal(ret, EOK);
+
+    ret = socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv);
+    assert_int_equal(ret, 0);
+
+    dp_client = talloc_zero(test_ctx->server, struct dp_fast_client);
+    assert_non_null(dp_client);
+    dp_client->server = test_ctx->server;
+
+    ret = sss_fast_conn_create(dp_client, test_ctx->ev, sv[0],
+                               dp_fast_client_frame, dp_fast_client_close,
+                               dp_client, &dp_client->conn);
+    assert_int_equal(ret, EOK);
+    test_ctx->dp_client = dp_client;
+
+    test_ctx->client_fd = sv[1];
+    ret = sss_fast_client_create(test_ctx, test_ctx->ev, sv[1],
+                                 &test_ctx->client);
+    assert_int_equal(ret, EOK);
+
+    *state = test_ctx;
+    return 0;
+}
+
+static int test_dp_fast_teardown(void **state)
+{
+    talloc_zfree(test_ctx);
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+static void test_dp_fast_call_done(struct tevent_req *req)
+{
+    const char *error_message;
+    char *expected;
+    uint16_t dp_error;
+    uint32_t error;
+    errno_t ret;
+
+    ret = sss_fast_dp_getAccountInfo_recv(test_ctx, req, &dp_error, &error,
+                                          &error_message);
+    talloc_free(req);
+    test_ctx->num_done++;
+    if (ret != EOK) {
+        test_ctx->error = ret;
+        return;
+    }
+
+    /* The reply belongs to this request */
+    expected = talloc_asprintf(test_ctx, "name=user%"PRIu32, error);
+    assert_non_null(expected);
+    assert_int_equal(dp_error, 0);
+    assert_string_equal(error_message, expected);
+    talloc_free(expected);
+    talloc_free(discard_const(error_message));
+}
+
+static void test_dp_fast_call_send(uint32_t num)
+{
+    struct tevent_req *req;
+    char *filter;
+
+    filter = talloc_asprintf(test_ctx, "name=user%"PRIu32, num);
+    assert_non_null(filter);
+
+    req = sss_fast_dp_getAccountInfo_send(test_ctx, test_ctx->client, 1,
+                                          num, filter, TEST_DOMAIN,
+                                          "extra");
+    talloc_free(filter);
+    assert_non_null(req);
+
+    tevent_req_set_callback(req, test_dp_fast_call_done, test_ctx);
+    test_ctx->num_sent++;
+}
+
+static void test_dp_fast_wait_lookups(size_t num_requests)
+{
+    while (test_ctx->server->num_requests < num_requests) {
+        assert_int_equal(tevent_loop_once(test_ctx->ev), 0);
+    }
+}
+
+static void test_dp_fast_finish_lookups(void)
+{
+    struct test_lookup_state *state;
+    size_t i;
+
+    for (i = 0; i < test_ctx->num_lookups; i++) {
+        state = tevent_req_data(test_ctx->lookups[i],
+                                struct test_lookup_state);
+
+        /* The arguments did not change while other frames were read */
+        assert_string_equal(state->filter, state->orig_filter);
+        assert_string_equal(state->domain, state->orig_domain);
+        assert_string_equal(state->extra, state->orig_extra);
+
+        tevent_req_done(test_ctx->lookups[i]);
+        test_ctx->lookups[i] = NULL;
+    }
+}
+
+static void test_dp_fast_in_flight(void **state)
+{
+    uint32_t i;
+
+    for (i = 0; i < TEST_NUM_LOOKUPS; i++) {
+        test_dp_fast_call_send(i);
+    }
+
+    /* Identical requests share one lookup */
+    test_dp_fast_call_send(0);
+    test_dp_fast_call_send(TEST_NUM_LOOKUPS - 1);
+
+    test_dp_fast_wait_lookups(TEST_NUM_LOOKUPS + 2);
+    assert_int_equal(test_ctx->num_lookups, TEST_NUM_LOOKUPS);
+    assert_int_equal(test_ctx->server->num_chained, 2);
+
+    test_dp_fast_finish_lookups();
+
+    while (test_ctx->num_done < test_ctx->num_sent) {
+        assert_int_equal(tevent_loop_once(test_ctx->ev), 0);
+    }
+
+    assert_int_equal(test_ctx->error, EOK);
+
+    /* Finished calls are removed from the table */
+    assert_int_equal(hash_count(test_ctx->server->calls), 0);
+}
+
+static void test_dp_fast_client_lost(void **state)
+{
+    struct dp_fast_call *call;
+    uint32_t i;
+    int ret;
+
+    for (i = 0; i < TEST_NUM_LOOKUPS; i++) {
+        test_dp_fast_call_send(i);
+    }
+
+    test_dp_fast_wait_lookups(TEST_NUM_LOOKUPS);
+    assert_int_equal(test_ctx->num_lookups, TEST_NUM_LOOKUPS);
+
+    /* The responder goes away while the lookups are running */
+    ret = shutdown(test_ctx->client_fd, SHUT_RDWR);
+    assert_int_equal(ret, 0);
+
+    call = talloc_get_type_abort(talloc_parent(test_ctx->lookups[0]),
+                                 struct dp_fast_call);
+    while (call->waiters != NULL || test_ctx->num_done < test_ctx->num_sent) {
+        assert_int_equal(tevent_loop_once(test_ctx->ev), 0);
+    }
+
+    assert_int_equal(test_ctx->error, ENOTCONN);
+
+    /* The lookups finish without anybody to reply to */
+    test_dp_fast_finish_lookups();
+    assert_int_equal(hash_count(test_ctx->server->calls), 0);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_dp_fast_in_flight,
+                                        test_dp_fast_setup,
+                                        test_dp_fast_teardown),
+        cmocka_unit_test_setup_teardown(test_dp_fast_client_lost,
+                                        test_dp_fast_setup,
+                                        test_dp_fast_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    tests_set_cwd();
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,473 @@
+/*
+    Copyright (C) 2026 Red Hat
+
+    SSSD tests - sbus request arenas and round trip benchmark
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <talloc.h>
+#include <tevent.h>
+#include <errno.h>
+#include <popt.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "util/util.h"
+#include "sbus/sbus_private.h"
+#include "sss_iface/sss_iface_async.h"
+#include "tests/cmocka/common_mock.h"
+#include "tests/common.h"
+
+#define TEST_BUS_DP "sssd.test.dp"
+#define TEST_BUS_RESP "sssd.test.resp%u"
+
+#define TEST_NUM_CALLS 5000
+#define TEST_MAX_IN_FLIGHT 16
+#define TEST_NUM_RESPONDERS 8
+#define TEST_NUM_ROUNDS 500
+
+struct test_ctx {
+    struct tevent_context *ev;
+    char *dir;
+    char *socket;
+    char *address;
+
+    struct sbus_server *server;
+    struct sbus_connection *dp_conn;
+    struct sbus_connection *resp_conn[TEST_NUM_RESPONDERS];
+
+    size_t num_handled;
+
+    size_t num_sent;
+    size_t num_done;
+    size_t num_total;
+    size_t in_flight;
+    errno_t error;
+    bool done;
+};
+
+static uint64_t test_usec_since(struct timeval *start)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+
+    return (now.tv_sec - start->tv_sec) * 1000000
+           + (now.tv_usec - start->tv_usec);
+}
+
+static void test_wait_req(struct test_ctx *test_ctx, struct tevent_req *req)
+{
+    while (tevent_req_is_in_progress(req)) {
+        assert_int_equal(tevent_loop_once(test_ctx->ev), 0);
+    }
+}
+
+static void test_wait_done(struct test_ctx *test_ctx)
+{
+    while (!test_ctx->done) {
+        assert_int_equal(tevent_loop_once(test_ctx->ev), 0);
+    }
+}
+
+static errno_t
+test_is_online(TALLOC_CTX *mem_ctx,
+               struct sbus_request *sbus_req,
+               struct test_ctx *test_ctx,
+               const char *domain,
+               bool *_is_online)
+{
+    test_ctx->num_handled++;
+
+    *_is_online = strncmp(domain, "online", 6) == 0;
+
+    return EOK;
+}
+
+static errno_t
+test_reset_users(TALLOC_CTX *mem_ctx,
+                 struct sbus_request *sbus_req,
+                 struct test_ctx *test_ctx)
+{
+    test_ctx->num_handled++;
+
+    return EOK;
+}
+
+static int test_setup(void **state)
+{
+    struct test_ctx *test_ctx;
+    struct tevent_req *req;
+    char *name;
+    errno_t ret;
+    unsigned int i;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct test_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->ev = tevent_context_init(test_ctx);
+    assert_non_null(test_ctx->ev);
+
+    test_ctx->dir = talloc_strdup(test_ctx, "/tmp/test_sbus_arena.XXXXXX");
+    assert_non_null(test_ctx->dir);
+    assert_non_null(mkdtemp(test_ctx->dir));
+
+    test_ctx->socket = talloc_asprintf(test_ctx, "%s/sbus", test_ctx->dir);
+    assert_non_null(test_ctx->socket);
+
+    test_ctx->address = talloc_asprintf(test_ctx, "unix:path=%s",
+                                        test_ctx->socket);
+    assert_non_null(test_ctx->address);
+
+    SBUS_INTERFACE(iface_dp_backend,
+        sssd_DataProvider_Backend,
+        SBUS_METHODS(
+            SBUS_SYNC(METHOD, sssd_DataProvider_Backend, IsOnline, test_is_online, test_ctx)
+        ),
+        SBUS_SIGNALS(SBUS_NO_SIGNALS),
+        SBUS_PROPERTIES(SBUS_NO_PROPERTIES)
+    );
+
+    SBUS_INTERFACE(iface_resp_negcache,
+        sssd_Responder_NegativeCache,
+        SBUS_METHODS(
+            SBUS_SYNC(METHOD, sssd_Responder_NegativeCache, ResetUsers, test_reset_users, test_ctx)
+        ),
+        SBUS_SIGNALS(SBUS_NO_SIGNALS),
+        SBUS_PROPERTIES(SBUS_NO_PROPERTIES)
+    );
+
+    req = sbus_server_create_and_connect_send(test_ctx, test_ctx->ev,
+                                              TEST_BUS_DP, NULL,
+                                              test_ctx->address, false, 100,
+                                              geteuid(), getegid());
+    assert_non_null(req);
+    test_wait_req(test_ctx, req);
+
+    ret = sbus_server_create_and_connect_recv(test_ctx, req,
+                                              &test_ctx->server,
+                                              &test_ctx->dp_conn);
+    talloc_free(req);
+    assert_int_equal(ret, EOK);
+
+    ret = sbus_connection_add_path(test_ctx->dp_conn, SSS_BUS_PATH,
+                                   &iface_dp_backend);
+    assert_int_equal(ret, EOK);
+
+    for (i = 0; i < TEST_NUM_RESPONDERS; i++) {
+        name = talloc_asprintf(test_ctx, TEST_BUS_RESP, i);
+        assert_non_null(name);
+
+        req = sbus_connect_private_send(test_ctx, test_ctx->ev,
+                                        test_ctx->address, name, NULL);
+        assert_non_null(req);
+        test_wait_req(test_ctx, req);
+
+        ret = sbus_connect_private_recv(test_ctx, req,
+                                        &test_ctx->resp_conn[i]);
+        talloc_free(req);
+        assert_int_equal(ret, EOK);
+
+        ret = sbus_connection_add_path(test_ctx->resp_conn[i], SSS_BUS_PATH,
+                                       &iface_resp_negcache);
+        assert_int_equal(ret, EOK);
+    }
+
+    *state = test_ctx;
+    return 0;
+}
+
+static int test_teardown(void **state)
+{
+    struct test_ctx *test_ctx;
+    char *dir;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_ctx);
+
+    dir = talloc_strdup(NULL, test_ctx->dir);
+    assert_non_null(dir);
+
+    unlink(test_ctx->socket);
+    talloc_free(test_ctx);
+
+    rmdir(dir);
+    talloc_free(dir);
+
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+static void test_sbus_request_arena_reuse(void **state)
+{
+    struct sbus_request_arena *arena[SBUS_REQUEST_ARENAS_MAX + 1];
+    struct sbus_request_arena *first;
+    struct sbus_connection *conn;
+    char *data;
+    int i;
+
+    assert_true(leak_check_setup());
+
+    conn = talloc_zero(global_talloc_context, struct sbus_connection);
+    assert_non_null(conn);
+
+    conn->arenas = sbus_request_arenas_init(conn);
+    assert_non_null(conn->arenas);
+
+    first = sbus_request_arena_get(conn);
+    assert_non_null(first);
+
+    data = talloc_strdup(first, "data");
+    assert_non_null(data);
+
+    /* Returned arenas are emptied and used again */
+    sbus_request_arena_put(conn, first);
+    assert_int_equal(conn->arenas->num_idle, 1);
+    assert_int_equal(talloc_total_blocks(first), 1);
+
+    arena[0] = sbus_request_arena_get(conn);
+    assert_ptr_equal(arena[0], first);
+    assert_int_equal(conn->arenas->stats.created, 1);
+    assert_int_equal(conn->arenas->stats.reused, 1);
+
+    /* Only a limited number of idle arenas is kept */
+    for (i = 1; i < SBUS_REQUEST_ARENAS_MAX + 1; i++) {
+        arena[i] = sbus_request_arena_get(conn);
+        assert_non_null(arena[i]);
+    }
+
+    for (i = 0; i < SBUS_REQUEST_ARENAS_MAX + 1; i++) {
+        sbus_request_arena_put(conn, arena[i]);
+    }
+    assert_int_equal(conn->arenas->num_idle, SBUS_REQUEST_ARENAS_MAX);
+
+    /* Nothing is kept once the connection is going away */
+    arena[0] = sbus_request_arena_get(conn);
+    conn->disconnecting = true;
+    sbus_request_arena_put(conn, arena[0]);
+    assert_int_equal(conn->arenas->num_idle, SBUS_REQUEST_ARENAS_MAX - 1);
+
+    talloc_free(conn);
+    assert_true(leak_check_teardown());
+}
+
+static void test_roundtrip_done(struct tevent_req *req);
+
+static void test_roundtrip_send(struct test_ctx *test_ctx)
+{
+    struct tevent_req *req;
+    char *domain;
+
+    domain = talloc_asprintf(test_ctx, "%s%zu",
+                             test_ctx->num_sent % 2 ? "online" : "offline",
+                             test_ctx->num_sent);
+    assert_non_null(domain);
+
+    /* Every domain name is different so no request is chained */
+    req = sbus_call_dp_backend_IsOnline_send(test_ctx, test_ctx->resp_conn[0],
+                                             TEST_BUS_DP, SSS_BUS_PATH,
+                                             domain);
+    assert_non_null(req);
+    talloc_steal(req, domain);
+
+    tevent_req_set_callback(req, test_roundtrip_done, test_ctx);
+    test_ctx->num_sent++;
+    test_ctx->in_flight++;
+}
+
+static void test_roundtrip_done(struct tevent_req *req)
+{
+    struct test_ctx *test_ctx;
+    bool is_online;
+    errno_t ret;
+
+    test_ctx = tevent_req_callback_data(req, struct test_ctx);
+    test_ctx->in_flight--;
+
+    ret = sbus_call_dp_backend_IsOnline_recv(req, &is_online);
+    talloc_free(req);
+    if (ret != EOK) {
+        test_ctx->error = ret;
+        test_ctx->done = true;
+        return;
+    }
+
+    test_ctx->num_done++;
+    if (test_ctx->num_done == test_ctx->num_total) {
+        test_ctx->done = true;
+        return;
+    }
+
+    while (test_ctx->num_sent < test_ctx->num_total
+            && test_ctx->in_flight < TEST_MAX_IN_FLIGHT) {
+        test_roundtrip_send(test_ctx);
+    }
+}
+
+/* Run with -d 0x0400 to see the results */
+static void test_sbus_bench_roundtrip(void **state)
+{
+    struct test_ctx *test_ctx;
+    struct sbus_request_arenas *arenas;
+    struct timeval start;
+    uint64_t usec;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_ctx);
+    arenas = test_ctx->dp_conn->arenas;
+
+    test_ctx->num_total = TEST_NUM_CALLS;
+
+    gettimeofday(&start, NULL);
+    while (test_ctx->num_sent < test_ctx->num_total
+            && test_ctx->in_flight < TEST_MAX_IN_FLIGHT) {
+        test_roundtrip_send(test_ctx);
+    }
+    test_wait_done(test_ctx);
+    usec = test_usec_since(&start);
+
+    assert_int_equal(test_ctx->error, EOK);
+    assert_int_equal(test_ctx->num_done, TEST_NUM_CALLS);
+    assert_int_equal(test_ctx->num_handled, TEST_NUM_CALLS);
+
+    /* The requests were decoded in reused arenas */
+    assert_true(arenas->stats.reused > arenas->stats.created);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "%d round trips with up to %d in flight took "
+          "%"PRIu64" us, %"PRIu64" calls/s, arenas created %"PRIu64
+          " reused %"PRIu64"\n", TEST_NUM_CALLS, TEST_MAX_IN_FLIGHT, usec,
+          usec == 0 ? 0 : TEST_NUM_CALLS * UINT64_C(1000000) / usec,
+          arenas->stats.created, arenas->stats.reused);
+}
+
+static void test_fanout_done(struct tevent_req *req)
+{
+    struct test_ctx *test_ctx;
+    errno_t ret;
+
+    test_ctx = tevent_req_callback_data(req, struct test_ctx);
+    test_ctx->in_flight--;
+
+    ret = sbus_call_resp_negcache_ResetUsers_recv(req);
+    talloc_free(req);
+    if (ret != EOK && test_ctx->error == EOK) {
+        test_ctx->error = ret;
+    }
+
+    test_ctx->num_done++;
+    if (test_ctx->in_flight == 0) {
+        test_ctx->done = true;
+    }
+}
+
+/* The data provider notifies all responders, e.g. to reset the negative
+ * cache, with one call per responder. Run with -d 0x0400 to see the
+ * results. */
+static void test_sbus_bench_fanout(void **state)
+{
+    struct test_ctx *test_ctx;
+    struct tevent_req *req;
+    struct timeval start;
+    uint64_t created = 0;
+    uint64_t reused = 0;
+    uint64_t usec;
+    char *bus;
+    int round;
+    unsigned int i;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_ctx);
+
+    gettimeofday(&start, NULL);
+    for (round = 0; round < TEST_NUM_ROUNDS; round++) {
+        test_ctx->done = false;
+
+        for (i = 0; i < TEST_NUM_RESPONDERS; i++) {
+            bus = talloc_asprintf(test_ctx, TEST_BUS_RESP, i);
+            assert_non_null(bus);
+
+            req = sbus_call_resp_negcache_ResetUsers_send(test_ctx,
+                      test_ctx->dp_conn, bus, SSS_BUS_PATH);
+            assert_non_null(req);
+            talloc_steal(req, bus);
+
+            tevent_req_set_callback(req, test_fanout_done, test_ctx);
+            test_ctx->in_flight++;
+        }
+
+        test_wait_done(test_ctx);
+        assert_int_equal(test_ctx->error, EOK);
+    }
+    usec = test_usec_since(&start);
+
+    assert_int_equal(test_ctx->num_done,
+                     TEST_NUM_ROUNDS * TEST_NUM_RESPONDERS);
+    assert_int_equal(test_ctx->num_handled,
+                     TEST_NUM_ROUNDS * TEST_NUM_RESPONDERS);
+
+    for (i = 0; i < TEST_NUM_RESPONDERS; i++) {
+        created += test_ctx->resp_conn[i]->arenas->stats.created;
+        reused += test_ctx->resp_conn[i]->arenas->stats.reused;
+    }
+
+    /* Each responder needs a single arena for sequential notifications */
+    assert_true(reused > created);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "%d rounds of notifications to %d responders "
+          "took %"PRIu64" us, %"PRIu64" calls/s, arenas created %"PRIu64
+          " reused %"PRIu64"\n", TEST_NUM_ROUNDS, TEST_NUM_RESPONDERS, usec,
+          usec == 0 ? 0 : TEST_NUM_ROUNDS * TEST_NUM_RESPONDERS
+                          * UINT64_C(1000000) / usec,
+          created, reused);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sbus_request_arena_reuse),
+        cmocka_unit_test_setup_teardown(test_sbus_bench_roundtrip,
+                                        test_setup, test_teardown),
+        cmocka_unit_test_setup_teardown(test_sbus_bench_fanout,
+                                        test_setup, test_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
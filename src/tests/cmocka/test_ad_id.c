@@ -0,0 +1,500 @@
+/*
+    SSSD
+
+    AD ID provider - concurrent Global Catalog and LDAP lookups
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <tevent.h>
+#include <errno.h>
+#include <popt.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "providers/ad/ad_common.h"
+
+/* Include source file to test the static functions */
+#include "providers/ad/ad_id.c"
+#include "providers/ad/ad_opts.c"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB "test_ad_id_conf.ldb"
+#define TEST_DOM_NAME "ad_id_test"
+#define TEST_ID_PROVIDER "ad"
+
+#define TEST_USER "user1@" TEST_DOM_NAME
+
+enum test_conn {
+    TEST_CONN_GC,
+    TEST_CONN_LDAP,
+    TEST_CONN_NUM
+};
+
+/* Result of a lookup on one connection */
+struct fake_lookup {
+    struct sdap_id_conn_ctx *conn;
+    errno_t ret;
+    int dp_error;
+    int sdap_err;
+    int delay_ms;
+
+    bool started;
+    bool finished;
+    bool cancelled;
+};
+
+struct ad_id_test_ctx {
+    struct sss_test_ctx *tctx;
+    struct sdap_id_ctx *id_ctx;
+    struct ad_options *ad_options;
+    struct sdap_domain *sdom;
+    struct sdap_id_conn_ctx **conn;
+    struct dp_id_data *ar;
+
+    struct fake_lookup lookups[TEST_CONN_NUM];
+    int dp_error;
+};
+
+static struct ad_id_test_ctx *ad_id_test_ctx;
+
+bool __wrap_sdap_idmap_domain_has_algorithmic_mapping(struct sdap_idmap_ctx *ctx,
+                                                      const char *name,
+                                                      const char *dom_sid)
+{
+    return false;
+}
+
+struct fake_acct_req_state {
+    struct fake_lookup *lookup;
+};
+
+static int fake_acct_req_state_destructor(struct fake_acct_req_state *state)
+{
+    if (!state->lookup->finished) {
+        state->lookup->cancelled = true;
+    }
+
+    return 0;
+}
+
+static void fake_acct_req_finish(struct tevent_context *ev,
+                                 struct tevent_timer *te,
+                                 struct timeval tv,
+                                 void *pvt)
+{
+    struct fake_acct_req_state *state;
+    struct tevent_req *req;
+
+    req = talloc_get_type(pvt, struct tevent_req);
+    state = tevent_req_data(req, struct fake_acct_req_state);
+
+    state->lookup->finished = true;
+    tevent_req_done(req);
+}
+
+struct tevent_req *
+__wrap_sdap_handle_acct_req_send(TALLOC_CTX *mem_ctx,
+                                 struct be_ctx *be_ctx,
+                                 struct dp_id_data *ar,
+                                 struct sdap_id_ctx *id_ctx,
+                                 struct sdap_domain *sdom,
+                                 struct sdap_id_conn_ctx *conn,
+                                 bool noexist_delete)
+{
+    struct fake_acct_req_state *state;
+    struct tevent_timer *te;
+    struct tevent_req *req;
+    int i;
+
+    /* Another lookup may still find the object. */
+    assert_false(noexist_delete);
+
+    req = tevent_req_create(mem_ctx, &state, struct fake_acct_req_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < TEST_CONN_NUM; i++) {
+        if (ad_id_test_ctx->lookups[i].conn == conn) {
+            state->lookup = &ad_id_test_ctx->lookups[i];
+        }
+    }
+    assert_non_null(state->lookup);
+    assert_false(state->lookup->started);
+
+    state->lookup->started = true;
+    talloc_set_destructor(state, fake_acct_req_state_destructor);
+
+    te = tevent_add_timer(be_ctx->ev, req,
+                          tevent_timeval_current_ofs(0,
+                                            state->lookup->delay_ms * 1000),
+                          fake_acct_req_finish, req);
+    if (te == NULL) {
+        talloc_free(req);
+        return NULL;
+    }
+
+    return req;
+}
+
+int __wrap_sdap_handle_acct_req_recv(struct tevent_req *req,
+                                     int *_dp_error, const char **_err,
+                                     int *sdap_ret)
+{
+    struct fake_acct_req_state *state;
+
+    state = tevent_req_data(req, struct fake_acct_req_state);
+
+    *_dp_error = state->lookup->dp_error;
+    *_err = state->lookup->ret == EOK ? "Success" : "Failure";
+    *sdap_ret = state->lookup->sdap_err;
+
+    return state->lookup->ret;
+}
+
+static void set_lookup(struct ad_id_test_ctx *test_ctx,
+                       enum test_conn conn,
+                       errno_t ret,
+                       int dp_error,
+                       int sdap_err,
+                       int delay_ms)
+{
+    test_ctx->lookups[conn].ret = ret;
+    test_ctx->lookups[conn].dp_error = dp_error;
+    test_ctx->lookups[conn].sdap_err = sdap_err;
+    test_ctx->lookups[conn].delay_ms = delay_ms;
+}
+
+static int test_ad_id_setup(void **state)
+{
+    struct ad_id_test_ctx *test_ctx;
+    errno_t ret;
+    int i;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct ad_id_test_ctx);
+    assert_non_null(test_ctx);
+
+    test_dom_suite_setup(TESTS_PATH);
+
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, TEST_ID_PROVIDER,
+                                         NULL);
+    assert_non_null(test_ctx->tctx);
+
+    ret = sysdb_add_user(test_ctx->tctx->dom, TEST_USER, 10001, 10001,
+                         "User One", "/home/user1", "/bin/sh", NULL, NULL,
+                         0, 0);
+    assert_int_equal(ret, EOK);
+
+    test_ctx->id_ctx = talloc_zero(test_ctx, struct sdap_id_ctx);
+    assert_non_null(test_ctx->id_ctx);
+
+    test_ctx->id_ctx->be = talloc_zero(test_ctx->id_ctx, struct be_ctx);
+    assert_non_null(test_ctx->id_ctx->be);
+    test_ctx->id_ctx->be->ev = test_ctx->tctx->ev;
+    test_ctx->id_ctx->be->domain = test_ctx->tctx->dom;
+
+    test_ctx->id_ctx->opts = talloc_zero(test_ctx->id_ctx,
+                                         struct sdap_options);
+    assert_non_null(test_ctx->id_ctx->opts);
+
+    test_ctx->ad_options = talloc_zero(test_ctx, struct ad_options);
+    assert_non_null(test_ctx->ad_options);
+
+    ret = dp_copy_defaults(test_ctx->ad_options, ad_basic_opts, AD_OPTS_BASIC,
+                           &test_ctx->ad_options->basic);
+    assert_int_equal(ret, EOK);
+
+    ret = dp_opt_set_bool(test_ctx->ad_options->basic,
+                          AD_CONCURRENT_GC_LOOKUP, true);
+    assert_int_equal(ret, EOK);
+
+    test_ctx->sdom = talloc_zero(test_ctx, struct sdap_domain);
+    assert_non_null(test_ctx->sdom);
+    test_ctx->sdom->dom = test_ctx->tctx->dom;
+
+    test_ctx->conn = talloc_zero_array(test_ctx, struct sdap_id_conn_ctx *,
+                                       TEST_CONN_NUM + 1);
+    assert_non_null(test_ctx->conn);
+
+    for (i = 0; i < TEST_CONN_NUM; i++) {
+        test_ctx->conn[i] = talloc_zero(test_ctx->conn,
+                                        struct sdap_id_conn_ctx);
+        assert_non_null(test_ctx->conn[i]);
+        test_ctx->lookups[i].conn = test_ctx->conn[i];
+    }
+
+    /* As in ad_gc_conn_list() */
+    test_ctx->conn[TEST_CONN_GC]->ignore_mark_offline = true;
+
+    test_ctx->ar = talloc_zero(test_ctx, struct dp_id_data);
+    assert_non_null(test_ctx->ar);
+    test_ctx->ar->entry_type = BE_REQ_USER;
+    test_ctx->ar->filter_type = BE_FILTER_NAME;
+    test_ctx->ar->filter_value = TEST_USER;
+
+    ad_id_test_ctx = test_ctx;
+    *state = test_ctx;
+
+    return 0;
+}
+
+static int test_ad_id_teardown(void **state)
+{
+    struct ad_id_test_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(*state, struct ad_id_test_ctx);
+
+    ad_id_test_ctx = NULL;
+    talloc_free(test_ctx);
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    assert_true(leak_check_teardown());
+
+    return 0;
+}
+
+static void test_ad_id_done(struct tevent_req *req)
+{
+    struct ad_id_test_ctx *test_ctx;
+    errno_t ret;
+
+    test_ctx = tevent_req_callback_data(req, struct ad_id_test_ctx);
+
+    ret = ad_handle_acct_info_recv(req, &test_ctx->dp_error, NULL);
+    talloc_zfree(req);
+
+    test_ev_done(test_ctx->tctx, ret);
+}
+
+static errno_t run_acct_info(struct ad_id_test_ctx *test_ctx)
+{
+    struct tevent_req *req;
+
+    req = ad_handle_acct_info_send(test_ctx, test_ctx->ar, test_ctx->id_ctx,
+                                   test_ctx->ad_options, test_ctx->sdom,
+                                   test_ctx->conn);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_ad_id_done, test_ctx);
+
+    return test_ev_loop(test_ctx->tctx);
+}
+
+static bool user_is_cached(struct ad_id_test_ctx *test_ctx)
+{
+    struct ldb_message *msg;
+    errno_t ret;
+
+    ret = sysdb_search_user_by_name(test_ctx, test_ctx->tctx->dom, TEST_USER,
+                                    NULL, &msg);
+    if (ret == ENOENT) {
+        return false;
+    }
+    assert_int_equal(ret, EOK);
+    talloc_free(msg);
+
+    return true;
+}
+
+void test_concurrent_first_hit_cancels(void **state)
+{
+    struct ad_id_test_ctx *test_ctx;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ad_id_test_ctx);
+
+    set_lookup(test_ctx, TEST_CONN_GC, EOK, DP_ERR_OK, EOK, 1);
+    set_lookup(test_ctx, TEST_CONN_LDAP, EOK, DP_ERR_OK, ENOENT, 500);
+
+    ret = run_acct_info(test_ctx);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(test_ctx->dp_error, DP_ERR_OK);
+
+    assert_true(test_ctx->lookups[TEST_CONN_GC].started);
+    assert_true(test_ctx->lookups[TEST_CONN_LDAP].started);
+    assert_true(test_ctx->lookups[TEST_CONN_GC].finished);
+    assert_true(test_ctx->lookups[TEST_CONN_LDAP].cancelled);
+
+    assert_true(user_is_cached(test_ctx));
+}
+
+void test_concurrent_miss_before_hit(void **state)
+{
+    struct ad_id_test_ctx *test_ctx;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ad_id_test_ctx);
+
+    /* The last connection misses first, it must not remove the object
+     * which the Global Catalog finds later. */
+    set_lookup(test_ctx, TEST_CONN_GC, EOK, DP_ERR_OK, EOK, 20);
+    set_lookup(test_ctx, TEST_CONN_LDAP, EOK, DP_ERR_OK, ENOENT, 1);
+
+    ret = run_acct_info(test_ctx);
+    assert_int_equal(ret, EOK);
+
+    assert_true(test_ctx->lookups[TEST_CONN_GC].finished);
+    assert_true(test_ctx->lookups[TEST_CONN_LDAP].finished);
+    assert_true(user_is_cached(test_ctx));
+}
+
+void test_concurrent_all_miss(void **state)
+{
+    struct ad_id_test_ctx *test_ctx;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ad_id_test_ctx);
+
+    set_lookup(test_ctx, TEST_CONN_GC, EOK, DP_ERR_OK, ENOENT, 10);
+    set_lookup(test_ctx, TEST_CONN_LDAP, EOK, DP_ERR_OK, ENOENT, 1);
+
+    ret = run_acct_info(test_ctx);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(test_ctx->dp_error, DP_ERR_OK);
+
+    assert_false(user_is_cached(test_ctx));
+}
+
+void test_concurrent_offline_gc_is_miss(void **state)
+{
+    struct ad_id_test_ctx *test_ctx;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ad_id_test_ctx);
+
+    set_lookup(test_ctx, TEST_CONN_GC, ERR_OFFLINE, DP_ERR_OFFLINE, EOK, 1);
+    set_lookup(test_ctx, TEST_CONN_LDAP, EOK, DP_ERR_OK, ENOENT, 10);
+
+    ret = run_acct_info(test_ctx);
+    assert_int_equal(ret, EOK);
+
+    assert_false(user_is_cached(test_ctx));
+}
+
+void test_concurrent_offline_gc_hit_on_ldap(void **state)
+{
+    struct ad_id_test_ctx *test_ctx;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ad_id_test_ctx);
+
+    set_lookup(test_ctx, TEST_CONN_GC, ERR_OFFLINE, DP_ERR_OFFLINE, EOK, 1);
+    set_lookup(test_ctx, TEST_CONN_LDAP, EOK, DP_ERR_OK, EOK, 10);
+
+    ret = run_acct_info(test_ctx);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(test_ctx->dp_error, DP_ERR_OK);
+
+    assert_true(user_is_cached(test_ctx));
+}
+
+void test_concurrent_error_order(void **state)
+{
+    struct ad_id_test_ctx *test_ctx;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ad_id_test_ctx);
+
+    /* The error of the first connection is reported even if it arrives
+     * last, as with lookups done one after another. */
+    set_lookup(test_ctx, TEST_CONN_GC, EIO, DP_ERR_FATAL, EOK, 20);
+    set_lookup(test_ctx, TEST_CONN_LDAP, ETIMEDOUT, DP_ERR_OFFLINE, EOK, 1);
+
+    ret = run_acct_info(test_ctx);
+    assert_int_equal(ret, EIO);
+    assert_int_equal(test_ctx->dp_error, DP_ERR_FATAL);
+
+    assert_true(user_is_cached(test_ctx));
+}
+
+void test_concurrent_error_and_miss(void **state)
+{
+    struct ad_id_test_ctx *test_ctx;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ad_id_test_ctx);
+
+    /* A failed lookup might have found the object, do not remove it. */
+    set_lookup(test_ctx, TEST_CONN_GC, EOK, DP_ERR_OK, ENOENT, 1);
+    set_lookup(test_ctx, TEST_CONN_LDAP, ETIMEDOUT, DP_ERR_OFFLINE, EOK, 10);
+
+    ret = run_acct_info(test_ctx);
+    assert_int_equal(ret, ETIMEDOUT);
+    assert_int_equal(test_ctx->dp_error, DP_ERR_OFFLINE);
+
+    assert_true(user_is_cached(test_ctx));
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_concurrent_first_hit_cancels,
+                                        test_ad_id_setup,
+                                        test_ad_id_teardown),
+        cmocka_unit_test_setup_teardown(test_concurrent_miss_before_hit,
+                                        test_ad_id_setup,
+                                        test_ad_id_teardown),
+        cmocka_unit_test_setup_teardown(test_concurrent_all_miss,
+                                        test_ad_id_setup,
+                                        test_ad_id_teardown),
+        cmocka_unit_test_setup_teardown(test_concurrent_offline_gc_is_miss,
+                                        test_ad_id_setup,
+                                        test_ad_id_teardown),
+        cmocka_unit_test_setup_teardown(test_concurrent_offline_gc_hit_on_ldap,
+                                        test_ad_id_setup,
+                                        test_ad_id_teardown),
+        cmocka_unit_test_setup_teardown(test_concurrent_error_order,
+                                        test_ad_id_setup,
+                                        test_ad_id_teardown),
+        cmocka_unit_test_setup_teardown(test_concurrent_error_and_miss,
+                                        test_ad_id_setup,
+                                        test_ad_id_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    /* Even though normally the tests should clean up after themselves
+     * they might not after a failed run. Remove the old DB to be sure */
+    tests_set_cwd();
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
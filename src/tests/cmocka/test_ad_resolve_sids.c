@@ -0,0 +1,771 @@
+/*
+    SSSD
+
+    AD initgroups - resolving group SIDs in batches
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <tevent.h>
+#include <errno.h>
+#include <popt.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "tests/cmocka/common_mock_sdap.h"
+
+/* Include source file to test the static functions */
+#include "providers/ldap/sdap_async_initgroups_ad.c"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB "test_ad_resolve_sids_conf.ldb"
+#define TEST_ID_PROVIDER "ad"
+
+#define TEST_DOM1_NAME "dom1.test"
+#define TEST_DOM2_NAME "dom2.test"
+#define TEST_DOM3_NAME "dom3.test"
+
+#define TEST_DOM1_SID "S-1-5-21-1111-1111-1111"
+#define TEST_DOM2_SID "S-1-5-21-2222-2222-2222"
+#define TEST_DOM3_SID "S-1-5-21-3333-3333-3333"
+
+#define TEST_MAX_SIDS 1000
+
+const char *domains[] = { TEST_DOM1_NAME,
+                          TEST_DOM2_NAME,
+                          TEST_DOM3_NAME,
+                          NULL };
+
+const char *domain_sids[] = { TEST_DOM1_SID,
+                              TEST_DOM2_SID,
+                              TEST_DOM3_SID,
+                              NULL };
+
+/* One batched search, in the order the searches are issued */
+struct test_search {
+    struct sdap_domain *sdom;
+    size_t num_sids;
+    /* indexes of the SIDs in the order they appear in the filter */
+    size_t *sids;
+};
+
+/* One group looked up by groups_get_send() */
+struct test_lookup {
+    struct sdap_domain *sdom;
+    const char *sid;
+};
+
+struct test_ctx {
+    struct sss_test_ctx *tctx;
+    struct sdap_options *opts;
+    struct sdap_id_ctx *id_ctx;
+    struct sdap_id_conn_ctx *conn;
+
+    char **sids;
+    size_t num_sids;
+    /* SIDs that do not exist on the server */
+    bool missing[TEST_MAX_SIDS];
+
+    struct test_search *searches;
+    size_t num_searches;
+    struct test_lookup *lookups;
+    size_t num_lookups;
+
+    /* index of the connect or search that fails, -1 for none */
+    ssize_t fail_connect_send;
+    ssize_t fail_connect;
+    ssize_t fail_search;
+    size_t num_connects;
+    /* result of groups_get_recv() */
+    errno_t lookup_ret;
+    int lookup_sdap_ret;
+
+    size_t active;
+    size_t max_active;
+};
+
+static struct test_ctx *test_ctx;
+
+struct test_req_state {
+    errno_t ret;
+};
+
+static void test_req_finish(struct tevent_context *ev,
+                            struct tevent_timer *te,
+                            struct timeval tv,
+                            void *pvt)
+{
+    struct tevent_req *req = talloc_get_type(pvt, struct tevent_req);
+    struct test_req_state *state;
+
+    state = tevent_req_data(req, struct test_req_state);
+    if (state->ret != EOK) {
+        tevent_req_error(req, state->ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+/* Finish later so that the searches run at the same time */
+static struct tevent_req *test_req_send(TALLOC_CTX *mem_ctx,
+                                        struct tevent_context *ev,
+                                        errno_t ret)
+{
+    struct test_req_state *state;
+    struct tevent_req *req;
+    struct tevent_timer *te;
+
+    req = tevent_req_create(mem_ctx, &state, struct test_req_state);
+    assert_non_null(req);
+    state->ret = ret;
+
+    te = tevent_add_timer(ev, req, tevent_timeval_current_ofs(0, 1000),
+                          test_req_finish, req);
+    assert_non_null(te);
+
+    return req;
+}
+
+struct sdap_id_op *__wrap_sdap_id_op_create(TALLOC_CTX *memctx,
+                                            struct sdap_id_conn_cache *cache)
+{
+    return talloc_named_const(memctx, 1, "struct sdap_id_op");
+}
+
+struct tevent_req *__wrap_sdap_id_op_connect_send(struct sdap_id_op *op,
+                                                  TALLOC_CTX *memctx,
+                                                  int *ret_out)
+{
+    size_t idx;
+
+    idx = test_ctx->num_connects++;
+    if ((ssize_t) idx == test_ctx->fail_connect_send) {
+        *ret_out = ENOMEM;
+        return NULL;
+    }
+
+    test_ctx->active++;
+    test_ctx->max_active = MAX(test_ctx->max_active, test_ctx->active);
+
+    if ((ssize_t) idx == test_ctx->fail_connect) {
+        test_ctx->active--;
+        return test_req_send(memctx, test_ctx->tctx->ev, ERR_NETWORK_IO);
+    }
+
+    return test_req_send(memctx, test_ctx->tctx->ev, EOK);
+}
+
+int __wrap_sdap_id_op_connect_recv(struct tevent_req *req, int *dp_error)
+{
+    *dp_error = DP_ERR_OFFLINE;
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *dp_error = DP_ERR_OK;
+    return EOK;
+}
+
+struct sdap_handle *__wrap_sdap_id_op_handle(struct sdap_id_op *op)
+{
+    return NULL;
+}
+
+int __wrap_sdap_id_op_done(struct sdap_id_op *op, int ret, int *dp_error)
+{
+    /* failed searches are not retried */
+    *dp_error = ret == EOK ? DP_ERR_OK : DP_ERR_FATAL;
+    return ret;
+}
+
+static bool filter_has_sid(const char *filter, const char *sid)
+{
+    char *needle;
+    bool found;
+
+    needle = talloc_asprintf(NULL, "=%s)", sid);
+    assert_non_null(needle);
+    found = strstr(filter, needle) != NULL;
+    talloc_free(needle);
+
+    return found;
+}
+
+static void store_group(struct sss_domain_info *dom, size_t idx)
+{
+    struct sysdb_attrs *attrs;
+    char *name;
+    errno_t ret;
+
+    attrs = sysdb_new_attrs(NULL);
+    assert_non_null(attrs);
+
+    ret = sysdb_attrs_add_string(attrs, SYSDB_SID_STR, test_ctx->sids[idx]);
+    assert_int_equal(ret, EOK);
+
+    name = talloc_asprintf(attrs, "group%zu@%s", idx, dom->name);
+    assert_non_null(name);
+
+    ret = sysdb_store_group(dom, name, 20000 + idx, attrs, 300, 0);
+    assert_int_equal(ret, EOK);
+
+    talloc_free(attrs);
+}
+
+struct tevent_req *
+__wrap_sdap_get_groups_send(TALLOC_CTX *memctx,
+                            struct tevent_context *ev,
+                            struct sdap_domain *sdom,
+                            struct sdap_options *opts,
+                            struct sdap_handle *sh,
+                            const char **attrs,
+                            const char *filter,
+                            int timeout,
+                            enum sdap_entry_lookup_type lookup_type,
+                            bool no_members)
+{
+    struct test_search *search;
+    size_t idx;
+    size_t i;
+
+    idx = test_ctx->num_searches;
+    test_ctx->searches = talloc_realloc(test_ctx, test_ctx->searches,
+                                        struct test_search, idx + 1);
+    assert_non_null(test_ctx->searches);
+    test_ctx->num_searches++;
+
+    search = &test_ctx->searches[idx];
+    search->sdom = sdom;
+    search->num_sids = 0;
+    search->sids = talloc_zero_array(test_ctx->searches, size_t,
+                                     test_ctx->num_sids);
+    assert_non_null(search->sids);
+
+    assert_true(no_members);
+
+    for (i = 0; i < test_ctx->num_sids; i++) {
+        if (!filter_has_sid(filter, test_ctx->sids[i])) {
+            continue;
+        }
+
+        search->sids[search->num_sids] = i;
+        search->num_sids++;
+
+        /* the search saves the groups it finds to the cache */
+        if ((ssize_t) idx != test_ctx->fail_search
+                && !test_ctx->missing[i]) {
+            store_group(sdom->dom, i);
+        }
+    }
+
+    if ((ssize_t) idx == test_ctx->fail_search) {
+        return test_req_send(memctx, ev, EIO);
+    }
+
+    return test_req_send(memctx, ev, EOK);
+}
+
+int __wrap_sdap_get_groups_recv(struct tevent_req *req,
+                                TALLOC_CTX *mem_ctx, char **timestamp)
+{
+    test_ctx->active--;
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
+struct tevent_req *__wrap_groups_get_send(TALLOC_CTX *memctx,
+                                          struct tevent_context *ev,
+                                          struct sdap_id_ctx *ctx,
+                                          struct sdap_domain *sdom,
+                                          struct sdap_id_conn_ctx *conn,
+                                          const char *name,
+                                          int filter_type,
+                                          bool noexist_delete,
+                                          bool no_members)
+{
+    struct test_lookup *lookup;
+    size_t idx;
+
+    /* all batched searches are done */
+    assert_int_equal(test_ctx->active, 0);
+    assert_int_equal(filter_type, BE_FILTER_SECID);
+
+    idx = test_ctx->num_lookups;
+    test_ctx->lookups = talloc_realloc(test_ctx, test_ctx->lookups,
+                                       struct test_lookup, idx + 1);
+    assert_non_null(test_ctx->lookups);
+    test_ctx->num_lookups++;
+
+    lookup = &test_ctx->lookups[idx];
+    lookup->sdom = sdom;
+    lookup->sid = talloc_strdup(test_ctx->lookups, name);
+    assert_non_null(lookup->sid);
+
+    return test_req_send(memctx, ev, EOK);
+}
+
+int __wrap_groups_get_recv(struct tevent_req *req,
+                           int *dp_error_out,
+                           int *sdap_ret)
+{
+    *dp_error_out = DP_ERR_OK;
+    *sdap_ret = test_ctx->lookup_sdap_ret;
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return test_ctx->lookup_ret;
+}
+
+static struct sss_domain_info *get_dom(size_t dom_idx)
+{
+    return find_domain_by_name(test_ctx->tctx->dom, domains[dom_idx], false);
+}
+
+static struct sdap_domain *get_sdom(size_t dom_idx)
+{
+    struct sdap_domain *sdom;
+
+    sdom = sdap_domain_get(test_ctx->opts, get_dom(dom_idx));
+    assert_non_null(sdom);
+
+    return sdom;
+}
+
+/* Add num_sids SIDs of the domain to the list of SIDs to resolve */
+static void add_sids(size_t dom_idx, size_t num_sids)
+{
+    size_t i;
+
+    assert_true(test_ctx->num_sids + num_sids < TEST_MAX_SIDS);
+
+    test_ctx->sids = talloc_realloc(test_ctx, test_ctx->sids, char *,
+                                    test_ctx->num_sids + num_sids + 1);
+    assert_non_null(test_ctx->sids);
+
+    for (i = 0; i < num_sids; i++) {
+        test_ctx->sids[test_ctx->num_sids] = talloc_asprintf(test_ctx->sids,
+                                                    "%s-%zu",
+                                                    domain_sids[dom_idx],
+                                                    1000 + test_ctx->num_sids);
+        assert_non_null(test_ctx->sids[test_ctx->num_sids]);
+        test_ctx->num_sids++;
+    }
+    test_ctx->sids[test_ctx->num_sids] = NULL;
+}
+
+static void test_resolve_sids_done(struct tevent_req *req)
+{
+    errno_t ret;
+
+    ret = sdap_ad_resolve_sids_recv(req);
+    talloc_zfree(req);
+
+    test_ev_done(test_ctx->tctx, ret);
+}
+
+static errno_t resolve_sids(void)
+{
+    struct tevent_req *req;
+
+    test_ctx->tctx->done = false;
+
+    req = sdap_ad_resolve_sids_send(test_ctx, test_ctx->tctx->ev,
+                                    test_ctx->id_ctx, test_ctx->conn,
+                                    test_ctx->opts, test_ctx->tctx->dom,
+                                    test_ctx->sids);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_resolve_sids_done, NULL);
+
+    return test_ev_loop(test_ctx->tctx);
+}
+
+static void assert_search(size_t search_idx,
+                          size_t dom_idx,
+                          size_t first_sid,
+                          size_t num_sids)
+{
+    struct test_search *search;
+    size_t i;
+
+    assert_true(search_idx < test_ctx->num_searches);
+    search = &test_ctx->searches[search_idx];
+
+    assert_ptr_equal(search->sdom, get_sdom(dom_idx));
+    assert_int_equal(search->num_sids, num_sids);
+    for (i = 0; i < num_sids; i++) {
+        assert_int_equal(search->sids[i], first_sid + i);
+    }
+}
+
+static void assert_lookup(size_t lookup_idx,
+                          size_t dom_idx,
+                          size_t sid_idx)
+{
+    assert_true(lookup_idx < test_ctx->num_lookups);
+    assert_ptr_equal(test_ctx->lookups[lookup_idx].sdom, get_sdom(dom_idx));
+    assert_string_equal(test_ctx->lookups[lookup_idx].sid,
+                        test_ctx->sids[sid_idx]);
+}
+
+static struct sss_test_conf_param **get_params(TALLOC_CTX *mem_ctx)
+{
+    struct sss_test_conf_param **params;
+    size_t i;
+
+    params = talloc_zero_array(mem_ctx, struct sss_test_conf_param *,
+                               sizeof(domains) / sizeof(domains[0]));
+    assert_non_null(params);
+
+    for (i = 0; domains[i] != NULL; i++) {
+        params[i] = talloc_zero_array(params, struct sss_test_conf_param, 2);
+        assert_non_null(params[i]);
+
+        params[i][0].key = "ldap_schema";
+        params[i][0].value = "ad";
+    }
+
+    return params;
+}
+
+static int test_setup(void **state)
+{
+    struct sss_test_conf_param **params;
+    struct sss_domain_info *dom;
+    errno_t ret;
+    size_t i;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct test_ctx);
+    assert_non_null(test_ctx);
+
+    test_dom_suite_setup(TESTS_PATH);
+
+    params = get_params(test_ctx);
+    test_ctx->tctx = create_multidom_test_ctx(test_ctx, TESTS_PATH,
+                                              TEST_CONF_DB, domains,
+                                              TEST_ID_PROVIDER, params);
+    assert_non_null(test_ctx->tctx);
+    talloc_free(params);
+
+    test_ctx->opts = mock_sdap_options_ldap(test_ctx, test_ctx->tctx->dom,
+                                            test_ctx->tctx->confdb,
+                                            test_ctx->tctx->conf_dom_path);
+    assert_non_null(test_ctx->opts);
+
+    for (i = 0; domains[i] != NULL; i++) {
+        dom = get_dom(i);
+        assert_non_null(dom);
+
+        dom->domain_id = talloc_strdup(dom, domain_sids[i]);
+        assert_non_null(dom->domain_id);
+
+        if (sdap_domain_get(test_ctx->opts, dom) == NULL) {
+            ret = sdap_domain_add(test_ctx->opts, dom, NULL);
+            assert_int_equal(ret, EOK);
+        }
+    }
+
+    test_ctx->id_ctx = mock_sdap_id_ctx(test_ctx, NULL, test_ctx->opts);
+    test_ctx->conn = talloc_zero(test_ctx, struct sdap_id_conn_ctx);
+    assert_non_null(test_ctx->conn);
+
+    test_ctx->fail_connect_send = -1;
+    test_ctx->fail_connect = -1;
+    test_ctx->fail_search = -1;
+
+    *state = test_ctx;
+    return 0;
+}
+
+static int test_teardown(void **state)
+{
+    talloc_zfree(test_ctx);
+    test_multidom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, domains);
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+void test_resolve_sids_none(void **state)
+{
+    errno_t ret;
+
+    ret = resolve_sids();
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->num_searches, 0);
+    assert_int_equal(test_ctx->num_lookups, 0);
+}
+
+void test_resolve_sids_by_domain(void **state)
+{
+    errno_t ret;
+
+    /* SIDs 0-2 belong to domain 1, 3-4 to domain 2 and 5 to domain 3 */
+    add_sids(0, 3);
+    add_sids(1, 2);
+    add_sids(2, 1);
+
+    ret = resolve_sids();
+    assert_int_equal(ret, EOK);
+
+    /* one search per domain for the SIDs of that domain only */
+    assert_int_equal(test_ctx->num_searches, 3);
+    assert_search(0, 0, 0, 3);
+    assert_search(1, 1, 3, 2);
+    assert_search(2, 2, 5, 1);
+
+    assert_int_equal(test_ctx->num_lookups, 0);
+}
+
+void test_resolve_sids_unknown_domain(void **state)
+{
+    errno_t ret;
+
+    add_sids(0, 2);
+
+    /* does not belong to any of the domains */
+    test_ctx->sids = talloc_realloc(test_ctx, test_ctx->sids, char *,
+                                    test_ctx->num_sids + 2);
+    assert_non_null(test_ctx->sids);
+    test_ctx->sids[test_ctx->num_sids] = talloc_strdup(test_ctx->sids,
+                                                "S-1-5-21-9999-9999-9999-1");
+    assert_non_null(test_ctx->sids[test_ctx->num_sids]);
+    test_ctx->sids[test_ctx->num_sids + 1] = NULL;
+    test_ctx->num_sids++;
+
+    ret = resolve_sids();
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->num_searches, 1);
+    assert_search(0, 0, 0, 2);
+    assert_int_equal(test_ctx->num_lookups, 0);
+}
+
+void test_resolve_sids_split(void **state)
+{
+    size_t dom1_num = SDAP_AD_RESOLVE_SIDS_BATCH * 2 + 20;
+    size_t dom2_num = SDAP_AD_RESOLVE_SIDS_BATCH + 10;
+    errno_t ret;
+
+    add_sids(0, dom1_num);
+    add_sids(1, dom2_num);
+
+    ret = resolve_sids();
+    assert_int_equal(ret, EOK);
+
+    /* the batches of the two domains take turns */
+    assert_int_equal(test_ctx->num_searches, 5);
+    assert_search(0, 0, 0, SDAP_AD_RESOLVE_SIDS_BATCH);
+    assert_search(1, 1, dom1_num, SDAP_AD_RESOLVE_SIDS_BATCH);
+    assert_search(2, 0, SDAP_AD_RESOLVE_SIDS_BATCH,
+                  SDAP_AD_RESOLVE_SIDS_BATCH);
+    assert_search(3, 1, dom1_num + SDAP_AD_RESOLVE_SIDS_BATCH, 10);
+    assert_search(4, 0, SDAP_AD_RESOLVE_SIDS_BATCH * 2, 20);
+
+    assert_int_equal(test_ctx->num_lookups, 0);
+}
+
+void test_resolve_sids_parallel(void **state)
+{
+    size_t num_batches = SDAP_AD_RESOLVE_SIDS_PARALLEL * 2 + 1;
+    errno_t ret;
+
+    add_sids(0, SDAP_AD_RESOLVE_SIDS_BATCH * num_batches);
+
+    ret = resolve_sids();
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->num_searches, num_batches);
+    assert_int_equal(test_ctx->max_active, SDAP_AD_RESOLVE_SIDS_PARALLEL);
+    assert_int_equal(test_ctx->active, 0);
+    assert_int_equal(test_ctx->num_lookups, 0);
+}
+
+void test_resolve_sids_not_found(void **state)
+{
+    errno_t ret;
+
+    add_sids(0, 3);
+    add_sids(1, 3);
+
+    /* for example groups outside of the search base */
+    test_ctx->missing[1] = true;
+    test_ctx->missing[5] = true;
+
+    ret = resolve_sids();
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->num_searches, 2);
+
+    /* only the SIDs the searches did not find are looked up one by one */
+    assert_int_equal(test_ctx->num_lookups, 2);
+    assert_lookup(0, 0, 1);
+    assert_lookup(1, 1, 5);
+}
+
+void test_resolve_sids_connect_send_fails(void **state)
+{
+    errno_t ret;
+
+    add_sids(0, 2);
+    add_sids(1, 2);
+
+    test_ctx->fail_connect_send = 0;
+
+    ret = resolve_sids();
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->num_searches, 1);
+    assert_search(0, 1, 2, 2);
+
+    assert_int_equal(test_ctx->num_lookups, 2);
+    assert_lookup(0, 0, 0);
+    assert_lookup(1, 0, 1);
+}
+
+void test_resolve_sids_connect_fails(void **state)
+{
+    errno_t ret;
+
+    add_sids(0, 2);
+    add_sids(1, 2);
+
+    test_ctx->fail_connect = 1;
+
+    ret = resolve_sids();
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->num_searches, 1);
+    assert_search(0, 0, 0, 2);
+
+    assert_int_equal(test_ctx->num_lookups, 2);
+    assert_lookup(0, 1, 2);
+    assert_lookup(1, 1, 3);
+}
+
+void test_resolve_sids_search_fails(void **state)
+{
+    errno_t ret;
+
+    add_sids(0, 2);
+    add_sids(1, 2);
+
+    test_ctx->fail_search = 0;
+
+    ret = resolve_sids();
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->num_searches, 2);
+
+    assert_int_equal(test_ctx->num_lookups, 2);
+    assert_lookup(0, 0, 0);
+    assert_lookup(1, 0, 1);
+}
+
+void test_resolve_sids_lookup_not_found(void **state)
+{
+    errno_t ret;
+
+    add_sids(0, 2);
+
+    test_ctx->missing[0] = true;
+    test_ctx->missing[1] = true;
+    test_ctx->lookup_sdap_ret = ENOENT;
+
+    /* a SID that cannot be resolved at all is skipped */
+    ret = resolve_sids();
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->num_lookups, 2);
+}
+
+void test_resolve_sids_lookup_fails(void **state)
+{
+    errno_t ret;
+
+    add_sids(0, 2);
+
+    test_ctx->missing[0] = true;
+    test_ctx->missing[1] = true;
+    test_ctx->lookup_ret = EIO;
+
+    ret = resolve_sids();
+    assert_int_equal(ret, EIO);
+
+    assert_int_equal(test_ctx->num_lookups, 1);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_resolve_sids_none,
+                                        test_setup, test_teardown),
+        cmocka_unit_test_setup_teardown(test_resolve_sids_by_domain,
+                                        test_setup, test_teardown),
+        cmocka_unit_test_setup_teardown(test_resolve_sids_unknown_domain,
+                                        test_setup, test_teardown),
+        cmocka_unit_test_setup_teardown(test_resolve_sids_split,
+                                        test_setup, test_teardown),
+        cmocka_unit_test_setup_teardown(test_resolve_sids_parallel,
+                                        test_setup, test_teardown),
+        cmocka_unit_test_setup_teardown(test_resolve_sids_not_found,
+                                        test_setup, test_teardown),
+        cmocka_unit_test_setup_teardown(test_resolve_sids_connect_send_fails,
+                                        test_setup, test_teardown),
+        cmocka_unit_test_setup_teardown(test_resolve_sids_connect_fails,
+                                        test_setup, test_teardown),
+        cmocka_unit_test_setup_teardown(test_resolve_sids_search_fails,
+                                        test_setup, test_teardown),
+        cmocka_unit_test_setup_teardown(test_resolve_sids_lookup_not_found,
+                                        test_setup, test_teardown),
+        cmocka_unit_test_setup_teardown(test_resolve_sids_lookup_fails,
+                                        test_setup, test_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    /* Even though normally the tests should clean up after themselves
+     * they might not after a failed run. Remove the old DB to be sure */
+    tests_set_cwd();
+    test_multidom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, domains);
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
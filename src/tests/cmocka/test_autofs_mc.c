@@ -0,0 +1,371 @@
+/*
+    Copyright (C) 2026 Red Hat
+
+    SSSD tests: Autofs memory cache
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <popt.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+
+#include "util/util.h"
+#include "responder/nss/nsssrv_mmap_cache.h"
+#include "sss_client/nss_mc.h"
+#include "tests/cmocka/common_mock.h"
+
+#define TEST_MC_FILE        SSS_NSS_MCACHE_DIR"/autofs"
+#define TEST_MC_ELEMENTS    10000
+#define TEST_MC_TIMEOUT     300
+
+#define TEST_MAP_HOME       "auto.home"
+#define TEST_MAP_DATA       "auto.data"
+
+/* The client library takes these from sss_client/common.c */
+void sss_nss_mc_lock(void)
+{
+    return;
+}
+
+void sss_nss_mc_unlock(void)
+{
+    return;
+}
+
+struct autofs_mc_test_ctx {
+    struct sss_mc_ctx *mcc;
+};
+
+static struct autofs_mc_test_ctx *global_test_ctx;
+
+static errno_t store_entry(struct sss_mc_ctx **mcc,
+                           const char *map,
+                           const char *key,
+                           const char *value)
+{
+    struct sized_string s_map;
+    struct sized_string s_key;
+    struct sized_string s_value;
+
+    to_sized_string(&s_map, map);
+    to_sized_string(&s_key, key);
+    to_sized_string(&s_value, value);
+
+    return sss_mmap_cache_autofs_store(mcc, &s_map, &s_key, &s_value);
+}
+
+static errno_t lookup_entry(const char *map, const char *key, char **_value)
+{
+    return sss_nss_mc_getautomntbyname(map, strlen(map),
+                                       key, strlen(key), _value);
+}
+
+static void assert_entry(const char *map, const char *key, const char *value)
+{
+    char *result = NULL;
+    errno_t ret;
+
+    ret = lookup_entry(map, key, &result);
+    assert_int_equal(ret, EOK);
+    assert_non_null(result);
+    assert_string_equal(result, value);
+    free(result);
+}
+
+static void assert_no_entry(const char *map, const char *key)
+{
+    char *result = NULL;
+    errno_t ret;
+
+    ret = lookup_entry(map, key, &result);
+    assert_int_equal(ret, ENOENT);
+    assert_null(result);
+}
+
+static errno_t autofs_mc_init(TALLOC_CTX *mem_ctx, size_t n_elem,
+                              struct sss_mc_ctx **_mcc)
+{
+    return sss_mmap_cache_init(mem_ctx, "autofs", geteuid(), getegid(),
+                               SSS_MC_AUTOFS, n_elem,
+                               TEST_MC_TIMEOUT, _mcc);
+}
+
+static int setup_autofs_mc_group(void **state)
+{
+    errno_t ret;
+
+    ret = mkdir(SSS_NSS_MCACHE_DIR, 0775);
+    assert_true(ret == 0 || errno == EEXIST);
+
+    global_test_ctx = talloc_zero(NULL, struct autofs_mc_test_ctx);
+    assert_non_null(global_test_ctx);
+
+    /* The client keeps the file mapped for the whole run, so all tests share
+     * one cache and clean up after themselves with sss_mmap_cache_reset(). */
+    ret = autofs_mc_init(global_test_ctx, TEST_MC_ELEMENTS,
+                         &global_test_ctx->mcc);
+    assert_int_equal(ret, EOK);
+
+    return 0;
+}
+
+static int teardown_autofs_mc_group(void **state)
+{
+    talloc_zfree(global_test_ctx);
+    unlink(TEST_MC_FILE);
+    rmdir(SSS_NSS_MCACHE_DIR);
+    return 0;
+}
+
+static int teardown_autofs_mc(void **state)
+{
+    sss_mmap_cache_reset(global_test_ctx->mcc);
+    return 0;
+}
+
+static void test_autofs_mc_store_lookup(void **state)
+{
+    errno_t ret;
+
+    ret = store_entry(&global_test_ctx->mcc, TEST_MAP_HOME, "user1",
+                      "-rw server:/home/user1");
+    assert_int_equal(ret, EOK);
+
+    ret = store_entry(&global_test_ctx->mcc, TEST_MAP_HOME, "user2",
+                      "-rw server:/home/user2");
+    assert_int_equal(ret, EOK);
+
+    assert_entry(TEST_MAP_HOME, "user1", "-rw server:/home/user1");
+    assert_entry(TEST_MAP_HOME, "user2", "-rw server:/home/user2");
+
+    /* key is unknown in this map */
+    assert_no_entry(TEST_MAP_HOME, "user3");
+
+    /* same key in a different map */
+    assert_no_entry(TEST_MAP_DATA, "user1");
+
+    /* the lookup key must match completely, not only as a prefix */
+    assert_no_entry(TEST_MAP_HOME, "user");
+    assert_no_entry(TEST_MAP_HOME, "user10");
+}
+
+static void test_autofs_mc_update(void **state)
+{
+    errno_t ret;
+
+    ret = store_entry(&global_test_ctx->mcc, TEST_MAP_HOME, "user1",
+                      "-rw server:/home/user1");
+    assert_int_equal(ret, EOK);
+    assert_entry(TEST_MAP_HOME, "user1", "-rw server:/home/user1");
+
+    /* replace the value with a longer one */
+    ret = store_entry(&global_test_ctx->mcc, TEST_MAP_HOME, "user1",
+                      "-rw,nosuid,intr fileserver.example.com:/export/home/user1");
+    assert_int_equal(ret, EOK);
+    assert_entry(TEST_MAP_HOME, "user1",
+                 "-rw,nosuid,intr fileserver.example.com:/export/home/user1");
+}
+
+static void test_autofs_mc_invalidate_map(void **state)
+{
+    struct sized_string map;
+    errno_t ret;
+
+    ret = store_entry(&global_test_ctx->mcc, TEST_MAP_HOME, "user1",
+                      "-rw server:/home/user1");
+    assert_int_equal(ret, EOK);
+
+    ret = store_entry(&global_test_ctx->mcc, TEST_MAP_HOME, "user2",
+                      "-rw server:/home/user2");
+    assert_int_equal(ret, EOK);
+
+    ret = store_entry(&global_test_ctx->mcc, TEST_MAP_DATA, "user1",
+                      "-ro server:/data/user1");
+    assert_int_equal(ret, EOK);
+
+    to_sized_string(&map, TEST_MAP_HOME);
+    ret = sss_mmap_cache_autofs_invalidate_map(global_test_ctx->mcc, &map);
+    assert_int_equal(ret, EOK);
+
+    assert_no_entry(TEST_MAP_HOME, "user1");
+    assert_no_entry(TEST_MAP_HOME, "user2");
+    assert_entry(TEST_MAP_DATA, "user1", "-ro server:/data/user1");
+
+    /* nothing left to invalidate */
+    ret = sss_mmap_cache_autofs_invalidate_map(global_test_ctx->mcc, &map);
+    assert_int_equal(ret, ENOENT);
+}
+
+static void test_autofs_mc_newline(void **state)
+{
+    errno_t ret;
+
+    ret = store_entry(&global_test_ctx->mcc, TEST_MAP_HOME "\nuser1", "x",
+                      "-rw server:/home/x");
+    assert_int_equal(ret, EINVAL);
+
+    ret = store_entry(&global_test_ctx->mcc, TEST_MAP_HOME, "user1\nx",
+                      "-rw server:/home/x");
+    assert_int_equal(ret, EINVAL);
+
+    ret = store_entry(&global_test_ctx->mcc, TEST_MAP_HOME, "user1",
+                      "-rw server:/home/user1");
+    assert_int_equal(ret, EOK);
+
+    /* a crafted key must not match the composite lookup key */
+    assert_no_entry(TEST_MAP_HOME "\nuser1", "");
+    assert_no_entry("", TEST_MAP_HOME "\nuser1");
+}
+
+static void test_autofs_mc_reset(void **state)
+{
+    errno_t ret;
+
+    ret = store_entry(&global_test_ctx->mcc, TEST_MAP_HOME, "user1",
+                      "-rw server:/home/user1");
+    assert_int_equal(ret, EOK);
+    assert_entry(TEST_MAP_HOME, "user1", "-rw server:/home/user1");
+
+    sss_mmap_cache_reset(global_test_ctx->mcc);
+
+    assert_no_entry(TEST_MAP_HOME, "user1");
+}
+
+static double time_diff(struct timeval *start, struct timeval *end)
+{
+    return (end->tv_sec - start->tv_sec)
+           + (end->tv_usec - start->tv_usec) / 1000000.0;
+}
+
+static void benchmark_autofs_mc(int num_keys)
+{
+    struct sss_mc_ctx *mcc = NULL;
+    struct timeval start;
+    struct timeval end;
+    char key[64];
+    char value[128];
+    char *result;
+    double elapsed;
+    int i;
+    errno_t ret;
+
+    ret = mkdir(SSS_NSS_MCACHE_DIR, 0775);
+    if (ret != 0 && errno != EEXIST) {
+        fprintf(stderr, "Unable to create %s\n", SSS_NSS_MCACHE_DIR);
+        return;
+    }
+
+    /* size the cache so that no entry is evicted while storing */
+    ret = autofs_mc_init(NULL, MAX(num_keys, TEST_MC_ELEMENTS), &mcc);
+    if (ret != EOK) {
+        fprintf(stderr, "Unable to initialize the cache [%d]\n", ret);
+        goto done;
+    }
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < num_keys; i++) {
+        snprintf(key, sizeof(key), "user%d", i);
+        snprintf(value, sizeof(value), "-rw server:/home/user%d", i);
+        ret = store_entry(&mcc, TEST_MAP_HOME, key, value);
+        if (ret != EOK) {
+            fprintf(stderr, "Unable to store %s [%d]\n", key, ret);
+            goto done;
+        }
+    }
+    gettimeofday(&end, NULL);
+    elapsed = time_diff(&start, &end);
+    printf("store:  %d entries in %.3f s (%.0f entries/s)\n",
+           num_keys, elapsed, num_keys / elapsed);
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < num_keys; i++) {
+        snprintf(key, sizeof(key), "user%d", i);
+        ret = lookup_entry(TEST_MAP_HOME, key, &result);
+        if (ret != EOK) {
+            fprintf(stderr, "Unable to look up %s [%d]\n", key, ret);
+            goto done;
+        }
+        free(result);
+    }
+    gettimeofday(&end, NULL);
+    elapsed = time_diff(&start, &end);
+    printf("lookup: %d entries in %.3f s (%.0f lookups/s)\n",
+           num_keys, elapsed, num_keys / elapsed);
+
+done:
+    talloc_free(mcc);
+    unlink(TEST_MC_FILE);
+    rmdir(SSS_NSS_MCACHE_DIR);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    int rv;
+    int benchmark = 0;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        { "benchmark", 0, POPT_ARG_INT, &benchmark, 0,
+          "Measure the throughput of the given number of map entries", NULL },
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_teardown(test_autofs_mc_store_lookup,
+                                  teardown_autofs_mc),
+        cmocka_unit_test_teardown(test_autofs_mc_update,
+                                  teardown_autofs_mc),
+        cmocka_unit_test_teardown(test_autofs_mc_invalidate_map,
+                                  teardown_autofs_mc),
+        cmocka_unit_test_teardown(test_autofs_mc_newline,
+                                  teardown_autofs_mc),
+        cmocka_unit_test_teardown(test_autofs_mc_reset,
+                                  teardown_autofs_mc),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    tests_set_cwd();
+
+    if (benchmark > 0) {
+        benchmark_autofs_mc(benchmark);
+        return 0;
+    }
+
+    rv = cmocka_run_group_tests(tests, setup_autofs_mc_group,
+                                teardown_autofs_mc_group);
+
+    return rv;
+}
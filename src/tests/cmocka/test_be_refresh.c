@@ -0,0 +1,599 @@
+/*
+    SSSD
+
+    Back end refresh - cache pre-warming
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <tevent.h>
+#include <errno.h>
+#include <popt.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "tests/cmocka/common_mock_be.h"
+
+/* Include source file to test the static functions */
+#include "providers/be_refresh.c"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB "test_be_refresh_conf.ldb"
+#define TEST_DOM_NAME "be_refresh_test"
+#define TEST_ID_PROVIDER "ldap"
+
+#define new_test(test) \
+    cmocka_unit_test_setup_teardown(test_ ## test, test_setup, test_teardown)
+
+/* Time of the oldest entry, the entries are one second apart */
+#define TEST_BASE_TIME 1000000
+
+struct test_batch {
+    enum be_refresh_type type;
+    char **names;
+};
+
+struct test_ctx {
+    struct sss_test_ctx *tctx;
+    struct be_ctx *be_ctx;
+    struct be_refresh_ctx *refresh_ctx;
+
+    struct test_batch *batches;
+    size_t num_batches;
+    /* batch that fails in the send function or in the request */
+    ssize_t fail_send;
+    ssize_t fail_recv;
+
+    size_t active;
+    size_t max_active;
+};
+
+bool be_is_offline(struct be_ctx *ctx)
+{
+    return ctx->offline;
+}
+
+int be_add_online_cb(TALLOC_CTX *mem_ctx,
+                     struct be_ctx *ctx,
+                     be_callback_t cb,
+                     void *pvt,
+                     struct be_cb **online_cb)
+{
+    return ERR_OK;
+}
+
+int be_add_offline_cb(TALLOC_CTX *mem_ctx,
+                      struct be_ctx *ctx,
+                      be_callback_t cb,
+                      void *pvt,
+                      struct be_cb **offline_cb)
+{
+    return ERR_OK;
+}
+
+struct test_refresh_state {
+    struct test_ctx *test_ctx;
+};
+
+static void test_refresh_finish(struct tevent_context *ev,
+                                struct tevent_timer *te,
+                                struct timeval tv,
+                                void *pvt)
+{
+    struct tevent_req *req = talloc_get_type(pvt, struct tevent_req);
+    struct test_refresh_state *state;
+
+    state = tevent_req_data(req, struct test_refresh_state);
+    state->test_ctx->active--;
+
+    if (tevent_req_is_in_progress(req)) {
+        tevent_req_done(req);
+    }
+}
+
+static struct tevent_req *
+test_refresh_send(struct test_ctx *test_ctx,
+                  TALLOC_CTX *mem_ctx,
+                  struct tevent_context *ev,
+                  enum be_refresh_type type,
+                  char **names)
+{
+    struct test_refresh_state *state;
+    struct test_batch *batch;
+    struct tevent_req *req;
+    struct tevent_timer *te;
+    size_t idx;
+
+    idx = test_ctx->num_batches;
+    test_ctx->batches = talloc_realloc(test_ctx, test_ctx->batches,
+                                       struct test_batch, idx + 1);
+    assert_non_null(test_ctx->batches);
+    test_ctx->num_batches++;
+
+    batch = &test_ctx->batches[idx];
+    batch->type = type;
+    batch->names = discard_const_p(char *,
+                        dup_string_list(test_ctx->batches,
+                                        discard_const_p(const char *, names)));
+    assert_non_null(batch->names);
+
+    if ((ssize_t) idx == test_ctx->fail_send) {
+        return NULL;
+    }
+
+    req = tevent_req_create(mem_ctx, &state, struct test_refresh_state);
+    assert_non_null(req);
+    state->test_ctx = test_ctx;
+
+    test_ctx->active++;
+    test_ctx->max_active = MAX(test_ctx->max_active, test_ctx->active);
+
+    if ((ssize_t) idx == test_ctx->fail_recv) {
+        test_ctx->active--;
+        tevent_req_error(req, ERR_NETWORK_IO);
+        tevent_req_post(req, ev);
+        return req;
+    }
+
+    /* finish later so that the requests run at the same time */
+    te = tevent_add_timer(ev, req, tevent_timeval_current_ofs(0, 1000),
+                          test_refresh_finish, req);
+    assert_non_null(te);
+
+    return req;
+}
+
+static errno_t test_refresh_recv(struct tevent_req *req)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
+#define TEST_REFRESH_SEND(type_name, type)                                  \
+static struct tevent_req *                                                  \
+test_refresh_ ## type_name ## _send(TALLOC_CTX *mem_ctx,                    \
+                                    struct tevent_context *ev,              \
+                                    struct be_ctx *be_ctx,                  \
+                                    struct sss_domain_info *domain,         \
+                                    char **names,                           \
+                                    void *pvt)                              \
+{                                                                           \
+    return test_refresh_send(talloc_get_type(pvt, struct test_ctx),         \
+                             mem_ctx, ev, type, names);                     \
+}
+
+TEST_REFRESH_SEND(initgroups, BE_REFRESH_TYPE_INITGROUPS)
+TEST_REFRESH_SEND(users, BE_REFRESH_TYPE_USERS)
+TEST_REFRESH_SEND(groups, BE_REFRESH_TYPE_GROUPS)
+
+static void enable_cb(struct test_ctx *test_ctx,
+                      enum be_refresh_type type)
+{
+    struct be_refresh_cb cb;
+    errno_t ret;
+
+    switch (type) {
+    case BE_REFRESH_TYPE_INITGROUPS:
+        cb.send_fn = test_refresh_initgroups_send;
+        break;
+    case BE_REFRESH_TYPE_USERS:
+        cb.send_fn = test_refresh_users_send;
+        break;
+    case BE_REFRESH_TYPE_GROUPS:
+        cb.send_fn = test_refresh_groups_send;
+        break;
+    default:
+        fail();
+    }
+    cb.recv_fn = test_refresh_recv;
+    cb.pvt = test_ctx;
+
+    ret = be_refresh_add_cb(test_ctx->refresh_ctx, type, &cb);
+    assert_int_equal(ret, EOK);
+}
+
+static const char *user_name(TALLOC_CTX *mem_ctx, size_t idx)
+{
+    char *name;
+
+    name = talloc_asprintf(mem_ctx, "user%zu@%s", idx, TEST_DOM_NAME);
+    assert_non_null(name);
+    return name;
+}
+
+/* The user with the highest index was looked up last */
+static void add_users(struct test_ctx *test_ctx, size_t num_users)
+{
+    const char *name;
+    errno_t ret;
+    size_t i;
+
+    for (i = 0; i < num_users; i++) {
+        name = user_name(test_ctx, i);
+        ret = sysdb_store_user(test_ctx->tctx->dom, name, NULL,
+                               10000 + i, 10000 + i, NULL, "/", "/bin/sh",
+                               NULL, NULL, NULL, 300, TEST_BASE_TIME + i);
+        assert_int_equal(ret, EOK);
+        talloc_free(discard_const(name));
+    }
+}
+
+static void set_last_login(struct test_ctx *test_ctx, size_t idx,
+                           time_t last_login)
+{
+    struct sysdb_attrs *attrs;
+    errno_t ret;
+
+    attrs = sysdb_new_attrs(test_ctx);
+    assert_non_null(attrs);
+
+    ret = sysdb_attrs_add_time_t(attrs, SYSDB_LAST_LOGIN, last_login);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_set_user_attr(test_ctx->tctx->dom, user_name(attrs, idx),
+                              attrs, SYSDB_MOD_REP);
+    assert_int_equal(ret, EOK);
+
+    talloc_free(attrs);
+}
+
+static int test_setup(void **state)
+{
+    struct test_ctx *test_ctx;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct test_ctx);
+    assert_non_null(test_ctx);
+
+    test_dom_suite_setup(TESTS_PATH);
+
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, TEST_ID_PROVIDER,
+                                         NULL);
+    assert_non_null(test_ctx->tctx);
+
+    test_ctx->be_ctx = mock_be_ctx(test_ctx, test_ctx->tctx);
+    assert_non_null(test_ctx->be_ctx);
+
+    test_ctx->refresh_ctx = talloc_zero(test_ctx, struct be_refresh_ctx);
+    assert_non_null(test_ctx->refresh_ctx);
+
+    test_ctx->refresh_ctx->callbacks[BE_REFRESH_TYPE_INITGROUPS].name =
+                                                                "initgroups";
+    test_ctx->refresh_ctx->callbacks[BE_REFRESH_TYPE_INITGROUPS].attr_name =
+                                                                SYSDB_NAME;
+    test_ctx->refresh_ctx->callbacks[BE_REFRESH_TYPE_USERS].name = "users";
+    test_ctx->refresh_ctx->callbacks[BE_REFRESH_TYPE_USERS].attr_name =
+                                                                SYSDB_NAME;
+    test_ctx->refresh_ctx->callbacks[BE_REFRESH_TYPE_GROUPS].name = "groups";
+    test_ctx->refresh_ctx->callbacks[BE_REFRESH_TYPE_GROUPS].attr_name =
+                                                                SYSDB_NAME;
+
+    test_ctx->fail_send = -1;
+    test_ctx->fail_recv = -1;
+
+    *state = test_ctx;
+    return 0;
+}
+
+static int test_teardown(void **state)
+{
+    talloc_zfree(*state);
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+static void test_prewarm_done(struct tevent_req *req)
+{
+    struct test_ctx *test_ctx;
+    errno_t ret;
+
+    test_ctx = tevent_req_callback_data(req, struct test_ctx);
+
+    ret = be_prewarm_recv(req);
+    talloc_zfree(req);
+
+    test_ev_done(test_ctx->tctx, ret);
+}
+
+static errno_t run_prewarm(struct test_ctx *test_ctx, uint32_t limit)
+{
+    struct tevent_req *req;
+
+    test_ctx->tctx->dom->prewarm_cache_entries = limit;
+    test_ctx->tctx->done = false;
+
+    req = be_prewarm_send(test_ctx, test_ctx->tctx->ev, test_ctx->be_ctx,
+                          NULL, test_ctx->refresh_ctx);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_prewarm_done, test_ctx);
+
+    return test_ev_loop(test_ctx->tctx);
+}
+
+static void assert_batch_users(struct test_ctx *test_ctx,
+                               size_t batch,
+                               const size_t *expected,
+                               size_t num_expected)
+{
+    char **names;
+    size_t i;
+
+    assert_true(batch < test_ctx->num_batches);
+    names = test_ctx->batches[batch].names;
+
+    for (i = 0; i < num_expected; i++) {
+        assert_non_null(names[i]);
+        assert_string_equal(names[i], user_name(names, expected[i]));
+    }
+    assert_null(names[num_expected]);
+}
+
+void test_prewarm_users_by_last_update(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                      struct test_ctx);
+    const size_t expected[] = { 4, 3, 2 };
+    errno_t ret;
+
+    add_users(test_ctx, 5);
+    enable_cb(test_ctx, BE_REFRESH_TYPE_USERS);
+
+    ret = run_prewarm(test_ctx, 3);
+    assert_int_equal(ret, EOK);
+
+    /* the most recently updated users first */
+    assert_int_equal(test_ctx->num_batches, 1);
+    assert_int_equal(test_ctx->batches[0].type, BE_REFRESH_TYPE_USERS);
+    assert_batch_users(test_ctx, 0, expected, 3);
+    assert_true(test_ctx->refresh_ctx->prewarmed);
+}
+
+void test_prewarm_initgroups_by_last_login(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                      struct test_ctx);
+    const size_t expected[] = { 0, 3 };
+    errno_t ret;
+
+    /* lastLogin does not follow lastUpdate and user 1, 2 and 4 never
+     * logged in */
+    add_users(test_ctx, 5);
+    set_last_login(test_ctx, 3, TEST_BASE_TIME + 10);
+    set_last_login(test_ctx, 0, TEST_BASE_TIME + 20);
+
+    enable_cb(test_ctx, BE_REFRESH_TYPE_INITGROUPS);
+    enable_cb(test_ctx, BE_REFRESH_TYPE_GROUPS);
+
+    ret = run_prewarm(test_ctx, 10);
+    assert_int_equal(ret, EOK);
+
+    /* no groups were cached */
+    assert_int_equal(test_ctx->num_batches, 1);
+    assert_int_equal(test_ctx->batches[0].type, BE_REFRESH_TYPE_INITGROUPS);
+    assert_batch_users(test_ctx, 0, expected, 2);
+}
+
+void test_prewarm_types(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                      struct test_ctx);
+    const char *group;
+    errno_t ret;
+
+    add_users(test_ctx, 2);
+    set_last_login(test_ctx, 1, TEST_BASE_TIME + 10);
+
+    group = "group0@" TEST_DOM_NAME;
+    ret = sysdb_store_group(test_ctx->tctx->dom, group, 20000, NULL, 300,
+                            TEST_BASE_TIME);
+    assert_int_equal(ret, EOK);
+
+    enable_cb(test_ctx, BE_REFRESH_TYPE_INITGROUPS);
+    enable_cb(test_ctx, BE_REFRESH_TYPE_USERS);
+    enable_cb(test_ctx, BE_REFRESH_TYPE_GROUPS);
+
+    ret = run_prewarm(test_ctx, 10);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->num_batches, 3);
+    assert_int_equal(test_ctx->batches[0].type, BE_REFRESH_TYPE_INITGROUPS);
+    assert_int_equal(test_ctx->batches[1].type, BE_REFRESH_TYPE_USERS);
+    assert_int_equal(test_ctx->batches[2].type, BE_REFRESH_TYPE_GROUPS);
+    assert_string_equal(test_ctx->batches[2].names[0], group);
+    assert_null(test_ctx->batches[2].names[1]);
+}
+
+void test_prewarm_batches(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                      struct test_ctx);
+    size_t num_users = BE_PREWARM_BATCH_SIZE * (BE_PREWARM_CONCURRENCY + 1)
+                       + 10;
+    size_t total;
+    size_t i;
+    errno_t ret;
+
+    add_users(test_ctx, num_users + 5);
+    enable_cb(test_ctx, BE_REFRESH_TYPE_USERS);
+
+    ret = run_prewarm(test_ctx, num_users);
+    assert_int_equal(ret, EOK);
+
+    /* full batches and one with the rest, never more than the limit */
+    assert_int_equal(test_ctx->num_batches, BE_PREWARM_CONCURRENCY + 2);
+    total = 0;
+    for (i = 0; i < test_ctx->num_batches; i++) {
+        total += talloc_array_length(test_ctx->batches[i].names) - 1;
+        if (i < test_ctx->num_batches - 1) {
+            assert_int_equal(talloc_array_length(test_ctx->batches[i].names)
+                                 - 1,
+                             BE_PREWARM_BATCH_SIZE);
+        }
+    }
+    assert_int_equal(total, num_users);
+
+    /* the oldest entries were left out */
+    assert_string_equal(test_ctx->batches[0].names[0],
+                        user_name(test_ctx, num_users + 4));
+
+    assert_int_equal(test_ctx->max_active, BE_PREWARM_CONCURRENCY);
+    assert_int_equal(test_ctx->active, 0);
+}
+
+void test_prewarm_batch_errors(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                      struct test_ctx);
+    errno_t ret;
+
+    add_users(test_ctx, BE_PREWARM_BATCH_SIZE * 3);
+    enable_cb(test_ctx, BE_REFRESH_TYPE_USERS);
+
+    /* a failed batch does not stop the others */
+    test_ctx->fail_send = 0;
+    test_ctx->fail_recv = 1;
+
+    ret = run_prewarm(test_ctx, BE_PREWARM_BATCH_SIZE * 3);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->num_batches, 3);
+    assert_int_equal(test_ctx->active, 0);
+    assert_true(test_ctx->refresh_ctx->prewarmed);
+}
+
+void test_prewarm_send_fails(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                      struct test_ctx);
+    errno_t ret;
+
+    add_users(test_ctx, 2);
+    enable_cb(test_ctx, BE_REFRESH_TYPE_USERS);
+
+    /* no refresh request could be started at all */
+    test_ctx->fail_send = 0;
+
+    ret = run_prewarm(test_ctx, 10);
+    assert_int_equal(ret, ENOMEM);
+    assert_int_equal(test_ctx->num_batches, 1);
+    assert_false(test_ctx->refresh_ctx->prewarmed);
+}
+
+void test_prewarm_only_once(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                      struct test_ctx);
+    errno_t ret;
+
+    add_users(test_ctx, 2);
+    enable_cb(test_ctx, BE_REFRESH_TYPE_USERS);
+
+    ret = run_prewarm(test_ctx, 10);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(test_ctx->num_batches, 1);
+
+    /* the task is run again when the back end goes online */
+    ret = run_prewarm(test_ctx, 10);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(test_ctx->num_batches, 1);
+}
+
+void test_prewarm_empty_cache(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                      struct test_ctx);
+    errno_t ret;
+
+    enable_cb(test_ctx, BE_REFRESH_TYPE_INITGROUPS);
+    enable_cb(test_ctx, BE_REFRESH_TYPE_USERS);
+    enable_cb(test_ctx, BE_REFRESH_TYPE_GROUPS);
+
+    ret = run_prewarm(test_ctx, 10);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->num_batches, 0);
+    assert_true(test_ctx->refresh_ctx->prewarmed);
+}
+
+void test_prewarm_invalid_ctx(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                      struct test_ctx);
+    struct tevent_req *req;
+    errno_t ret;
+
+    test_ctx->tctx->done = false;
+
+    req = be_prewarm_send(test_ctx, test_ctx->tctx->ev, test_ctx->be_ctx,
+                          NULL, test_ctx);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_prewarm_done, test_ctx);
+
+    ret = test_ev_loop(test_ctx->tctx);
+    assert_int_equal(ret, EINVAL);
+    assert_false(test_ctx->refresh_ctx->prewarmed);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        new_test(prewarm_users_by_last_update),
+        new_test(prewarm_initgroups_by_last_login),
+        new_test(prewarm_types),
+        new_test(prewarm_batches),
+        new_test(prewarm_batch_errors),
+        new_test(prewarm_send_fails),
+        new_test(prewarm_only_once),
+        new_test(prewarm_empty_cache),
+        new_test(prewarm_invalid_ctx),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    /* Even though normally the tests should clean up after themselves
+     * they might not after a failed run. Remove the old DB to be sure */
+    tests_set_cwd();
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,293 @@
+/*
+    Copyright (C) 2020 Red Hat
+
+    SSSD tests: Asynchronous password hashing
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <popt.h>
+
+#include "util/util.h"
+#include "util/crypto/sss_crypto.h"
+#include "util/sss_crypt_pool.h"
+#include "tests/cmocka/common_mock.h"
+
+#define TEST_PASSWORD   "Passw0rd!"
+#define TEST_SALT       "$6$rounds=5000$saltsaltsaltsalt"
+#define TEST_NUM_REQS   16
+
+struct crypt_pool_test_ctx {
+    struct sss_test_ctx *tctx;
+    struct sss_crypt_pool *pool;
+    char *expected;
+    int num_done;
+    int num_reqs;
+};
+
+static int setup_crypt_pool(void **state)
+{
+    struct crypt_pool_test_ctx *test_ctx;
+    errno_t ret;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct crypt_pool_test_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->tctx = create_ev_test_ctx(test_ctx);
+    assert_non_null(test_ctx->tctx);
+
+    ret = s3crypt_sha512(test_ctx, TEST_PASSWORD, TEST_SALT,
+                         &test_ctx->expected);
+    assert_int_equal(ret, EOK);
+
+    check_leaks_push(test_ctx);
+    *state = test_ctx;
+    return 0;
+}
+
+static int teardown_crypt_pool(void **state)
+{
+    struct crypt_pool_test_ctx *test_ctx = talloc_get_type(*state,
+                                                struct crypt_pool_test_ctx);
+
+    assert_non_null(test_ctx);
+
+    talloc_zfree(test_ctx->pool);
+    assert_true(check_leaks_pop(test_ctx) == true);
+    talloc_free(test_ctx);
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+static void test_crypt_pool_hash_done(struct tevent_req *req)
+{
+    struct crypt_pool_test_ctx *test_ctx;
+    char *hash;
+    errno_t ret;
+
+    test_ctx = tevent_req_callback_data(req, struct crypt_pool_test_ctx);
+
+    ret = s3crypt_sha512_recv(test_ctx, req, &hash);
+    talloc_zfree(req);
+    if (ret != EOK) {
+        test_ev_done(test_ctx->tctx, ret);
+        return;
+    }
+
+    if (strcmp(hash, test_ctx->expected) != 0) {
+        test_ev_done(test_ctx->tctx, EINVAL);
+        talloc_free(hash);
+        return;
+    }
+    talloc_free(hash);
+
+    test_ctx->num_done++;
+    if (test_ctx->num_done == test_ctx->num_reqs) {
+        test_ev_done(test_ctx->tctx, EOK);
+    }
+}
+
+static void test_crypt_pool_run(struct crypt_pool_test_ctx *test_ctx,
+                                int num_reqs)
+{
+    struct tevent_req *req;
+    errno_t ret;
+    int i;
+
+    test_ctx->num_reqs = num_reqs;
+    for (i = 0; i < num_reqs; i++) {
+        req = s3crypt_sha512_send(test_ctx, test_ctx->tctx->ev,
+                                  test_ctx->pool, TEST_PASSWORD, TEST_SALT);
+        assert_non_null(req);
+        tevent_req_set_callback(req, test_crypt_pool_hash_done, test_ctx);
+    }
+
+    ret = test_ev_loop(test_ctx->tctx);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(test_ctx->num_done, num_reqs);
+}
+
+void test_crypt_pool_no_pool(void **state)
+{
+    struct crypt_pool_test_ctx *test_ctx = talloc_get_type(*state,
+                                                struct crypt_pool_test_ctx);
+
+    test_crypt_pool_run(test_ctx, 1);
+}
+
+void test_crypt_pool_no_workers(void **state)
+{
+    struct crypt_pool_test_ctx *test_ctx = talloc_get_type(*state,
+                                                struct crypt_pool_test_ctx);
+    struct sss_crypt_pool_stats stats;
+    errno_t ret;
+
+    ret = sss_crypt_pool_init(test_ctx, test_ctx->tctx->ev, 0,
+                              &test_ctx->pool);
+    assert_int_equal(ret, EOK);
+
+    test_crypt_pool_run(test_ctx, TEST_NUM_REQS);
+
+    sss_crypt_pool_get_stats(test_ctx->pool, &stats);
+    assert_int_equal(stats.sync, TEST_NUM_REQS);
+    assert_int_equal(stats.queued, 0);
+}
+
+void test_crypt_pool_workers(void **state)
+{
+    struct crypt_pool_test_ctx *test_ctx = talloc_get_type(*state,
+                                                struct crypt_pool_test_ctx);
+    struct sss_crypt_pool_stats stats;
+    errno_t ret;
+
+    ret = sss_crypt_pool_init(test_ctx, test_ctx->tctx->ev, 4,
+                              &test_ctx->pool);
+    assert_int_equal(ret, EOK);
+
+    test_crypt_pool_run(test_ctx, TEST_NUM_REQS);
+
+    sss_crypt_pool_get_stats(test_ctx->pool, &stats);
+#ifdef HAVE_PTHREAD
+    assert_int_equal(stats.queued, TEST_NUM_REQS);
+    assert_int_equal(stats.sync, 0);
+#else
+    assert_int_equal(stats.sync, TEST_NUM_REQS);
+#endif
+}
+
+void test_crypt_pool_cancel(void **state)
+{
+    struct crypt_pool_test_ctx *test_ctx = talloc_get_type(*state,
+                                                struct crypt_pool_test_ctx);
+    struct tevent_req *req[TEST_NUM_REQS];
+    errno_t ret;
+    int i;
+
+    ret = sss_crypt_pool_init(test_ctx, test_ctx->tctx->ev, 1,
+                              &test_ctx->pool);
+    assert_int_equal(ret, EOK);
+
+    for (i = 0; i < TEST_NUM_REQS; i++) {
+        req[i] = s3crypt_sha512_send(test_ctx, test_ctx->tctx->ev,
+                                     test_ctx->pool, TEST_PASSWORD, TEST_SALT);
+        assert_non_null(req[i]);
+    }
+
+    /* Requests freed while queued or running must not crash or leak. */
+    for (i = 0; i < TEST_NUM_REQS; i++) {
+        talloc_free(req[i]);
+    }
+
+    /* A new request must still be processed. */
+    test_crypt_pool_run(test_ctx, 1);
+}
+
+static void benchmark_crypt_pool(int num_hashes, int num_workers)
+{
+    struct crypt_pool_test_ctx *test_ctx;
+    struct timeval start;
+    struct timeval end;
+    double elapsed;
+    errno_t ret;
+
+    test_ctx = talloc_zero(NULL, struct crypt_pool_test_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->tctx = create_ev_test_ctx(test_ctx);
+    assert_non_null(test_ctx->tctx);
+
+    ret = s3crypt_sha512(test_ctx, TEST_PASSWORD, TEST_SALT,
+                         &test_ctx->expected);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_crypt_pool_init(test_ctx, test_ctx->tctx->ev, num_workers,
+                              &test_ctx->pool);
+    assert_int_equal(ret, EOK);
+
+    gettimeofday(&start, NULL);
+    test_crypt_pool_run(test_ctx, num_hashes);
+    gettimeofday(&end, NULL);
+
+    elapsed = (end.tv_sec - start.tv_sec)
+                + (end.tv_usec - start.tv_usec) / 1000000.0;
+    printf("%d hashes, %d worker(s): %.3f s, %.1f hashes/s\n",
+           num_hashes, num_workers, elapsed, num_hashes / elapsed);
+
+    talloc_free(test_ctx);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    int rv;
+    int benchmark = 0;
+    int workers[] = { 0, 1, 2, 4, 8 };
+    size_t i;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        { "benchmark", 0, POPT_ARG_INT, &benchmark, 0,
+          "Measure the throughput of the given number of hashes", NULL },
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_crypt_pool_no_pool,
+                                        setup_crypt_pool,
+                                        teardown_crypt_pool),
+        cmocka_unit_test_setup_teardown(test_crypt_pool_no_workers,
+                                        setup_crypt_pool,
+                                        teardown_crypt_pool),
+        cmocka_unit_test_setup_teardown(test_crypt_pool_workers,
+                                        setup_crypt_pool,
+                                        teardown_crypt_pool),
+        cmocka_unit_test_setup_teardown(test_crypt_pool_cancel,
+                                        setup_crypt_pool,
+                                        teardown_crypt_pool),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    if (benchmark > 0) {
+        for (i = 0; i < sizeof(workers) / sizeof(workers[0]); i++) {
+            benchmark_crypt_pool(benchmark, workers[i]);
+        }
+        return 0;
+    }
+
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+
+    return rv;
+}
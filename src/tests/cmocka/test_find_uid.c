@@ -30,10 +30,25 @@
 #include <sys/types.h>
 #include <cmocka.h>
 #include <dhash.h>
+#include <popt.h>
 
-#include "util/find_uid.h"
 #include "tests/common.h"
 
+/* Include source file to test static functions */
+#include "util/find_uid.c"
+
+#define FAKE_PROCS 10000
+#define FAKE_UIDS 100
+#define FAKE_UID_BASE 500000
+
+struct fake_proc_ctx {
+    char *dirname;
+    int nprocs;
+};
+
+/* number of processes created by fake_proc_setup() */
+static int fake_procs = FAKE_PROCS;
+
 void test_check_if_uid_is_active_success(void **state)
 {
     int ret;
@@ -93,13 +108,248 @@ void test_get_uid_table(void **state)
     talloc_free(tmp_ctx);
 }
 
-int main(void)
+/* Builds a /proc look-alike with fake_procs processes of FAKE_UIDS users,
+ * the process with pid N belongs to FAKE_UID_BASE + N % FAKE_UIDS */
+static int fake_proc_setup(void **state)
+{
+    struct fake_proc_ctx *ctx;
+    char *path;
+    FILE *f;
+    int ret;
+    int i;
+
+    ctx = talloc_zero(NULL, struct fake_proc_ctx);
+    assert_non_null(ctx);
+
+    ctx->dirname = talloc_strdup(ctx, "test_find_uid_proc.XXXXXX");
+    assert_non_null(ctx->dirname);
+    assert_non_null(mkdtemp(ctx->dirname));
+
+    for (i = 1; i <= fake_procs; i++) {
+        path = talloc_asprintf(ctx, "%s/%d", ctx->dirname, i);
+        assert_non_null(path);
+        ret = mkdir(path, 0700);
+        assert_int_equal(ret, 0);
+        ctx->nprocs = i;
+
+        path = talloc_asprintf_append(path, "/status");
+        assert_non_null(path);
+        f = fopen(path, "w");
+        assert_non_null(f);
+        fprintf(f, "Name:\tfake\nPid:\t%d\nUid:\t%d\t%d\t%d\t%d\n", i,
+                FAKE_UID_BASE + i % FAKE_UIDS, FAKE_UID_BASE + i % FAKE_UIDS,
+                FAKE_UID_BASE + i % FAKE_UIDS, FAKE_UID_BASE + i % FAKE_UIDS);
+        fclose(f);
+        talloc_free(path);
+    }
+
+    proc_dir_path = ctx->dirname;
+    *state = ctx;
+    return 0;
+}
+
+static int fake_proc_teardown(void **state)
+{
+    struct fake_proc_ctx *ctx = talloc_get_type(*state, struct fake_proc_ctx);
+    char *path;
+    int i;
+
+    talloc_zfree(uid_tracker);
+    proc_dir_path = "/proc";
+
+    for (i = 1; i <= ctx->nprocs; i++) {
+        path = talloc_asprintf(ctx, "%s/%d/status", ctx->dirname, i);
+        assert_non_null(path);
+        unlink(path);
+        path[strlen(path) - strlen("/status")] = '\0';
+        rmdir(path);
+        talloc_free(path);
+    }
+    rmdir(ctx->dirname);
+
+    talloc_free(ctx);
+    return 0;
+}
+
+/* Set up the tracker without listening to the kernel, events are fed to
+ * it by the tests */
+static struct uid_tracker *fake_tracker_setup(void)
+{
+    struct uid_tracker *tracker;
+    errno_t ret;
+
+    tracker = talloc_zero(NULL, struct uid_tracker);
+    assert_non_null(tracker);
+    tracker->fd = -1;
+    talloc_set_destructor(tracker, uid_tracker_destructor);
+
+    ret = uid_tracker_scan(tracker);
+    assert_int_equal(ret, EOK);
+
+    uid_tracker = tracker;
+    return tracker;
+}
+
+static void assert_uid_active(uid_t uid, bool expected)
+{
+    bool result;
+    errno_t ret;
+
+    ret = check_if_uid_is_active(uid, &result);
+    assert_int_equal(ret, EOK);
+    assert_true(result == expected);
+}
+
+void test_uid_tracker_events(void **state)
+{
+    struct uid_tracker *tracker;
+    struct proc_event ev;
+    uid_t parent_uid = FAKE_UID_BASE + 1;
+    uid_t new_uid = FAKE_UID_BASE + FAKE_UIDS + 1;
+    pid_t child = FAKE_PROCS + 1;
+    errno_t ret;
+
+    tracker = fake_tracker_setup();
+    assert_int_equal(hash_count(tracker->pids), FAKE_PROCS);
+    assert_int_equal(hash_count(tracker->uids), FAKE_UIDS);
+    assert_uid_active(parent_uid, true);
+    assert_uid_active(new_uid, false);
+
+    /* the child inherits the UID of its parent */
+    memset(&ev, 0, sizeof(ev));
+    ev.what = PROC_EVENT_FORK;
+    ev.event_data.fork.parent_pid = 1;
+    ev.event_data.fork.parent_tgid = 1;
+    ev.event_data.fork.child_pid = child;
+    ev.event_data.fork.child_tgid = child;
+    ret = uid_tracker_process_event(tracker, &ev);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(hash_count(tracker->pids), FAKE_PROCS + 1);
+
+    /* threads are ignored */
+    ev.event_data.fork.child_pid = child + 1;
+    ret = uid_tracker_process_event(tracker, &ev);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(hash_count(tracker->pids), FAKE_PROCS + 1);
+
+    memset(&ev, 0, sizeof(ev));
+    ev.what = PROC_EVENT_UID;
+    ev.event_data.id.process_pid = child;
+    ev.event_data.id.process_tgid = child;
+    ev.event_data.id.r.ruid = new_uid;
+    ev.event_data.id.e.euid = new_uid;
+    ret = uid_tracker_process_event(tracker, &ev);
+    assert_int_equal(ret, EOK);
+    assert_uid_active(new_uid, true);
+    assert_int_equal(hash_count(tracker->uids), FAKE_UIDS + 1);
+
+    memset(&ev, 0, sizeof(ev));
+    ev.what = PROC_EVENT_EXIT;
+    ev.event_data.exit.process_pid = child;
+    ev.event_data.exit.process_tgid = child;
+    ret = uid_tracker_process_event(tracker, &ev);
+    assert_int_equal(ret, EOK);
+    assert_uid_active(new_uid, false);
+    assert_int_equal(hash_count(tracker->pids), FAKE_PROCS);
+    assert_int_equal(hash_count(tracker->uids), FAKE_UIDS);
+
+    /* the UID is active until its last process exits */
+    ev.event_data.exit.process_pid = 1;
+    ev.event_data.exit.process_tgid = 1;
+    ret = uid_tracker_process_event(tracker, &ev);
+    assert_int_equal(ret, EOK);
+    assert_uid_active(parent_uid, true);
+}
+
+static double elapsed_ms(struct timeval *start)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return (now.tv_sec - start->tv_sec) * 1000.0
+           + (now.tv_usec - start->tv_usec) / 1000.0;
+}
+
+/* Compares the cost of the queries with and without the tracker */
+static void benchmark_uid_tracker(int nprocs)
 {
+    const int rounds = 10;
+    struct timeval start;
+    hash_table_t *table;
+    double scan_ms;
+    double tracker_ms;
+    void *state;
+    errno_t ret;
+    int i;
+
+    fake_procs = nprocs;
+    fake_proc_setup(&state);
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < rounds; i++) {
+        ret = get_uid_table(NULL, &table);
+        assert_int_equal(ret, EOK);
+        assert_int_equal(hash_count(table), MIN(nprocs, FAKE_UIDS));
+        hash_destroy(table);
+    }
+    scan_ms = elapsed_ms(&start);
+
+    fake_tracker_setup();
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < rounds; i++) {
+        ret = get_uid_table(NULL, &table);
+        assert_int_equal(ret, EOK);
+        assert_int_equal(hash_count(table), MIN(nprocs, FAKE_UIDS));
+        hash_destroy(table);
+    }
+    tracker_ms = elapsed_ms(&start);
+
+    printf("get_uid_table() with %d processes: %.3f ms scanning, "
+           "%.3f ms tracking\n", nprocs,
+           scan_ms / rounds, tracker_ms / rounds);
+
+    fake_proc_teardown(&state);
+}
+
+int main(int argc, const char *argv[])
+{
+    int benchmark = 0;
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        { "benchmark", 0, POPT_ARG_INT, &benchmark, 0,
+          "Measure the UID queries with the given number of processes",
+          NULL },
+        POPT_TABLEEND
+    };
+
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_check_if_uid_is_active_success),
         cmocka_unit_test(test_check_if_uid_is_active_fail),
-        cmocka_unit_test(test_get_uid_table)
+        cmocka_unit_test(test_get_uid_table),
+        cmocka_unit_test_setup_teardown(test_uid_tracker_events,
+                                        fake_proc_setup,
+                                        fake_proc_teardown),
     };
 
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    if (benchmark > 0) {
+        benchmark_uid_tracker(benchmark);
+        return 0;
+    }
+
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
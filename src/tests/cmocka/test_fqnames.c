@@ -21,6 +21,7 @@
 */
 
 #include <popt.h>
+#include <sys/time.h>
 
 #include "db/sysdb_private.h"
 #include "tests/cmocka/common_mock.h"
@@ -38,6 +39,15 @@
 #define SUBDOMNAME    "subdomname"
 #define SUBFLATNAME   "subflatname"
 
+#define DEFAULT_RE  "(?P<name>[^@]+)@?(?P<domain>[^@]*$)"
+#define IPA_AD_RE   "(((?P<domain>[^\\\\]+)\\\\(?P<name>.+$))|" \
+                    "((?P<name>[^@]+)@(?P<domain>.+$))|" \
+                    "(^(?P<name>[^@\\\\]+)$))"
+
+#define DOMSID      "S-1-5-21-1-2-3"
+#define DOMSID2     "S-1-5-21-4-5-6"
+#define SUBDOMSID   "S-1-5-21-7-8-9"
+
 static struct sss_domain_info *create_test_domain(TALLOC_CTX *mem_ctx,
                                                   const char *name,
                                                   const char *flatname,
@@ -284,10 +294,7 @@ static int parse_name_test_setup(void **state)
     assert_non_null(test_ctx);
 
     /* Init with an AD-style regex to be able to test flat name */
-    ret = sss_names_init_from_args(test_ctx,
-                                   "(((?P<domain>[^\\\\]+)\\\\(?P<name>.+$))|" \
-                                   "((?P<name>[^@]+)@(?P<domain>.+$))|" \
-                                   "(^(?P<name>[^@\\\\]+)$))",
+    ret = sss_names_init_from_args(test_ctx, IPA_AD_RE,
                                    "%1$s@%2$s", &test_ctx->nctx);
     assert_int_equal(ret, EOK);
 
@@ -462,13 +469,249 @@ void sss_parse_name_fail(void **state)
     sss_parse_name_check(test_ctx, NAME"\\", ERR_REGEX_NOMATCH, NULL, NULL);
 }
 
+/* The well known expressions are split without running the regular
+ * expression. Compare the results with the same expressions prefixed with
+ * a space, which does not change their meaning in the extended syntax but
+ * forces the regular expression to be used. */
+static void compare_parse_name(TALLOC_CTX *mem_ctx,
+                               const char *re_pattern,
+                               enum sss_names_re_format exp_format,
+                               const char **inputs)
+{
+    struct sss_names_ctx *fast;
+    struct sss_names_ctx *slow;
+    char *slow_pattern;
+    char *fast_name, *fast_domain;
+    char *slow_name, *slow_domain;
+    int fast_ret, slow_ret;
+    errno_t ret;
+    int i;
+
+    ret = sss_names_init_from_args(mem_ctx, re_pattern, "%1$s@%2$s", &fast);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(fast->re_format, exp_format);
+
+    slow_pattern = talloc_asprintf(mem_ctx, " %s", re_pattern);
+    assert_non_null(slow_pattern);
+    ret = sss_names_init_from_args(mem_ctx, slow_pattern, "%1$s@%2$s", &slow);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(slow->re_format, SSS_NAMES_RE_GENERIC);
+
+    for (i = 0; inputs[i] != NULL; i++) {
+        fast_name = fast_domain = NULL;
+        slow_name = slow_domain = NULL;
+
+        fast_ret = sss_parse_name(mem_ctx, fast, inputs[i],
+                                  &fast_domain, &fast_name);
+        slow_ret = sss_parse_name(mem_ctx, slow, inputs[i],
+                                  &slow_domain, &slow_name);
+        assert_int_equal(fast_ret, slow_ret);
+        if (fast_ret != EOK) {
+            continue;
+        }
+
+        assert_string_equal(fast_name, slow_name);
+        if (slow_domain == NULL) {
+            assert_null(fast_domain);
+        } else {
+            assert_non_null(fast_domain);
+            assert_string_equal(fast_domain, slow_domain);
+        }
+
+        talloc_free(fast_name);
+        talloc_free(fast_domain);
+        talloc_free(slow_name);
+        talloc_free(slow_domain);
+    }
+
+    talloc_free(fast);
+    talloc_free(slow);
+    talloc_free(slow_pattern);
+}
+
+void parse_name_fast_path(void **state)
+{
+    struct parse_name_test_ctx *test_ctx = talloc_get_type(*state,
+                                                           struct parse_name_test_ctx);
+    const char *inputs[] = { NAME, SPECIALNAME, "", "@", "\\", "@@",
+                             NAME"@"DOMNAME, DOMNAME"\\"NAME,
+                             NAME"@", "@"NAME, NAME"\\", "\\"NAME,
+                             NAME"@"DOMNAME"@"DOMNAME2,
+                             DOMNAME"\\"NAME"@"DOMNAME2,
+                             NAME"@"DOMNAME"\\"NAME,
+                             "\\"NAME"@"DOMNAME, NAME"@"DOMNAME"\\",
+                             DOMNAME"\\\\"NAME, NAME"\n", NAME"@"DOMNAME"\n",
+                             "a b@c d", NULL };
+
+    check_leaks_push(test_ctx);
+    compare_parse_name(test_ctx, DEFAULT_RE, SSS_NAMES_RE_DEFAULT, inputs);
+    compare_parse_name(test_ctx, IPA_AD_RE, SSS_NAMES_RE_IPA_AD, inputs);
+    assert_true(check_leaks_pop(test_ctx) == true);
+}
+
+void test_domain_index(void **state)
+{
+    struct parse_name_test_ctx *test_ctx = talloc_get_type(*state,
+                                                           struct parse_name_test_ctx);
+    struct sss_domain_info *dom2 = test_ctx->dom->next;
+    struct sss_domain_info *subdom = test_ctx->subdom;
+
+    test_ctx->dom->domain_id = discard_const(DOMSID);
+    dom2->domain_id = discard_const(DOMSID2);
+    subdom->domain_id = discard_const(SUBDOMSID);
+    dom2->subdomains = subdom;
+
+    sss_domain_index_update(dom2);
+    assert_non_null(test_ctx->dom->index);
+    assert_null(dom2->index);
+
+    check_leaks_push(test_ctx);
+
+    assert_ptr_equal(find_domain_by_name(test_ctx->dom, DOMNAME2, false),
+                     dom2);
+    assert_ptr_equal(find_domain_by_name(test_ctx->dom, "DomName2", false),
+                     dom2);
+    assert_null(find_domain_by_name(test_ctx->dom, FLATNAME2, false));
+    assert_ptr_equal(find_domain_by_name(test_ctx->dom, FLATNAME2, true),
+                     dom2);
+    assert_ptr_equal(find_domain_by_name(test_ctx->dom, SUBFLATNAME, true),
+                     subdom);
+    assert_null(find_domain_by_name_ex(test_ctx->dom, SUBDOMNAME, false, 0));
+
+    /* Lookups do not return domains preceding the first one */
+    assert_null(find_domain_by_name(dom2, DOMNAME, false));
+
+    assert_ptr_equal(find_domain_by_sid(test_ctx->dom, DOMSID),
+                     test_ctx->dom);
+    assert_ptr_equal(find_domain_by_sid(test_ctx->dom, SUBDOMSID"-1000"),
+                     subdom);
+    assert_null(find_domain_by_sid(test_ctx->dom, DOMSID"1-1000"));
+    assert_null(find_domain_by_sid(test_ctx->dom, "S-1-5-21-1-2"));
+
+    /* Disabled domains are skipped unless requested */
+    sss_domain_set_state(subdom, DOM_DISABLED);
+    assert_null(find_domain_by_name(test_ctx->dom, SUBDOMNAME, false));
+    assert_ptr_equal(find_domain_by_name_ex(test_ctx->dom, SUBDOMNAME, false,
+                                            SSS_GND_ALL_DOMAINS),
+                     subdom);
+    assert_null(find_domain_by_sid(test_ctx->dom, SUBDOMSID));
+    sss_domain_set_state(subdom, DOM_ACTIVE);
+
+    /* Unlinked domains must not be found even with a stale index */
+    DLIST_REMOVE(test_ctx->dom, dom2);
+    assert_null(find_domain_by_name(test_ctx->dom, DOMNAME2, false));
+    assert_null(find_domain_by_name(test_ctx->dom, SUBDOMNAME, false));
+    assert_null(find_domain_by_sid(test_ctx->dom, DOMSID2));
+
+    /* Domains linked without updating the index are still found */
+    DLIST_ADD_END(test_ctx->dom, dom2, struct sss_domain_info *);
+    dom2->subdomains = NULL;
+    assert_null(find_domain_by_name(test_ctx->dom, SUBDOMNAME, false));
+    dom2->subdomains = subdom;
+    dom2->name = discard_const("renamed");
+    assert_ptr_equal(find_domain_by_name(test_ctx->dom, "renamed", false),
+                     dom2);
+    assert_null(find_domain_by_name(test_ctx->dom, DOMNAME2, false));
+    dom2->name = discard_const(DOMNAME2);
+
+    assert_true(check_leaks_pop(test_ctx) == true);
+
+    talloc_zfree(test_ctx->dom->index);
+}
+
+#define BENCHMARK_SUBDOMAINS 40
+
+static void benchmark_domains(int num_calls, bool use_index)
+{
+    TALLOC_CTX *mem_ctx;
+    struct sss_names_ctx *nctx;
+    struct sss_domain_info *domains = NULL;
+    struct sss_domain_info *dom;
+    struct sss_domain_info *sub;
+    const char *last_name = NULL;
+    const char *last_flat = NULL;
+    const char *last_sid = NULL;
+    char *name;
+    char *domain;
+    struct timeval start;
+    struct timeval end;
+    double elapsed;
+    errno_t ret;
+    int i;
+
+    mem_ctx = talloc_new(NULL);
+    assert_non_null(mem_ctx);
+
+    ret = sss_names_init_from_args(mem_ctx, IPA_AD_RE, "%1$s@%2$s", &nctx);
+    assert_int_equal(ret, EOK);
+
+    dom = create_test_domain(mem_ctx, DOMNAME, FLATNAME, NULL, nctx);
+    dom->domain_id = discard_const(DOMSID);
+    DLIST_ADD_END(domains, dom, struct sss_domain_info *);
+
+    for (i = 0; i < BENCHMARK_SUBDOMAINS; i++) {
+        sub = create_test_domain(dom,
+                                 talloc_asprintf(dom, "sub%d.%s", i, DOMNAME),
+                                 talloc_asprintf(dom, "SUB%d", i),
+                                 dom, nctx);
+        sub->domain_id = talloc_asprintf(sub, "S-1-5-21-100-200-%d", i);
+        DLIST_ADD_END(dom->subdomains, sub, struct sss_domain_info *);
+        last_name = sub->name;
+        last_flat = sub->flat_name;
+        last_sid = sub->domain_id;
+    }
+    assert_non_null(last_name);
+
+    if (use_index) {
+        sss_domain_index_update(domains);
+        assert_non_null(domains->index);
+    }
+
+    name = talloc_asprintf(mem_ctx, NAME"@%s", last_name);
+    assert_non_null(name);
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < num_calls; i++) {
+        ret = sss_parse_name_for_domains(NULL, domains, NULL, name,
+                                         &domain, NULL);
+        assert_int_equal(ret, EOK);
+        talloc_free(domain);
+    }
+    gettimeofday(&end, NULL);
+
+    elapsed = (end.tv_sec - start.tv_sec)
+                + (end.tv_usec - start.tv_usec) / 1000000.0;
+    printf("%d sss_parse_name_for_domains() calls, index %s: "
+           "%.3f s, %.2f us/call\n", num_calls, use_index ? "on" : "off",
+           elapsed, elapsed * 1000000.0 / num_calls);
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < num_calls; i++) {
+        assert_non_null(find_domain_by_name(domains, last_flat, true));
+        assert_non_null(find_domain_by_sid(domains, last_sid));
+    }
+    gettimeofday(&end, NULL);
+
+    elapsed = (end.tv_sec - start.tv_sec)
+                + (end.tv_usec - start.tv_usec) / 1000000.0;
+    printf("%d name and SID lookups, index %s: %.3f s, %.2f us/call\n",
+           num_calls, use_index ? "on" : "off",
+           elapsed, elapsed * 1000000.0 / num_calls);
+
+    talloc_free(mem_ctx);
+}
+
 int main(int argc, const char *argv[])
 {
     poptContext pc;
     int opt;
+    int benchmark = 0;
     struct poptOption long_options[] = {
         POPT_AUTOHELP
         SSSD_DEBUG_OPTS
+        { "benchmark", 0, POPT_ARG_INT, &benchmark, 0,
+          "Measure the time needed to parse the given number of names",
+          NULL },
         POPT_TABLEEND
     };
 
@@ -502,6 +745,12 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(sss_parse_name_fail,
                                         parse_name_test_setup,
                                         parse_name_test_teardown),
+        cmocka_unit_test_setup_teardown(parse_name_fast_path,
+                                        parse_name_test_setup,
+                                        parse_name_test_teardown),
+        cmocka_unit_test_setup_teardown(test_domain_index,
+                                        parse_name_test_setup,
+                                        parse_name_test_teardown),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
@@ -525,5 +774,11 @@ int main(int argc, const char *argv[])
      * they might not after a failed run. Remove the old DB to be sure */
     tests_set_cwd();
 
+    if (benchmark > 0) {
+        benchmark_domains(benchmark, false);
+        benchmark_domains(benchmark, true);
+        return 0;
+    }
+
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
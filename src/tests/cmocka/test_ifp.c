@@ -27,6 +27,15 @@
 #include "tests/cmocka/common_mock.h"
 #include "tests/cmocka/common_mock_resp.h"
 #include "responder/ifp/ifp_private.h"
+#include "sbus/sbus_private.h"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB "test_ifp_conf.ldb"
+#define TEST_DOM_NAME "ifp_test"
+#define TEST_ID_PROVIDER "ldap"
+
+#define TEST_USER_PATH "/org/freedesktop/sssd/infopipe/Users/ifp_5ftest/10001"
+#define TEST_GROUP_PATH "/org/freedesktop/sssd/infopipe/Groups/ifp_5ftest/10001"
 
 /* dbus library checks for valid object paths when unit testing, we don't
  * want that */
@@ -264,13 +273,288 @@ void test_attr_allowed(void **state)
     assert_false(ifp_attr_allowed(NULL, "name"));
 }
 
+struct snapshot_test_ctx {
+    struct tevent_context *ev;
+    struct ifp_ctx *ifp_ctx;
+    struct ldb_message *msg;
+};
+
+static int setup_snapshot(void **state)
+{
+    struct snapshot_test_ctx *test_ctx;
+    errno_t ret;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct snapshot_test_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->ev = tevent_context_init(test_ctx);
+    assert_non_null(test_ctx->ev);
+
+    test_ctx->ifp_ctx = talloc_zero(test_ctx, struct ifp_ctx);
+    assert_non_null(test_ctx->ifp_ctx);
+
+    test_ctx->ifp_ctx->rctx = mock_rctx(test_ctx->ifp_ctx, test_ctx->ev,
+                                        NULL, test_ctx->ifp_ctx);
+    assert_non_null(test_ctx->ifp_ctx->rctx);
+
+    ret = ifp_snapshot_init(test_ctx->ifp_ctx);
+    assert_int_equal(ret, EOK);
+
+    test_ctx->msg = ldb_msg_new(test_ctx);
+    assert_non_null(test_ctx->msg);
+
+    ret = ldb_msg_add_string(test_ctx->msg, SYSDB_NAME, "user1");
+    assert_int_equal(ret, LDB_SUCCESS);
+
+    ret = ldb_msg_add_string(test_ctx->msg, SYSDB_UIDNUM, "10001");
+    assert_int_equal(ret, LDB_SUCCESS);
+
+    /* Snapshots must not outlive the test. */
+    check_leaks_push(test_ctx->ifp_ctx);
+    *state = test_ctx;
+
+    return 0;
+}
+
+static int teardown_snapshot(void **state)
+{
+    struct snapshot_test_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(*state, struct snapshot_test_ctx);
+
+    assert_true(check_leaks_pop(test_ctx->ifp_ctx));
+    talloc_free(test_ctx);
+    assert_true(leak_check_teardown());
+
+    return 0;
+}
+
+static void assert_snapshot(struct ifp_ctx *ifp_ctx,
+                            struct sbus_request *sbus_req,
+                            const char *name)
+{
+    struct ldb_message *msg;
+    errno_t ret;
+
+    ret = ifp_snapshot_get(NULL, ifp_ctx, sbus_req, &msg);
+    if (name == NULL) {
+        assert_int_equal(ret, ENOENT);
+        return;
+    }
+
+    assert_int_equal(ret, EOK);
+    assert_string_equal(ldb_msg_find_attr_as_string(msg, SYSDB_NAME, NULL),
+                        name);
+    talloc_free(msg);
+}
+
+void test_snapshot_store(void **state)
+{
+    struct snapshot_test_ctx *test_ctx;
+    struct sbus_request user_req = { .path = TEST_USER_PATH };
+    struct sbus_request group_req = { .path = TEST_GROUP_PATH };
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct snapshot_test_ctx);
+
+    assert_snapshot(test_ctx->ifp_ctx, &user_req, NULL);
+
+    ret = ifp_snapshot_store(test_ctx->ifp_ctx, &user_req, test_ctx->msg);
+    assert_int_equal(ret, EOK);
+
+    /* The snapshot is a copy, the original message can go away. */
+    talloc_zfree(test_ctx->msg);
+
+    assert_snapshot(test_ctx->ifp_ctx, &user_req, "user1");
+    assert_snapshot(test_ctx->ifp_ctx, &user_req, "user1");
+    assert_snapshot(test_ctx->ifp_ctx, &group_req, NULL);
+
+    ifp_snapshot_invalidate(test_ctx->ifp_ctx, TEST_USER_PATH);
+    assert_snapshot(test_ctx->ifp_ctx, &user_req, NULL);
+}
+
+void test_snapshot_replace(void **state)
+{
+    struct snapshot_test_ctx *test_ctx;
+    struct sbus_request user_req = { .path = TEST_USER_PATH };
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct snapshot_test_ctx);
+
+    ret = ifp_snapshot_store(test_ctx->ifp_ctx, &user_req, test_ctx->msg);
+    assert_int_equal(ret, EOK);
+
+    ldb_msg_remove_attr(test_ctx->msg, SYSDB_NAME);
+    ret = ldb_msg_add_string(test_ctx->msg, SYSDB_NAME, "user2");
+    assert_int_equal(ret, LDB_SUCCESS);
+
+    ret = ifp_snapshot_store(test_ctx->ifp_ctx, &user_req, test_ctx->msg);
+    assert_int_equal(ret, EOK);
+
+    assert_snapshot(test_ctx->ifp_ctx, &user_req, "user2");
+    assert_int_equal(hash_count(test_ctx->ifp_ctx->snapshots), 1);
+
+    ifp_snapshot_invalidate(test_ctx->ifp_ctx, TEST_USER_PATH);
+}
+
+void test_snapshot_expire(void **state)
+{
+    struct snapshot_test_ctx *test_ctx;
+    struct sbus_request user_req = { .path = TEST_USER_PATH };
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct snapshot_test_ctx);
+
+    ret = ifp_snapshot_store(test_ctx->ifp_ctx, &user_req, test_ctx->msg);
+    assert_int_equal(ret, EOK);
+    assert_snapshot(test_ctx->ifp_ctx, &user_req, "user1");
+
+    /* Wait for the expiration timer. */
+    ret = tevent_loop_once(test_ctx->ev);
+    assert_int_equal(ret, 0);
+
+    assert_snapshot(test_ctx->ifp_ctx, &user_req, NULL);
+    assert_int_equal(hash_count(test_ctx->ifp_ctx->snapshots), 0);
+}
+
+void test_snapshot_batch(void **state)
+{
+    struct snapshot_test_ctx *test_ctx;
+    struct sbus_request batch_req = { .path = TEST_USER_PATH };
+    struct sbus_request user_req = { .path = TEST_USER_PATH };
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct snapshot_test_ctx);
+
+    batch_req.batch = sbus_request_batch_create(test_ctx);
+    assert_non_null(batch_req.batch);
+
+    ret = ifp_snapshot_store(test_ctx->ifp_ctx, &batch_req, test_ctx->msg);
+    assert_int_equal(ret, EOK);
+
+    /* The batch outlives the snapshot for the rest of GetAll. */
+    ifp_snapshot_invalidate(test_ctx->ifp_ctx, TEST_USER_PATH);
+    assert_snapshot(test_ctx->ifp_ctx, &user_req, NULL);
+    assert_snapshot(test_ctx->ifp_ctx, &batch_req, "user1");
+
+    talloc_free(batch_req.batch);
+
+    /* A new GetAll call picks up an existing snapshot. */
+    batch_req.batch = sbus_request_batch_create(test_ctx);
+    assert_non_null(batch_req.batch);
+
+    ret = ifp_snapshot_store(test_ctx->ifp_ctx, &user_req, test_ctx->msg);
+    assert_int_equal(ret, EOK);
+    assert_null(sbus_request_batch_get(&batch_req, struct ldb_message));
+
+    assert_snapshot(test_ctx->ifp_ctx, &batch_req, "user1");
+    assert_non_null(sbus_request_batch_get(&batch_req, struct ldb_message));
+
+    talloc_free(batch_req.batch);
+    ifp_snapshot_invalidate(test_ctx->ifp_ctx, TEST_USER_PATH);
+}
+
+/* Number of properties of org.freedesktop.sssd.infopipe.Users.User that
+ * require the user object. */
+#define BENCHMARK_USER_PROPERTIES 9
+
+static void benchmark_getall(int num_calls, bool snapshot)
+{
+    TALLOC_CTX *mem_ctx;
+    struct sss_test_ctx *tctx;
+    struct ifp_ctx *ifp_ctx;
+    struct sbus_request sbus_req = { .path = TEST_USER_PATH };
+    struct ldb_result *res;
+    struct ldb_message *msg;
+    struct timeval start;
+    struct timeval end;
+    double elapsed;
+    int i;
+    int j;
+    errno_t ret;
+
+    mem_ctx = talloc_new(NULL);
+    assert_non_null(mem_ctx);
+
+    test_dom_suite_setup(TESTS_PATH);
+
+    tctx = create_dom_test_ctx(mem_ctx, TESTS_PATH, TEST_CONF_DB,
+                               TEST_DOM_NAME, TEST_ID_PROVIDER, NULL);
+    assert_non_null(tctx);
+
+    ret = sysdb_add_user(tctx->dom, "user1@" TEST_DOM_NAME, 10001, 10001,
+                         "User One", "/home/user1", "/bin/sh", NULL, NULL,
+                         0, 0);
+    assert_int_equal(ret, EOK);
+
+    ifp_ctx = talloc_zero(mem_ctx, struct ifp_ctx);
+    assert_non_null(ifp_ctx);
+
+    ifp_ctx->rctx = mock_rctx(ifp_ctx, tctx->ev, tctx->dom, ifp_ctx);
+    assert_non_null(ifp_ctx->rctx);
+
+    if (snapshot) {
+        ret = ifp_snapshot_init(ifp_ctx);
+        assert_int_equal(ret, EOK);
+    }
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < num_calls; i++) {
+        /* Every page view is a new GetAll call that starts with
+         * an empty batch and without the short-lived snapshot. */
+        if (snapshot) {
+            sbus_req.batch = sbus_request_batch_create(mem_ctx);
+            assert_non_null(sbus_req.batch);
+        }
+
+        for (j = 0; j < BENCHMARK_USER_PROPERTIES; j++) {
+            ret = snapshot ? ifp_snapshot_get(NULL, ifp_ctx, &sbus_req, &msg)
+                           : ENOENT;
+            if (ret == ENOENT) {
+                ret = sysdb_getpwuid_with_views(NULL, tctx->dom, 10001, &res);
+                assert_int_equal(ret, EOK);
+                assert_int_equal(res->count, 1);
+                msg = talloc_steal(NULL, res->msgs[0]);
+                talloc_free(res);
+
+                if (snapshot) {
+                    ret = ifp_snapshot_store(ifp_ctx, &sbus_req, msg);
+                }
+            }
+            assert_int_equal(ret, EOK);
+            talloc_free(msg);
+        }
+
+        if (snapshot) {
+            ifp_snapshot_invalidate(ifp_ctx, TEST_USER_PATH);
+            talloc_zfree(sbus_req.batch);
+        }
+    }
+    gettimeofday(&end, NULL);
+
+    elapsed = (end.tv_sec - start.tv_sec)
+                + (end.tv_usec - start.tv_usec) / 1000000.0;
+    printf("%d GetAll calls, snapshot %s: %.3f s, %.1f us/call\n",
+           num_calls, snapshot ? "on" : "off",
+           elapsed, elapsed * 1000000.0 / num_calls);
+
+    talloc_free(mem_ctx);
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+}
+
 int main(int argc, const char *argv[])
 {
     poptContext pc;
     int opt;
+    int benchmark = 0;
     struct poptOption long_options[] = {
         POPT_AUTOHELP
         SSSD_DEBUG_OPTS
+        { "benchmark", 0, POPT_ARG_INT, &benchmark, 0,
+          "Measure the time needed to serve the given number of GetAll calls",
+          NULL },
         POPT_TABLEEND
     };
 
@@ -279,6 +563,18 @@ int main(int argc, const char *argv[])
         cmocka_unit_test(test_attr_acl),
         cmocka_unit_test(test_attr_acl_ex),
         cmocka_unit_test(test_attr_allowed),
+        cmocka_unit_test_setup_teardown(test_snapshot_store,
+                                        setup_snapshot,
+                                        teardown_snapshot),
+        cmocka_unit_test_setup_teardown(test_snapshot_replace,
+                                        setup_snapshot,
+                                        teardown_snapshot),
+        cmocka_unit_test_setup_teardown(test_snapshot_expire,
+                                        setup_snapshot,
+                                        teardown_snapshot),
+        cmocka_unit_test_setup_teardown(test_snapshot_batch,
+                                        setup_snapshot,
+                                        teardown_snapshot),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
@@ -302,5 +598,11 @@ int main(int argc, const char *argv[])
      * they might not after a failed run. Remove the old DB to be sure */
     tests_set_cwd();
 
+    if (benchmark > 0) {
+        benchmark_getall(benchmark, false);
+        benchmark_getall(benchmark, true);
+        return 0;
+    }
+
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
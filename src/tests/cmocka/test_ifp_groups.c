@@ -0,0 +1,494 @@
+/*
+    SSSD
+
+    InfoPipe responder - resolving ghost members of groups
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <popt.h>
+
+#include "db/sysdb.h"
+#include "tests/cmocka/common_mock.h"
+#include "tests/cmocka/common_mock_resp.h"
+#include "responder/ifp/ifp_private.h"
+
+/* Include source file to test the static functions */
+#include "responder/ifp/ifp_groups.c"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB "test_ifp_groups_conf.ldb"
+#define TEST_DOM_NAME "ifp_groups_test"
+#define TEST_ID_PROVIDER "ldap"
+
+#define TEST_GROUP_NAME "group1@" TEST_DOM_NAME
+#define TEST_GROUP_GID 10000
+#define TEST_MAX_GHOSTS 16
+
+/* Ghost members with this prefix are not found by the lookup, members
+ * with the BROKEN prefix fail with EIO. Everything else is resolved. */
+#define MISSING_PREFIX "missing"
+#define BROKEN_PREFIX "broken"
+
+/* The rest of the module is not tested here. */
+errno_t
+ifp_cache_list(TALLOC_CTX *mem_ctx,
+               struct ifp_ctx *ifp_ctx,
+               enum ifp_cache_type type,
+               const char ***_paths)
+{
+    return ENOSYS;
+}
+
+errno_t
+ifp_cache_list_by_domain(TALLOC_CTX *mem_ctx,
+                         struct ifp_ctx *ifp_ctx,
+                         const char *domainname,
+                         enum ifp_cache_type type,
+                         const char ***_paths)
+{
+    return ENOSYS;
+}
+
+errno_t
+ifp_cache_object_store(struct sss_domain_info *domain,
+                       struct ldb_dn *dn)
+{
+    return ENOSYS;
+}
+
+errno_t
+ifp_cache_object_remove(struct sss_domain_info *domain,
+                        struct ldb_dn *dn)
+{
+    return ENOSYS;
+}
+
+char *ifp_users_build_path_from_msg(TALLOC_CTX *mem_ctx,
+                                    struct sss_domain_info *domain,
+                                    struct ldb_message *msg)
+{
+    return NULL;
+}
+
+struct ghosts_test_ctx {
+    struct sss_test_ctx *tctx;
+    struct ifp_ctx *ifp_ctx;
+    struct sbus_request sbus_req;
+
+    const char *looked_up[TEST_MAX_GHOSTS];
+    int num_looked_up;
+    int num_resolved;
+    int active;
+    int max_active;
+};
+
+static struct ghosts_test_ctx *ghosts_test_ctx;
+
+struct fake_lookup_state {
+    errno_t ret;
+};
+
+static void fake_lookup_finish(struct tevent_context *ev,
+                               struct tevent_timer *te,
+                               struct timeval tv,
+                               void *pvt)
+{
+    struct fake_lookup_state *state;
+    struct tevent_req *req;
+
+    req = talloc_get_type(pvt, struct tevent_req);
+    state = tevent_req_data(req, struct fake_lookup_state);
+
+    ghosts_test_ctx->active--;
+
+    if (state->ret != EOK) {
+        tevent_req_error(req, state->ret);
+        return;
+    }
+
+    ghosts_test_ctx->num_resolved++;
+    tevent_req_done(req);
+}
+
+struct tevent_req *
+__wrap_cache_req_group_by_name_send(TALLOC_CTX *mem_ctx,
+                                    struct tevent_context *ev,
+                                    struct resp_ctx *rctx,
+                                    struct sss_nc_ctx *ncache,
+                                    int cache_refresh_percent,
+                                    enum cache_req_dom_type req_dom_type,
+                                    const char *domain,
+                                    const char *name)
+{
+    struct fake_lookup_state *state;
+    struct tevent_req *req;
+
+    req = tevent_req_create(mem_ctx, &state, struct fake_lookup_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    assert_string_equal(name, TEST_GROUP_NAME);
+
+    tevent_req_done(req);
+    tevent_req_post(req, ev);
+
+    return req;
+}
+
+struct tevent_req *
+__wrap_cache_req_user_by_name_send(TALLOC_CTX *mem_ctx,
+                                   struct tevent_context *ev,
+                                   struct resp_ctx *rctx,
+                                   struct sss_nc_ctx *ncache,
+                                   int cache_refresh_percent,
+                                   enum cache_req_dom_type req_dom_type,
+                                   const char *domain,
+                                   const char *name)
+{
+    struct fake_lookup_state *state;
+    struct tevent_timer *te;
+    struct tevent_req *req;
+
+    req = tevent_req_create(mem_ctx, &state, struct fake_lookup_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    if (strncmp(name, MISSING_PREFIX, sizeof(MISSING_PREFIX) - 1) == 0) {
+        state->ret = ENOENT;
+    } else if (strncmp(name, BROKEN_PREFIX, sizeof(BROKEN_PREFIX) - 1) == 0) {
+        state->ret = EIO;
+    } else {
+        state->ret = EOK;
+    }
+
+    assert_true(ghosts_test_ctx->num_looked_up < TEST_MAX_GHOSTS);
+    ghosts_test_ctx->looked_up[ghosts_test_ctx->num_looked_up] = name;
+    ghosts_test_ctx->num_looked_up++;
+
+    ghosts_test_ctx->active++;
+    if (ghosts_test_ctx->active > ghosts_test_ctx->max_active) {
+        ghosts_test_ctx->max_active = ghosts_test_ctx->active;
+    }
+
+    /* Finish the lookups asynchronously so they can overlap. */
+    te = tevent_add_timer(ev, req, tevent_timeval_current_ofs(0, 10),
+                          fake_lookup_finish, req);
+    if (te == NULL) {
+        talloc_free(req);
+        return NULL;
+    }
+
+    return req;
+}
+
+errno_t __wrap_cache_req_single_domain_recv(TALLOC_CTX *mem_ctx,
+                                            struct tevent_req *req,
+                                            struct cache_req_result **_result)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    if (_result != NULL) {
+        *_result = NULL;
+    }
+
+    return EOK;
+}
+
+static int test_resolv_ghosts_setup(void **state)
+{
+    struct ghosts_test_ctx *test_ctx;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct ghosts_test_ctx);
+    assert_non_null(test_ctx);
+
+    test_dom_suite_setup(TESTS_PATH);
+
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, TEST_ID_PROVIDER,
+                                         NULL);
+    assert_non_null(test_ctx->tctx);
+
+    test_ctx->ifp_ctx = talloc_zero(test_ctx, struct ifp_ctx);
+    assert_non_null(test_ctx->ifp_ctx);
+
+    test_ctx->ifp_ctx->rctx = mock_rctx(test_ctx->ifp_ctx, test_ctx->tctx->ev,
+                                        test_ctx->tctx->dom,
+                                        test_ctx->ifp_ctx);
+    assert_non_null(test_ctx->ifp_ctx->rctx);
+
+    test_ctx->sbus_req.path = talloc_asprintf(test_ctx, "%u", TEST_GROUP_GID);
+    assert_non_null(test_ctx->sbus_req.path);
+    test_ctx->sbus_req.path = sbus_opath_compose(test_ctx, IFP_PATH_GROUPS,
+                                                 TEST_DOM_NAME,
+                                                 test_ctx->sbus_req.path);
+    assert_non_null(test_ctx->sbus_req.path);
+
+    ghosts_test_ctx = test_ctx;
+    *state = test_ctx;
+
+    return 0;
+}
+
+static int test_resolv_ghosts_teardown(void **state)
+{
+    struct ghosts_test_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(*state, struct ghosts_test_ctx);
+
+    ghosts_test_ctx = NULL;
+    talloc_free(test_ctx);
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    assert_true(leak_check_teardown());
+
+    return 0;
+}
+
+static void store_group(struct ghosts_test_ctx *test_ctx,
+                        const char **ghosts)
+{
+    struct sysdb_attrs *attrs;
+    errno_t ret;
+    int i;
+
+    attrs = sysdb_new_attrs(test_ctx);
+    assert_non_null(attrs);
+
+    for (i = 0; ghosts[i] != NULL; i++) {
+        ret = sysdb_attrs_add_string(attrs, SYSDB_GHOST, ghosts[i]);
+        assert_int_equal(ret, EOK);
+    }
+
+    ret = sysdb_add_group(test_ctx->tctx->dom, TEST_GROUP_NAME,
+                          TEST_GROUP_GID, attrs, 0, 0);
+    assert_int_equal(ret, EOK);
+
+    talloc_free(attrs);
+}
+
+static void test_resolv_ghosts_done(struct tevent_req *req)
+{
+    struct ghosts_test_ctx *test_ctx;
+    errno_t ret;
+
+    test_ctx = tevent_req_callback_data(req, struct ghosts_test_ctx);
+
+    ret = resolv_ghosts_recv(req);
+    talloc_zfree(req);
+
+    test_ev_done(test_ctx->tctx, ret);
+}
+
+static errno_t run_resolv_ghosts(struct ghosts_test_ctx *test_ctx,
+                                 int concurrency,
+                                 int limit)
+{
+    struct tevent_req *req;
+
+    test_ctx->ifp_ctx->resolve_members_concurrency = concurrency;
+    test_ctx->ifp_ctx->resolve_members_limit = limit;
+
+    req = resolv_ghosts_send(test_ctx, test_ctx->tctx->ev,
+                             &test_ctx->sbus_req, test_ctx->ifp_ctx);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_resolv_ghosts_done, test_ctx);
+
+    return test_ev_loop(test_ctx->tctx);
+}
+
+void test_resolv_ghosts_sequential(void **state)
+{
+    struct ghosts_test_ctx *test_ctx;
+    const char *ghosts[] = { "user1", "user2", "user3", NULL };
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ghosts_test_ctx);
+    store_group(test_ctx, ghosts);
+
+    ret = run_resolv_ghosts(test_ctx, 1, 0);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->num_looked_up, 3);
+    assert_int_equal(test_ctx->num_resolved, 3);
+    assert_int_equal(test_ctx->max_active, 1);
+    assert_string_equal(test_ctx->looked_up[0], "user1");
+    assert_string_equal(test_ctx->looked_up[1], "user2");
+    assert_string_equal(test_ctx->looked_up[2], "user3");
+}
+
+void test_resolv_ghosts_concurrency(void **state)
+{
+    struct ghosts_test_ctx *test_ctx;
+    const char *ghosts[] = { "user1", "user2", "user3", "user4", "user5",
+                             "user6", "user7", "user8", "user9", "user10",
+                             NULL };
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ghosts_test_ctx);
+    store_group(test_ctx, ghosts);
+
+    ret = run_resolv_ghosts(test_ctx, 3, 0);
+    assert_int_equal(ret, EOK);
+
+    /* All members are resolved but never more than 3 at once. */
+    assert_int_equal(test_ctx->num_looked_up, 10);
+    assert_int_equal(test_ctx->num_resolved, 10);
+    assert_int_equal(test_ctx->max_active, 3);
+    assert_int_equal(test_ctx->active, 0);
+}
+
+void test_resolv_ghosts_limit(void **state)
+{
+    struct ghosts_test_ctx *test_ctx;
+    const char *ghosts[] = { "user1", "user2", "user3", "user4", "user5",
+                             "user6", "user7", "user8", "user9", "user10",
+                             NULL };
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ghosts_test_ctx);
+    store_group(test_ctx, ghosts);
+
+    ret = run_resolv_ghosts(test_ctx, 3, 4);
+    assert_int_equal(ret, EOK);
+
+    /* No lookup is started beyond the limit even with free slots. */
+    assert_int_equal(test_ctx->num_looked_up, 4);
+    assert_int_equal(test_ctx->num_resolved, 4);
+    assert_int_equal(test_ctx->max_active, 3);
+}
+
+void test_resolv_ghosts_limit_skip_missing(void **state)
+{
+    struct ghosts_test_ctx *test_ctx;
+    const char *ghosts[] = { MISSING_PREFIX "1", MISSING_PREFIX "2",
+                             "user1", "user2", "user3", "user4", NULL };
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ghosts_test_ctx);
+    store_group(test_ctx, ghosts);
+
+    ret = run_resolv_ghosts(test_ctx, 1, 2);
+    assert_int_equal(ret, EOK);
+
+    /* Members that are not found stay at the head of the list, they must
+     * not use up the limit or the rest would never be resolved. */
+    assert_int_equal(test_ctx->num_looked_up, 4);
+    assert_int_equal(test_ctx->num_resolved, 2);
+    assert_string_equal(test_ctx->looked_up[0], MISSING_PREFIX "1");
+    assert_string_equal(test_ctx->looked_up[1], MISSING_PREFIX "2");
+    assert_string_equal(test_ctx->looked_up[2], "user1");
+    assert_string_equal(test_ctx->looked_up[3], "user2");
+
+    /* The next call walks the same list and reaches the same members. */
+    test_ctx->num_looked_up = 0;
+    test_ctx->num_resolved = 0;
+
+    ret = run_resolv_ghosts(test_ctx, 2, 2);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(test_ctx->num_resolved, 2);
+}
+
+void test_resolv_ghosts_error(void **state)
+{
+    struct ghosts_test_ctx *test_ctx;
+    const char *ghosts[] = { "user1", BROKEN_PREFIX "1", "user2", "user3",
+                             NULL };
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ghosts_test_ctx);
+    store_group(test_ctx, ghosts);
+
+    ret = run_resolv_ghosts(test_ctx, 1, 0);
+    assert_int_equal(ret, EIO);
+
+    /* Lookup errors other than ENOENT stop the whole request. */
+    assert_int_equal(test_ctx->num_looked_up, 2);
+    assert_int_equal(test_ctx->num_resolved, 1);
+}
+
+void test_resolv_ghosts_no_ghosts(void **state)
+{
+    struct ghosts_test_ctx *test_ctx;
+    const char *ghosts[] = { NULL };
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ghosts_test_ctx);
+    store_group(test_ctx, ghosts);
+
+    ret = run_resolv_ghosts(test_ctx, 3, 2);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(test_ctx->num_looked_up, 0);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_resolv_ghosts_sequential,
+                                        test_resolv_ghosts_setup,
+                                        test_resolv_ghosts_teardown),
+        cmocka_unit_test_setup_teardown(test_resolv_ghosts_concurrency,
+                                        test_resolv_ghosts_setup,
+                                        test_resolv_ghosts_teardown),
+        cmocka_unit_test_setup_teardown(test_resolv_ghosts_limit,
+                                        test_resolv_ghosts_setup,
+                                        test_resolv_ghosts_teardown),
+        cmocka_unit_test_setup_teardown(test_resolv_ghosts_limit_skip_missing,
+                                        test_resolv_ghosts_setup,
+                                        test_resolv_ghosts_teardown),
+        cmocka_unit_test_setup_teardown(test_resolv_ghosts_error,
+                                        test_resolv_ghosts_setup,
+                                        test_resolv_ghosts_teardown),
+        cmocka_unit_test_setup_teardown(test_resolv_ghosts_no_ghosts,
+                                        test_resolv_ghosts_setup,
+                                        test_resolv_ghosts_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    /* Even though normally the tests should clean up after themselves
+     * they might not after a failed run. Remove the old DB to be sure */
+    tests_set_cwd();
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -30,6 +30,7 @@
 #define INVALID_ID      -1
 #define FAST_REQ_ID     0
 #define SLOW_REQ_ID     1
+#define WRITE_REQ_ID    2
 
 #define FAST_REQ_DELAY  1
 #define SLOW_REQ_DELAY  2
@@ -55,7 +56,8 @@ static struct tevent_req *timed_request_send(TALLOC_CTX *mem_ctx,
                                              struct kcm_ops_queue_ctx *qctx,
                                              struct cli_creds *client,
                                              int delay,
-                                             int req_id)
+                                             int req_id,
+                                             bool readonly)
 {
     struct tevent_req *req;
     struct tevent_req *subreq;
@@ -73,7 +75,7 @@ static struct tevent_req *timed_request_send(TALLOC_CTX *mem_ctx,
 
     DEBUG(SSSDBG_TRACE_ALL, "Request %p with delay %d\n", req, delay);
 
-    subreq = kcm_op_queue_send(state, ev, qctx, client);
+    subreq = kcm_op_queue_send(state, ev, qctx, client, readonly);
     if (subreq == NULL) {
         return NULL;
     }
@@ -211,7 +213,7 @@ static void test_kcm_queue_single(void **state)
     req = timed_request_send(test_ctx,
                              test_ctx->ev,
                              test_ctx->qctx,
-                             &client, 1, 0);
+                             &client, 1, 0, false);
     assert_non_null(req);
     tevent_req_set_callback(req, test_kcm_queue_done, test_ctx);
 
@@ -245,7 +247,8 @@ static void test_kcm_queue_multi_same_id(void **state)
                              test_ctx->qctx,
                              &client,
                              SLOW_REQ_DELAY,
-                             SLOW_REQ_ID);
+                             SLOW_REQ_ID,
+                             false);
     assert_non_null(req);
     tevent_req_set_callback(req, test_kcm_queue_done, test_ctx);
 
@@ -254,7 +257,8 @@ static void test_kcm_queue_multi_same_id(void **state)
                              test_ctx->qctx,
                              &client,
                              FAST_REQ_DELAY,
-                             FAST_REQ_ID);
+                             FAST_REQ_ID,
+                             false);
     assert_non_null(req);
     tevent_req_set_callback(req, test_kcm_queue_done, test_ctx);
 
@@ -290,7 +294,8 @@ static void test_kcm_queue_multi_different_id(void **state)
                              test_ctx->qctx,
                              &client,
                              SLOW_REQ_DELAY,
-                             SLOW_REQ_ID);
+                             SLOW_REQ_ID,
+                             false);
     assert_non_null(req);
     tevent_req_set_callback(req, test_kcm_queue_done, test_ctx);
 
@@ -302,7 +307,8 @@ static void test_kcm_queue_multi_different_id(void **state)
                              test_ctx->qctx,
                              &client,
                              FAST_REQ_DELAY,
-                             FAST_REQ_ID);
+                             FAST_REQ_ID,
+                             false);
     assert_non_null(req);
     tevent_req_set_callback(req, test_kcm_queue_done, test_ctx);
 
@@ -315,6 +321,117 @@ static void test_kcm_queue_multi_different_id(void **state)
     assert_int_equal(test_ctx->error, EOK);
 }
 
+/*
+ * Test that read-only requests from the same ID run concurrently
+ */
+static void test_kcm_queue_multi_readonly(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type(*state, struct test_ctx);
+    struct tevent_req *req;
+    struct cli_creds client;
+    struct kcm_ops_queue_stats stats;
+    static int req_ids[] = { FAST_REQ_ID, SLOW_REQ_ID };
+
+    client.ucred.uid = getuid();
+    client.ucred.gid = getgid();
+
+    req = timed_request_send(test_ctx,
+                             test_ctx->ev,
+                             test_ctx->qctx,
+                             &client,
+                             SLOW_REQ_DELAY,
+                             SLOW_REQ_ID,
+                             true);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_kcm_queue_done, test_ctx);
+
+    req = timed_request_send(test_ctx,
+                             test_ctx->ev,
+                             test_ctx->qctx,
+                             &client,
+                             FAST_REQ_DELAY,
+                             FAST_REQ_ID,
+                             true);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_kcm_queue_done, test_ctx);
+
+    test_ctx->num_requests = 2;
+    test_ctx->req_ids = req_ids;
+
+    while (test_ctx->done == false) {
+        tevent_loop_once(test_ctx->ev);
+    }
+    assert_int_equal(test_ctx->error, EOK);
+
+    kcm_ops_queue_get_stats(test_ctx->qctx, &stats);
+    assert_int_equal(stats.queued, 2);
+    assert_int_equal(stats.immediate, 2);
+    assert_int_equal(stats.waited, 0);
+    assert_int_equal(stats.max_depth, 2);
+}
+
+/*
+ * Test that a read-only request does not overtake a mutating request
+ * enqueued before it and that the mutating request waits for the
+ * read-only requests in front of it
+ */
+static void test_kcm_queue_readonly_after_write(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type(*state, struct test_ctx);
+    struct tevent_req *req;
+    struct cli_creds client;
+    struct kcm_ops_queue_stats stats;
+    static int req_ids[] = { SLOW_REQ_ID, WRITE_REQ_ID, FAST_REQ_ID };
+
+    client.ucred.uid = getuid();
+    client.ucred.gid = getgid();
+
+    req = timed_request_send(test_ctx,
+                             test_ctx->ev,
+                             test_ctx->qctx,
+                             &client,
+                             SLOW_REQ_DELAY,
+                             SLOW_REQ_ID,
+                             true);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_kcm_queue_done, test_ctx);
+
+    req = timed_request_send(test_ctx,
+                             test_ctx->ev,
+                             test_ctx->qctx,
+                             &client,
+                             FAST_REQ_DELAY,
+                             WRITE_REQ_ID,
+                             false);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_kcm_queue_done, test_ctx);
+
+    req = timed_request_send(test_ctx,
+                             test_ctx->ev,
+                             test_ctx->qctx,
+                             &client,
+                             FAST_REQ_DELAY,
+                             FAST_REQ_ID,
+                             true);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_kcm_queue_done, test_ctx);
+
+    test_ctx->num_requests = 3;
+    test_ctx->req_ids = req_ids;
+
+    while (test_ctx->done == false) {
+        tevent_loop_once(test_ctx->ev);
+    }
+    assert_int_equal(test_ctx->error, EOK);
+
+    kcm_ops_queue_get_stats(test_ctx->qctx, &stats);
+    assert_int_equal(stats.queued, 3);
+    assert_int_equal(stats.immediate, 1);
+    assert_int_equal(stats.waited, 2);
+    assert_int_equal(stats.max_depth, 3);
+    assert_true(stats.wait_time_max_ms >= SLOW_REQ_DELAY * 1000);
+}
+
 int main(int argc, const char *argv[])
 {
     poptContext pc;
@@ -336,6 +453,12 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_kcm_queue_multi_different_id,
                                         setup_kcm_queue,
                                         teardown_kcm_queue),
+        cmocka_unit_test_setup_teardown(test_kcm_queue_multi_readonly,
+                                        setup_kcm_queue,
+                                        teardown_kcm_queue),
+        cmocka_unit_test_setup_teardown(test_kcm_queue_readonly_after_write,
+                                        setup_kcm_queue,
+                                        teardown_kcm_queue),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
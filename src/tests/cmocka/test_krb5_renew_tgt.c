@@ -0,0 +1,389 @@
+/*
+    Copyright (C) 2026 Red Hat
+
+    SSSD tests: Kerberos TGT renewal queue tests
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <tevent.h>
+#include <errno.h>
+#include <popt.h>
+#include <stdlib.h>
+#include <security/pam_modules.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "tests/cmocka/common_mock_be.h"
+
+/* Include source file to test the static functions */
+#include "providers/krb5/krb5_renew_tgt.c"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB "test_krb5_renew_tgt_conf.ldb"
+#define TEST_DOM_NAME "krb5_renew_tgt_test"
+#define TEST_ID_PROVIDER "ldap"
+
+#define TEST_RENEW_INTERVAL 3600
+#define TEST_MAX_RENEWALS 10
+
+struct test_krb5_renew_tgt {
+    struct sss_test_ctx *tctx;
+    struct be_ctx *be_ctx;
+    struct krb5_ctx *krb5_ctx;
+    time_t now;
+
+    /* result of the renewal requests */
+    int pam_status;
+    /* users in the order their tickets were renewed */
+    const char *renewed[TEST_MAX_RENEWALS];
+    size_t num_renewed;
+    size_t num_expected;
+};
+
+static struct test_krb5_renew_tgt *test_ctx;
+
+struct tevent_req *__wrap_krb5_auth_queue_send(TALLOC_CTX *mem_ctx,
+                                               struct tevent_context *ev,
+                                               struct be_ctx *be_ctx,
+                                               struct pam_data *pd,
+                                               struct krb5_ctx *krb5_ctx)
+{
+    struct tevent_req *req;
+    void *state;
+
+    assert_int_equal(pd->cmd, SSS_CMD_RENEW);
+    assert_true(test_ctx->num_renewed < TEST_MAX_RENEWALS);
+
+    test_ctx->renewed[test_ctx->num_renewed] = talloc_strdup(test_ctx,
+                                                             pd->user);
+    assert_non_null(test_ctx->renewed[test_ctx->num_renewed]);
+    test_ctx->num_renewed++;
+
+    req = tevent_req_create(mem_ctx, &state, void *);
+    assert_non_null(req);
+
+    tevent_req_done(req);
+    tevent_req_post(req, ev);
+    return req;
+}
+
+int __wrap_krb5_auth_queue_recv(struct tevent_req *req,
+                                int *_pam_status,
+                                int *_dp_err)
+{
+    *_pam_status = test_ctx->pam_status;
+    *_dp_err = DP_ERR_OK;
+
+    if (test_ctx->num_renewed == test_ctx->num_expected) {
+        test_ev_done(test_ctx->tctx, EOK);
+    }
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+    return EOK;
+}
+
+static void add_tgt(const char *user, time_t renew_at)
+{
+    struct tgt_times tgtt = { 0 };
+    struct pam_data *pd;
+    const char *ccfile;
+    errno_t ret;
+
+    pd = create_pam_data(test_ctx);
+    assert_non_null(pd);
+
+    pd->cmd = SSS_PAM_AUTHENTICATE;
+    pd->user = talloc_strdup(pd, user);
+    assert_non_null(pd->user);
+
+    ccfile = talloc_asprintf(pd, "KEYRING:persistent:%s", user);
+    assert_non_null(ccfile);
+
+    /* The renewal starts in the middle of the ticket lifetime. The lifetime
+     * is short enough for the random offset to be always zero. */
+    tgtt.starttime = renew_at - 10;
+    tgtt.endtime = renew_at + 10;
+    tgtt.renew_till = renew_at + 1000;
+
+    ret = add_tgt_to_renew_table(test_ctx->krb5_ctx, ccfile, &tgtt, pd, user);
+    assert_int_equal(ret, EOK);
+
+    talloc_free(pd);
+}
+
+static void del_tgt(const char *user)
+{
+    hash_key_t key;
+    int ret;
+
+    key.type = HASH_KEY_STRING;
+    key.str = discard_const_p(char, user);
+
+    ret = hash_delete(test_ctx->krb5_ctx->renew_tgt_ctx->tgt_table, &key);
+    assert_int_equal(ret, HASH_SUCCESS);
+}
+
+static void assert_first(const char *user, time_t renew_at)
+{
+    struct renew_data *first;
+
+    first = renew_queue_first(test_ctx->krb5_ctx->renew_tgt_ctx);
+    assert_non_null(first);
+    assert_string_equal(first->upn, user);
+    assert_int_equal(first->start_renew_at, renew_at);
+}
+
+/* Take the items out of the queue, they must come in the given order */
+static void assert_queue(const char **users)
+{
+    struct renew_tgt_ctx *renew_tgt_ctx = test_ctx->krb5_ctx->renew_tgt_ctx;
+    struct renew_data *first;
+    size_t i;
+
+    for (i = 0; users[i] != NULL; i++) {
+        first = renew_queue_first(renew_tgt_ctx);
+        assert_non_null(first);
+        assert_string_equal(first->upn, users[i]);
+        renew_queue_remove(first);
+        assert_int_equal(first->queue_idx, RENEW_NOT_QUEUED);
+    }
+
+    assert_null(renew_queue_first(renew_tgt_ctx));
+    assert_int_equal(renew_tgt_ctx->queue_len, 0);
+}
+
+static int test_krb5_renew_tgt_setup(void **state)
+{
+    errno_t ret;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context,
+                           struct test_krb5_renew_tgt);
+    assert_non_null(test_ctx);
+
+    test_dom_suite_setup(TESTS_PATH);
+
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, TEST_ID_PROVIDER,
+                                         NULL);
+    assert_non_null(test_ctx->tctx);
+
+    test_ctx->be_ctx = mock_be_ctx(test_ctx, test_ctx->tctx);
+    assert_non_null(test_ctx->be_ctx);
+
+    test_ctx->krb5_ctx = talloc_zero(test_ctx, struct krb5_ctx);
+    assert_non_null(test_ctx->krb5_ctx);
+
+    test_ctx->now = time(NULL);
+
+    ret = init_renew_tgt(test_ctx->krb5_ctx, test_ctx->be_ctx,
+                         test_ctx->tctx->ev, TEST_RENEW_INTERVAL);
+    assert_int_equal(ret, EOK);
+
+    test_ctx->pam_status = PAM_SUCCESS;
+
+    *state = test_ctx;
+    return 0;
+}
+
+static int test_krb5_renew_tgt_teardown(void **state)
+{
+    talloc_zfree(test_ctx);
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+void test_krb5_renew_tgt_order(void **state)
+{
+    time_t now = test_ctx->now;
+    const char *expected[] = { "u10", "u20", "u40", "u50", "u60", "u70",
+                               NULL };
+
+    add_tgt("u70", now + 70);
+    add_tgt("u10", now + 10);
+    add_tgt("u50", now + 50);
+    add_tgt("u30", now + 30);
+    add_tgt("u60", now + 60);
+    add_tgt("u20", now + 20);
+    add_tgt("u40", now + 40);
+
+    assert_int_equal(test_ctx->krb5_ctx->renew_tgt_ctx->queue_len, 7);
+    assert_first("u10", now + 10);
+
+    /* removing an item from the table takes it out of the queue */
+    del_tgt("u30");
+    assert_int_equal(test_ctx->krb5_ctx->renew_tgt_ctx->queue_len, 6);
+
+    assert_queue(expected);
+}
+
+void test_krb5_renew_tgt_replace(void **state)
+{
+    time_t now = test_ctx->now;
+    const char *expected[] = { "u20", "u10", NULL };
+
+    add_tgt("u10", now + 10);
+    add_tgt("u20", now + 20);
+
+    /* a new ticket for the same user replaces the old one */
+    add_tgt("u10", now + 30);
+    assert_int_equal(test_ctx->krb5_ctx->renew_tgt_ctx->queue_len, 2);
+
+    assert_queue(expected);
+}
+
+void test_krb5_renew_tgt_reschedule(void **state)
+{
+    struct renew_tgt_ctx *renew_tgt_ctx = test_ctx->krb5_ctx->renew_tgt_ctx;
+    time_t now = test_ctx->now;
+
+    /* nothing to renew, check every renewal interval */
+    assert_non_null(renew_tgt_ctx->te);
+    assert_true(renew_tgt_ctx->te_due >= now + TEST_RENEW_INTERVAL);
+
+    /* an earlier ticket moves the timer */
+    add_tgt("u100", now + 100);
+    assert_int_equal(renew_tgt_ctx->te_due, now + 100);
+
+    add_tgt("u50", now + 50);
+    assert_int_equal(renew_tgt_ctx->te_due, now + 50);
+
+    /* a later one does not */
+    add_tgt("u200", now + 200);
+    assert_int_equal(renew_tgt_ctx->te_due, now + 50);
+
+    /* the timer stays disabled while offline */
+    renew_tgt_offline_callback(renew_tgt_ctx);
+    assert_null(renew_tgt_ctx->te);
+
+    add_tgt("u10", now + 10);
+    assert_null(renew_tgt_ctx->te);
+    assert_first("u10", now + 10);
+}
+
+void test_krb5_renew_tgt_renew_due(void **state)
+{
+    struct renew_tgt_ctx *renew_tgt_ctx = test_ctx->krb5_ctx->renew_tgt_ctx;
+    time_t now = test_ctx->now;
+    errno_t ret;
+
+    add_tgt("future", now + 100);
+    add_tgt("due", now - 20);
+    add_tgt("overdue", now - 40);
+
+    /* the timer fires right away for the tickets which are already due */
+    test_ctx->num_expected = 2;
+    ret = test_ev_loop(test_ctx->tctx);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->num_renewed, 2);
+    assert_string_equal(test_ctx->renewed[0], "overdue");
+    assert_string_equal(test_ctx->renewed[1], "due");
+
+    assert_int_equal(renew_tgt_ctx->stats.renewals, 2);
+    assert_true(renew_tgt_ctx->stats.lag_max >= 40);
+
+    /* the renewed tickets were not added again and are forgotten */
+    assert_int_equal(renew_tgt_ctx->queue_len, 1);
+    assert_first("future", now + 100);
+    assert_int_equal(renew_tgt_ctx->te_due, now + 100);
+}
+
+void test_krb5_renew_tgt_retry(void **state)
+{
+    struct renew_tgt_ctx *renew_tgt_ctx = test_ctx->krb5_ctx->renew_tgt_ctx;
+    struct renew_data *first;
+    time_t now = test_ctx->now;
+    errno_t ret;
+
+    add_tgt("future", now + 100);
+    add_tgt("due", now - 20);
+
+    /* the KDC is not reachable */
+    test_ctx->pam_status = PAM_AUTHINFO_UNAVAIL;
+    test_ctx->num_expected = 1;
+    ret = test_ev_loop(test_ctx->tctx);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->num_renewed, 1);
+    assert_string_equal(test_ctx->renewed[0], "due");
+
+    /* the ticket is back in the queue, but is retried only after the
+     * renewal interval */
+    assert_int_equal(renew_tgt_ctx->queue_len, 2);
+    assert_first("future", now + 100);
+
+    renew_queue_remove(renew_queue_first(renew_tgt_ctx));
+    first = renew_queue_first(renew_tgt_ctx);
+    assert_non_null(first);
+    assert_string_equal(first->upn, "due");
+    assert_true(first->start_renew_at >= now + TEST_RENEW_INTERVAL);
+    assert_true(first->start_renew_at <= time(NULL) + TEST_RENEW_INTERVAL);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_krb5_renew_tgt_order,
+                                        test_krb5_renew_tgt_setup,
+                                        test_krb5_renew_tgt_teardown),
+        cmocka_unit_test_setup_teardown(test_krb5_renew_tgt_replace,
+                                        test_krb5_renew_tgt_setup,
+                                        test_krb5_renew_tgt_teardown),
+        cmocka_unit_test_setup_teardown(test_krb5_renew_tgt_reschedule,
+                                        test_krb5_renew_tgt_setup,
+                                        test_krb5_renew_tgt_teardown),
+        cmocka_unit_test_setup_teardown(test_krb5_renew_tgt_renew_due,
+                                        test_krb5_renew_tgt_setup,
+                                        test_krb5_renew_tgt_teardown),
+        cmocka_unit_test_setup_teardown(test_krb5_renew_tgt_retry,
+                                        test_krb5_renew_tgt_setup,
+                                        test_krb5_renew_tgt_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    /* Even though normally the tests should clean up after themselves
+     * they might not after a failed run. Remove the old DB to be sure */
+    tests_set_cwd();
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
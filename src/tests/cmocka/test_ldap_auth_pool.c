@@ -0,0 +1,640 @@
+/*
+    SSSD
+
+    LDAP authentication - connection pool
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <tevent.h>
+#include <errno.h>
+#include <popt.h>
+
+#include "tests/cmocka/common_mock.h"
+
+/* Include source file to test the static functions */
+#include "providers/ldap/ldap_auth.c"
+#include "providers/ldap/ldap_opts.h"
+
+#define TESTS_PATH "tp_" BASE_FILE_STEM
+#define TEST_CONF_DB "test_ldap_auth_pool_conf.ldb"
+#define TEST_DOM_NAME "ldap_auth_pool_test"
+#define TEST_ID_PROVIDER "ldap"
+
+#define TEST_URI "ldap://ldap1.example.com"
+#define TEST_URI2 "ldap://ldap2.example.com"
+
+#define TEST_USER1 "user1@" TEST_DOM_NAME
+#define TEST_USER2 "user2@" TEST_DOM_NAME
+#define TEST_DN1 "uid=user1,ou=people,dc=example,dc=com"
+#define TEST_DN2 "uid=user2,ou=people,dc=example,dc=com"
+
+#define TEST_MAX_BINDS 8
+
+/* Result of one fake bind, in the order the binds are issued */
+struct fake_bind {
+    errno_t ret;
+    bool ppolicy;
+
+    /* filled in when the bind is issued */
+    struct sdap_handle *sh;
+    const char *dn;
+};
+
+struct ldap_auth_pool_test_ctx {
+    struct sss_test_ctx *tctx;
+    struct sdap_auth_ctx *auth_ctx;
+    struct sss_auth_token *authtok;
+
+    struct fake_bind binds[TEST_MAX_BINDS];
+    int num_binds;
+
+    int connects;
+    int closed;
+};
+
+static struct ldap_auth_pool_test_ctx *ldap_auth_pool_test_ctx;
+
+int __wrap_ldap_get_option(LDAP *ld, int option, void *outvalue)
+{
+    return LDAP_OPT_ERROR;
+}
+
+int __wrap_ldap_tls_inplace(LDAP *ld)
+{
+    /* all connections are protected by StartTLS */
+    return 1;
+}
+
+struct fake_connect_state {
+    struct sdap_handle *sh;
+};
+
+static int fake_sh_destructor(struct sdap_handle *sh)
+{
+    ldap_auth_pool_test_ctx->closed++;
+    return 0;
+}
+
+struct tevent_req *
+__wrap_sdap_cli_connect_send(TALLOC_CTX *memctx,
+                             struct tevent_context *ev,
+                             struct sdap_options *opts,
+                             struct be_ctx *be,
+                             struct sdap_service *service,
+                             bool skip_rootdse,
+                             enum connect_tls force_tls,
+                             bool skip_auth)
+{
+    struct fake_connect_state *state;
+    struct tevent_req *req;
+
+    req = tevent_req_create(memctx, &state, struct fake_connect_state);
+    assert_non_null(req);
+
+    /* only connections used just for the user bind are pooled */
+    assert_true(skip_auth);
+    assert_int_equal(force_tls, CON_TLS_ON);
+
+    state->sh = talloc_zero(state, struct sdap_handle);
+    assert_non_null(state->sh);
+    state->sh->connected = true;
+    talloc_set_destructor(state->sh, fake_sh_destructor);
+
+    ldap_auth_pool_test_ctx->connects++;
+
+    tevent_req_done(req);
+    tevent_req_post(req, ev);
+    return req;
+}
+
+int __wrap_sdap_cli_connect_recv(struct tevent_req *req,
+                                 TALLOC_CTX *memctx,
+                                 bool *can_retry,
+                                 struct sdap_handle **gsh,
+                                 struct sdap_server_opts **srv_opts)
+{
+    struct fake_connect_state *state;
+
+    state = tevent_req_data(req, struct fake_connect_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *gsh = talloc_steal(memctx, state->sh);
+    return EOK;
+}
+
+struct fake_auth_state {
+    struct sdap_ppolicy_data *ppolicy;
+};
+
+struct tevent_req *__wrap_sdap_auth_send(TALLOC_CTX *memctx,
+                                         struct tevent_context *ev,
+                                         struct sdap_handle *sh,
+                                         const char *sasl_mech,
+                                         const char *sasl_user,
+                                         const char *user_dn,
+                                         struct sss_auth_token *authtok,
+                                         int simple_bind_timeout)
+{
+    struct ldap_auth_pool_test_ctx *test_ctx = ldap_auth_pool_test_ctx;
+    struct fake_auth_state *state;
+    struct fake_bind *bind;
+    struct tevent_req *req;
+
+    req = tevent_req_create(memctx, &state, struct fake_auth_state);
+    assert_non_null(req);
+
+    assert_true(test_ctx->num_binds < TEST_MAX_BINDS);
+    bind = &test_ctx->binds[test_ctx->num_binds++];
+    bind->sh = sh;
+    bind->dn = user_dn;
+
+    if (bind->ppolicy) {
+        state->ppolicy = talloc_zero(state, struct sdap_ppolicy_data);
+        assert_non_null(state->ppolicy);
+    }
+
+    if (bind->ret == EOK) {
+        tevent_req_done(req);
+    } else {
+        tevent_req_error(req, bind->ret);
+    }
+    tevent_req_post(req, ev);
+    return req;
+}
+
+errno_t __wrap_sdap_auth_recv(struct tevent_req *req,
+                              TALLOC_CTX *memctx,
+                              struct sdap_ppolicy_data **ppolicy)
+{
+    struct fake_auth_state *state;
+
+    state = tevent_req_data(req, struct fake_auth_state);
+
+    if (ppolicy != NULL) {
+        *ppolicy = talloc_steal(memctx, state->ppolicy);
+    }
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
+static void add_user(struct ldap_auth_pool_test_ctx *test_ctx,
+                     const char *name, uid_t uid, const char *dn)
+{
+    struct sysdb_attrs *attrs;
+    errno_t ret;
+
+    attrs = sysdb_new_attrs(test_ctx);
+    assert_non_null(attrs);
+
+    ret = sysdb_attrs_add_string(attrs, SYSDB_ORIG_DN, dn);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_add_user(test_ctx->tctx->dom, name, uid, uid, NULL, NULL,
+                         NULL, dn, attrs, 0, 0);
+    assert_int_equal(ret, EOK);
+
+    talloc_free(attrs);
+}
+
+static int test_ldap_auth_pool_setup(void **state)
+{
+    struct ldap_auth_pool_test_ctx *test_ctx;
+    struct sdap_auth_ctx *auth_ctx;
+    errno_t ret;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context,
+                           struct ldap_auth_pool_test_ctx);
+    assert_non_null(test_ctx);
+
+    test_dom_suite_setup(TESTS_PATH);
+
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, TEST_ID_PROVIDER,
+                                         NULL);
+    assert_non_null(test_ctx->tctx);
+
+    add_user(test_ctx, TEST_USER1, 10001, TEST_DN1);
+    add_user(test_ctx, TEST_USER2, 10002, TEST_DN2);
+
+    test_ctx->authtok = sss_authtok_new(test_ctx);
+    assert_non_null(test_ctx->authtok);
+    ret = sss_authtok_set_password(test_ctx->authtok, "secret", 0);
+    assert_int_equal(ret, EOK);
+
+    auth_ctx = talloc_zero(test_ctx, struct sdap_auth_ctx);
+    assert_non_null(auth_ctx);
+
+    auth_ctx->be = talloc_zero(auth_ctx, struct be_ctx);
+    assert_non_null(auth_ctx->be);
+    auth_ctx->be->ev = test_ctx->tctx->ev;
+    auth_ctx->be->domain = test_ctx->tctx->dom;
+
+    auth_ctx->opts = talloc_zero(auth_ctx, struct sdap_options);
+    assert_non_null(auth_ctx->opts);
+
+    ret = dp_copy_defaults(auth_ctx->opts, default_basic_opts,
+                           SDAP_OPTS_BASIC, &auth_ctx->opts->basic);
+    assert_int_equal(ret, EOK);
+
+    ret = dp_opt_set_int(auth_ctx->opts->basic, SDAP_AUTH_POOL_SIZE, 2);
+    assert_int_equal(ret, EOK);
+
+    auth_ctx->service = talloc_zero(auth_ctx, struct sdap_service);
+    assert_non_null(auth_ctx->service);
+    auth_ctx->service->name = talloc_strdup(auth_ctx->service, "LDAP");
+    assert_non_null(auth_ctx->service->name);
+    auth_ctx->service->uri = talloc_strdup(auth_ctx->service, TEST_URI);
+    assert_non_null(auth_ctx->service->uri);
+
+    test_ctx->auth_ctx = auth_ctx;
+
+    ldap_auth_pool_test_ctx = test_ctx;
+    *state = test_ctx;
+
+    return 0;
+}
+
+static int test_ldap_auth_pool_teardown(void **state)
+{
+    struct ldap_auth_pool_test_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(*state, struct ldap_auth_pool_test_ctx);
+
+    talloc_free(test_ctx);
+    ldap_auth_pool_test_ctx = NULL;
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+    assert_true(leak_check_teardown());
+
+    return 0;
+}
+
+static void set_bind(struct ldap_auth_pool_test_ctx *test_ctx,
+                     int idx, errno_t ret, bool ppolicy)
+{
+    test_ctx->binds[idx].ret = ret;
+    test_ctx->binds[idx].ppolicy = ppolicy;
+}
+
+static void test_auth_done(struct tevent_req *req)
+{
+    struct ldap_auth_pool_test_ctx *test_ctx;
+    enum pwexpire pw_expire_type;
+    errno_t ret;
+
+    test_ctx = tevent_req_callback_data(req, struct ldap_auth_pool_test_ctx);
+
+    ret = auth_recv(req, test_ctx, NULL, NULL, &pw_expire_type, NULL);
+    talloc_zfree(req);
+
+    test_ev_done(test_ctx->tctx, ret);
+}
+
+static errno_t run_auth(struct ldap_auth_pool_test_ctx *test_ctx,
+                        const char *username)
+{
+    struct tevent_req *req;
+
+    test_ctx->tctx->done = false;
+
+    req = auth_send(test_ctx, test_ctx->tctx->ev, test_ctx->auth_ctx,
+                    username, test_ctx->authtok, false, true);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_auth_done, test_ctx);
+
+    return test_ev_loop(test_ctx->tctx);
+}
+
+/* Fill the pool with two connections by authenticating two users at the
+ * same time. */
+static void fill_pool(struct ldap_auth_pool_test_ctx *test_ctx)
+{
+    struct tevent_req *req;
+    int i;
+
+    set_bind(test_ctx, 0, EOK, false);
+    set_bind(test_ctx, 1, EOK, false);
+
+    req = auth_send(test_ctx, test_ctx->tctx->ev, test_ctx->auth_ctx,
+                    TEST_USER1, test_ctx->authtok, false, true);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_auth_done, test_ctx);
+
+    req = auth_send(test_ctx, test_ctx->tctx->ev, test_ctx->auth_ctx,
+                    TEST_USER2, test_ctx->authtok, false, true);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_auth_done, test_ctx);
+
+    for (i = 0; i < 2; i++) {
+        test_ctx->tctx->done = false;
+        assert_int_equal(test_ev_loop(test_ctx->tctx), EOK);
+    }
+
+    assert_int_equal(test_ctx->connects, 2);
+    assert_non_null(test_ctx->auth_ctx->pool);
+    assert_int_equal(test_ctx->auth_ctx->pool->num_conns, 2);
+}
+
+void test_pool_reuse_rebinds(void **state)
+{
+    struct ldap_auth_pool_test_ctx *test_ctx;
+    struct sdap_auth_pool *pool;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ldap_auth_pool_test_ctx);
+
+    set_bind(test_ctx, 0, EOK, false);
+    set_bind(test_ctx, 1, EOK, false);
+
+    ret = run_auth(test_ctx, TEST_USER1);
+    assert_int_equal(ret, EOK);
+
+    pool = test_ctx->auth_ctx->pool;
+    assert_non_null(pool);
+    assert_int_equal(pool->num_conns, 1);
+    assert_int_equal(test_ctx->connects, 1);
+
+    ret = run_auth(test_ctx, TEST_USER2);
+    assert_int_equal(ret, EOK);
+
+    /* The second user is bound on the same connection before the result
+     * is reported, nothing of the first bind is used. */
+    assert_int_equal(test_ctx->connects, 1);
+    assert_int_equal(test_ctx->num_binds, 2);
+    assert_ptr_equal(test_ctx->binds[1].sh, test_ctx->binds[0].sh);
+    assert_string_equal(test_ctx->binds[0].dn, TEST_DN1);
+    assert_string_equal(test_ctx->binds[1].dn, TEST_DN2);
+    assert_int_equal(pool->reused, 1);
+    assert_int_equal(pool->num_conns, 1);
+}
+
+void test_pool_wrong_password_rebinds(void **state)
+{
+    struct ldap_auth_pool_test_ctx *test_ctx;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ldap_auth_pool_test_ctx);
+
+    set_bind(test_ctx, 0, ERR_AUTH_FAILED, false);
+    set_bind(test_ctx, 1, EOK, false);
+
+    ret = run_auth(test_ctx, TEST_USER1);
+    assert_int_equal(ret, ERR_AUTH_FAILED);
+    assert_int_equal(test_ctx->auth_ctx->pool->num_conns, 1);
+
+    ret = run_auth(test_ctx, TEST_USER2);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->connects, 1);
+    assert_ptr_equal(test_ctx->binds[1].sh, test_ctx->binds[0].sh);
+    assert_string_equal(test_ctx->binds[1].dn, TEST_DN2);
+}
+
+void test_pool_ppolicy_not_pooled(void **state)
+{
+    struct ldap_auth_pool_test_ctx *test_ctx;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ldap_auth_pool_test_ctx);
+
+    set_bind(test_ctx, 0, EOK, true);
+    set_bind(test_ctx, 1, EOK, false);
+
+    ret = run_auth(test_ctx, TEST_USER1);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(test_ctx->auth_ctx->pool->num_conns, 0);
+    assert_int_equal(test_ctx->auth_ctx->pool->discarded, 1);
+    assert_int_equal(test_ctx->closed, 1);
+
+    ret = run_auth(test_ctx, TEST_USER2);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->connects, 2);
+    assert_int_equal(test_ctx->auth_ctx->pool->reused, 0);
+}
+
+void test_pool_error_not_pooled(void **state)
+{
+    struct ldap_auth_pool_test_ctx *test_ctx;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ldap_auth_pool_test_ctx);
+
+    set_bind(test_ctx, 0, ERR_PASSWORD_EXPIRED, false);
+    set_bind(test_ctx, 1, EOK, false);
+
+    ret = run_auth(test_ctx, TEST_USER1);
+    assert_int_equal(ret, ERR_PASSWORD_EXPIRED);
+    assert_int_equal(test_ctx->auth_ctx->pool->num_conns, 0);
+    assert_int_equal(test_ctx->closed, 1);
+
+    ret = run_auth(test_ctx, TEST_USER2);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->connects, 2);
+    assert_ptr_not_equal(test_ctx->binds[1].sh, test_ctx->binds[0].sh);
+}
+
+void test_pool_disconnected_rejected(void **state)
+{
+    struct ldap_auth_pool_test_ctx *test_ctx;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ldap_auth_pool_test_ctx);
+
+    set_bind(test_ctx, 0, EOK, false);
+    set_bind(test_ctx, 1, EOK, false);
+
+    ret = run_auth(test_ctx, TEST_USER1);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(test_ctx->auth_ctx->pool->num_conns, 1);
+
+    /* closed by the server while idle */
+    test_ctx->auth_ctx->pool->conns->sh->connected = false;
+
+    ret = run_auth(test_ctx, TEST_USER2);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->connects, 2);
+    assert_int_equal(test_ctx->closed, 1);
+    assert_int_equal(test_ctx->auth_ctx->pool->discarded, 1);
+    assert_int_equal(test_ctx->auth_ctx->pool->num_conns, 1);
+}
+
+void test_pool_network_error_retry(void **state)
+{
+    struct ldap_auth_pool_test_ctx *test_ctx;
+    struct sdap_auth_pool *pool;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ldap_auth_pool_test_ctx);
+
+    fill_pool(test_ctx);
+    pool = test_ctx->auth_ctx->pool;
+
+    /* The bind on the pooled connection fails, the request retries on a
+     * new connection. */
+    set_bind(test_ctx, 2, ERR_NETWORK_IO, false);
+    set_bind(test_ctx, 3, EOK, false);
+
+    ret = run_auth(test_ctx, TEST_USER1);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->num_binds, 4);
+    assert_int_equal(test_ctx->connects, 3);
+    assert_ptr_not_equal(test_ctx->binds[3].sh, test_ctx->binds[2].sh);
+
+    /* Both the failed connection and the other one to the same server
+     * are closed right away, only the new one is pooled. */
+    assert_int_equal(test_ctx->closed, 2);
+    assert_int_equal(pool->num_conns, 1);
+    assert_ptr_equal(pool->conns->sh, test_ctx->binds[3].sh);
+}
+
+void test_pool_flush_offline(void **state)
+{
+    struct ldap_auth_pool_test_ctx *test_ctx;
+    struct sdap_auth_pool *pool;
+
+    test_ctx = talloc_get_type_abort(*state, struct ldap_auth_pool_test_ctx);
+
+    fill_pool(test_ctx);
+    pool = test_ctx->auth_ctx->pool;
+
+    be_run_offline_cb(test_ctx->auth_ctx->be);
+    while (pool->num_conns > 0) {
+        tevent_loop_once(test_ctx->tctx->ev);
+    }
+
+    assert_int_equal(test_ctx->closed, 2);
+    assert_int_equal(pool->discarded, 2);
+}
+
+void test_pool_flush_reconnect(void **state)
+{
+    struct ldap_auth_pool_test_ctx *test_ctx;
+    struct sdap_auth_pool *pool;
+
+    test_ctx = talloc_get_type_abort(*state, struct ldap_auth_pool_test_ctx);
+
+    fill_pool(test_ctx);
+    pool = test_ctx->auth_ctx->pool;
+
+    be_run_reconnect_cb(test_ctx->auth_ctx->be);
+
+    assert_int_equal(pool->num_conns, 0);
+    assert_int_equal(test_ctx->closed, 2);
+}
+
+void test_pool_failover_uri(void **state)
+{
+    struct ldap_auth_pool_test_ctx *test_ctx;
+    struct sdap_auth_pool *pool;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(*state, struct ldap_auth_pool_test_ctx);
+
+    fill_pool(test_ctx);
+    pool = test_ctx->auth_ctx->pool;
+
+    /* fail over switched to another server */
+    talloc_free(test_ctx->auth_ctx->service->uri);
+    test_ctx->auth_ctx->service->uri = talloc_strdup(test_ctx->auth_ctx->service,
+                                                     TEST_URI2);
+    assert_non_null(test_ctx->auth_ctx->service->uri);
+
+    set_bind(test_ctx, 2, EOK, false);
+
+    ret = run_auth(test_ctx, TEST_USER1);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->connects, 3);
+    assert_int_equal(test_ctx->closed, 2);
+    assert_int_equal(pool->reused, 0);
+    assert_int_equal(pool->num_conns, 1);
+    assert_string_equal(pool->conns->uri, TEST_URI2);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_pool_reuse_rebinds,
+                                        test_ldap_auth_pool_setup,
+                                        test_ldap_auth_pool_teardown),
+        cmocka_unit_test_setup_teardown(test_pool_wrong_password_rebinds,
+                                        test_ldap_auth_pool_setup,
+                                        test_ldap_auth_pool_teardown),
+        cmocka_unit_test_setup_teardown(test_pool_ppolicy_not_pooled,
+                                        test_ldap_auth_pool_setup,
+                                        test_ldap_auth_pool_teardown),
+        cmocka_unit_test_setup_teardown(test_pool_error_not_pooled,
+                                        test_ldap_auth_pool_setup,
+                                        test_ldap_auth_pool_teardown),
+        cmocka_unit_test_setup_teardown(test_pool_disconnected_rejected,
+                                        test_ldap_auth_pool_setup,
+                                        test_ldap_auth_pool_teardown),
+        cmocka_unit_test_setup_teardown(test_pool_network_error_retry,
+                                        test_ldap_auth_pool_setup,
+                                        test_ldap_auth_pool_teardown),
+        cmocka_unit_test_setup_teardown(test_pool_flush_offline,
+                                        test_ldap_auth_pool_setup,
+                                        test_ldap_auth_pool_teardown),
+        cmocka_unit_test_setup_teardown(test_pool_flush_reconnect,
+                                        test_ldap_auth_pool_setup,
+                                        test_ldap_auth_pool_teardown),
+        cmocka_unit_test_setup_teardown(test_pool_failover_uri,
+                                        test_ldap_auth_pool_setup,
+                                        test_ldap_auth_pool_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    /* Even though normally the tests should clean up after themselves
+     * they might not after a failed run. Remove the old DB to be sure */
+    tests_set_cwd();
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_DOM_NAME);
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -300,6 +300,82 @@ static void test_id_cleanup_exp_group(void **state)
     assert_int_equal(ret, ENOENT);
 }
 
+static void test_id_cleanup_done(struct tevent_req *req)
+{
+    errno_t *_ret = tevent_req_callback_data(req, errno_t);
+
+    *_ret = ldap_id_cleanup_recv(req);
+    talloc_free(req);
+}
+
+static void test_id_cleanup_chunks(void **state)
+{
+    errno_t ret;
+    errno_t cleanup_ret = EAGAIN;
+    struct tevent_req *req;
+    struct ldb_message *msg;
+    struct sdap_domain sdom;
+    char *grp;
+    char *test_user;
+    /* more than one transaction worth of entries */
+    const int NUM_GROUPS = 120;
+    const uint64_t CACHE_TIMEOUT = 30;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                            struct sysdb_test_ctx);
+
+    for (int i = 0; i < NUM_GROUPS; i++) {
+        grp = talloc_asprintf(test_ctx, "grp%d@%s", i,
+                              test_ctx->domain->name);
+        assert_non_null(grp);
+
+        ret = sysdb_store_group(test_ctx->domain, grp,
+                                20000 + i, NULL, CACHE_TIMEOUT, 0);
+        assert_int_equal(ret, EOK);
+
+        ret = invalidate_group(test_ctx, test_ctx->domain, grp);
+        assert_int_equal(ret, EOK);
+        talloc_free(grp);
+    }
+
+    /* The primary group of this user must be kept */
+    test_user = sss_create_internal_fqname(test_ctx, "test_user",
+                                           test_ctx->domain->name);
+    assert_non_null(test_user);
+
+    ret = sysdb_store_user(test_ctx->domain, test_user, NULL,
+                           10001, 20007, "Test user",
+                           NULL, NULL, NULL, NULL, NULL,
+                           0, 0);
+    assert_int_equal(ret, EOK);
+
+    sdom.dom = test_ctx->domain;
+
+    req = ldap_id_cleanup_send(test_ctx, test_ctx->ev, test_ctx->id_ctx,
+                               &sdom);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_id_cleanup_done, &cleanup_ret);
+
+    while (cleanup_ret == EAGAIN) {
+        assert_int_equal(tevent_loop_once(test_ctx->ev), 0);
+    }
+    assert_int_equal(cleanup_ret, EOK);
+
+    for (int i = 0; i < NUM_GROUPS; i++) {
+        grp = talloc_asprintf(test_ctx, "grp%d@%s", i,
+                              test_ctx->domain->name);
+        assert_non_null(grp);
+
+        ret = sysdb_search_group_by_name(test_ctx, test_ctx->domain,
+                                         grp, NULL, &msg);
+        assert_int_equal(ret, i == 7 ? EOK : ENOENT);
+        talloc_free(grp);
+    }
+
+    ret = sysdb_search_user_by_name(test_ctx, test_ctx->domain,
+                                    test_user, NULL, &msg);
+    assert_int_equal(ret, EOK);
+}
+
 int main(int argc, const char *argv[])
 {
     int rv;
@@ -317,6 +393,8 @@ int main(int argc, const char *argv[])
     const struct CMUnitTest tests[] = {
         cmocka_unit_test_setup_teardown(test_id_cleanup_exp_group,
                                         test_sysdb_setup, test_sysdb_teardown),
+        cmocka_unit_test_setup_teardown(test_id_cleanup_chunks,
+                                        test_sysdb_setup, test_sysdb_teardown),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
@@ -990,6 +990,87 @@ static void test_sss_ncache_reset(void **state)
     assert_int_equal(ret, ENOENT);
 }
 
+static void test_sss_ncache_adaptive_timeout(void **state)
+{
+    errno_t ret;
+    struct test_state *ts;
+    struct sss_domain_info *dom;
+
+    ts = talloc_get_type_abort(*state, struct test_state);
+    dom = talloc(ts, struct sss_domain_info);
+    assert_non_null(dom);
+    dom->case_sensitive = true;
+    dom->name = discard_const_p(char, TEST_DOM_NAME);
+
+    sss_ncache_set_max_timeout(ts->ctx, SHORTSPAN * 8);
+
+    /* Storing a still valid entry again keeps the base timeout */
+    ret = sss_ncache_set_user(ts->ctx, false, dom, NAME);
+    assert_int_equal(ret, EOK);
+    ret = sss_ncache_set_user(ts->ctx, false, dom, NAME);
+    assert_int_equal(ret, EOK);
+    sleep(SHORTSPAN + 1);
+    ret = sss_ncache_check_user(ts->ctx, dom, NAME);
+    assert_int_equal(ret, ENOENT);
+
+    /* Missing again, the timeout doubles */
+    ret = sss_ncache_set_user(ts->ctx, false, dom, NAME);
+    assert_int_equal(ret, EOK);
+    sleep(SHORTSPAN);
+    ret = sss_ncache_check_user(ts->ctx, dom, NAME);
+    assert_int_equal(ret, EEXIST);
+    sleep(SHORTSPAN * 2 + 1);
+    ret = sss_ncache_check_user(ts->ctx, dom, NAME);
+    assert_int_equal(ret, ENOENT);
+
+    /* Reset starts over with the base timeout */
+    ret = sss_ncache_reset_users(ts->ctx);
+    assert_int_equal(ret, EOK);
+    ret = sss_ncache_set_user(ts->ctx, false, dom, NAME);
+    assert_int_equal(ret, EOK);
+    sleep(SHORTSPAN + 1);
+    ret = sss_ncache_check_user(ts->ctx, dom, NAME);
+    assert_int_equal(ret, ENOENT);
+}
+
+static void test_sss_ncache_stats(void **state)
+{
+    errno_t ret;
+    struct test_state *ts;
+    struct sss_domain_info *dom;
+    struct sss_nc_stats stats;
+
+    ts = talloc_get_type_abort(*state, struct test_state);
+    dom = talloc(ts, struct sss_domain_info);
+    assert_non_null(dom);
+    dom->case_sensitive = true;
+    dom->name = discard_const_p(char, TEST_DOM_NAME);
+
+    /* Nothing was stored yet, the filter answers */
+    ret = sss_ncache_check_user(ts->ctx, dom, NAME);
+    assert_int_equal(ret, ENOENT);
+
+    ret = sss_ncache_set_user(ts->ctx, true, dom, NAME);
+    assert_int_equal(ret, EOK);
+    ret = sss_ncache_check_user(ts->ctx, dom, NAME);
+    assert_int_equal(ret, EEXIST);
+
+    sss_ncache_get_stats(ts->ctx, &stats);
+    assert_int_equal(stats.lookups, 2);
+    assert_int_equal(stats.filtered, 1);
+    assert_int_equal(stats.hits, 1);
+
+    /* The filter is rebuilt without the permanent entry */
+    ret = sss_ncache_reset_permanent(ts->ctx);
+    assert_int_equal(ret, EOK);
+    ret = sss_ncache_check_user(ts->ctx, dom, NAME);
+    assert_int_equal(ret, ENOENT);
+
+    sss_ncache_get_stats(ts->ctx, &stats);
+    assert_int_equal(stats.filtered, 2);
+    assert_int_equal(stats.false_positives, 0);
+}
+
 static void test_sss_ncache_locate_uid_gid(void **state)
 {
     uid_t uid;
@@ -1087,6 +1168,10 @@ int main(void)
                                         setup, teardown),
         cmocka_unit_test_setup_teardown(test_sss_ncache_reset,
                                         setup, teardown),
+        cmocka_unit_test_setup_teardown(test_sss_ncache_adaptive_timeout,
+                                        setup, teardown),
+        cmocka_unit_test_setup_teardown(test_sss_ncache_stats,
+                                        setup, teardown),
         cmocka_unit_test_setup_teardown(test_sss_ncache_locate_uid_gid,
                                         setup, teardown),
         cmocka_unit_test_setup_teardown(test_sss_ncache_domain_locate_type,
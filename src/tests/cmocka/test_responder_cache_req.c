@@ -884,6 +884,51 @@ void test_user_by_name_cache_midpoint(void **state)
     check_user(test_ctx, &users[0], test_ctx->tctx->dom);
 }
 
+void test_user_by_name_cache_stale(void **state)
+{
+    struct cache_req_test_ctx *test_ctx = NULL;
+
+    test_ctx = talloc_get_type_abort(*state, struct cache_req_test_ctx);
+    test_ctx->rctx->cache_stale_grace = 300;
+
+    /* Setup user. */
+    prepare_user(test_ctx->tctx->dom, &users[0], 50, time(NULL) - 100);
+
+    /* Mock values. */
+    /* DP should be contacted without callback */
+    will_return(__wrap_sss_dp_get_account_send, test_ctx);
+
+    /* Test. */
+    run_user_by_name(test_ctx, test_ctx->tctx->dom, 0, ERR_OK);
+    assert_true(test_ctx->dp_called);
+    check_user(test_ctx, &users[0], test_ctx->tctx->dom);
+    assert_int_equal(test_ctx->rctx->cache_refresh_stats.stale_served, 1);
+    assert_int_equal(test_ctx->rctx->cache_refresh_stats.started, 1);
+}
+
+void test_user_by_name_cache_stale_grace_over(void **state)
+{
+    struct cache_req_test_ctx *test_ctx = NULL;
+
+    test_ctx = talloc_get_type_abort(*state, struct cache_req_test_ctx);
+    test_ctx->rctx->cache_stale_grace = 30;
+
+    /* Setup user. */
+    prepare_user(test_ctx->tctx->dom, &users[0], 50, time(NULL) - 100);
+
+    /* Mock values. */
+    /* DP should be contacted */
+    will_return(__wrap_sss_dp_get_account_send, test_ctx);
+    mock_account_recv_simple();
+
+    /* Test. */
+    run_user_by_name(test_ctx, test_ctx->tctx->dom, 0, ERR_OK);
+    assert_true(test_ctx->dp_called);
+    check_user(test_ctx, &users[0], test_ctx->tctx->dom);
+    assert_int_equal(test_ctx->rctx->cache_refresh_stats.stale_served, 0);
+    assert_int_equal(test_ctx->rctx->cache_refresh_stats.started, 0);
+}
+
 void test_user_by_name_ncache(void **state)
 {
     struct cache_req_test_ctx *test_ctx = NULL;
@@ -3954,6 +3999,8 @@ int main(int argc, const char *argv[])
         new_single_domain_test(user_by_name_cache_valid),
         new_single_domain_test(user_by_name_cache_expired),
         new_single_domain_test(user_by_name_cache_midpoint),
+        new_single_domain_test(user_by_name_cache_stale),
+        new_single_domain_test(user_by_name_cache_stale_grace_over),
         new_single_domain_test(user_by_name_ncache),
         new_single_domain_test(user_by_name_missing_found),
         new_single_domain_test(user_by_name_missing_notfound),
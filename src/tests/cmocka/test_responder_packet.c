@@ -0,0 +1,405 @@
+/*
+    Copyright (C) 2020 Red Hat
+
+    SSSD tests: Responder packets
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <popt.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+
+#include "util/util.h"
+#include "responder/common/responder_packet.h"
+#include "tests/cmocka/common_mock.h"
+
+#define TEST_CHUNK_SIZE 100
+#define TEST_NUM_CHUNKS 1000
+#define TEST_FRAG_SIZE  (256 * 1024)
+
+struct packet_test_ctx {
+    int fds[2];
+};
+
+static int setup_packet(void **state)
+{
+    struct packet_test_ctx *test_ctx;
+    int ret;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct packet_test_ctx);
+    assert_non_null(test_ctx);
+
+    ret = socketpair(AF_UNIX, SOCK_STREAM, 0, test_ctx->fds);
+    assert_int_equal(ret, 0);
+
+    /* Responders use non-blocking sockets. */
+    ret = fcntl(test_ctx->fds[0], F_SETFL, O_NONBLOCK);
+    assert_int_equal(ret, 0);
+
+    check_leaks_push(test_ctx);
+    *state = test_ctx;
+    return 0;
+}
+
+static int teardown_packet(void **state)
+{
+    struct packet_test_ctx *test_ctx = talloc_get_type(*state,
+                                                struct packet_test_ctx);
+
+    assert_non_null(test_ctx);
+
+    close(test_ctx->fds[0]);
+    close(test_ctx->fds[1]);
+
+    assert_true(check_leaks_pop(test_ctx) == true);
+    talloc_free(test_ctx);
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+static void fill_packet(struct sss_packet *packet, size_t num_chunks)
+{
+    uint8_t *body;
+    size_t blen;
+    size_t i;
+    errno_t ret;
+
+    for (i = 0; i < num_chunks; i++) {
+        ret = sss_packet_grow(packet, TEST_CHUNK_SIZE);
+        assert_int_equal(ret, EOK);
+
+        sss_packet_get_body(packet, &body, &blen);
+        assert_int_equal(blen, (i + 1) * TEST_CHUNK_SIZE);
+        memset(body + i * TEST_CHUNK_SIZE, i % 256, TEST_CHUNK_SIZE);
+    }
+}
+
+void test_packet_grow(void **state)
+{
+    struct packet_test_ctx *test_ctx = talloc_get_type(*state,
+                                                struct packet_test_ctx);
+    struct sss_packet *packet;
+    uint8_t *body;
+    size_t blen;
+    size_t i;
+    errno_t ret;
+
+    ret = sss_packet_new(test_ctx, 0, SSS_NSS_GETPWENT, &packet);
+    assert_int_equal(ret, EOK);
+
+    fill_packet(packet, TEST_NUM_CHUNKS);
+
+    sss_packet_get_body(packet, &body, &blen);
+    assert_int_equal(blen, TEST_NUM_CHUNKS * TEST_CHUNK_SIZE);
+    for (i = 0; i < blen; i++) {
+        assert_int_equal(body[i], (i / TEST_CHUNK_SIZE) % 256);
+    }
+
+    ret = sss_packet_shrink(packet, TEST_CHUNK_SIZE);
+    assert_int_equal(ret, EOK);
+    sss_packet_get_body(packet, &body, &blen);
+    assert_int_equal(blen, (TEST_NUM_CHUNKS - 1) * TEST_CHUNK_SIZE);
+
+    talloc_free(packet);
+}
+
+void test_packet_reserve(void **state)
+{
+    struct packet_test_ctx *test_ctx = talloc_get_type(*state,
+                                                struct packet_test_ctx);
+    struct sss_packet *packet;
+    uint8_t *body;
+    uint8_t *reserved_body;
+    size_t blen;
+    errno_t ret;
+
+    ret = sss_packet_new(test_ctx, 0, SSS_NSS_GETPWENT, &packet);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_packet_reserve(packet, TEST_NUM_CHUNKS * TEST_CHUNK_SIZE);
+    assert_int_equal(ret, EOK);
+
+    /* Reserving space does not change the length of the packet. */
+    sss_packet_get_body(packet, &reserved_body, &blen);
+    assert_int_equal(blen, 0);
+
+    /* And the buffer does not move while the reserved space is used. */
+    fill_packet(packet, TEST_NUM_CHUNKS);
+    sss_packet_get_body(packet, &body, &blen);
+    assert_ptr_equal(body, reserved_body);
+
+    talloc_free(packet);
+}
+
+void test_packet_pool(void **state)
+{
+    struct packet_test_ctx *test_ctx = talloc_get_type(*state,
+                                                struct packet_test_ctx);
+    struct sss_packet_pool_stats stats;
+    struct sss_packet *packet;
+    TALLOC_CTX *pool_ctx;
+    uint8_t *body;
+    size_t blen;
+    size_t i;
+    errno_t ret;
+
+    pool_ctx = talloc_new(test_ctx);
+    assert_non_null(pool_ctx);
+
+    ret = sss_packet_pool_init(pool_ctx);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_packet_new(test_ctx, 0, SSS_NSS_GETPWENT, &packet);
+    assert_int_equal(ret, EOK);
+    fill_packet(packet, TEST_NUM_CHUNKS);
+    talloc_free(packet);
+
+    sss_packet_pool_get_stats(&stats);
+    assert_int_equal(stats.misses, 1);
+    assert_int_equal(stats.recycled, 1);
+
+    /* The large buffer is reused and does not contain old data. */
+    ret = sss_packet_new(test_ctx, 0, SSS_NSS_GETPWENT, &packet);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_packet_grow(packet, TEST_NUM_CHUNKS * TEST_CHUNK_SIZE);
+    assert_int_equal(ret, EOK);
+
+    sss_packet_get_body(packet, &body, &blen);
+    for (i = 0; i < blen; i++) {
+        assert_int_equal(body[i], 0);
+    }
+    talloc_free(packet);
+
+    sss_packet_pool_get_stats(&stats);
+    assert_int_equal(stats.hits, 1);
+    assert_int_equal(stats.misses, 1);
+    assert_int_equal(stats.recycled, 2);
+
+    talloc_free(pool_ctx);
+}
+
+void test_packet_pool_recv_limit(void **state)
+{
+    struct packet_test_ctx *test_ctx = talloc_get_type(*state,
+                                                struct packet_test_ctx);
+    struct sss_packet *packet;
+    TALLOC_CTX *pool_ctx;
+    uint32_t header[4] = { 0 };
+    ssize_t len;
+    errno_t ret;
+
+    pool_ctx = talloc_new(test_ctx);
+    assert_non_null(pool_ctx);
+
+    ret = sss_packet_pool_init(pool_ctx);
+    assert_int_equal(ret, EOK);
+
+    /* Put a large buffer into the pool. */
+    ret = sss_packet_new(test_ctx, 0, SSS_NSS_GETPWENT, &packet);
+    assert_int_equal(ret, EOK);
+    fill_packet(packet, TEST_NUM_CHUNKS);
+    talloc_free(packet);
+
+    /* Requests larger than the maximum must be refused even if the pooled
+     * buffer is large enough to hold them. */
+    ret = sss_packet_new(test_ctx, SSS_PACKET_MAX_RECV_SIZE, 0, &packet);
+    assert_int_equal(ret, EOK);
+
+    header[0] = 4 * SSS_PACKET_MAX_RECV_SIZE;
+    header[1] = SSS_NSS_GETPWNAM;
+    len = write(test_ctx->fds[1], header, sizeof(header));
+    assert_int_equal(len, sizeof(header));
+
+    ret = sss_packet_recv(packet, test_ctx->fds[0]);
+    assert_int_equal(ret, EINVAL);
+
+    talloc_free(packet);
+    talloc_free(pool_ctx);
+}
+
+void test_packet_fragments(void **state)
+{
+    struct packet_test_ctx *test_ctx = talloc_get_type(*state,
+                                                struct packet_test_ctx);
+    struct sss_packet *packet;
+    uint8_t *frag;
+    uint8_t *body;
+    uint8_t *recvbuf;
+    size_t blen;
+    size_t total;
+    size_t received;
+    uint32_t packet_len;
+    ssize_t len;
+    errno_t ret;
+
+    ret = sss_packet_new(test_ctx, 0, SSS_SUDO_GET_SUDORULES, &packet);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_packet_grow(packet, 3);
+    assert_int_equal(ret, EOK);
+    sss_packet_get_body(packet, &body, &blen);
+    memcpy(body, "abc", 3);
+
+    frag = talloc_size(test_ctx, TEST_FRAG_SIZE);
+    assert_non_null(frag);
+    memset(frag, 'x', TEST_FRAG_SIZE);
+
+    ret = sss_packet_append_fragment(packet, frag, TEST_FRAG_SIZE);
+    assert_int_equal(ret, EOK);
+
+    /* The inline body does not include the fragment and can not be
+     * resized anymore. */
+    sss_packet_get_body(packet, &body, &blen);
+    assert_int_equal(blen, 3);
+    assert_int_equal(sss_packet_grow(packet, 1), EINVAL);
+    assert_int_equal(sss_packet_shrink(packet, 1), EINVAL);
+
+    total = SSS_NSS_HEADER_SIZE + 3 + TEST_FRAG_SIZE;
+    recvbuf = talloc_size(test_ctx, total);
+    assert_non_null(recvbuf);
+
+    /* The socket buffer is smaller than the packet, send and receive
+     * in turns. */
+    received = 0;
+    ret = EAGAIN;
+    do {
+        if (ret == EAGAIN) {
+            ret = sss_packet_send(packet, test_ctx->fds[0]);
+            assert_true(ret == EOK || ret == EAGAIN);
+        }
+
+        len = read(test_ctx->fds[1], recvbuf + received, total - received);
+        assert_true(len > 0);
+        received += len;
+    } while (received < total);
+    assert_int_equal(ret, EOK);
+
+    memcpy(&packet_len, recvbuf, sizeof(uint32_t));
+    assert_int_equal(packet_len, total);
+    assert_memory_equal(recvbuf + SSS_NSS_HEADER_SIZE, "abc", 3);
+    assert_memory_equal(recvbuf + SSS_NSS_HEADER_SIZE + 3, frag,
+                        TEST_FRAG_SIZE);
+
+    talloc_free(recvbuf);
+    talloc_free(packet);
+}
+
+static void benchmark_packet(int num_replies, size_t reply_size, bool pool)
+{
+    TALLOC_CTX *mem_ctx;
+    struct sss_packet *packet;
+    struct timeval start;
+    struct timeval end;
+    double elapsed;
+    int i;
+    errno_t ret;
+
+    mem_ctx = talloc_new(NULL);
+    assert_non_null(mem_ctx);
+
+    if (pool) {
+        ret = sss_packet_pool_init(mem_ctx);
+        assert_int_equal(ret, EOK);
+    }
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < num_replies; i++) {
+        ret = sss_packet_new(mem_ctx, 0, SSS_NSS_GETPWENT, &packet);
+        assert_int_equal(ret, EOK);
+
+        fill_packet(packet, reply_size / TEST_CHUNK_SIZE);
+        talloc_free(packet);
+    }
+    gettimeofday(&end, NULL);
+
+    elapsed = (end.tv_sec - start.tv_sec)
+                + (end.tv_usec - start.tv_usec) / 1000000.0;
+    printf("%d replies of %zu bytes, pool %s: %.3f s, %.1f us/reply\n",
+           num_replies, reply_size, pool ? "on" : "off",
+           elapsed, elapsed * 1000000.0 / num_replies);
+
+    talloc_free(mem_ctx);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    int rv;
+    int benchmark = 0;
+    size_t sizes[] = { 4 * 1024, 64 * 1024, 1024 * 1024, 4 * 1024 * 1024 };
+    size_t i;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        { "benchmark", 0, POPT_ARG_INT, &benchmark, 0,
+          "Measure the time needed to build the given number of replies",
+          NULL },
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_packet_grow,
+                                        setup_packet,
+                                        teardown_packet),
+        cmocka_unit_test_setup_teardown(test_packet_reserve,
+                                        setup_packet,
+                                        teardown_packet),
+        cmocka_unit_test_setup_teardown(test_packet_pool,
+                                        setup_packet,
+                                        teardown_packet),
+        cmocka_unit_test_setup_teardown(test_packet_pool_recv_limit,
+                                        setup_packet,
+                                        teardown_packet),
+        cmocka_unit_test_setup_teardown(test_packet_fragments,
+                                        setup_packet,
+                                        teardown_packet),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    if (benchmark > 0) {
+        for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            benchmark_packet(benchmark, sizes[i], false);
+            benchmark_packet(benchmark, sizes[i], true);
+        }
+        return 0;
+    }
+
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+
+    return rv;
+}
@@ -32,10 +32,14 @@
 #include "tests/common_check.h"
 #include "tests/cmocka/test_expire_common.h"
 #include "tests/cmocka/test_sdap_access.h"
+#include "providers/ldap/sdap_access.h"
 
 /* linking against function from sdap_access.c module */
 extern bool nds_check_expired(const char *exp_time_str);
 extern errno_t sdap_access_rhost(struct ldb_message *user_entry, char *pam_rhost);
+extern bool sdap_access_cached_result_valid(struct ldb_message *user_entry,
+                                            const char *time_attr,
+                                            int timeout);
 
 static void nds_check_expired_wrap(void *in, void *_out)
 {
@@ -249,6 +253,94 @@ static void test_sdap_access_rhost(void **state)
     assert_int_equal(EOK, ret); /* Expected access allowed */
 }
 
+static struct ldb_message *cached_result_entry(TALLOC_CTX *mem_ctx,
+                                               time_t stored,
+                                               time_t last_update,
+                                               const char *modstamp)
+{
+    struct ldb_message *msg;
+    int ret;
+
+    msg = ldb_msg_new(mem_ctx);
+    assert_non_null(msg);
+
+    if (stored != 0) {
+        ret = ldb_msg_add_fmt(msg, SYSDB_LDAP_ACCESS_FILTER_TIME, "%ld",
+                              (long) stored);
+        assert_int_equal(ret, LDB_SUCCESS);
+    }
+
+    ret = ldb_msg_add_fmt(msg, SYSDB_LAST_UPDATE, "%ld", (long) last_update);
+    assert_int_equal(ret, LDB_SUCCESS);
+
+    if (modstamp != NULL) {
+        ret = ldb_msg_add_string(msg, SYSDB_ORIG_MODSTAMP, modstamp);
+        assert_int_equal(ret, LDB_SUCCESS);
+    }
+
+    return msg;
+}
+
+static void test_sdap_access_cached_result(void **state)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_message *msg;
+    char recent[32];
+    struct tm tm;
+    time_t now;
+
+    tmp_ctx = talloc_new(NULL);
+    assert_non_null(tmp_ctx);
+
+    now = time(NULL);
+    gmtime_r(&now, &tm);
+    strftime(recent, sizeof(recent), "%Y%m%d%H%M%SZ", &tm);
+
+    /* Stored 10 seconds ago, user not refreshed since */
+    msg = cached_result_entry(tmp_ctx, now - 10, now - 100, NULL);
+    assert_true(sdap_access_cached_result_valid(msg,
+                                                SYSDB_LDAP_ACCESS_FILTER_TIME,
+                                                60));
+    /* Caching disabled */
+    assert_false(sdap_access_cached_result_valid(msg,
+                                                 SYSDB_LDAP_ACCESS_FILTER_TIME,
+                                                 0));
+    /* Expired */
+    assert_false(sdap_access_cached_result_valid(msg,
+                                                 SYSDB_LDAP_ACCESS_FILTER_TIME,
+                                                 10));
+
+    /* Nothing stored yet */
+    msg = cached_result_entry(tmp_ctx, 0, now - 100, NULL);
+    assert_false(sdap_access_cached_result_valid(msg,
+                                                 SYSDB_LDAP_ACCESS_FILTER_TIME,
+                                                 60));
+
+    /* User refreshed after the result was stored, no modify timestamp */
+    msg = cached_result_entry(tmp_ctx, now - 10, now - 5, NULL);
+    assert_false(sdap_access_cached_result_valid(msg,
+                                                 SYSDB_LDAP_ACCESS_FILTER_TIME,
+                                                 60));
+
+    /* User refreshed, but not changed on the server */
+    msg = cached_result_entry(tmp_ctx, now - 10, now - 5, "20000101000000Z");
+    assert_true(sdap_access_cached_result_valid(msg,
+                                                SYSDB_LDAP_ACCESS_FILTER_TIME,
+                                                60));
+    msg = cached_result_entry(tmp_ctx, now - 10, now - 5, "20000101000000.0Z");
+    assert_true(sdap_access_cached_result_valid(msg,
+                                                SYSDB_LDAP_ACCESS_FILTER_TIME,
+                                                60));
+
+    /* User changed on the server after the result was stored */
+    msg = cached_result_entry(tmp_ctx, now - 10, now - 5, recent);
+    assert_false(sdap_access_cached_result_valid(msg,
+                                                 SYSDB_LDAP_ACCESS_FILTER_TIME,
+                                                 60));
+
+    talloc_free(tmp_ctx);
+}
+
 int main(void)
 {
     const struct CMUnitTest tests[] = {
@@ -258,6 +350,7 @@ int main(void)
         cmocka_unit_test_setup_teardown(test_sdap_access_rhost,
                                         test_sdap_access_rhost_setup,
                                         test_sdap_access_rhost_teardown),
+        cmocka_unit_test(test_sdap_access_cached_result),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,374 @@
+/*
+    Copyright (C) 2026 Red Hat
+
+    SSSD tests - LDAP TLS session cache
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <setjmp.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <cmocka.h>
+#include <popt.h>
+
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+#include "tests/common.h"
+
+/* Include source file to test static functions */
+#include "providers/ldap/sdap_tls_session.c"
+
+#define TEST_URI "ldaps://ldap.example.com"
+#define TEST_URI2 "ldaps://ldap2.example.com"
+
+/* The SSL object of the last client handshake, reported to
+ * sdap_tls_session_handshake_done() as if libldap owned it. */
+static SSL *test_client_ssl;
+
+int __real_ldap_get_option(LDAP *ld, int option, void *outvalue);
+
+int __wrap_ldap_get_option(LDAP *ld, int option, void *outvalue)
+{
+    switch (option) {
+    case LDAP_OPT_X_TLS_PACKAGE:
+        /* the system libldap may be built against another TLS library */
+        *(char **)outvalue = ber_strdup("OpenSSL");
+        return LDAP_OPT_SUCCESS;
+    case LDAP_OPT_X_TLS_SSL_CTX:
+        *(SSL **)outvalue = test_client_ssl;
+        return LDAP_OPT_SUCCESS;
+    default:
+        return __real_ldap_get_option(ld, option, outvalue);
+    }
+}
+
+struct test_tls_ctx {
+    SSL_CTX *server_ctx;
+    SSL_CTX *client_ctx;
+    LDAP *ldap;
+    LDAP *ldap2;
+};
+
+/* A stand-in for the LDAP server: a self-signed certificate is enough since
+ * the client does not verify it. */
+static SSL_CTX *test_server_ctx(void)
+{
+    EVP_PKEY_CTX *pctx;
+    EVP_PKEY *pkey = NULL;
+    X509 *cert;
+    X509_NAME *name;
+    SSL_CTX *ctx;
+    int ret;
+
+    pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL);
+    assert_non_null(pctx);
+    ret = EVP_PKEY_keygen_init(pctx);
+    assert_int_equal(ret, 1);
+    ret = EVP_PKEY_CTX_set_ec_paramgen_curve_nid(pctx, NID_X9_62_prime256v1);
+    assert_int_equal(ret, 1);
+    ret = EVP_PKEY_keygen(pctx, &pkey);
+    assert_int_equal(ret, 1);
+    EVP_PKEY_CTX_free(pctx);
+
+    cert = X509_new();
+    assert_non_null(cert);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, pkey);
+    name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                               (const unsigned char *)"ldap.example.com",
+                               -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    ret = X509_sign(cert, pkey, EVP_sha256());
+    assert_true(ret > 0);
+
+    ctx = SSL_CTX_new(TLS_server_method());
+    assert_non_null(ctx);
+    ret = SSL_CTX_use_certificate(ctx, cert);
+    assert_int_equal(ret, 1);
+    ret = SSL_CTX_use_PrivateKey(ctx, pkey);
+    assert_int_equal(ret, 1);
+
+    X509_free(cert);
+    EVP_PKEY_free(pkey);
+    return ctx;
+}
+
+static int test_tls_setup(void **state)
+{
+    struct test_tls_ctx *test_ctx;
+    errno_t ret;
+    int lret;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct test_tls_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->server_ctx = test_server_ctx();
+    test_ctx->client_ctx = SSL_CTX_new(TLS_client_method());
+    assert_non_null(test_ctx->client_ctx);
+    SSL_CTX_set_verify(test_ctx->client_ctx, SSL_VERIFY_NONE, NULL);
+
+    lret = ldap_initialize(&test_ctx->ldap, TEST_URI);
+    assert_int_equal(lret, LDAP_SUCCESS);
+    lret = ldap_initialize(&test_ctx->ldap2, TEST_URI2);
+    assert_int_equal(lret, LDAP_SUCCESS);
+
+    ret = sdap_tls_session_cache_setup();
+    assert_int_equal(ret, EOK);
+    assert_true(sdap_tls_cache.enabled);
+
+    check_leaks_push(test_ctx);
+    *state = test_ctx;
+    return 0;
+}
+
+static int test_tls_teardown(void **state)
+{
+    struct test_tls_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                          struct test_tls_ctx);
+
+    /* the cache is process-global, start every test from scratch */
+    talloc_zfree(sdap_tls_cache.mem_ctx);
+    sdap_tls_cache.sessions = NULL;
+    memset(&sdap_tls_cache.stats, 0, sizeof(sdap_tls_cache.stats));
+
+    assert_true(check_leaks_pop(test_ctx));
+
+    ldap_unbind_ext_s(test_ctx->ldap, NULL, NULL);
+    ldap_unbind_ext_s(test_ctx->ldap2, NULL, NULL);
+    SSL_CTX_free(test_ctx->client_ctx);
+    SSL_CTX_free(test_ctx->server_ctx);
+    talloc_free(test_ctx);
+
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+static bool test_tls_pump(SSL *ssl, int ret)
+{
+    switch (SSL_get_error(ssl, ret)) {
+    case SSL_ERROR_NONE:
+    case SSL_ERROR_WANT_READ:
+    case SSL_ERROR_WANT_WRITE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* Connect to the stand-in server the same way libldap does: create the SSL
+ * object, run the connect callback, do the handshake and report it. Returns
+ * whether the session was resumed. */
+static bool test_tls_connect(struct test_tls_ctx *test_ctx, LDAP *ldap)
+{
+    SSL *client;
+    SSL *server;
+    bool client_done = false;
+    bool server_done = false;
+    bool resumed;
+    char buf[1];
+    int fd[2];
+    int ret;
+    int i;
+
+    ret = socketpair(AF_UNIX, SOCK_STREAM, 0, fd);
+    assert_int_equal(ret, 0);
+    fcntl(fd[0], F_SETFL, O_NONBLOCK);
+    fcntl(fd[1], F_SETFL, O_NONBLOCK);
+
+    client = SSL_new(test_ctx->client_ctx);
+    assert_non_null(client);
+    SSL_set_fd(client, fd[0]);
+    SSL_set_connect_state(client);
+
+    server = SSL_new(test_ctx->server_ctx);
+    assert_non_null(server);
+    SSL_set_fd(server, fd[1]);
+    SSL_set_accept_state(server);
+
+    ret = sdap_tls_session_connect_cb(ldap, client, test_ctx->client_ctx,
+                                      NULL);
+    assert_int_equal(ret, 0);
+
+    for (i = 0; i < 100 && !(client_done && server_done); i++) {
+        if (!client_done) {
+            ret = SSL_do_handshake(client);
+            client_done = (ret == 1);
+            assert_true(test_tls_pump(client, ret));
+        }
+        if (!server_done) {
+            ret = SSL_do_handshake(server);
+            server_done = (ret == 1);
+            assert_true(test_tls_pump(server, ret));
+        }
+    }
+    assert_true(client_done && server_done);
+
+    /* TLS 1.3 session tickets are only processed when the client reads */
+    ret = SSL_write(server, "x", 1);
+    assert_int_equal(ret, 1);
+    ret = SSL_read(client, buf, sizeof(buf));
+    assert_int_equal(ret, 1);
+
+    test_client_ssl = client;
+    sdap_tls_session_handshake_done(ldap);
+    test_client_ssl = NULL;
+
+    resumed = SSL_session_reused(client);
+
+    SSL_free(client);
+    SSL_free(server);
+    close(fd[0]);
+    close(fd[1]);
+
+    return resumed;
+}
+
+static void test_tls_session_resume(void **state)
+{
+    struct test_tls_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                          struct test_tls_ctx);
+    struct sdap_tls_session_stats stats;
+
+    assert_false(test_tls_connect(test_ctx, test_ctx->ldap));
+    sdap_tls_session_get_stats(&stats);
+    assert_int_equal(stats.full, 1);
+    assert_int_equal(stats.resumed, 0);
+    assert_int_equal(stats.cached, 1);
+    assert_non_null(sdap_tls_session_lookup(TEST_URI));
+
+    assert_true(test_tls_connect(test_ctx, test_ctx->ldap));
+    assert_true(test_tls_connect(test_ctx, test_ctx->ldap));
+    sdap_tls_session_get_stats(&stats);
+    assert_int_equal(stats.full, 1);
+    assert_int_equal(stats.resumed, 2);
+    assert_int_equal(stats.cached, 1);
+
+    /* sessions are not shared between servers */
+    assert_false(test_tls_connect(test_ctx, test_ctx->ldap2));
+    sdap_tls_session_get_stats(&stats);
+    assert_int_equal(stats.full, 2);
+    assert_int_equal(stats.resumed, 2);
+    assert_int_equal(stats.cached, 2);
+}
+
+static void test_tls_session_forget(void **state)
+{
+    struct test_tls_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                          struct test_tls_ctx);
+    struct sdap_tls_session_stats stats;
+
+    assert_false(test_tls_connect(test_ctx, test_ctx->ldap));
+    assert_false(test_tls_connect(test_ctx, test_ctx->ldap2));
+
+    sdap_tls_session_forget(test_ctx->ldap);
+    sdap_tls_session_get_stats(&stats);
+    assert_int_equal(stats.cached, 1);
+    assert_null(sdap_tls_session_lookup(TEST_URI));
+    assert_non_null(sdap_tls_session_lookup(TEST_URI2));
+
+    /* falls back to a full handshake */
+    assert_false(test_tls_connect(test_ctx, test_ctx->ldap));
+    assert_true(test_tls_connect(test_ctx, test_ctx->ldap2));
+    sdap_tls_session_get_stats(&stats);
+    assert_int_equal(stats.full, 3);
+    assert_int_equal(stats.resumed, 1);
+    assert_int_equal(stats.cached, 2);
+}
+
+static void test_tls_session_evict(void **state)
+{
+    struct sdap_tls_session_stats stats;
+    SSL_SESSION *session;
+    char uri[64];
+    errno_t ret;
+    int i;
+
+    for (i = 0; i <= SDAP_TLS_SESSION_MAX; i++) {
+        snprintf(uri, sizeof(uri), "ldaps://ldap%d.example.com", i);
+        session = SSL_SESSION_new();
+        assert_non_null(session);
+
+        ret = sdap_tls_session_store(uri, session);
+        assert_int_equal(ret, EOK);
+
+        /* keep the first one in use */
+        assert_non_null(sdap_tls_session_lookup("ldaps://ldap0.example.com"));
+        if (i > 0) {
+            ret = sdap_tls_session_store("ldaps://ldap0.example.com",
+                                         SSL_SESSION_new());
+            assert_int_equal(ret, EOK);
+        }
+    }
+
+    sdap_tls_session_get_stats(&stats);
+    assert_int_equal(stats.cached, SDAP_TLS_SESSION_MAX);
+    assert_non_null(sdap_tls_session_lookup("ldaps://ldap0.example.com"));
+    assert_null(sdap_tls_session_lookup("ldaps://ldap1.example.com"));
+    assert_non_null(sdap_tls_session_lookup("ldaps://ldap2.example.com"));
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    int rv;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_tls_session_resume,
+                                        test_tls_setup,
+                                        test_tls_teardown),
+        cmocka_unit_test_setup_teardown(test_tls_session_forget,
+                                        test_tls_setup,
+                                        test_tls_teardown),
+        cmocka_unit_test_setup_teardown(test_tls_session_evict,
+                                        test_tls_setup,
+                                        test_tls_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    tests_set_cwd();
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+
+    return rv;
+}
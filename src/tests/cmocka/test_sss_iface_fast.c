@@ -0,0 +1,555 @@
+/*
+    Copyright (C) 2026 Red Hat
+
+    SSSD tests - Binary IPC between responders and the data provider
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <setjmp.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <cmocka.h>
+#include <popt.h>
+
+#include "tests/common.h"
+#include "sss_iface/sss_iface_async.h"
+#include "sss_iface/sss_iface_fast.h"
+
+#define TEST_DOMAIN "example.com"
+#define TEST_BUS_DP "sssd.test.dp"
+#define TEST_BUS_RESP "sssd.test.resp"
+#define TEST_NUM_CALLS 10000
+#define TEST_MAX_IN_FLIGHT 64
+
+struct test_fast_ctx {
+    struct tevent_context *ev;
+    struct sss_fast_conn *server;
+    struct sss_fast_client *client;
+
+    /* The same calls over sbus */
+    char *dir;
+    char *socket;
+    char *address;
+    struct sbus_server *sbus_server;
+    struct sbus_connection *dp_conn;
+    struct sbus_connection *resp_conn;
+    bool use_sbus;
+
+    size_t num_served;
+
+    /* Calls of the current test */
+    size_t num_sent;
+    size_t num_done;
+    size_t num_total;
+    size_t in_flight;
+    errno_t error;
+    bool done;
+};
+
+/* Replies with the entry type as error and the filter as error message,
+ * so the client can tell the replies apart. */
+static void test_server_frame(struct sss_fast_conn *conn,
+                              uint32_t serial,
+                              uint32_t code,
+                              const uint8_t *body,
+                              size_t body_len,
+                              void *data)
+{
+    struct test_fast_ctx *test_ctx;
+    struct sss_fast_account_req req;
+    uint8_t *reply;
+    size_t reply_len;
+    errno_t ret;
+
+    test_ctx = talloc_get_type_abort(data, struct test_fast_ctx);
+
+    assert_int_equal(code, SSS_FAST_DP_GET_ACCOUNT_INFO);
+
+    ret = sss_fast_account_req_unpack(body, body_len, &req);
+    assert_int_equal(ret, EOK);
+    assert_string_equal(req.domain, TEST_DOMAIN);
+
+    ret = sss_fast_account_reply_pack(test_ctx, 0, req.entry_type, req.filter,
+                                      &reply, &reply_len);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_fast_conn_send(conn, serial, EOK, reply, reply_len);
+    assert_int_equal(ret, EOK);
+
+    talloc_free(reply);
+    test_ctx->num_served++;
+}
+
+static void test_server_close(struct sss_fast_conn *conn,
+                              errno_t error,
+                              void *data)
+{
+    struct test_fast_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(data, struct test_fast_ctx);
+    talloc_zfree(test_ctx->server);
+}
+
+/* Replies like test_server_frame() */
+static errno_t
+test_sbus_getAccountInfo(TALLOC_CTX *mem_ctx,
+                         struct sbus_request *sbus_req,
+                         struct test_fast_ctx *test_ctx,
+                         uint32_t dp_flags,
+                         uint32_t entry_type,
+                         const char *filter,
+                         const char *domain,
+                         const char *extra,
+                         uint16_t *_dp_error,
+                         uint32_t *_error,
+                         const char **_error_message)
+{
+    assert_string_equal(domain, TEST_DOMAIN);
+
+    *_dp_error = 0;
+    *_error = entry_type;
+    *_error_message = talloc_strdup(mem_ctx, filter);
+    if (*_error_message == NULL) {
+        return ENOMEM;
+    }
+
+    test_ctx->num_served++;
+    return EOK;
+}
+
+static int test_fast_setup(void **state)
+{
+    struct test_fast_ctx *test_ctx;
+    int sv[2];
+    errno_t ret;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct test_fast_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->ev = tevent_context_init(test_ctx);
+    assert_non_null(test_ctx->ev);
+
+    ret = socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv);
+    assert_int_equal(ret, 0);
+
+    ret = sss_fast_conn_create(test_ctx, test_ctx->ev, sv[0],
+                               test_server_frame, test_server_close,
+                               test_ctx, &test_ctx->server);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_fast_client_create(test_ctx, test_ctx->ev, sv[1],
+                                 &test_ctx->client);
+    assert_int_equal(ret, EOK);
+
+    *state = test_ctx;
+    return 0;
+}
+
+static int test_fast_teardown(void **state)
+{
+    struct test_fast_ctx *test_ctx;
+    char *dir = NULL;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_fast_ctx);
+
+    if (test_ctx->dir != NULL) {
+        dir = talloc_strdup(NULL, test_ctx->dir);
+        assert_non_null(dir);
+        unlink(test_ctx->socket);
+    }
+
+    talloc_free(test_ctx);
+
+    if (dir != NULL) {
+        rmdir(dir);
+        talloc_free(dir);
+    }
+
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+static void test_fast_wait(struct test_fast_ctx *test_ctx)
+{
+    while (!test_ctx->done) {
+        assert_int_equal(tevent_loop_once(test_ctx->ev), 0);
+    }
+}
+
+static void test_fast_wait_req(struct test_fast_ctx *test_ctx,
+                               struct tevent_req *req)
+{
+    while (tevent_req_is_in_progress(req)) {
+        assert_int_equal(tevent_loop_once(test_ctx->ev), 0);
+    }
+}
+
+/* Also connects a responder to a data provider over sbus, as in
+ * test_sbus_request_arena */
+static int test_fast_sbus_setup(void **state)
+{
+    struct test_fast_ctx *test_ctx;
+    struct tevent_req *req;
+    errno_t ret;
+
+    test_fast_setup(state);
+    test_ctx = talloc_get_type_abort(*state, struct test_fast_ctx);
+
+    test_ctx->dir = talloc_strdup(test_ctx, "/tmp/test_sss_iface_fast.XXXXXX");
+    assert_non_null(test_ctx->dir);
+    assert_non_null(mkdtemp(test_ctx->dir));
+
+    test_ctx->socket = talloc_asprintf(test_ctx, "%s/sbus", test_ctx->dir);
+    assert_non_null(test_ctx->socket);
+
+    test_ctx->address = talloc_asprintf(test_ctx, "unix:path=%s",
+                                        test_ctx->socket);
+    assert_non_null(test_ctx->address);
+
+    SBUS_INTERFACE(iface_dp,
+        sssd_dataprovider,
+        SBUS_METHODS(
+            SBUS_SYNC(METHOD, sssd_dataprovider, getAccountInfo, test_sbus_getAccountInfo, test_ctx)
+        ),
+        SBUS_SIGNALS(SBUS_NO_SIGNALS),
+        SBUS_PROPERTIES(SBUS_NO_PROPERTIES)
+    );
+
+    req = sbus_server_create_and_connect_send(test_ctx, test_ctx->ev,
+                                              TEST_BUS_DP, NULL,
+                                              test_ctx->address, false, 100,
+                                              geteuid(), getegid());
+    assert_non_null(req);
+    test_fast_wait_req(test_ctx, req);
+
+    ret = sbus_server_create_and_connect_recv(test_ctx, req,
+                                              &test_ctx->sbus_server,
+                                              &test_ctx->dp_conn);
+    talloc_free(req);
+    assert_int_equal(ret, EOK);
+
+    ret = sbus_connection_add_path(test_ctx->dp_conn, SSS_BUS_PATH,
+                                   &iface_dp);
+    assert_int_equal(ret, EOK);
+
+    req = sbus_connect_private_send(test_ctx, test_ctx->ev,
+                                    test_ctx->address, TEST_BUS_RESP, NULL);
+    assert_non_null(req);
+    test_fast_wait_req(test_ctx, req);
+
+    ret = sbus_connect_private_recv(test_ctx, req, &test_ctx->resp_conn);
+    talloc_free(req);
+    assert_int_equal(ret, EOK);
+
+    return 0;
+}
+
+static void test_sss_fast_account_req_pack(void **state)
+{
+    struct sss_fast_account_req in = { 0 };
+    struct sss_fast_account_req out;
+    uint8_t *body;
+    size_t body_len;
+    errno_t ret;
+
+    in.dp_flags = 1;
+    in.entry_type = 0x1001;
+    in.filter = "name=user1";
+    in.domain = TEST_DOMAIN;
+    in.extra = NULL;
+
+    ret = sss_fast_account_req_pack(global_talloc_context, &in,
+                                    &body, &body_len);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_fast_account_req_unpack(body, body_len, &out);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(out.dp_flags, in.dp_flags);
+    assert_int_equal(out.entry_type, in.entry_type);
+    assert_string_equal(out.filter, in.filter);
+    assert_string_equal(out.domain, in.domain);
+    /* NULL is sent as an empty string, as with sbus */
+    assert_string_equal(out.extra, "");
+
+    /* Truncated bodies are rejected */
+    ret = sss_fast_account_req_unpack(body, body_len - 1, &out);
+    assert_int_equal(ret, EBADMSG);
+
+    ret = sss_fast_account_req_unpack(body, sizeof(uint32_t), &out);
+    assert_int_equal(ret, EBADMSG);
+
+    talloc_free(body);
+}
+
+static void test_fast_call_done(struct tevent_req *req);
+
+static errno_t test_fast_call_send(struct test_fast_ctx *test_ctx)
+{
+    struct tevent_req *req;
+    char *filter;
+
+    filter = talloc_asprintf(test_ctx, "name=user%zu", test_ctx->num_sent);
+    if (filter == NULL) {
+        return ENOMEM;
+    }
+
+    /* Every filter is different so no request is chained */
+    if (test_ctx->use_sbus) {
+        req = sbus_call_dp_dp_getAccountInfo_send(test_ctx,
+                  test_ctx->resp_conn, TEST_BUS_DP, SSS_BUS_PATH, 1,
+                  test_ctx->num_sent, filter, TEST_DOMAIN, "");
+    } else {
+        req = sss_fast_dp_getAccountInfo_send(test_ctx, test_ctx->client, 1,
+                                              test_ctx->num_sent, filter,
+                                              TEST_DOMAIN, NULL);
+    }
+    if (req == NULL) {
+        talloc_free(filter);
+        return ENOMEM;
+    }
+    talloc_steal(req, filter);
+
+    tevent_req_set_callback(req, test_fast_call_done, test_ctx);
+    test_ctx->num_sent++;
+    test_ctx->in_flight++;
+
+    return EOK;
+}
+
+static void test_fast_call_done(struct tevent_req *req)
+{
+    struct test_fast_ctx *test_ctx;
+    const char *error_message;
+    char *expected;
+    uint16_t dp_error;
+    uint32_t error;
+    errno_t ret;
+
+    test_ctx = tevent_req_callback_data(req, struct test_fast_ctx);
+    test_ctx->in_flight--;
+
+    if (test_ctx->use_sbus) {
+        ret = sbus_call_dp_dp_getAccountInfo_recv(test_ctx, req, &dp_error,
+                                                  &error, &error_message);
+    } else {
+        ret = sss_fast_dp_getAccountInfo_recv(test_ctx, req, &dp_error,
+                                              &error, &error_message);
+    }
+    talloc_free(req);
+    if (ret != EOK) {
+        test_ctx->error = ret;
+        test_ctx->done = true;
+        return;
+    }
+
+    /* The reply belongs to this request */
+    expected = talloc_asprintf(test_ctx, "name=user%"PRIu32, error);
+    assert_non_null(expected);
+    assert_int_equal(dp_error, 0);
+    assert_string_equal(error_message, expected);
+    talloc_free(expected);
+    talloc_free(discard_const(error_message));
+
+    test_ctx->num_done++;
+    if (test_ctx->num_done == test_ctx->num_total) {
+        test_ctx->done = true;
+        return;
+    }
+
+    while (test_ctx->num_sent < test_ctx->num_total
+            && test_ctx->in_flight < TEST_MAX_IN_FLIGHT) {
+        ret = test_fast_call_send(test_ctx);
+        assert_int_equal(ret, EOK);
+    }
+}
+
+static void test_fast_calls(struct test_fast_ctx *test_ctx, size_t num)
+{
+    errno_t ret;
+
+    test_ctx->num_sent = 0;
+    test_ctx->num_done = 0;
+    test_ctx->num_served = 0;
+    test_ctx->done = false;
+    test_ctx->num_total = num;
+
+    while (test_ctx->num_sent < num
+            && test_ctx->in_flight < TEST_MAX_IN_FLIGHT) {
+        ret = test_fast_call_send(test_ctx);
+        assert_int_equal(ret, EOK);
+    }
+
+    test_fast_wait(test_ctx);
+}
+
+static void test_sss_fast_getAccountInfo(void **state)
+{
+    struct test_fast_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_fast_ctx);
+
+    test_fast_calls(test_ctx, 1);
+
+    assert_int_equal(test_ctx->error, EOK);
+    assert_int_equal(test_ctx->num_done, 1);
+    assert_int_equal(test_ctx->num_served, 1);
+}
+
+static void test_sss_fast_getAccountInfo_many(void **state)
+{
+    struct test_fast_ctx *test_ctx;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_fast_ctx);
+
+    test_fast_calls(test_ctx, TEST_NUM_CALLS);
+
+    assert_int_equal(test_ctx->error, EOK);
+    assert_int_equal(test_ctx->num_done, TEST_NUM_CALLS);
+    assert_int_equal(test_ctx->num_served, TEST_NUM_CALLS);
+    assert_true(sss_fast_client_is_connected(test_ctx->client));
+}
+
+static uint64_t test_fast_bench(struct test_fast_ctx *test_ctx, bool use_sbus)
+{
+    struct timeval start;
+    struct timeval end;
+    uint64_t usec;
+
+    test_ctx->use_sbus = use_sbus;
+
+    gettimeofday(&start, NULL);
+    test_fast_calls(test_ctx, TEST_NUM_CALLS);
+    gettimeofday(&end, NULL);
+
+    assert_int_equal(test_ctx->error, EOK);
+    assert_int_equal(test_ctx->num_done, TEST_NUM_CALLS);
+    assert_int_equal(test_ctx->num_served, TEST_NUM_CALLS);
+
+    usec = (end.tv_sec - start.tv_sec) * 1000000
+           + (end.tv_usec - start.tv_usec);
+
+    return usec == 0 ? 0 : TEST_NUM_CALLS * UINT64_C(1000000) / usec;
+}
+
+/* The same calls over binary IPC and sbus, run with -d 0x0400 to see the
+ * call rates */
+static void test_sss_fast_bench_sbus(void **state)
+{
+    struct test_fast_ctx *test_ctx;
+    uint64_t fast_rate;
+    uint64_t sbus_rate;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_fast_ctx);
+
+    sbus_rate = test_fast_bench(test_ctx, true);
+    fast_rate = test_fast_bench(test_ctx, false);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "%d calls with up to %d in flight: "
+          "sbus %"PRIu64" calls/s, binary IPC %"PRIu64" calls/s, "
+          "%"PRIu64".%02"PRIu64"x\n", TEST_NUM_CALLS, TEST_MAX_IN_FLIGHT,
+          sbus_rate, fast_rate,
+          sbus_rate == 0 ? 0 : fast_rate / sbus_rate,
+          sbus_rate == 0 ? 0 : fast_rate * 100 / sbus_rate % 100);
+}
+
+static void test_sss_fast_getAccountInfo_conn_lost(void **state)
+{
+    struct test_fast_ctx *test_ctx;
+    struct tevent_req *req;
+
+    test_ctx = talloc_get_type_abort(*state, struct test_fast_ctx);
+
+    /* The server goes away before it reads the request */
+    talloc_zfree(test_ctx->server);
+
+    req = sss_fast_dp_getAccountInfo_send(test_ctx, test_ctx->client, 1,
+                                          0, "name=user0", TEST_DOMAIN, NULL);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_fast_call_done, test_ctx);
+    test_ctx->in_flight++;
+
+    test_fast_wait(test_ctx);
+
+    assert_int_equal(test_ctx->error, ENOTCONN);
+    assert_int_equal(test_ctx->num_done, 0);
+    assert_false(sss_fast_client_is_connected(test_ctx->client));
+
+    /* New requests fail right away */
+    test_ctx->done = false;
+    test_ctx->error = EOK;
+
+    req = sss_fast_dp_getAccountInfo_send(test_ctx, test_ctx->client, 1,
+                                          0, "name=user0", TEST_DOMAIN, NULL);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_fast_call_done, test_ctx);
+    test_ctx->in_flight++;
+
+    test_fast_wait(test_ctx);
+
+    assert_int_equal(test_ctx->error, ENOTCONN);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sss_fast_account_req_pack),
+        cmocka_unit_test_setup_teardown(test_sss_fast_getAccountInfo,
+                                        test_fast_setup,
+                                        test_fast_teardown),
+        cmocka_unit_test_setup_teardown(test_sss_fast_getAccountInfo_many,
+                                        test_fast_setup,
+                                        test_fast_teardown),
+        cmocka_unit_test_setup_teardown(test_sss_fast_getAccountInfo_conn_lost,
+                                        test_fast_setup,
+                                        test_fast_teardown),
+        cmocka_unit_test_setup_teardown(test_sss_fast_bench_sbus,
+                                        test_fast_sbus_setup,
+                                        test_fast_teardown),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    tests_set_cwd();
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,452 @@
+/*
+    Copyright (C) 2026 Red Hat
+
+    SSSD tests: Sudo rules memory cache
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <popt.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+
+#include "util/util.h"
+#include "db/sysdb.h"
+#include "responder/nss/nsssrv_mmap_cache.h"
+#include "responder/sudo/sudosrv_private.h"
+#include "sss_client/sss_cli.h"
+#include "sss_client/sudo/sss_sudo.h"
+#include "tests/cmocka/common_mock.h"
+
+#define TEST_MC_FILE        SSS_NSS_MCACHE_DIR"/sudo"
+#define TEST_MC_ELEMENTS    100
+#define TEST_MC_TIMEOUT     300
+
+#define TEST_USER           "user1"
+#define TEST_UID            1001
+
+/* The client library takes these from sss_client/common.c */
+void sss_nss_mc_lock(void)
+{
+    return;
+}
+
+void sss_nss_mc_unlock(void)
+{
+    return;
+}
+
+/* Every request that misses the memory cache ends up here. */
+static int socket_requests;
+
+int sss_sudo_make_request(enum sss_cli_command cmd,
+                          struct sss_cli_req_data *rd,
+                          uint8_t **repbuf, size_t *replen,
+                          int *errnop)
+{
+    socket_requests++;
+    *errnop = EHOSTDOWN;
+    return SSS_STATUS_UNAVAIL;
+}
+
+struct sudo_mc_test_ctx {
+    struct sss_mc_ctx *mcc;
+};
+
+static struct sudo_mc_test_ctx *global_test_ctx;
+
+static struct sysdb_attrs **create_rules(TALLOC_CTX *mem_ctx,
+                                         uint32_t num_rules)
+{
+    struct sysdb_attrs **rules;
+    char *name;
+    uint32_t i;
+    errno_t ret;
+
+    rules = talloc_zero_array(mem_ctx, struct sysdb_attrs *, num_rules);
+    assert_non_null(rules);
+
+    for (i = 0; i < num_rules; i++) {
+        rules[i] = sysdb_new_attrs(rules);
+        assert_non_null(rules[i]);
+
+        name = talloc_asprintf(rules, "rule%u", i);
+        assert_non_null(name);
+
+        ret = sysdb_attrs_add_string(rules[i], "cn", name);
+        assert_int_equal(ret, EOK);
+        ret = sysdb_attrs_add_string(rules[i], "sudoUser", TEST_USER);
+        assert_int_equal(ret, EOK);
+        ret = sysdb_attrs_add_string(rules[i], "sudoHost", "ALL");
+        assert_int_equal(ret, EOK);
+        ret = sysdb_attrs_add_string(rules[i], "sudoCommand", "/bin/ls");
+        assert_int_equal(ret, EOK);
+        ret = sysdb_attrs_add_string(rules[i], "sudoCommand", "/bin/cat");
+        assert_int_equal(ret, EOK);
+    }
+
+    return rules;
+}
+
+static errno_t store_rules(struct sss_mc_ctx **mcc,
+                           uint32_t command,
+                           uid_t uid,
+                           const char *username,
+                           uint32_t num_rules)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sysdb_attrs **rules;
+    struct sized_string user;
+    uint8_t *body;
+    size_t body_len;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    assert_non_null(tmp_ctx);
+
+    rules = create_rules(tmp_ctx, num_rules);
+
+    ret = sudosrv_build_response(tmp_ctx, SSS_SUDO_ERROR_OK, num_rules, rules,
+                                 &body, &body_len);
+    assert_int_equal(ret, EOK);
+
+    to_sized_string(&user, username);
+    ret = sss_mmap_cache_sudo_store(mcc, command, uid, &user, body, body_len);
+
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static void assert_rules(uid_t uid, const char *username, uint32_t num_rules)
+{
+    struct sss_sudo_result *result = NULL;
+    char **values = NULL;
+    char *name;
+    uint32_t error;
+    uint32_t i;
+    int requests = socket_requests;
+    int ret;
+
+    ret = sss_sudo_send_recv(uid, username, NULL, &error, &result);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(error, SSS_SUDO_ERROR_OK);
+    assert_non_null(result);
+    assert_int_equal(result->num_rules, num_rules);
+
+    /* the rules were not fetched from the responder */
+    assert_int_equal(socket_requests, requests);
+
+    for (i = 0; i < num_rules; i++) {
+        ret = sss_sudo_get_values(&result->rules[i], "cn", &values);
+        assert_int_equal(ret, EOK);
+        name = talloc_asprintf(global_test_ctx, "rule%u", i);
+        assert_non_null(name);
+        assert_string_equal(values[0], name);
+        assert_null(values[1]);
+        talloc_free(name);
+        sss_sudo_free_values(values);
+
+        ret = sss_sudo_get_values(&result->rules[i], "sudoCommand", &values);
+        assert_int_equal(ret, EOK);
+        assert_string_equal(values[0], "/bin/ls");
+        assert_string_equal(values[1], "/bin/cat");
+        assert_null(values[2]);
+        sss_sudo_free_values(values);
+    }
+
+    sss_sudo_free_result(result);
+}
+
+static void assert_no_rules(uid_t uid, const char *username)
+{
+    struct sss_sudo_result *result = NULL;
+    uint32_t error;
+    int requests = socket_requests;
+    int ret;
+
+    ret = sss_sudo_send_recv(uid, username, NULL, &error, &result);
+    assert_int_equal(ret, EHOSTDOWN);
+    assert_null(result);
+
+    /* the client fell back to the responder */
+    assert_int_equal(socket_requests, requests + 1);
+}
+
+static errno_t sudo_mc_init(TALLOC_CTX *mem_ctx, size_t n_elem,
+                            struct sss_mc_ctx **_mcc)
+{
+    return sss_mmap_cache_init(mem_ctx, "sudo", geteuid(), getegid(),
+                               SSS_MC_SUDO, n_elem,
+                               TEST_MC_TIMEOUT, _mcc);
+}
+
+static int setup_sudo_mc_group(void **state)
+{
+    errno_t ret;
+
+    ret = mkdir(SSS_NSS_MCACHE_DIR, 0775);
+    assert_true(ret == 0 || errno == EEXIST);
+
+    global_test_ctx = talloc_zero(NULL, struct sudo_mc_test_ctx);
+    assert_non_null(global_test_ctx);
+
+    /* The client keeps the file mapped for the whole run, so all tests share
+     * one cache and clean up after themselves with sss_mmap_cache_reset(). */
+    ret = sudo_mc_init(global_test_ctx, TEST_MC_ELEMENTS,
+                       &global_test_ctx->mcc);
+    assert_int_equal(ret, EOK);
+
+    return 0;
+}
+
+static int teardown_sudo_mc_group(void **state)
+{
+    talloc_zfree(global_test_ctx);
+    unlink(TEST_MC_FILE);
+    rmdir(SSS_NSS_MCACHE_DIR);
+    return 0;
+}
+
+static int teardown_sudo_mc(void **state)
+{
+    sss_mmap_cache_reset(global_test_ctx->mcc);
+    return 0;
+}
+
+static void test_sudo_mc_file_mode(void **state)
+{
+    struct stat st;
+    int ret;
+
+    /* only sudo running as root may read the rules */
+    ret = stat(TEST_MC_FILE, &st);
+    assert_int_equal(ret, 0);
+    assert_int_equal(st.st_mode & 0777, 0600);
+}
+
+static void test_sudo_mc_hit(void **state)
+{
+    errno_t ret;
+
+    assert_no_rules(TEST_UID, TEST_USER);
+
+    ret = store_rules(&global_test_ctx->mcc, SSS_SUDO_GET_SUDORULES,
+                      TEST_UID, TEST_USER, 3);
+    assert_int_equal(ret, EOK);
+
+    assert_rules(TEST_UID, TEST_USER, 3);
+
+    /* replace the rule set */
+    ret = store_rules(&global_test_ctx->mcc, SSS_SUDO_GET_SUDORULES,
+                      TEST_UID, TEST_USER, 5);
+    assert_int_equal(ret, EOK);
+
+    assert_rules(TEST_UID, TEST_USER, 5);
+}
+
+static void test_sudo_mc_key(void **state)
+{
+    struct sss_sudo_result *result = NULL;
+    char *domainname = NULL;
+    uint32_t error;
+    errno_t ret;
+
+    ret = store_rules(&global_test_ctx->mcc, SSS_SUDO_GET_SUDORULES,
+                      TEST_UID, TEST_USER, 1);
+    assert_int_equal(ret, EOK);
+
+    /* the reply depends on everything the client sends */
+    assert_no_rules(TEST_UID + 1, TEST_USER);
+    assert_no_rules(TEST_UID, TEST_USER "@example.com");
+    assert_no_rules(TEST_UID, "user");
+
+    ret = sss_sudo_send_recv_defaults(TEST_UID, TEST_USER, &error,
+                                      &domainname, &result);
+    assert_int_equal(ret, EHOSTDOWN);
+    assert_null(result);
+
+    ret = store_rules(&global_test_ctx->mcc, SSS_SUDO_GET_DEFAULTS,
+                      TEST_UID, TEST_USER, 2);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_sudo_send_recv_defaults(TEST_UID, TEST_USER, &error,
+                                      &domainname, &result);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(error, SSS_SUDO_ERROR_OK);
+    assert_non_null(result);
+    assert_int_equal(result->num_rules, 2);
+    sss_sudo_free_result(result);
+    free(domainname);
+
+    assert_rules(TEST_UID, TEST_USER, 1);
+}
+
+static void test_sudo_mc_invalidate_user(void **state)
+{
+    struct sized_string user;
+    errno_t ret;
+
+    ret = store_rules(&global_test_ctx->mcc, SSS_SUDO_GET_SUDORULES,
+                      TEST_UID, TEST_USER, 1);
+    assert_int_equal(ret, EOK);
+
+    ret = store_rules(&global_test_ctx->mcc, SSS_SUDO_GET_SUDORULES,
+                      TEST_UID + 1, "user2", 1);
+    assert_int_equal(ret, EOK);
+
+    to_sized_string(&user, TEST_USER);
+    ret = sss_mmap_cache_sudo_invalidate_user(global_test_ctx->mcc, &user);
+    assert_int_equal(ret, EOK);
+
+    assert_no_rules(TEST_UID, TEST_USER);
+    assert_rules(TEST_UID + 1, "user2", 1);
+
+    /* nothing left to invalidate */
+    ret = sss_mmap_cache_sudo_invalidate_user(global_test_ctx->mcc, &user);
+    assert_int_equal(ret, ENOENT);
+}
+
+static void test_sudo_mc_too_big(void **state)
+{
+    errno_t ret;
+
+    /* a single rule set must not evict the rest of the cache */
+    ret = store_rules(&global_test_ctx->mcc, SSS_SUDO_GET_SUDORULES,
+                      TEST_UID, TEST_USER, 1000);
+    assert_int_equal(ret, E2BIG);
+
+    assert_no_rules(TEST_UID, TEST_USER);
+}
+
+static double time_diff(struct timeval *start, struct timeval *end)
+{
+    return (end->tv_sec - start->tv_sec)
+           + (end->tv_usec - start->tv_usec) / 1000000.0;
+}
+
+static void benchmark_sudo_mc(int iterations)
+{
+    struct sss_mc_ctx *mcc = NULL;
+    struct sss_sudo_result *result;
+    struct timeval start;
+    struct timeval end;
+    uint32_t num_rules[] = { 1, 10, 50 };
+    uint32_t error;
+    double elapsed;
+    int i;
+    int j;
+    errno_t ret;
+
+    ret = mkdir(SSS_NSS_MCACHE_DIR, 0775);
+    if (ret != 0 && errno != EEXIST) {
+        fprintf(stderr, "Unable to create %s\n", SSS_NSS_MCACHE_DIR);
+        return;
+    }
+
+    ret = sudo_mc_init(NULL, SUDO_MC_CACHE_ELEMENTS, &mcc);
+    if (ret != EOK) {
+        fprintf(stderr, "Unable to initialize the cache [%d]\n", ret);
+        goto done;
+    }
+
+    for (i = 0; i < sizeof(num_rules) / sizeof(num_rules[0]); i++) {
+        ret = store_rules(&mcc, SSS_SUDO_GET_SUDORULES, TEST_UID, TEST_USER,
+                          num_rules[i]);
+        if (ret != EOK) {
+            fprintf(stderr, "Unable to store %u rules [%d]\n",
+                    num_rules[i], ret);
+            goto done;
+        }
+
+        gettimeofday(&start, NULL);
+        for (j = 0; j < iterations; j++) {
+            ret = sss_sudo_send_recv(TEST_UID, TEST_USER, NULL,
+                                     &error, &result);
+            if (ret != EOK) {
+                fprintf(stderr, "Unable to read the rules [%d]\n", ret);
+                goto done;
+            }
+            sss_sudo_free_result(result);
+        }
+        gettimeofday(&end, NULL);
+        elapsed = time_diff(&start, &end);
+        printf("%3u rules: %d lookups in %.3f s (%.2f us per lookup)\n",
+               num_rules[i], iterations, elapsed,
+               elapsed * 1000000.0 / iterations);
+    }
+
+done:
+    talloc_free(mcc);
+    unlink(TEST_MC_FILE);
+    rmdir(SSS_NSS_MCACHE_DIR);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    int rv;
+    int benchmark = 0;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        { "benchmark", 0, POPT_ARG_INT, &benchmark, 0,
+          "Measure the latency of the given number of cached lookups", NULL },
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sudo_mc_file_mode),
+        cmocka_unit_test_teardown(test_sudo_mc_hit,
+                                  teardown_sudo_mc),
+        cmocka_unit_test_teardown(test_sudo_mc_key,
+                                  teardown_sudo_mc),
+        cmocka_unit_test_teardown(test_sudo_mc_invalidate_user,
+                                  teardown_sudo_mc),
+        cmocka_unit_test_teardown(test_sudo_mc_too_big,
+                                  teardown_sudo_mc),
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    tests_set_cwd();
+
+    if (benchmark > 0) {
+        benchmark_sudo_mc(benchmark);
+        return 0;
+    }
+
+    rv = cmocka_run_group_tests(tests, setup_sudo_mc_group,
+                                teardown_sudo_mc_group);
+
+    return rv;
+}
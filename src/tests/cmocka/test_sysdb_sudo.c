@@ -481,6 +481,83 @@ void test_sudo_purge_by_rules(void **state)
     talloc_zfree(rule);
 }
 
+void test_sudo_sync(void **state)
+{
+    errno_t ret;
+    struct sysdb_attrs *rules[3];
+    struct sysdb_sudo_sync_stats stats;
+    const char *attrs[] = { SYSDB_SUDO_CACHE_AT_COMMAND, NULL };
+    struct ldb_message **msgs = NULL;
+    size_t msgs_count;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                         struct sysdb_test_ctx);
+
+    for (int i = 0; i < 3; i++) {
+        rules[i] = sysdb_new_attrs(test_ctx);
+        assert_non_null(rules[i]);
+        create_rule_attrs(rules[i], i);
+    }
+
+    ret = sysdb_attrs_add_string_safe(rules[1], SYSDB_SUDO_CACHE_AT_OPTION,
+                                      "!authenticate");
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_sudo_sync(test_ctx->tctx->dom, "(objectClass=sudoRule)",
+                          rules, 3, &stats);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(stats.added, 3);
+    assert_int_equal(stats.modified, 0);
+    assert_int_equal(stats.deleted, 0);
+    assert_int_equal(stats.unchanged, 0);
+    assert_int_equal(get_stored_rules_count(test_ctx), 3);
+
+    ret = sysdb_search_sudo_rules(test_ctx, test_ctx->tctx->dom,
+                                  "(sudoOption=!authenticate)",
+                                  attrs, &msgs_count, &msgs);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(msgs_count, 1);
+    talloc_zfree(msgs);
+
+    /* rule 0 is unchanged, rule 1 is modified and rule 2 was deleted,
+     * the modified rule 1 also lost its sudoOption */
+    for (int i = 0; i < 2; i++) {
+        talloc_free(rules[i]);
+        rules[i] = sysdb_new_attrs(test_ctx);
+        assert_non_null(rules[i]);
+        create_rule_attrs(rules[i], i);
+    }
+
+    ret = sysdb_attrs_add_string_safe(rules[1], SYSDB_SUDO_CACHE_AT_COMMAND,
+                                      "/bin/true");
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_sudo_sync(test_ctx->tctx->dom, "(objectClass=sudoRule)",
+                          rules, 2, &stats);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(stats.added, 0);
+    assert_int_equal(stats.modified, 1);
+    assert_int_equal(stats.deleted, 1);
+    assert_int_equal(stats.unchanged, 1);
+    assert_int_equal(get_stored_rules_count(test_ctx), 2);
+
+    ret = sysdb_search_sudo_rules(test_ctx, test_ctx->tctx->dom,
+                                  "(sudoCommand=/bin/true)",
+                                  attrs, &msgs_count, &msgs);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(msgs_count, 1);
+    talloc_zfree(msgs);
+
+    ret = sysdb_search_sudo_rules(test_ctx, test_ctx->tctx->dom,
+                                  "(sudoOption=*)",
+                                  attrs, &msgs_count, &msgs);
+    assert_int_equal(ret, ENOENT);
+
+    talloc_zfree(msgs);
+    for (int i = 0; i < 3; i++) {
+        talloc_zfree(rules[i]);
+    }
+}
+
 void test_sudo_set_get_last_full_refresh(void **state)
 {
     errno_t ret;
@@ -981,6 +1058,11 @@ int main(int argc, const char *argv[])
                                         test_sysdb_setup,
                                         test_sysdb_teardown),
 
+        /* sysdb_sudo_sync() */
+        cmocka_unit_test_setup_teardown(test_sudo_sync,
+                                        test_sysdb_setup,
+                                        test_sysdb_teardown),
+
         /*
          * sysdb_sudo_set_last_full_refresh()
          * sysdb_sudo_get_last_full_refresh()
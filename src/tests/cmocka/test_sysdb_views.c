@@ -26,6 +26,7 @@
 #include <stdarg.h>
 #include <stddef.h>
 #include <setjmp.h>
+#include <sys/time.h>
 #include <cmocka.h>
 #include <popt.h>
 
@@ -515,6 +516,389 @@ void test_sysdb_invalidate_overrides(void **state)
     assert_int_equal(ret, EOK);
 }
 
+#define TEST_MEMBER_GROUP_NAME "members_group"
+#define TEST_MEMBER_GROUP_GID 4321
+#define TEST_NUM_MEMBERS 100
+
+static void store_user_with_override(TALLOC_CTX *mem_ctx,
+                                     struct sysdb_test_ctx *test_ctx,
+                                     const char *name,
+                                     uid_t uid,
+                                     const char *override_name,
+                                     bool has_override)
+{
+    struct sysdb_attrs *attrs = NULL;
+    const char *anchor;
+    struct ldb_dn *dn;
+    int ret;
+
+    ret = sysdb_store_user(test_ctx->domain, name, NULL, uid, TEST_USER_GID,
+                           TEST_USER_GECOS, TEST_USER_HOMEDIR,
+                           TEST_USER_SHELL, NULL, NULL, NULL, 0, 0);
+    assert_int_equal(ret, EOK);
+
+    dn = sysdb_user_dn(mem_ctx, test_ctx->domain, name);
+    assert_non_null(dn);
+
+    if (has_override) {
+        attrs = sysdb_new_attrs(mem_ctx);
+        assert_non_null(attrs);
+
+        anchor = talloc_asprintf(mem_ctx, "%s%u", TEST_ANCHOR_PREFIX, uid);
+        assert_non_null(anchor);
+        ret = sysdb_attrs_add_string(attrs, SYSDB_OVERRIDE_ANCHOR_UUID,
+                                     anchor);
+        assert_int_equal(ret, EOK);
+
+        if (override_name != NULL) {
+            ret = sysdb_attrs_add_string(attrs, SYSDB_NAME, override_name);
+            assert_int_equal(ret, EOK);
+        } else {
+            ret = sysdb_attrs_add_string(attrs, SYSDB_GECOS,
+                                         "Override gecos");
+            assert_int_equal(ret, EOK);
+        }
+    }
+
+    ret = sysdb_store_override(test_ctx->domain, TEST_VIEW_NAME,
+                               SYSDB_MEMBER_USER, attrs, dn);
+    assert_int_equal(ret, EOK);
+}
+
+/* Store a group with num_members members. Every third member has no
+ * override, every other member with an override has its name overridden.
+ * num_other users that are not members of the group get a name override
+ * as well. Returns the name of the group. */
+static char *store_member_group(TALLOC_CTX *mem_ctx,
+                                struct sysdb_test_ctx *test_ctx,
+                                size_t num_members,
+                                size_t num_other)
+{
+    int ret;
+    size_t c;
+    char *group_name;
+    char *name;
+    char *override_name;
+
+    test_ctx->domain->mpg_mode = MPG_DISABLED;
+
+    ret = sysdb_update_view_name(test_ctx->domain->sysdb, TEST_VIEW_NAME);
+    assert_int_equal(ret, EOK);
+
+    group_name = sss_create_internal_fqname(mem_ctx, TEST_MEMBER_GROUP_NAME,
+                                            test_ctx->domain->name);
+    assert_non_null(group_name);
+
+    ret = sysdb_store_group(test_ctx->domain, group_name,
+                            TEST_MEMBER_GROUP_GID, NULL, 0, 0);
+    assert_int_equal(ret, EOK);
+
+    for (c = 0; c < num_members; c++) {
+        name = sss_create_internal_fqname(mem_ctx,
+                                          talloc_asprintf(mem_ctx, "member%zu",
+                                                          c),
+                                          test_ctx->domain->name);
+        assert_non_null(name);
+
+        override_name = NULL;
+        if (c % 3 != 0 && c % 2 == 0) {
+            override_name = talloc_asprintf(mem_ctx, "override%zu", c);
+            assert_non_null(override_name);
+        }
+
+        store_user_with_override(mem_ctx, test_ctx, name, TEST_USER_UID + c,
+                                 override_name, c % 3 != 0);
+
+        ret = sysdb_add_group_member(test_ctx->domain, group_name, name,
+                                     SYSDB_MEMBER_USER, false);
+        assert_int_equal(ret, EOK);
+    }
+
+    for (c = 0; c < num_other; c++) {
+        name = sss_create_internal_fqname(mem_ctx,
+                                          talloc_asprintf(mem_ctx, "other%zu",
+                                                          c),
+                                          test_ctx->domain->name);
+        assert_non_null(name);
+
+        override_name = talloc_asprintf(mem_ctx, "other_override%zu", c);
+        assert_non_null(override_name);
+
+        store_user_with_override(mem_ctx, test_ctx, name,
+                                 TEST_USER_UID + num_members + c,
+                                 override_name, true);
+    }
+
+    return group_name;
+}
+
+/* The other tests count the users of the domain */
+static void delete_member_group(TALLOC_CTX *mem_ctx,
+                                struct sysdb_test_ctx *test_ctx,
+                                const char *group_name,
+                                size_t num_members,
+                                size_t num_other)
+{
+    int ret;
+    size_t c;
+    char *name;
+
+    ret = sysdb_delete_group(test_ctx->domain, group_name, 0);
+    assert_int_equal(ret, EOK);
+
+    for (c = 0; c < num_members; c++) {
+        name = sss_create_internal_fqname(mem_ctx,
+                                          talloc_asprintf(mem_ctx, "member%zu",
+                                                          c),
+                                          test_ctx->domain->name);
+        assert_non_null(name);
+
+        ret = sysdb_delete_user(test_ctx->domain, name, 0);
+        assert_int_equal(ret, EOK);
+    }
+
+    for (c = 0; c < num_other; c++) {
+        name = sss_create_internal_fqname(mem_ctx,
+                                          talloc_asprintf(mem_ctx, "other%zu",
+                                                          c),
+                                          test_ctx->domain->name);
+        assert_non_null(name);
+
+        ret = sysdb_delete_user(test_ctx->domain, name, 0);
+        assert_int_equal(ret, EOK);
+    }
+
+    ret = sysdb_delete_view_tree(test_ctx->domain->sysdb, TEST_VIEW_NAME);
+    assert_int_equal(ret, EOK);
+}
+
+static void check_member_overrides(TALLOC_CTX *mem_ctx,
+                                   struct sysdb_test_ctx *test_ctx,
+                                   struct ldb_message *msg,
+                                   size_t num_members)
+{
+    struct ldb_message_element *el;
+    char *expected;
+    size_t c;
+    size_t i;
+
+    el = ldb_msg_find_element(msg, OVERRIDE_PREFIX SYSDB_MEMBERUID);
+    assert_non_null(el);
+    assert_int_equal(el->num_values, num_members);
+
+    for (c = 0; c < num_members; c++) {
+        if (c % 3 != 0 && c % 2 == 0) {
+            expected = talloc_asprintf(mem_ctx, "override%zu", c);
+        } else {
+            expected = talloc_asprintf(mem_ctx, "member%zu", c);
+        }
+        expected = sss_create_internal_fqname(mem_ctx, expected,
+                                              test_ctx->domain->name);
+        assert_non_null(expected);
+
+        for (i = 0; i < el->num_values; i++) {
+            if (strcmp((const char *) el->values[i].data, expected) == 0) {
+                break;
+            }
+        }
+        assert_true(i < el->num_values);
+    }
+}
+
+/* Large enough to read all overrides of the view with a single search */
+void test_sysdb_add_group_member_overrides(void **state)
+{
+    int ret;
+    struct ldb_message *msg;
+    char *group_name;
+    TALLOC_CTX *tmp_ctx;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                         struct sysdb_test_ctx);
+
+    tmp_ctx = talloc_new(test_ctx);
+    assert_non_null(tmp_ctx);
+
+    group_name = store_member_group(tmp_ctx, test_ctx, TEST_NUM_MEMBERS, 0);
+
+    ret = sysdb_search_group_by_name(tmp_ctx, test_ctx->domain, group_name,
+                                     NULL, &msg);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_add_group_member_overrides(test_ctx->domain, msg, true);
+    assert_int_equal(ret, EOK);
+
+    check_member_overrides(tmp_ctx, test_ctx, msg, TEST_NUM_MEMBERS);
+
+    delete_member_group(tmp_ctx, test_ctx, group_name, TEST_NUM_MEMBERS, 0);
+    talloc_free(tmp_ctx);
+}
+
+/* The view has many more overrides than the group has members with an
+ * override, the overrides are read one by one */
+void test_sysdb_add_group_member_overrides_large_view(void **state)
+{
+    int ret;
+    struct ldb_message *msg;
+    char *group_name;
+    TALLOC_CTX *tmp_ctx;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                         struct sysdb_test_ctx);
+
+    tmp_ctx = talloc_new(test_ctx);
+    assert_non_null(tmp_ctx);
+
+    group_name = store_member_group(tmp_ctx, test_ctx, TEST_NUM_MEMBERS,
+                                    TEST_NUM_MEMBERS * 5);
+
+    ret = sysdb_search_group_by_name(tmp_ctx, test_ctx->domain, group_name,
+                                     NULL, &msg);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_add_group_member_overrides(test_ctx->domain, msg, true);
+    assert_int_equal(ret, EOK);
+
+    check_member_overrides(tmp_ctx, test_ctx, msg, TEST_NUM_MEMBERS);
+
+    delete_member_group(tmp_ctx, test_ctx, group_name, TEST_NUM_MEMBERS,
+                        TEST_NUM_MEMBERS * 5);
+    talloc_free(tmp_ctx);
+}
+
+static void check_overrides_to_objects(struct sysdb_test_ctx *test_ctx,
+                                       size_t num_other)
+{
+    int ret;
+    size_t c;
+    char *group_name;
+    char *name;
+    char *expected;
+    const char *attrs[] = SYSDB_PW_ATTRS;
+    struct ldb_message **msgs;
+    TALLOC_CTX *tmp_ctx;
+
+    tmp_ctx = talloc_new(test_ctx);
+    assert_non_null(tmp_ctx);
+
+    group_name = store_member_group(tmp_ctx, test_ctx, TEST_NUM_MEMBERS,
+                                    num_other);
+
+    msgs = talloc_array(tmp_ctx, struct ldb_message *, TEST_NUM_MEMBERS);
+    assert_non_null(msgs);
+
+    for (c = 0; c < TEST_NUM_MEMBERS; c++) {
+        name = sss_create_internal_fqname(tmp_ctx,
+                                          talloc_asprintf(tmp_ctx, "member%zu",
+                                                          c),
+                                          test_ctx->domain->name);
+        assert_non_null(name);
+
+        ret = sysdb_search_user_by_name(msgs, test_ctx->domain, name, attrs,
+                                        &msgs[c]);
+        assert_int_equal(ret, EOK);
+    }
+
+    ret = sysdb_add_overrides_to_objects(test_ctx->domain, msgs,
+                                         TEST_NUM_MEMBERS);
+    assert_int_equal(ret, EOK);
+
+    for (c = 0; c < TEST_NUM_MEMBERS; c++) {
+        if (c % 3 == 0) {
+            assert_null(ldb_msg_find_element(msgs[c],
+                                             OVERRIDE_PREFIX SYSDB_NAME));
+            assert_null(ldb_msg_find_element(msgs[c],
+                                             OVERRIDE_PREFIX SYSDB_GECOS));
+        } else if (c % 2 == 0) {
+            expected = talloc_asprintf(tmp_ctx, "override%zu", c);
+            assert_non_null(expected);
+            assert_string_equal(ldb_msg_find_attr_as_string(msgs[c],
+                                            OVERRIDE_PREFIX SYSDB_NAME, NULL),
+                                expected);
+        } else {
+            assert_null(ldb_msg_find_element(msgs[c],
+                                             OVERRIDE_PREFIX SYSDB_NAME));
+            assert_string_equal(ldb_msg_find_attr_as_string(msgs[c],
+                                            OVERRIDE_PREFIX SYSDB_GECOS, NULL),
+                                "Override gecos");
+        }
+    }
+
+    delete_member_group(tmp_ctx, test_ctx, group_name, TEST_NUM_MEMBERS,
+                        num_other);
+    talloc_free(tmp_ctx);
+}
+
+/* Many users with overrides, all overrides are read with a single search */
+void test_sysdb_add_overrides_to_objects(void **state)
+{
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                         struct sysdb_test_ctx);
+
+    check_overrides_to_objects(test_ctx, 0);
+}
+
+/* The view has many more overrides, they are read one by one */
+void test_sysdb_add_overrides_to_objects_large_view(void **state)
+{
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                         struct sysdb_test_ctx);
+
+    check_overrides_to_objects(test_ctx, TEST_NUM_MEMBERS * 5);
+}
+
+#define BENCHMARK_LOOKUPS 10
+
+static void benchmark_member_overrides_run(struct sysdb_test_ctx *test_ctx,
+                                           const char *group_name,
+                                           int num_members,
+                                           bool views)
+{
+    struct ldb_result *res;
+    struct timeval start;
+    struct timeval end;
+    double elapsed;
+    int ret;
+    int i;
+
+    test_ctx->domain->has_views = views;
+    test_ctx->domain->view_name = views ? TEST_VIEW_NAME : NULL;
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < BENCHMARK_LOOKUPS; i++) {
+        ret = sysdb_getgrnam_with_views(test_ctx, test_ctx->domain,
+                                        group_name, &res);
+        assert_int_equal(ret, EOK);
+        assert_int_equal(res->count, 1);
+        talloc_free(res);
+    }
+    gettimeofday(&end, NULL);
+
+    elapsed = (end.tv_sec - start.tv_sec)
+                + (end.tv_usec - start.tv_usec) / 1000000.0;
+    printf("Group with %d members, views %s: %.1f ms/lookup\n",
+           num_members, views ? "on" : "off",
+           elapsed * 1000.0 / BENCHMARK_LOOKUPS);
+}
+
+static void benchmark_member_overrides(int num_members)
+{
+    struct sysdb_test_ctx *test_ctx;
+    char *group_name;
+    int ret;
+
+    test_dom_suite_setup(TESTS_PATH);
+
+    ret = setup_sysdb_tests(&test_ctx);
+    assert_int_equal(ret, EOK);
+
+    group_name = store_member_group(test_ctx, test_ctx, num_members, 0);
+
+    benchmark_member_overrides_run(test_ctx, group_name, num_members, false);
+    benchmark_member_overrides_run(test_ctx, group_name, num_members, true);
+
+    talloc_free(test_ctx);
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_FILE, "FILES");
+}
+
 static const char *users[] = { "alice", "bob", "barney", NULL };
 
 static void enum_test_user_override(struct sysdb_test_ctx *test_ctx,
@@ -1050,6 +1434,7 @@ int main(int argc, const char *argv[])
 {
     int rv;
     int no_cleanup = 0;
+    int benchmark = 0;
     poptContext pc;
     int opt;
     struct poptOption long_options[] = {
@@ -1057,6 +1442,8 @@ int main(int argc, const char *argv[])
         SSSD_DEBUG_OPTS
         {"no-cleanup", 'n', POPT_ARG_NONE, &no_cleanup, 0,
          _("Do not delete the test database after a test run"), NULL },
+        { "benchmark", 0, POPT_ARG_INT, &benchmark, 0,
+          "Measure group lookups with the given number of members", NULL },
         POPT_TABLEEND
     };
 
@@ -1075,6 +1462,14 @@ int main(int argc, const char *argv[])
                                         test_sysdb_setup, test_sysdb_teardown),
         cmocka_unit_test_setup_teardown(test_sysdb_invalidate_overrides,
                                         test_sysdb_setup, test_sysdb_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_add_group_member_overrides,
+                                        test_sysdb_setup, test_sysdb_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_add_group_member_overrides_large_view,
+                                        test_sysdb_setup, test_sysdb_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_add_overrides_to_objects,
+                                        test_sysdb_setup, test_sysdb_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_add_overrides_to_objects_large_view,
+                                        test_sysdb_setup, test_sysdb_teardown),
         cmocka_unit_test_setup_teardown(test_sysdb_enumpwent,
                                         test_enum_users_setup,
                                         test_enum_users_teardown),
@@ -1120,6 +1515,12 @@ int main(int argc, const char *argv[])
 
     tests_set_cwd();
     test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_FILE, "FILES");
+
+    if (benchmark > 0) {
+        benchmark_member_overrides(benchmark);
+        return 0;
+    }
+
     test_dom_suite_setup(TESTS_PATH);
     rv = cmocka_run_group_tests(tests, NULL, NULL);
 
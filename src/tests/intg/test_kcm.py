@@ -544,6 +544,47 @@ def test_kcm_sec_parallel_klist(setup_for_kcm_sec,
         assert rc == 0
 
 
+def many_creds_klist(testenv, ncreds=200):
+    """
+    Test that a ccache with many service tickets can be listed and report
+    how long it takes to iterate over the credentials
+    """
+    svcs = ["host/svc%d.kcmtest" % i for i in range(ncreds)]
+
+    testenv.k5kdc.add_principal("alice", "alicepw")
+    for svc in svcs:
+        testenv.k5kdc.add_principal(svc)
+
+    out, _, _ = testenv.k5util.kinit("alice", "alicepw")
+    assert out == 0
+    out, _, _ = testenv.k5util._run_in_env(["kvno"] + svcs)
+    assert out == 0
+
+    nruns = 10
+    start = time.time()
+    for i in range(nruns):
+        cc_coll = testenv.k5util.list_all_princs()
+    elapsed = time.time() - start
+
+    assert len(cc_coll) == 1
+    assert len(cc_coll['alice@KCMTEST']) == ncreds + 1
+    assert set(cc_coll['alice@KCMTEST']) == \
+        set(["krbtgt/KCMTEST@KCMTEST"] + [s + "@KCMTEST" for s in svcs])
+
+    print("Listing %d credentials took %.1f ms on average" %
+          (ncreds + 1, elapsed * 1000 / nruns))
+
+
+def test_kcm_mem_many_creds_klist(setup_for_kcm_mem):
+    testenv = setup_for_kcm_mem
+    many_creds_klist(testenv)
+
+
+def test_kcm_secdb_many_creds_klist(setup_for_kcm_secdb):
+    testenv = setup_for_kcm_secdb
+    many_creds_klist(testenv)
+
+
 def get_secrets_socket():
     return os.path.join(config.RUNSTATEDIR, "secrets.socket")
 
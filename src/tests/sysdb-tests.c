@@ -27,8 +27,10 @@
 #include <popt.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 #include "util/util.h"
 #include "util/crypto/sss_crypto.h"
+#include "util/sss_crypt_pool.h"
 #include "db/sysdb_private.h"
 #include "db/sysdb_services.h"
 #include "db/sysdb_autofs.h"
@@ -2298,6 +2300,83 @@ static void cached_authentication_with_expiration(uid_t uid,
     talloc_free(test_ctx);
 }
 
+struct cached_auth_async_state {
+    bool done;
+    int ret;
+    time_t expire_date;
+    time_t delayed_until;
+};
+
+static void cached_authentication_async_done(struct tevent_req *req)
+{
+    struct cached_auth_async_state *state;
+
+    state = tevent_req_callback_data(req, struct cached_auth_async_state);
+    state->ret = sysdb_cache_auth_recv(req, &state->expire_date,
+                                       &state->delayed_until);
+    talloc_free(req);
+    state->done = true;
+}
+
+static void cached_authentication_async(uid_t uid,
+                                        const char *password,
+                                        unsigned int num_workers,
+                                        int expected_result)
+{
+    struct sysdb_test_ctx *test_ctx;
+    struct test_data *data;
+    struct sss_crypt_pool *pool;
+    struct cached_auth_async_state state = { 0 };
+    struct tevent_req *req;
+    int ret;
+    const char *val[2];
+    val[1] = NULL;
+
+    /* Setup */
+    ret = setup_sysdb_tests(&test_ctx);
+    fail_unless(ret == EOK, "Could not set up the test");
+
+    data = test_data_new_user(test_ctx, uid);
+    fail_if(data == NULL);
+
+    val[0] = "0";
+    ret = confdb_add_param(test_ctx->confdb, true, CONFDB_PAM_CONF_ENTRY,
+                           CONFDB_PAM_CRED_TIMEOUT, val);
+    if (ret != EOK) {
+        fail("Could not initialize provider");
+        talloc_free(test_ctx);
+        return;
+    }
+
+    ret = sss_crypt_pool_init(test_ctx, test_ctx->ev, num_workers, &pool);
+    fail_unless(ret == EOK, "Could not create crypto pool");
+
+    req = sysdb_cache_auth_send(test_ctx, test_ctx->ev, pool,
+                                test_ctx->domain, data->username,
+                                password ? password : data->username,
+                                test_ctx->confdb, false);
+    fail_if(req == NULL);
+    tevent_req_set_callback(req, cached_authentication_async_done, &state);
+
+    while (!state.done) {
+        tevent_loop_once(test_ctx->ev);
+    }
+
+    fail_unless(state.ret == expected_result,
+                "sysdb_cache_auth_send request does not return expected "
+                "result [%d], got [%d].", expected_result, state.ret);
+
+    fail_unless(state.expire_date == 0,
+                "Wrong expire date, expected [%d], got [%d]",
+                0, state.expire_date);
+
+    fail_unless(state.delayed_until == -1,
+                "Wrong delay, expected [%d], got [%d]",
+                -1, state.delayed_until);
+
+    talloc_free(test_ctx);
+}
+
 START_TEST (test_sysdb_cached_authentication_missing_password)
 {
     cached_authentication_without_expiration(_i, "abc", ERR_NO_CACHED_CREDS);
@@ -2319,6 +2398,104 @@ START_TEST (test_sysdb_cached_authentication)
 }
 END_TEST
 
+START_TEST (test_sysdb_cached_authentication_async)
+{
+    cached_authentication_async(_i, "abc", 0, ERR_AUTH_FAILED);
+    cached_authentication_async(_i, "abc", 2, ERR_AUTH_FAILED);
+    cached_authentication_async(_i, NULL, 0, EOK);
+    cached_authentication_async(_i, NULL, 2, EOK);
+}
+END_TEST
+
+/* Another attempt locks the account while the hash is computed */
+START_TEST (test_sysdb_cached_authentication_async_locked)
+{
+    struct sysdb_test_ctx *test_ctx;
+    struct test_data *data;
+    struct sss_crypt_pool *pool;
+    struct cached_auth_async_state state = { 0 };
+    struct sysdb_attrs *attrs;
+    struct ldb_result *res;
+    struct tevent_req *req;
+    const char *user_attrs[] = { SYSDB_FAILED_LOGIN_ATTEMPTS, NULL };
+    time_t now;
+    int ret;
+    const char *val[2];
+    val[1] = NULL;
+
+    /* Setup */
+    ret = setup_sysdb_tests(&test_ctx);
+    fail_unless(ret == EOK, "Could not set up the test");
+
+    data = test_data_new_user(test_ctx, _i);
+    fail_if(data == NULL);
+
+    val[0] = "0";
+    ret = confdb_add_param(test_ctx->confdb, true, CONFDB_PAM_CONF_ENTRY,
+                           CONFDB_PAM_CRED_TIMEOUT, val);
+    fail_unless(ret == EOK, "Could not set the credentials timeout");
+
+    val[0] = "3";
+    ret = confdb_add_param(test_ctx->confdb, true, CONFDB_PAM_CONF_ENTRY,
+                           CONFDB_PAM_FAILED_LOGIN_ATTEMPTS, val);
+    fail_unless(ret == EOK, "Could not set the failed login attempts");
+
+    ret = sss_crypt_pool_init(test_ctx, test_ctx->ev, 2, &pool);
+    fail_unless(ret == EOK, "Could not create crypto pool");
+
+    /* The password is correct */
+    req = sysdb_cache_auth_send(test_ctx, test_ctx->ev, pool,
+                                test_ctx->domain, data->username,
+                                data->username, test_ctx->confdb, false);
+    fail_if(req == NULL);
+    tevent_req_set_callback(req, cached_authentication_async_done, &state);
+
+    now = time(NULL);
+    attrs = sysdb_new_attrs(test_ctx);
+    fail_if(attrs == NULL);
+    ret = sysdb_attrs_add_uint32(attrs, SYSDB_FAILED_LOGIN_ATTEMPTS, 3);
+    fail_unless(ret == EOK);
+    ret = sysdb_attrs_add_time_t(attrs, SYSDB_LAST_FAILED_LOGIN, now);
+    fail_unless(ret == EOK);
+    ret = sysdb_set_user_attr(test_ctx->domain, data->username, attrs,
+                              SYSDB_MOD_REP);
+    fail_unless(ret == EOK, "Could not lock the account");
+
+    while (!state.done) {
+        tevent_loop_once(test_ctx->ev);
+    }
+
+    fail_unless(state.ret == ERR_AUTH_DENIED,
+                "Expected ERR_AUTH_DENIED, got [%d].", state.ret);
+    fail_unless(state.delayed_until >= now,
+                "Wrong delay [%lld]", (long long)state.delayed_until);
+
+    /* The lockout is kept */
+    ret = sysdb_get_user_attr(test_ctx, test_ctx->domain, data->username,
+                              user_attrs, &res);
+    fail_unless(ret == EOK && res->count == 1, "Could not read the user");
+    fail_unless(ldb_msg_find_attr_as_uint(res->msgs[0],
+                                          SYSDB_FAILED_LOGIN_ATTEMPTS, 0) == 3,
+                "Failed login attempts were changed");
+
+    /* Unlock the account for the other tests */
+    val[0] = "0";
+    ret = confdb_add_param(test_ctx->confdb, true, CONFDB_PAM_CONF_ENTRY,
+                           CONFDB_PAM_FAILED_LOGIN_ATTEMPTS, val);
+    fail_unless(ret == EOK, "Could not reset the failed login attempts");
+
+    attrs = sysdb_new_attrs(test_ctx);
+    fail_if(attrs == NULL);
+    ret = sysdb_attrs_add_uint32(attrs, SYSDB_FAILED_LOGIN_ATTEMPTS, 0);
+    fail_unless(ret == EOK);
+    ret = sysdb_set_user_attr(test_ctx->domain, data->username, attrs,
+                              SYSDB_MOD_REP);
+    fail_unless(ret == EOK, "Could not unlock the account");
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
 START_TEST (test_sysdb_prepare_asq_test_user)
 {
     struct sysdb_test_ctx *test_ctx;
@@ -5728,6 +5905,171 @@ START_TEST(test_sysdb_has_enumerated)
 }
 END_TEST
 
+START_TEST(test_sysdb_cache_generation)
+{
+    errno_t ret;
+    struct sysdb_test_ctx *test_ctx;
+    struct ldb_message *msg;
+    uint32_t generation;
+    uint32_t users_generation;
+    time_t now;
+
+    /* Setup */
+    ret = setup_sysdb_tests(&test_ctx);
+    fail_if(ret != EOK, "Could not set up the test");
+
+    msg = ldb_msg_new(test_ctx);
+    fail_if(msg == NULL);
+
+    now = time(NULL);
+    ret = ldb_msg_add_fmt(msg, SYSDB_LAST_UPDATE, "%lld", (long long)now);
+    fail_if(ret != LDB_SUCCESS);
+
+    ret = sysdb_get_cache_generation(test_ctx->domain, SYSDB_CACHE_GEN_USERS,
+                                     &generation);
+    fail_if(ret != EOK, "Error [%d][%s] reading generation",
+                        ret, strerror(ret));
+    fail_unless(generation == 0, "Unexpected generation %u", generation);
+    fail_if(sysdb_is_older_than_generation(msg, SYSDB_CACHE_GEN_USERS,
+                                           generation),
+            "Object should not be invalidated");
+
+    ret = sysdb_bump_cache_generation(test_ctx->domain, SYSDB_CACHE_GEN_USERS);
+    fail_if(ret != EOK, "Error [%d][%s] bumping generation",
+                        ret, strerror(ret));
+
+    ret = sysdb_get_cache_generation(test_ctx->domain, SYSDB_CACHE_GEN_USERS,
+                                     &users_generation);
+    fail_if(ret != EOK, "Error [%d][%s] reading generation",
+                        ret, strerror(ret));
+    fail_unless(users_generation >= now, "Unexpected generation %u",
+                users_generation);
+    fail_unless(sysdb_is_older_than_generation(msg, SYSDB_CACHE_GEN_USERS,
+                                               users_generation),
+                "Object should be invalidated");
+
+    /* Generation must increase even when bumped twice in a second */
+    ret = sysdb_bump_cache_generation(test_ctx->domain, SYSDB_CACHE_GEN_USERS);
+    fail_if(ret != EOK, "Error [%d][%s] bumping generation",
+                        ret, strerror(ret));
+
+    ret = sysdb_get_cache_generation(test_ctx->domain, SYSDB_CACHE_GEN_USERS,
+                                     &generation);
+    fail_if(ret != EOK, "Error [%d][%s] reading generation",
+                        ret, strerror(ret));
+    fail_unless(generation > users_generation, "Unexpected generation %u",
+                generation);
+
+    /* Other object types are not affected */
+    ret = sysdb_get_cache_generation(test_ctx->domain, SYSDB_CACHE_GEN_GROUPS,
+                                     &generation);
+    fail_if(ret != EOK, "Error [%d][%s] reading generation",
+                        ret, strerror(ret));
+    fail_unless(generation == 0, "Unexpected generation %u", generation);
+
+    /* The cached variant picks up a new generation after the refresh
+     * interval at the latest */
+    ret = sysdb_get_cache_generation_cached(test_ctx->domain,
+                                            SYSDB_CACHE_GEN_GROUPS,
+                                            &generation);
+    fail_if(ret != EOK, "Error [%d][%s] reading generation",
+                        ret, strerror(ret));
+    fail_unless(generation == 0, "Unexpected generation %u", generation);
+
+    ret = sysdb_bump_cache_generation(test_ctx->domain, SYSDB_CACHE_GEN_GROUPS);
+    fail_if(ret != EOK, "Error [%d][%s] bumping generation",
+                        ret, strerror(ret));
+
+    sleep(SYSDB_CACHE_GEN_REFRESH);
+
+    ret = sysdb_get_cache_generation_cached(test_ctx->domain,
+                                            SYSDB_CACHE_GEN_GROUPS,
+                                            &generation);
+    fail_if(ret != EOK, "Error [%d][%s] reading generation",
+                        ret, strerror(ret));
+    fail_unless(generation >= now, "Unexpected generation %u", generation);
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
+START_TEST(test_sysdb_cache_generation_initgroups)
+{
+    errno_t ret;
+    struct sysdb_test_ctx *test_ctx;
+    struct ldb_message *msg;
+    uint32_t generation;
+    time_t now;
+
+    /* Setup */
+    ret = setup_sysdb_tests(&test_ctx);
+    fail_if(ret != EOK, "Could not set up the test");
+
+    ret = sysdb_bump_cache_generation(test_ctx->domain,
+                                      SYSDB_CACHE_GEN_INITGROUPS);
+    fail_if(ret != EOK, "Error [%d][%s] bumping generation",
+                        ret, strerror(ret));
+
+    /* The user was refreshed but its groups were not */
+    msg = ldb_msg_new(test_ctx);
+    fail_if(msg == NULL);
+
+    now = time(NULL);
+    ret = ldb_msg_add_fmt(msg, SYSDB_LAST_UPDATE, "%lld",
+                          (long long)now + 1);
+    fail_if(ret != LDB_SUCCESS);
+
+    ret = sysdb_refresh_cache_generation(test_ctx->domain,
+                                         SYSDB_CACHE_GEN_INITGROUPS,
+                                         &generation);
+    fail_if(ret != EOK, "Error [%d][%s] reading generation",
+                        ret, strerror(ret));
+    fail_unless(generation >= now, "Unexpected generation %u", generation);
+    fail_if(sysdb_is_older_than_generation(msg, SYSDB_CACHE_GEN_USERS,
+                                           generation),
+            "User should not be invalidated");
+    fail_unless(sysdb_is_older_than_generation(msg,
+                                               SYSDB_CACHE_GEN_INITGROUPS,
+                                               generation),
+                "Group memberships should be invalidated");
+
+    ret = ldb_msg_add_fmt(msg, SYSDB_INITGR_LAST_UPDATE, "%lld",
+                          (long long)generation + 1);
+    fail_if(ret != LDB_SUCCESS);
+    fail_if(sysdb_is_older_than_generation(msg, SYSDB_CACHE_GEN_INITGROUPS,
+                                           generation),
+            "Group memberships should not be invalidated");
+
+    /* A refresh is noticed right away by the cached variant */
+    ret = sysdb_get_cache_generation_cached(test_ctx->domain,
+                                            SYSDB_CACHE_GEN_GROUPS,
+                                            &generation);
+    fail_if(ret != EOK, "Error [%d][%s] reading generation",
+                        ret, strerror(ret));
+    fail_unless(generation == 0, "Unexpected generation %u", generation);
+
+    ret = sysdb_bump_cache_generation(test_ctx->domain, SYSDB_CACHE_GEN_GROUPS);
+    fail_if(ret != EOK, "Error [%d][%s] bumping generation",
+                        ret, strerror(ret));
+
+    ret = sysdb_refresh_cache_generation(test_ctx->domain,
+                                         SYSDB_CACHE_GEN_GROUPS,
+                                         &generation);
+    fail_if(ret != EOK, "Error [%d][%s] reading generation",
+                        ret, strerror(ret));
+    fail_unless(generation >= now, "Unexpected generation %u", generation);
+
+    ret = sysdb_get_cache_generation_cached(test_ctx->domain,
+                                            SYSDB_CACHE_GEN_GROUPS,
+                                            &generation);
+    fail_if(ret != EOK, "Error [%d][%s] reading generation",
+                        ret, strerror(ret));
+    fail_unless(generation >= now, "Unexpected generation %u", generation);
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
 START_TEST(test_sysdb_original_dn_case_insensitive)
 {
     errno_t ret;
@@ -7572,6 +7914,12 @@ Suite *create_sysdb_suite(void)
     tcase_add_loop_test(tc_sysdb, test_sysdb_cached_authentication_wrong_password,
                         27010, 27011);
     tcase_add_loop_test(tc_sysdb, test_sysdb_cached_authentication, 27010, 27011);
+    tcase_add_loop_test(tc_sysdb, test_sysdb_cached_authentication_async,
+                        27010, 27011);
+
+    tcase_add_loop_test(tc_sysdb,
+                        test_sysdb_cached_authentication_async_locked,
+                        27010, 27011);
 
     tcase_add_loop_test(tc_sysdb, test_sysdb_cache_password_ex, 27010, 27011);
 
@@ -7630,6 +7978,10 @@ Suite *create_sysdb_suite(void)
     /* Test sysdb enumerated flag */
     tcase_add_test(tc_sysdb, test_sysdb_has_enumerated);
 
+    /* Test cache generations */
+    tcase_add_test(tc_sysdb, test_sysdb_cache_generation);
+    tcase_add_test(tc_sysdb, test_sysdb_cache_generation_initgroups);
+
     /* Test originalDN searches */
     tcase_add_test(tc_sysdb, test_sysdb_original_dn_case_insensitive);
 
@@ -128,6 +128,9 @@ static errno_t init_context(int argc, const char *argv[],
 static errno_t invalidate_entry(TALLOC_CTX *ctx,
                                 struct sss_domain_info *domain,
                                 const char *name, int entry_type);
+static bool invalidate_generation(struct sss_domain_info *dinfo,
+                                  enum sss_cache_entry entry_type,
+                                  bool *_handled);
 static bool invalidate_entries(TALLOC_CTX *ctx,
                                struct sss_domain_info *dinfo,
                                enum sss_cache_entry entry_type,
@@ -459,9 +462,19 @@ static bool invalidate_entries(TALLOC_CTX *ctx,
     errno_t ret = EINVAL;
     int i;
     const char *c_name;
+    bool handled;
     bool iret;
 
     if (!filter) return false;
+
+    if (name == NULL) {
+        /* All objects of this type are invalidated, try to do it at once. */
+        iret = invalidate_generation(dinfo, entry_type, &handled);
+        if (handled) {
+            return iret;
+        }
+    }
+
     switch (entry_type) {
     case TYPE_USER:
         type_string = "user";
@@ -549,6 +562,63 @@ static bool invalidate_entries(TALLOC_CTX *ctx,
     return iret;
 }
 
+static bool invalidate_generation(struct sss_domain_info *dinfo,
+                                  enum sss_cache_entry entry_type,
+                                  bool *_handled)
+{
+    enum sysdb_cache_gen_type type;
+    errno_t ret;
+
+    switch (entry_type) {
+    case TYPE_USER:
+        type = SYSDB_CACHE_GEN_USERS;
+        break;
+    case TYPE_GROUP:
+        type = SYSDB_CACHE_GEN_GROUPS;
+        break;
+    case TYPE_NETGROUP:
+        type = SYSDB_CACHE_GEN_NETGROUPS;
+        break;
+    case TYPE_SERVICE:
+        type = SYSDB_CACHE_GEN_SERVICES;
+        break;
+    case TYPE_AUTOFSMAP:
+        type = SYSDB_CACHE_GEN_AUTOFS;
+        break;
+    case TYPE_SSH_HOST:
+        type = SYSDB_CACHE_GEN_SSH_HOSTS;
+        break;
+    default:
+        /* sudo rules are not checked by cache_req, expire them one by one */
+        *_handled = false;
+        return false;
+    }
+
+    *_handled = true;
+
+    ret = sysdb_bump_cache_generation(dinfo, type);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to bump cache generation of domain %s [%d]: %s\n",
+              dinfo->name, ret, sss_strerror(ret));
+        return false;
+    }
+
+    /* Group memberships are refreshed separately from the users, see
+     * SYSDB_INITGR_EXPIRE in invalidate_entry() */
+    if (type == SYSDB_CACHE_GEN_USERS) {
+        ret = sysdb_bump_cache_generation(dinfo, SYSDB_CACHE_GEN_INITGROUPS);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to bump initgroups cache "
+                  "generation of domain %s [%d]: %s\n",
+                  dinfo->name, ret, sss_strerror(ret));
+            return false;
+        }
+    }
+
+    return true;
+}
+
 static errno_t invalidate_entry(TALLOC_CTX *ctx,
                                 struct sss_domain_info *domain,
                                 const char *name, int entry_type)
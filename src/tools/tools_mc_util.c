@@ -129,6 +129,129 @@ done:
     return ret;
 }
 
+/* Expire all records of the memory cache at once by bumping the generation
+ * stored in its header. This works even while sssd_nss is running, clients
+ * compare the generation of each record with the one in the header. */
+static errno_t sss_mc_bump_generation(const char *mc_filename)
+{
+    struct sss_mc_header h;
+    uint32_t generation;
+    off_t offset;
+    off_t pos;
+    ssize_t len;
+    int count;
+    int mc_fd;
+    errno_t ret;
+
+    mc_fd = open(mc_filename, O_RDWR);
+    if (mc_fd == -1) {
+        ret = errno;
+        if (ret == ENOENT) {
+            DEBUG(SSSDBG_TRACE_FUNC, "Memory cache file %s "
+                  "does not exist.\n", mc_filename);
+            return EOK;
+        }
+
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to open file %s: %s\n",
+              mc_filename, strerror(ret));
+        return ret;
+    }
+
+    /* retry barrier protected reading max 5 times then give up */
+    for (count = 5; count > 0; count--) {
+        pos = lseek(mc_fd, 0, SEEK_SET);
+        if (pos == -1) {
+            ret = errno;
+            goto done;
+        }
+
+        errno = 0;
+        len = sss_atomic_read_s(mc_fd, (uint8_t *)&h, sizeof(h));
+        if (len == -1) {
+            ret = errno;
+            goto done;
+        }
+
+        if (len != sizeof(h)) {
+            ret = EIO;
+            goto done;
+        }
+
+        if (MC_VALID_BARRIER(h.b1) && h.b1 == h.b2) {
+            break;
+        }
+    }
+    if (count == 0) {
+        ret = EAGAIN;
+        goto done;
+    }
+
+    if (h.major_vno != SSS_MC_MAJOR_VNO
+            || h.minor_vno != SSS_MC_MINOR_VNO
+            || h.status != SSS_MC_HEADER_ALIVE) {
+        /* Created by a different version of sssd_nss or not in use. */
+        DEBUG(SSSDBG_TRACE_FUNC, "Memory cache file %s does not support "
+              "generations.\n", mc_filename);
+        ret = EINVAL;
+        goto done;
+    }
+
+    generation = h.generation + 1;
+    if (generation == MC_INVALID_VAL) {
+        /* Used to mark records that are not finished yet. */
+        generation = 0;
+    }
+
+    offset = MC_PTR_DIFF(&h.generation, &h);
+    pos = lseek(mc_fd, offset, SEEK_SET);
+    if (pos == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    errno = 0;
+    len = sss_atomic_write_s(mc_fd, (uint8_t *)&generation,
+                             sizeof(h.generation));
+    if (len == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    if (len != sizeof(h.generation)) {
+        ret = EIO;
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Memory cache %s moved to generation %u\n",
+          mc_filename, generation);
+    ret = EOK;
+
+done:
+    close(mc_fd);
+    return ret;
+}
+
+static errno_t bump_memcache_generations(void)
+{
+    const char *files[] = { SSS_NSS_MCACHE_DIR"/passwd",
+                            SSS_NSS_MCACHE_DIR"/group",
+                            SSS_NSS_MCACHE_DIR"/initgroups",
+                            SSS_NSS_MCACHE_DIR"/autofs",
+                            SSS_NSS_MCACHE_DIR"/sudo",
+                            NULL };
+    errno_t ret;
+    int i;
+
+    for (i = 0; files[i] != NULL; i++) {
+        ret = sss_mc_bump_generation(files[i]);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
 static int clear_memcache(bool *sssd_nss_is_off)
 {
     int ret;
@@ -162,6 +285,17 @@ static int clear_memcache(bool *sssd_nss_is_off)
         }
     }
 
+    /* The autofs responder recreates its cache file on SIGHUP */
+    ret = sss_memcache_invalidate(SSS_NSS_MCACHE_DIR"/autofs");
+    if (ret != EOK) {
+        if (ret == EACCES) {
+            *sssd_nss_is_off = false;
+            return EOK;
+        } else {
+            return ret;
+        }
+    }
+
     *sssd_nss_is_off = true;
     return EOK;
 }
@@ -199,6 +333,15 @@ errno_t sss_memcache_clear_all(void)
     bool sssd_nss_is_off = false;
     FILE *clear_mc_flag;
 
+    ret = bump_memcache_generations();
+    if (ret == EOK) {
+        return EOK;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Unable to expire memory cache records in "
+          "place [%d]: %s. The memory cache will be recreated.\n",
+          ret, sss_strerror(ret));
+
     ret = clear_memcache(&sssd_nss_is_off);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to clear caches.\n");
@@ -68,9 +68,8 @@ static inline void b64_from_24bit(char **dest, size_t *len, size_t n,
     *dest += i;
 }
 
-static int sha512_crypt_r(const char *key,
-                          const char *salt,
-                          char *buffer, size_t buflen)
+int s3crypt_sha512_r(const char *key, const char *salt,
+                     char *buffer, size_t buflen)
 {
     unsigned char temp_result[64];
     unsigned char alt_result[64];
@@ -333,15 +332,13 @@ int s3crypt_sha512(TALLOC_CTX *memctx,
                    const char *key, const char *salt, char **_hash)
 {
     char *hash;
-    int hlen = (sizeof (sha512_salt_prefix) - 1
-                + sizeof (sha512_rounds_prefix) + 9 + 1
-                + strlen (salt) + 1 + 86 + 1);
+    size_t hlen = S3CRYPT_SHA512_BUFLEN(strlen(salt));
     int ret;
 
     hash = talloc_size(memctx, hlen);
     if (!hash) return ENOMEM;
 
-    ret = sha512_crypt_r(key, salt, hash, hlen);
+    ret = s3crypt_sha512_r(key, salt, hash, hlen);
     if (ret) return ret;
 
     *_hash = hash;
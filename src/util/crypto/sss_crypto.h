@@ -30,6 +30,17 @@ int sss_generate_csprng_buffer(uint8_t *buf, size_t size);
 
 int s3crypt_sha512(TALLOC_CTX *mmectx,
                    const char *key, const char *salt, char **_hash);
+
+/* Size of the buffer needed by s3crypt_sha512_r() for a salt (or a complete
+ * hash used as salt) of the given length. */
+#define S3CRYPT_SHA512_BUFLEN(salt_len) \
+    ((sizeof("$6$") - 1) + sizeof("rounds=") + 9 + 1 + (salt_len) + 1 + 86 + 1)
+
+/* Same as s3crypt_sha512() but writes the result into a caller provided
+ * buffer. It does not allocate any talloc memory so it is safe to call it
+ * from a helper thread. */
+int s3crypt_sha512_r(const char *key, const char *salt,
+                     char *buffer, size_t buflen);
 int s3crypt_gen_salt(TALLOC_CTX *memctx, char **_salt);
 
 /* Methods of obfuscation. */
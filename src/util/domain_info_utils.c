@@ -93,17 +93,231 @@ bool subdomain_enumerates(struct sss_domain_info *parent,
     return false;
 }
 
-struct sss_domain_info *find_domain_by_name_ex(struct sss_domain_info *domain,
-                                                const char *name,
-                                                bool match_any,
-                                                uint32_t gnd_flags)
+/* Lookup index over a domain list.
+ *
+ * Looking up a domain by name or SID walks the whole list of domains and
+ * subdomains and compares the names one by one, which becomes visible with
+ * dozens of trusted domains. The index maps lowercased names, flat names and
+ * SIDs to the first domain in the list order that carries them. It is
+ * attached to the list head and rebuilt with sss_domain_index_update() when
+ * the domain list changes.
+ *
+ * Domains may be linked into the list directly, so the index is only
+ * trusted for hits that are still reachable in the list. Everything else
+ * falls back to walking the list. */
+struct sss_domain_index {
+    hash_table_t *names;
+    hash_table_t *flat_names;
+    hash_table_t *sids;
+};
+
+/* Domain names and SIDs are far shorter, longer keys are not indexed. */
+#define SSS_DOMAIN_INDEX_KEY_MAX 256
+
+static bool domain_index_key(const char *str, char *key)
 {
-    struct sss_domain_info *dom = domain;
+    size_t i;
+
+    for (i = 0; str[i] != '\0'; i++) {
+        if (i + 1 >= SSS_DOMAIN_INDEX_KEY_MAX) {
+            return false;
+        }
+
+        key[i] = tolower((unsigned char)str[i]);
+    }
+    key[i] = '\0';
+
+    return true;
+}
+
+static errno_t domain_index_add(hash_table_t *table,
+                                const char *str,
+                                struct sss_domain_info *dom)
+{
+    char keybuf[SSS_DOMAIN_INDEX_KEY_MAX];
+    hash_key_t key;
+    hash_value_t value;
+    int hret;
+
+    if (str == NULL || !domain_index_key(str, keybuf)) {
+        return EOK;
+    }
+
+    key.type = HASH_KEY_STRING;
+    key.str = keybuf;
+
+    /* Keep the first domain in the list order. */
+    if (hash_has_key(table, &key)) {
+        return EOK;
+    }
+
+    value.type = HASH_VALUE_PTR;
+    value.ptr = dom;
+
+    hret = hash_enter(table, &key, &value);
+    if (hret != HASH_SUCCESS) {
+        return EIO;
+    }
+
+    return EOK;
+}
+
+static struct sss_domain_index *
+domain_index_build(struct sss_domain_info *head)
+{
+    struct sss_domain_index *index;
+    struct sss_domain_info *dom;
+    errno_t ret;
+
+    index = talloc_zero(head, struct sss_domain_index);
+    if (index == NULL) {
+        return NULL;
+    }
+
+    ret = sss_hash_create(index, 0, &index->names);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_hash_create(index, 0, &index->flat_names);
+    if (ret != EOK) {
+        goto done;
+    }
 
-    if (name == NULL) {
+    ret = sss_hash_create(index, 0, &index->sids);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    for (dom = head; dom != NULL;
+            dom = get_next_domain(dom, SSS_GND_ALL_DOMAINS)) {
+        ret = domain_index_add(index->names, dom->name, dom);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = domain_index_add(index->flat_names, dom->flat_name, dom);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = domain_index_add(index->sids, dom->domain_id, dom);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to build domain index [%d]: %s\n",
+              ret, sss_strerror(ret));
+        talloc_free(index);
         return NULL;
     }
 
+    return index;
+}
+
+static struct sss_domain_info *
+domain_list_head(struct sss_domain_info *domain)
+{
+    struct sss_domain_info *head;
+
+    head = get_domains_head(domain);
+    while (head->prev != NULL) {
+        head = head->prev;
+    }
+
+    return head;
+}
+
+void sss_domain_index_update(struct sss_domain_info *domain)
+{
+    struct sss_domain_info *head;
+
+    if (domain == NULL) {
+        return;
+    }
+
+    /* The index is attached to the first top level domain. */
+    head = domain_list_head(domain);
+
+    talloc_zfree(head->index);
+    head->index = domain_index_build(head);
+}
+
+static struct sss_domain_info *
+domain_index_lookup(hash_table_t *table, const char *str)
+{
+    char keybuf[SSS_DOMAIN_INDEX_KEY_MAX];
+    hash_key_t key;
+    hash_value_t value;
+    int hret;
+
+    if (table == NULL || !domain_index_key(str, keybuf)) {
+        return NULL;
+    }
+
+    key.type = HASH_KEY_STRING;
+    key.str = keybuf;
+
+    hret = hash_lookup(table, &key, &value);
+    if (hret != HASH_SUCCESS) {
+        return NULL;
+    }
+
+    return value.ptr;
+}
+
+/* Check that @dom would be reached by walking the list from @start with
+ * the given flags, i.e. that it is still linked in the list and that it
+ * does not precede @start. */
+static bool domain_index_reachable(struct sss_domain_info *start,
+                                   struct sss_domain_info *dom,
+                                   uint32_t gnd_flags)
+{
+    struct sss_domain_info *top;
+
+    if (IS_SUBDOMAIN(start)) {
+        return false;
+    }
+
+    if (!(gnd_flags & SSS_GND_DESCEND) && IS_SUBDOMAIN(dom)) {
+        return false;
+    }
+
+    if (!(gnd_flags & SSS_GND_INCLUDE_DISABLED)
+            && sss_domain_get_state(dom) == DOM_DISABLED) {
+        return false;
+    }
+
+    /* DLIST_REMOVE() clears the list pointers of a removed domain. */
+    for (top = dom; top->parent != NULL; top = top->parent) {
+        if (top->parent->subdomains != top
+                && (top->prev == NULL || top->prev->next != top)) {
+            return false;
+        }
+    }
+
+    for (; start != NULL; start = start->next) {
+        if (start == top) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static struct sss_domain_info *
+find_domain_by_name_walk(struct sss_domain_info *domain,
+                         const char *name,
+                         bool match_any,
+                         uint32_t gnd_flags)
+{
+    struct sss_domain_info *dom = domain;
+
     if (!(gnd_flags & SSS_GND_INCLUDE_DISABLED)) {
         while (dom && sss_domain_get_state(dom) == DOM_DISABLED) {
             dom = get_next_domain(dom, gnd_flags);
@@ -122,6 +336,42 @@ struct sss_domain_info *find_domain_by_name_ex(struct sss_domain_info *domain,
     return NULL;
 }
 
+struct sss_domain_info *find_domain_by_name_ex(struct sss_domain_info *domain,
+                                                const char *name,
+                                                bool match_any,
+                                                uint32_t gnd_flags)
+{
+    struct sss_domain_index *index;
+    struct sss_domain_info *by_name = NULL;
+    struct sss_domain_info *by_flat = NULL;
+    struct sss_domain_info *dom;
+
+    if (domain == NULL || name == NULL) {
+        return NULL;
+    }
+
+    index = domain_list_head(domain)->index;
+    if (index != NULL) {
+        by_name = domain_index_lookup(index->names, name);
+        if (match_any) {
+            by_flat = domain_index_lookup(index->flat_names, name);
+        }
+    }
+
+    /* The first match in the list order wins, if the name matches two
+     * different domains we do not know which one it is. */
+    dom = by_name != NULL ? by_name : by_flat;
+    if (dom != NULL && (by_flat == NULL || by_flat == dom)
+            && (strcasecmp(dom->name, name) == 0
+                || (match_any && dom->flat_name != NULL
+                    && strcasecmp(dom->flat_name, name) == 0))
+            && domain_index_reachable(domain, dom, gnd_flags)) {
+        return dom;
+    }
+
+    return find_domain_by_name_walk(domain, name, match_any, gnd_flags);
+}
+
 struct sss_domain_info *find_domain_by_name(struct sss_domain_info *domain,
                                             const char *name,
                                             bool match_any)
@@ -129,39 +379,99 @@ struct sss_domain_info *find_domain_by_name(struct sss_domain_info *domain,
     return find_domain_by_name_ex(domain, name, match_any, SSS_GND_DESCEND);
 }
 
+static bool domain_sid_matches(struct sss_domain_info *dom,
+                               const char *sid,
+                               size_t sid_len)
+{
+    size_t dom_sid_len;
+
+    if (dom->domain_id == NULL) {
+        return false;
+    }
+
+    dom_sid_len = strlen(dom->domain_id);
+
+    if (strncasecmp(dom->domain_id, sid, dom_sid_len) == 0) {
+        if (dom_sid_len == sid_len) {
+            /* sid is domain sid */
+            return true;
+        }
+
+        /* sid is object sid, check if domain sid is align with
+         * sid first subauthority component */
+        if (sid[dom_sid_len] == '-') {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static struct sss_domain_info *
+find_domain_by_sid_index(struct sss_domain_index *index,
+                         const char *sid)
+{
+    char keybuf[SSS_DOMAIN_INDEX_KEY_MAX];
+    hash_key_t key;
+    hash_value_t value;
+    char *p;
+    int hret;
+
+    if (!domain_index_key(sid, keybuf)) {
+        return NULL;
+    }
+
+    key.type = HASH_KEY_STRING;
+    key.str = keybuf;
+
+    /* Domain SIDs are never prefixes of each other so the first domain
+     * SID that matches the object SID with the sub-authorities stripped
+     * one by one is the only candidate. */
+    do {
+        hret = hash_lookup(index->sids, &key, &value);
+        if (hret == HASH_SUCCESS) {
+            return value.ptr;
+        }
+
+        p = strrchr(keybuf, '-');
+        if (p != NULL) {
+            *p = '\0';
+        }
+    } while (p != NULL);
+
+    return NULL;
+}
+
 struct sss_domain_info *find_domain_by_sid(struct sss_domain_info *domain,
                                               const char *sid)
 {
-    struct sss_domain_info *dom = domain;
+    struct sss_domain_index *index;
+    struct sss_domain_info *dom;
     size_t sid_len;
-    size_t dom_sid_len;
 
-    if (sid == NULL) {
+    if (domain == NULL || sid == NULL) {
         return NULL;
     }
 
     sid_len = strlen(sid);
 
+    index = domain_list_head(domain)->index;
+    if (index != NULL) {
+        dom = find_domain_by_sid_index(index, sid);
+        if (dom != NULL && domain_sid_matches(dom, sid, sid_len)
+                && domain_index_reachable(domain, dom, SSS_GND_DESCEND)) {
+            return dom;
+        }
+    }
+
+    dom = domain;
     while (dom && sss_domain_get_state(dom) == DOM_DISABLED) {
         dom = get_next_domain(dom, SSS_GND_DESCEND);
     }
 
     while (dom) {
-        if (dom->domain_id != NULL) {
-            dom_sid_len = strlen(dom->domain_id);
-
-            if (strncasecmp(dom->domain_id, sid, dom_sid_len) == 0) {
-                if (dom_sid_len == sid_len) {
-                    /* sid is domain sid */
-                    return dom;
-                }
-
-                /* sid is object sid, check if domain sid is align with
-                 * sid first subauthority component */
-                if (sid[dom_sid_len] == '-') {
-                    return dom;
-                }
-            }
+        if (domain_sid_matches(dom, sid, sid_len)) {
+            return dom;
         }
 
         dom = get_next_domain(dom, SSS_GND_DESCEND);
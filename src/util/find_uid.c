@@ -36,6 +36,14 @@
 #include <ctype.h>
 #include <sys/time.h>
 #include <dhash.h>
+#include <tevent.h>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+#endif
 
 #include "util/find_uid.h"
 #include "util/util.h"
@@ -46,9 +54,12 @@
 #endif
 
 #define INITIAL_TABLE_SIZE 64
-#define PATHLEN (NAME_MAX + 14)
+#define PATHLEN PATH_MAX
 #define BUFSIZE 4096
 
+/* Can be changed by tests */
+static const char *proc_dir_path = "/proc";
+
 static void *hash_talloc(const size_t size, void *pvt)
 {
     return talloc_size(pvt, size);
@@ -72,7 +83,7 @@ static errno_t get_uid_from_pid(const pid_t pid, uid_t *uid)
     uint32_t num=0;
     errno_t error;
 
-    ret = snprintf(path, PATHLEN, "/proc/%d/status", pid);
+    ret = snprintf(path, PATHLEN, "%s/%d/status", proc_dir_path, pid);
     if (ret < 0) {
         DEBUG(SSSDBG_CRIT_FAILURE, "snprintf failed\n");
         return EINVAL;
@@ -210,7 +221,11 @@ static int only_numbers(char *p)
     return *p;
 }
 
-static errno_t get_active_uid_linux(hash_table_t *table, uid_t search_uid)
+/* The callback returns EOK to continue, EEXIST to stop the walk or an
+ * error code */
+typedef errno_t (*proc_walk_cb)(pid_t pid, uid_t uid, void *pvt);
+
+static errno_t walk_proc_dir(proc_walk_cb cb, void *pvt)
 {
     DIR *proc_dir = NULL;
     struct dirent *dirent;
@@ -218,10 +233,7 @@ static errno_t get_active_uid_linux(hash_table_t *table, uid_t search_uid)
     pid_t pid = -1;
     uid_t uid;
 
-    hash_key_t key;
-    hash_value_t value;
-
-    proc_dir = opendir("/proc");
+    proc_dir = opendir(proc_dir_path);
     if (proc_dir == NULL) {
         ret = errno;
         DEBUG(SSSDBG_CRIT_FAILURE, "Cannot open proc dir.\n");
@@ -249,24 +261,9 @@ static errno_t get_active_uid_linux(hash_table_t *table, uid_t search_uid)
             continue;
         }
 
-        if (table != NULL) {
-            key.type = HASH_KEY_ULONG;
-            key.ul = (unsigned long) uid;
-            value.type = HASH_VALUE_ULONG;
-            value.ul = (unsigned long) uid;
-
-            ret = hash_enter(table, &key, &value);
-            if (ret != HASH_SUCCESS) {
-                DEBUG(SSSDBG_CRIT_FAILURE,
-                      "cannot add to table [%s]\n", hash_error_string(ret));
-                ret = ENOMEM;
-                goto done;
-            }
-        } else {
-            if (uid == search_uid) {
-                ret = EOK;
-                goto done;
-            }
+        ret = cb(pid, uid, pvt);
+        if (ret != EOK) {
+            goto done;
         }
 
         errno = 0;
@@ -283,11 +280,7 @@ static errno_t get_active_uid_linux(hash_table_t *table, uid_t search_uid)
         DEBUG(SSSDBG_CRIT_FAILURE, "closedir failed, watch out.\n");
     }
 
-    if (table != NULL) {
-        ret = EOK;
-    } else {
-        ret = ENOENT;
-    }
+    ret = EOK;
 
 done:
     if (proc_dir != NULL) {
@@ -299,9 +292,448 @@ done:
     return ret;
 }
 
+static errno_t add_uid_cb(pid_t pid, uid_t uid, void *pvt)
+{
+    hash_table_t *table = pvt;
+    hash_key_t key;
+    hash_value_t value;
+    int ret;
+
+    key.type = HASH_KEY_ULONG;
+    key.ul = (unsigned long) uid;
+    value.type = HASH_VALUE_ULONG;
+    value.ul = (unsigned long) uid;
+
+    ret = hash_enter(table, &key, &value);
+    if (ret != HASH_SUCCESS) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "cannot add to table [%s]\n", hash_error_string(ret));
+        return ENOMEM;
+    }
+
+    return EOK;
+}
+
+static errno_t search_uid_cb(pid_t pid, uid_t uid, void *pvt)
+{
+    uid_t *search_uid = pvt;
+
+    return uid == *search_uid ? EEXIST : EOK;
+}
+
+/* ==Tracking-of-active-UIDs============================================== */
+
+/*
+ * Instead of scanning /proc on every query, the tracker scans it once and
+ * then follows process creation, UID changes and process exit through the
+ * process events connector of the kernel. The queries are answered from
+ * the tables below. If the kernel drops events, e.g. because the socket
+ * buffer overflowed, /proc is scanned again.
+ *
+ * Listening to the process events requires CAP_NET_ADMIN. If it is not
+ * available, /proc is scanned on every query as before.
+ */
+struct uid_tracker {
+    int fd;
+    struct tevent_fd *fde;
+    /* the kernel sends process events to the socket */
+    bool subscribed;
+
+    /* pid:uid of all processes */
+    hash_table_t *pids;
+    /* uid:number of processes */
+    hash_table_t *uids;
+};
+
+static struct uid_tracker *uid_tracker;
+
+static errno_t uid_tracker_ref_uid(struct uid_tracker *tracker,
+                                   uid_t uid, long delta)
+{
+    hash_key_t key;
+    hash_value_t value;
+    int ret;
+
+    key.type = HASH_KEY_ULONG;
+    key.ul = (unsigned long) uid;
+
+    ret = hash_lookup(tracker->uids, &key, &value);
+    if (ret == HASH_ERROR_KEY_NOT_FOUND) {
+        value.type = HASH_VALUE_ULONG;
+        value.ul = 0;
+    } else if (ret != HASH_SUCCESS) {
+        return EIO;
+    }
+
+    if (delta < 0 && value.ul <= (unsigned long) -delta) {
+        ret = hash_delete(tracker->uids, &key);
+        return ret == HASH_SUCCESS ? EOK : EIO;
+    }
+
+    value.ul += delta;
+    ret = hash_enter(tracker->uids, &key, &value);
+    return ret == HASH_SUCCESS ? EOK : ENOMEM;
+}
+
+static errno_t uid_tracker_del_pid(struct uid_tracker *tracker, pid_t pid)
+{
+    hash_key_t key;
+    hash_value_t value;
+    int ret;
+
+    key.type = HASH_KEY_ULONG;
+    key.ul = (unsigned long) pid;
+
+    ret = hash_lookup(tracker->pids, &key, &value);
+    if (ret == HASH_ERROR_KEY_NOT_FOUND) {
+        return EOK;
+    } else if (ret != HASH_SUCCESS) {
+        return EIO;
+    }
+
+    ret = hash_delete(tracker->pids, &key);
+    if (ret != HASH_SUCCESS) {
+        return EIO;
+    }
+
+    return uid_tracker_ref_uid(tracker, (uid_t) value.ul, -1);
+}
+
+static errno_t uid_tracker_add_pid(pid_t pid, uid_t uid, void *pvt)
+{
+    struct uid_tracker *tracker = talloc_get_type(pvt, struct uid_tracker);
+    hash_key_t key;
+    hash_value_t value;
+    errno_t ret;
+
+    /* the pid might have been reused or changed its uid */
+    ret = uid_tracker_del_pid(tracker, pid);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    key.type = HASH_KEY_ULONG;
+    key.ul = (unsigned long) pid;
+    value.type = HASH_VALUE_ULONG;
+    value.ul = (unsigned long) uid;
+
+    ret = hash_enter(tracker->pids, &key, &value);
+    if (ret != HASH_SUCCESS) {
+        return ENOMEM;
+    }
+
+    return uid_tracker_ref_uid(tracker, uid, 1);
+}
+
+static errno_t uid_tracker_scan(struct uid_tracker *tracker)
+{
+    errno_t ret;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Scanning %s for active UIDs\n", proc_dir_path);
+
+    hash_destroy(tracker->pids);
+    hash_destroy(tracker->uids);
+    tracker->pids = NULL;
+    tracker->uids = NULL;
+
+    ret = hash_create_ex(INITIAL_TABLE_SIZE * 16, &tracker->pids, 0, 0, 0, 0,
+                         hash_talloc, hash_talloc_free, tracker,
+                         NULL, NULL);
+    if (ret != HASH_SUCCESS) {
+        return ENOMEM;
+    }
+
+    ret = hash_create_ex(INITIAL_TABLE_SIZE, &tracker->uids, 0, 0, 0, 0,
+                         hash_talloc, hash_talloc_free, tracker,
+                         NULL, NULL);
+    if (ret != HASH_SUCCESS) {
+        return ENOMEM;
+    }
+
+    return walk_proc_dir(uid_tracker_add_pid, tracker);
+}
+
+static errno_t uid_tracker_fork(struct uid_tracker *tracker,
+                                pid_t parent, pid_t child)
+{
+    hash_key_t key;
+    hash_value_t value;
+    uid_t uid;
+    errno_t ret;
+
+    key.type = HASH_KEY_ULONG;
+    key.ul = (unsigned long) parent;
+
+    ret = hash_lookup(tracker->pids, &key, &value);
+    if (ret == HASH_SUCCESS) {
+        uid = (uid_t) value.ul;
+    } else {
+        /* not known yet, ask /proc */
+        ret = get_uid_from_pid(child, &uid);
+        if (ret != EOK) {
+            /* already gone */
+            return EOK;
+        }
+    }
+
+    return uid_tracker_add_pid(child, uid, tracker);
+}
+
+#ifdef __linux__
+static errno_t uid_tracker_process_event(struct uid_tracker *tracker,
+                                         struct proc_event *ev)
+{
+    /* Only processes are tracked, not their threads */
+    switch (ev->what) {
+    case PROC_EVENT_FORK:
+        if (ev->event_data.fork.child_pid
+                != ev->event_data.fork.child_tgid) {
+            return EOK;
+        }
+        return uid_tracker_fork(tracker, ev->event_data.fork.parent_tgid,
+                                ev->event_data.fork.child_tgid);
+    case PROC_EVENT_UID:
+        if (ev->event_data.id.process_pid
+                != ev->event_data.id.process_tgid) {
+            return EOK;
+        }
+        /* /proc/<pid>/status lists the real UID first */
+        return uid_tracker_add_pid(ev->event_data.id.process_tgid,
+                                   ev->event_data.id.r.ruid, tracker);
+    case PROC_EVENT_EXIT:
+        if (ev->event_data.exit.process_pid
+                != ev->event_data.exit.process_tgid) {
+            return EOK;
+        }
+        return uid_tracker_del_pid(tracker, ev->event_data.exit.process_tgid);
+    default:
+        return EOK;
+    }
+}
+
+static void uid_tracker_handler(struct tevent_context *ev,
+                                struct tevent_fd *fde,
+                                uint16_t flags,
+                                void *pvt)
+{
+    struct uid_tracker *tracker = talloc_get_type(pvt, struct uid_tracker);
+    char buf[4096] __attribute__((aligned(NLMSG_ALIGNTO)));
+    struct sockaddr_nl from;
+    socklen_t from_len;
+    struct nlmsghdr *hdr;
+    struct cn_msg *msg;
+    bool resync = false;
+    ssize_t len;
+    errno_t ret;
+
+    while (true) {
+        from_len = sizeof(from);
+        len = recvfrom(tracker->fd, buf, sizeof(buf), 0,
+                       (struct sockaddr *) &from, &from_len);
+        if (len == -1) {
+            ret = errno;
+            if (ret == EINTR) {
+                continue;
+            } else if (ret == EAGAIN || ret == EWOULDBLOCK) {
+                break;
+            } else if (ret == ENOBUFS) {
+                DEBUG(SSSDBG_MINOR_FAILURE, "Process events were lost\n");
+                resync = true;
+                continue;
+            }
+
+            DEBUG(SSSDBG_OP_FAILURE, "recv() failed [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            resync = true;
+            break;
+        }
+
+        /* Any process can send to the socket, trust only the kernel */
+        if (from_len != sizeof(from) || from.nl_family != AF_NETLINK
+                || from.nl_pid != 0) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Ignoring process event which was "
+                  "not sent by the kernel\n");
+            continue;
+        }
+
+        for (hdr = (struct nlmsghdr *) buf;
+             NLMSG_OK(hdr, len);
+             hdr = NLMSG_NEXT(hdr, len)) {
+            if (hdr->nlmsg_type == NLMSG_ERROR
+                    || hdr->nlmsg_type == NLMSG_OVERRUN) {
+                resync = true;
+                continue;
+            }
+
+            if (hdr->nlmsg_type != NLMSG_DONE
+                    || hdr->nlmsg_len < NLMSG_LENGTH(sizeof(struct cn_msg)
+                                                 + sizeof(struct proc_event))) {
+                continue;
+            }
+
+            msg = NLMSG_DATA(hdr);
+            if (msg->id.idx != CN_IDX_PROC || msg->id.val != CN_VAL_PROC) {
+                continue;
+            }
+
+            ret = uid_tracker_process_event(tracker,
+                                            (struct proc_event *) msg->data);
+            if (ret != EOK) {
+                resync = true;
+            }
+        }
+    }
+
+    if (resync) {
+        ret = uid_tracker_scan(tracker);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Cannot scan for active UIDs [%d]: %s, "
+                  "falling back to scanning on every query\n",
+                  ret, sss_strerror(ret));
+            talloc_free(tracker);
+        }
+    }
+}
+
+/* Start (PROC_CN_MCAST_LISTEN) or stop (PROC_CN_MCAST_IGNORE) receiving
+ * process events. The kernel counts the listeners and generates the events
+ * only while there are any. */
+static errno_t uid_tracker_subscribe(int fd, enum proc_cn_mcast_op op)
+{
+    char buf[NLMSG_SPACE(sizeof(struct cn_msg)
+                         + sizeof(enum proc_cn_mcast_op))]
+         __attribute__((aligned(NLMSG_ALIGNTO)));
+    struct nlmsghdr *hdr;
+    struct cn_msg *msg;
+    ssize_t len;
+
+    memset(buf, 0, sizeof(buf));
+
+    hdr = (struct nlmsghdr *) buf;
+    hdr->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(op));
+    hdr->nlmsg_type = NLMSG_DONE;
+    hdr->nlmsg_pid = getpid();
+
+    msg = NLMSG_DATA(hdr);
+    msg->id.idx = CN_IDX_PROC;
+    msg->id.val = CN_VAL_PROC;
+    msg->len = sizeof(op);
+    memcpy(msg->data, &op, sizeof(op));
+
+    len = send(fd, hdr, hdr->nlmsg_len, 0);
+    if (len == -1) {
+        return errno;
+    } else if (len != hdr->nlmsg_len) {
+        return EIO;
+    }
+
+    return EOK;
+}
+#endif /* __linux__ */
+
+static int uid_tracker_destructor(struct uid_tracker *tracker)
+{
+#ifdef __linux__
+    errno_t ret;
+#endif
+
+    if (uid_tracker == tracker) {
+        uid_tracker = NULL;
+    }
+
+    talloc_zfree(tracker->fde);
+#ifdef __linux__
+    if (tracker->subscribed) {
+        ret = uid_tracker_subscribe(tracker->fd, PROC_CN_MCAST_IGNORE);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Cannot unsubscribe from process "
+                  "events [%d]: %s\n", ret, sss_strerror(ret));
+        }
+    }
+#endif
+    if (tracker->fd != -1) {
+        close(tracker->fd);
+    }
+
+    return 0;
+}
+
+errno_t find_uid_tracker_setup(TALLOC_CTX *mem_ctx, struct tevent_context *ev)
+{
+#ifdef __linux__
+    struct uid_tracker *tracker;
+    struct sockaddr_nl addr;
+    errno_t ret;
+
+    if (uid_tracker != NULL) {
+        return EOK;
+    }
+
+    tracker = talloc_zero(mem_ctx, struct uid_tracker);
+    if (tracker == NULL) {
+        return ENOMEM;
+    }
+    tracker->fd = -1;
+    talloc_set_destructor(tracker, uid_tracker_destructor);
+
+    tracker->fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                         NETLINK_CONNECTOR);
+    if (tracker->fd == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = CN_IDX_PROC;
+
+    ret = bind(tracker->fd, (struct sockaddr *) &addr, sizeof(addr));
+    if (ret == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    ret = uid_tracker_subscribe(tracker->fd, PROC_CN_MCAST_LISTEN);
+    if (ret != EOK) {
+        goto done;
+    }
+    tracker->subscribed = true;
+
+    /* Events that arrive during the scan wait in the socket */
+    ret = uid_tracker_scan(tracker);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    tracker->fde = tevent_add_fd(ev, tracker, tracker->fd, TEVENT_FD_READ,
+                                 uid_tracker_handler, tracker);
+    if (tracker->fde == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Tracking active UIDs with process events\n");
+    uid_tracker = tracker;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "Cannot listen to process events "
+              "[%d]: %s, active UIDs will be found by scanning %s\n",
+              ret, sss_strerror(ret), proc_dir_path);
+        talloc_free(tracker);
+    }
+    return ret;
+#else
+    return ENOSYS;
+#endif
+}
+
 errno_t get_uid_table(TALLOC_CTX *mem_ctx, hash_table_t **table)
 {
 #ifdef __linux__
+    struct hash_iter_context_t *iter;
+    hash_entry_t *entry;
     int ret;
 
     ret = hash_create_ex(INITIAL_TABLE_SIZE, table, 0, 0, 0, 0,
@@ -313,7 +745,25 @@ errno_t get_uid_table(TALLOC_CTX *mem_ctx, hash_table_t **table)
         return ENOMEM;
     }
 
-    return get_active_uid_linux(*table, 0);
+    if (uid_tracker == NULL) {
+        return walk_proc_dir(add_uid_cb, *table);
+    }
+
+    iter = new_hash_iter_context(uid_tracker->uids);
+    if (iter == NULL) {
+        return ENOMEM;
+    }
+
+    while ((entry = iter->next(iter)) != NULL) {
+        ret = add_uid_cb(-1, (uid_t) entry->key.ul, *table);
+        if (ret != EOK) {
+            talloc_free(iter);
+            return ret;
+        }
+    }
+    talloc_free(iter);
+
+    return EOK;
 #else
     return ENOSYS;
 #endif
@@ -321,8 +771,19 @@ errno_t get_uid_table(TALLOC_CTX *mem_ctx, hash_table_t **table)
 
 errno_t check_if_uid_is_active(uid_t uid, bool *result)
 {
+    hash_key_t key;
     int ret;
 
+    /* The tracker gives the same answer as the /proc scan below, without
+     * a call to logind. */
+    if (uid_tracker != NULL) {
+        key.type = HASH_KEY_ULONG;
+        key.ul = (unsigned long) uid;
+
+        *result = hash_has_key(uid_tracker->uids, &key);
+        return EOK;
+    }
+
 #ifdef HAVE_SYSTEMD_LOGIN
     ret = sd_uid_get_sessions(uid, 0, NULL);
     if (ret > 0) {
@@ -339,13 +800,13 @@ errno_t check_if_uid_is_active(uid_t uid, bool *result)
     /* fall back to the old method */
 #endif
 
-    ret = get_active_uid_linux(NULL, uid);
-    if (ret != EOK && ret != ENOENT) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "get_active_uid_linux() failed.\n");
+    ret = walk_proc_dir(search_uid_cb, &uid);
+    if (ret != EOK && ret != EEXIST) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "walk_proc_dir() failed.\n");
         return ret;
     }
 
-    if (ret == EOK) {
+    if (ret == EEXIST) {
         *result = true;
     } else {
         *result = false;
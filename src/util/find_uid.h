@@ -25,6 +25,7 @@
 #define __FIND_UID_H__
 
 #include <talloc.h>
+#include <tevent.h>
 #include <sys/types.h>
 #include <dhash.h>
 
@@ -33,4 +34,10 @@
 errno_t get_uid_table(TALLOC_CTX *mem_ctx, hash_table_t **table);
 errno_t check_if_uid_is_active(uid_t uid, bool *result);
 
+/* Follow process events of the kernel to keep the set of active UIDs up to
+ * date, so that the functions above do not have to scan /proc on every
+ * call. Needs CAP_NET_ADMIN. If the setup fails, /proc is still scanned
+ * on every call and the error is only informative. */
+errno_t find_uid_tracker_setup(TALLOC_CTX *mem_ctx, struct tevent_context *ev);
+
 #endif /* __FIND_UID_H__ */
@@ -79,7 +79,7 @@ typedef uint32_t rel_ptr_t;
 
 
 #define SSS_MC_MAJOR_VNO    1
-#define SSS_MC_MINOR_VNO    1
+#define SSS_MC_MINOR_VNO    2
 
 #define SSS_MC_HEADER_UNINIT    0   /* after ftruncate or before reset */
 #define SSS_MC_HEADER_ALIVE     1   /* current and in use */
@@ -98,7 +98,7 @@ struct sss_mc_header {
     rel_ptr_t data_table;   /* data table pointer relative to mmap base */
     rel_ptr_t free_table;   /* free table pointer relative to mmap base */
     rel_ptr_t hash_table;   /* hash table pointer relative to mmap base */
-    rel_ptr_t reserved;     /* reserved for future changes */
+    uint32_t generation;    /* records with other generation are expired */
     uint32_t b2;            /* barrier 2 */
 };
 
@@ -112,7 +112,7 @@ struct sss_mc_rec {
                             /* next2 is related to hash2 */
     uint32_t hash1;         /* val of first hash (usually name of record) */
     uint32_t hash2;         /* val of second hash (usually id of record) */
-    uint32_t padding;       /* padding & reserved for future changes */
+    uint32_t generation;    /* header generation the record was added in */
     uint32_t b2;            /* barrier 2 - 32 bytes mark, fits a slot */
     char data[0];
 };
@@ -149,6 +149,29 @@ struct sss_mc_initgr_data {
                              * after gids */
 };
 
+struct sss_mc_autofs_data {
+    rel_ptr_t name;         /* ptr to lookup key string, rel. to struct base addr
+                             * the lookup key is "<map name>\n<entry key>" */
+    rel_ptr_t map;          /* ptr to map name string, rel. to struct base addr */
+    rel_ptr_t value;        /* ptr to value string, rel. to struct base addr */
+    uint32_t strs_len;      /* length of strs */
+    char strs[0];           /* concatenation of all autofs strings, each
+                             * string is zero terminated ordered as follows:
+                             * lookup key, map name, value */
+};
+
+struct sss_mc_sudo_data {
+    rel_ptr_t name;         /* ptr to lookup key string, rel. to struct base addr
+                             * the lookup key is "<command>\n<uid>\n<user>" */
+    rel_ptr_t user;         /* ptr to user name string, rel. to struct base addr */
+    rel_ptr_t reply;        /* ptr to the serialized responder reply,
+                             * rel. to struct base addr */
+    uint32_t reply_len;     /* length of the reply */
+    uint32_t strs_len;      /* length of strs */
+    char strs[0];           /* lookup key and user name, each zero terminated,
+                             * followed by the reply */
+};
+
 #pragma pack()
 
 
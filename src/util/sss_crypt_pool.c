@@ -0,0 +1,566 @@
+/*
+    Copyright (C) 2020 Red Hat
+
+    SSSD: Asynchronous password hashing
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <talloc.h>
+#include <tevent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+#include "util/util.h"
+#include "util/dlinklist.h"
+#include "util/crypto/sss_crypto.h"
+#include "util/sss_crypt_pool.h"
+
+enum sss_crypt_job_state {
+    SSS_CRYPT_JOB_QUEUED,
+    SSS_CRYPT_JOB_RUNNING,
+    SSS_CRYPT_JOB_DONE,
+};
+
+/* Jobs are allocated with malloc() and never touched by talloc from the
+ * helper threads. The owning tevent request is only accessed from the main
+ * thread. */
+struct sss_crypt_job {
+    struct sss_crypt_job *prev;
+    struct sss_crypt_job *next;
+
+    enum sss_crypt_job_state state;
+    struct tevent_req *req;
+
+    char *key;
+    size_t key_len;
+    char *salt;
+    char *buffer;
+    size_t buflen;
+    int ret;
+};
+
+struct sss_crypt_pool {
+    struct tevent_context *ev;
+    unsigned int num_workers;
+    struct sss_crypt_pool_stats stats;
+
+#ifdef HAVE_PTHREAD
+    pthread_t *threads;
+    unsigned int num_threads;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool shutdown;
+
+    struct sss_crypt_job *queued;
+    uint64_t num_queued;
+    struct sss_crypt_job *done;
+
+    int pipefd[2];
+    struct tevent_fd *fde;
+#endif
+};
+
+struct s3crypt_sha512_state {
+    struct sss_crypt_pool *pool;
+    struct sss_crypt_job *job;
+    char *hash;
+};
+
+static void sss_crypt_job_free(struct sss_crypt_job *job)
+{
+    if (job == NULL) {
+        return;
+    }
+
+    if (job->key != NULL) {
+        sss_erase_mem_securely(job->key, job->key_len);
+        free(job->key);
+    }
+    free(job->salt);
+    if (job->buffer != NULL) {
+        sss_erase_mem_securely(job->buffer, job->buflen);
+        free(job->buffer);
+    }
+    free(job);
+}
+
+static struct sss_crypt_job *sss_crypt_job_new(const char *key,
+                                               const char *salt)
+{
+    struct sss_crypt_job *job;
+
+    job = calloc(1, sizeof(struct sss_crypt_job));
+    if (job == NULL) {
+        return NULL;
+    }
+
+    job->key_len = strlen(key);
+    job->key = strdup(key);
+    job->salt = strdup(salt);
+    job->buflen = S3CRYPT_SHA512_BUFLEN(strlen(salt));
+    job->buffer = malloc(job->buflen);
+    if (job->key == NULL || job->salt == NULL || job->buffer == NULL) {
+        sss_crypt_job_free(job);
+        return NULL;
+    }
+    job->state = SSS_CRYPT_JOB_QUEUED;
+    job->ret = EOK;
+
+    return job;
+}
+
+/* Called in the main thread once the hash is available. */
+static void sss_crypt_job_finish(struct sss_crypt_job *job)
+{
+    struct s3crypt_sha512_state *state;
+    struct tevent_req *req;
+
+    req = job->req;
+    if (req == NULL) {
+        /* The caller is not interested anymore. */
+        sss_crypt_job_free(job);
+        return;
+    }
+
+    state = tevent_req_data(req, struct s3crypt_sha512_state);
+    state->job = NULL;
+    job->req = NULL;
+
+    if (job->ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to compute password hash [%d]: %s\n",
+              job->ret, sss_strerror(job->ret));
+        tevent_req_error(req, job->ret);
+        sss_crypt_job_free(job);
+        return;
+    }
+
+    state->hash = talloc_strdup(state, job->buffer);
+    sss_crypt_job_free(job);
+    if (state->hash == NULL) {
+        tevent_req_error(req, ENOMEM);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+#ifdef HAVE_PTHREAD
+
+static void *sss_crypt_pool_worker(void *pvt)
+{
+    struct sss_crypt_pool *pool = pvt;
+    struct sss_crypt_job *job;
+    ssize_t len;
+    int ret;
+
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->shutdown) {
+        job = pool->queued;
+        if (job == NULL) {
+            pthread_cond_wait(&pool->cond, &pool->lock);
+            continue;
+        }
+
+        DLIST_REMOVE(pool->queued, job);
+        pool->num_queued--;
+        job->state = SSS_CRYPT_JOB_RUNNING;
+        pthread_mutex_unlock(&pool->lock);
+
+        ret = s3crypt_sha512_r(job->key, job->salt, job->buffer, job->buflen);
+
+        pthread_mutex_lock(&pool->lock);
+        job->ret = ret;
+        job->state = SSS_CRYPT_JOB_DONE;
+        DLIST_ADD(pool->done, job);
+        pthread_mutex_unlock(&pool->lock);
+
+        /* Wake up the main thread. If the pipe is full there is already
+         * a notification pending so EAGAIN can be safely ignored. */
+        do {
+            len = write(pool->pipefd[1], "", 1);
+        } while (len == -1 && errno == EINTR);
+
+        pthread_mutex_lock(&pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+static void sss_crypt_pool_notify(struct tevent_context *ev,
+                                  struct tevent_fd *fde,
+                                  uint16_t flags,
+                                  void *pvt)
+{
+    struct sss_crypt_pool *pool;
+    struct sss_crypt_job *done;
+    struct sss_crypt_job *job;
+    struct sss_crypt_job *next;
+    char buf[64];
+    ssize_t len;
+
+    pool = talloc_get_type(pvt, struct sss_crypt_pool);
+
+    do {
+        len = read(pool->pipefd[0], buf, sizeof(buf));
+    } while (len > 0 || (len == -1 && errno == EINTR));
+
+    pthread_mutex_lock(&pool->lock);
+    done = pool->done;
+    pool->done = NULL;
+    pthread_mutex_unlock(&pool->lock);
+
+    DLIST_FOR_EACH_SAFE(job, next, done) {
+        DLIST_REMOVE(done, job);
+        sss_crypt_job_finish(job);
+    }
+}
+
+static void sss_crypt_pool_free_list(struct sss_crypt_job *list)
+{
+    struct sss_crypt_job *job;
+    struct sss_crypt_job *next;
+    struct s3crypt_sha512_state *state;
+
+    DLIST_FOR_EACH_SAFE(job, next, list) {
+        DLIST_REMOVE(list, job);
+        if (job->req != NULL) {
+            state = tevent_req_data(job->req, struct s3crypt_sha512_state);
+            state->job = NULL;
+            state->pool = NULL;
+        }
+        sss_crypt_job_free(job);
+    }
+}
+
+static int sss_crypt_pool_destructor(struct sss_crypt_pool *pool)
+{
+    unsigned int i;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 0; i < pool->num_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    /* No thread is running anymore so we can drop the lists freely. */
+    sss_crypt_pool_free_list(pool->queued);
+    pool->queued = NULL;
+    sss_crypt_pool_free_list(pool->done);
+    pool->done = NULL;
+
+    talloc_zfree(pool->fde);
+    PIPE_FD_CLOSE(pool->pipefd[0]);
+    PIPE_FD_CLOSE(pool->pipefd[1]);
+
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->lock);
+
+    return 0;
+}
+
+static errno_t sss_crypt_pool_start(struct sss_crypt_pool *pool)
+{
+    sigset_t old_sigset;
+    sigset_t sigset;
+    unsigned int i;
+    errno_t ret;
+
+    pool->pipefd[0] = -1;
+    pool->pipefd[1] = -1;
+
+    ret = pthread_mutex_init(&pool->lock, NULL);
+    if (ret != 0) {
+        return ret;
+    }
+
+    ret = pthread_cond_init(&pool->cond, NULL);
+    if (ret != 0) {
+        pthread_mutex_destroy(&pool->lock);
+        return ret;
+    }
+
+    /* From now on the destructor takes care of the cleanup. */
+    talloc_set_destructor(pool, sss_crypt_pool_destructor);
+
+    ret = pipe(pool->pipefd);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "pipe failed [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return ret;
+    }
+
+    ret = sss_fd_nonblocking(pool->pipefd[0]);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sss_fd_nonblocking(pool->pipefd[1]);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    pool->fde = tevent_add_fd(pool->ev, pool, pool->pipefd[0], TEVENT_FD_READ,
+                              sss_crypt_pool_notify, pool);
+    if (pool->fde == NULL) {
+        return ENOMEM;
+    }
+
+    pool->threads = talloc_zero_array(pool, pthread_t, pool->num_workers);
+    if (pool->threads == NULL) {
+        return ENOMEM;
+    }
+
+    /* Signals must be handled by the main thread only, the workers inherit
+     * the blocked signal mask. */
+    sigfillset(&sigset);
+    ret = pthread_sigmask(SIG_BLOCK, &sigset, &old_sigset);
+    if (ret != 0) {
+        return ret;
+    }
+
+    for (i = 0; i < pool->num_workers; i++) {
+        ret = pthread_create(&pool->threads[i], NULL,
+                             sss_crypt_pool_worker, pool);
+        if (ret != 0) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to start worker thread "
+                  "[%d]: %s\n", ret, sss_strerror(ret));
+            break;
+        }
+        pool->num_threads++;
+    }
+
+    pthread_sigmask(SIG_SETMASK, &old_sigset, NULL);
+
+    return ret;
+}
+
+static errno_t sss_crypt_pool_enqueue(struct sss_crypt_pool *pool,
+                                      struct sss_crypt_job *job)
+{
+    pthread_mutex_lock(&pool->lock);
+    DLIST_ADD_END(pool->queued, job, struct sss_crypt_job *);
+    pool->num_queued++;
+    if (pool->num_queued > pool->stats.max_pending) {
+        pool->stats.max_pending = pool->num_queued;
+    }
+    pthread_cond_signal(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    pool->stats.queued++;
+
+    return EOK;
+}
+
+/* Returns true if the job was taken out of the queue, false if a thread is
+ * already working on it and it will be freed once it is finished. */
+static bool sss_crypt_pool_cancel(struct sss_crypt_pool *pool,
+                                  struct sss_crypt_job *job)
+{
+    bool cancelled = false;
+
+    pthread_mutex_lock(&pool->lock);
+    if (job->state == SSS_CRYPT_JOB_QUEUED) {
+        DLIST_REMOVE(pool->queued, job);
+        pool->num_queued--;
+        cancelled = true;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (cancelled) {
+        pool->stats.cancelled++;
+    }
+
+    return cancelled;
+}
+
+#else /* HAVE_PTHREAD */
+
+static errno_t sss_crypt_pool_start(struct sss_crypt_pool *pool)
+{
+    if (pool->num_workers > 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "SSSD was built without thread support, "
+              "password hashes will be computed in the main thread.\n");
+        pool->num_workers = 0;
+    }
+
+    return EOK;
+}
+
+static errno_t sss_crypt_pool_enqueue(struct sss_crypt_pool *pool,
+                                      struct sss_crypt_job *job)
+{
+    return ENOTSUP;
+}
+
+static bool sss_crypt_pool_cancel(struct sss_crypt_pool *pool,
+                                  struct sss_crypt_job *job)
+{
+    return false;
+}
+
+#endif /* HAVE_PTHREAD */
+
+errno_t sss_crypt_pool_init(TALLOC_CTX *mem_ctx,
+                            struct tevent_context *ev,
+                            unsigned int num_workers,
+                            struct sss_crypt_pool **_pool)
+{
+    struct sss_crypt_pool *pool;
+    errno_t ret;
+
+    pool = talloc_zero(mem_ctx, struct sss_crypt_pool);
+    if (pool == NULL) {
+        return ENOMEM;
+    }
+
+    pool->ev = ev;
+    pool->num_workers = num_workers;
+
+    if (num_workers > 0) {
+        ret = sss_crypt_pool_start(pool);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to start crypto pool "
+                  "[%d]: %s\n", ret, sss_strerror(ret));
+            talloc_free(pool);
+            return ret;
+        }
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Password hashes will be computed by %u "
+          "helper thread(s)\n", pool->num_workers);
+
+    *_pool = pool;
+    return EOK;
+}
+
+void sss_crypt_pool_get_stats(struct sss_crypt_pool *pool,
+                              struct sss_crypt_pool_stats *stats)
+{
+    *stats = pool->stats;
+}
+
+static int s3crypt_sha512_state_destructor(struct s3crypt_sha512_state *state)
+{
+    struct sss_crypt_job *job = state->job;
+
+    if (job == NULL) {
+        return 0;
+    }
+
+    /* The request went away while the hash is being computed. Either drop
+     * the job from the queue or let the notify handler free it. */
+    job->req = NULL;
+    state->job = NULL;
+    if (sss_crypt_pool_cancel(state->pool, job)) {
+        sss_crypt_job_free(job);
+    }
+
+    return 0;
+}
+
+struct tevent_req *s3crypt_sha512_send(TALLOC_CTX *mem_ctx,
+                                       struct tevent_context *ev,
+                                       struct sss_crypt_pool *pool,
+                                       const char *key,
+                                       const char *salt)
+{
+    struct s3crypt_sha512_state *state;
+    struct sss_crypt_job *job;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct s3crypt_sha512_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_req_create() failed\n");
+        return NULL;
+    }
+
+    if (key == NULL || salt == NULL) {
+        ret = EINVAL;
+        goto immediately;
+    }
+
+    job = sss_crypt_job_new(key, salt);
+    if (job == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+    job->req = req;
+    state->job = job;
+
+    if (pool == NULL || pool->num_workers == 0) {
+        if (pool != NULL) {
+            pool->stats.sync++;
+        }
+
+        job->ret = s3crypt_sha512_r(job->key, job->salt,
+                                    job->buffer, job->buflen);
+        job->state = SSS_CRYPT_JOB_DONE;
+
+        /* Deliver the result through the event loop to keep the calling
+         * convention the same as with helper threads. */
+        sss_crypt_job_finish(job);
+        tevent_req_post(req, ev);
+        return req;
+    }
+
+    state->pool = pool;
+    talloc_set_destructor(state, s3crypt_sha512_state_destructor);
+
+    ret = sss_crypt_pool_enqueue(pool, job);
+    if (ret != EOK) {
+        state->job = NULL;
+        sss_crypt_job_free(job);
+        goto immediately;
+    }
+
+    return req;
+
+immediately:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else {
+        tevent_req_error(req, ret);
+    }
+    tevent_req_post(req, ev);
+
+    return req;
+}
+
+errno_t s3crypt_sha512_recv(TALLOC_CTX *mem_ctx,
+                            struct tevent_req *req,
+                            char **_hash)
+{
+    struct s3crypt_sha512_state *state;
+    state = tevent_req_data(req, struct s3crypt_sha512_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_hash = talloc_steal(mem_ctx, state->hash);
+
+    return EOK;
+}
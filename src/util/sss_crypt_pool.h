@@ -0,0 +1,61 @@
+/*
+    Copyright (C) 2020 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SSS_CRYPT_POOL_H_
+#define _SSS_CRYPT_POOL_H_
+
+#include <talloc.h>
+#include <tevent.h>
+
+#include "util/util.h"
+
+/* Small pool of helper threads used to compute salted SHA-512 password
+ * hashes outside of the main event loop. Results are delivered back through
+ * the tevent context the pool was created with.
+ *
+ * If SSSD was built without pthread support or the pool was created with
+ * zero workers the hashes are computed synchronously but the result is still
+ * delivered asynchronously so callers do not need to care. */
+struct sss_crypt_pool;
+
+struct sss_crypt_pool_stats {
+    uint64_t queued;      /* jobs handed to the helper threads */
+    uint64_t sync;        /* jobs computed directly in the main thread */
+    uint64_t cancelled;   /* jobs dropped before a thread picked them up */
+    uint64_t max_pending; /* highest number of jobs waiting for a thread */
+};
+
+errno_t sss_crypt_pool_init(TALLOC_CTX *mem_ctx,
+                            struct tevent_context *ev,
+                            unsigned int num_workers,
+                            struct sss_crypt_pool **_pool);
+
+void sss_crypt_pool_get_stats(struct sss_crypt_pool *pool,
+                              struct sss_crypt_pool_stats *stats);
+
+/* @pool may be NULL, in that case the hash is computed synchronously. */
+struct tevent_req *s3crypt_sha512_send(TALLOC_CTX *mem_ctx,
+                                       struct tevent_context *ev,
+                                       struct sss_crypt_pool *pool,
+                                       const char *key,
+                                       const char *salt);
+
+errno_t s3crypt_sha512_recv(TALLOC_CTX *mem_ctx,
+                            struct tevent_req *req,
+                            char **_hash);
+
+#endif /* _SSS_CRYPT_POOL_H_ */
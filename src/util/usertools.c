@@ -55,6 +55,8 @@ char *get_uppercase_realm(TALLOC_CTX *memctx, const char *name)
 }
 
 
+#define SSS_DEFAULT_RE "(?P<name>[^@]+)@?(?P<domain>[^@]*$)"
+
 #define IPA_AD_DEFAULT_RE "(((?P<domain>[^\\\\]+)\\\\(?P<name>.+$))|" \
                          "((?P<name>[^@]+)@(?P<domain>.+$))|" \
                          "(^(?P<name>[^@\\\\]+)$))"
@@ -161,6 +163,14 @@ int sss_names_init_from_args(TALLOC_CTX *mem_ctx, const char *re_pattern,
 
     DEBUG(SSSDBG_CONF_SETTINGS, "Using re [%s].\n", ctx->re_pattern);
 
+    if (strcmp(ctx->re_pattern, SSS_DEFAULT_RE) == 0) {
+        ctx->re_format = SSS_NAMES_RE_DEFAULT;
+    } else if (strcmp(ctx->re_pattern, IPA_AD_DEFAULT_RE) == 0) {
+        ctx->re_format = SSS_NAMES_RE_IPA_AD;
+    } else {
+        ctx->re_format = SSS_NAMES_RE_GENERIC;
+    }
+
     ret = sss_fqnames_init(ctx, fq_fmt);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE, "Could not check the FQ names format"
@@ -231,8 +241,7 @@ int sss_names_init(TALLOC_CTX *mem_ctx, struct confdb_ctx *cdb,
     }
 
     if (!re_pattern) {
-        re_pattern = talloc_strdup(tmpctx,
-                                   "(?P<name>[^@]+)@?(?P<domain>[^@]*$)");
+        re_pattern = talloc_strdup(tmpctx, SSS_DEFAULT_RE);
         if (!re_pattern) {
             ret = ENOMEM;
             goto done;
@@ -285,14 +294,128 @@ int sss_ad_default_names_ctx(TALLOC_CTX *mem_ctx,
                                     _out);
 }
 
+/* Split the name according to the well known expressions without running
+ * the regular expression. Only the inputs where the expression matches at
+ * the very first character are handled here, which covers all the names we
+ * expect to see. Returns false if the regular expression must be used. */
+static bool sss_parse_name_fast(struct sss_names_ctx *snctx,
+                                const char *orig,
+                                const char **_name, size_t *_name_len,
+                                const char **_domain, size_t *_domain_len)
+{
+    const char *at = NULL;
+    const char *bs = NULL;
+    const char *p;
+    size_t len;
+
+    for (p = orig; *p != '\0'; p++) {
+        switch (*p) {
+        case '@':
+            if (at == NULL) {
+                at = p;
+            } else if (snctx->re_format == SSS_NAMES_RE_DEFAULT) {
+                /* More than one '@' */
+                return false;
+            }
+            break;
+        case '\\':
+            if (bs == NULL) {
+                bs = p;
+            }
+            break;
+        case '\n':
+        case '\r':
+            /* '$' and '.' treat line breaks specially */
+            return false;
+        }
+    }
+    len = p - orig;
+
+    switch (snctx->re_format) {
+    case SSS_NAMES_RE_DEFAULT:
+        if (len == 0 || at == orig) {
+            return false;
+        }
+
+        if (at == NULL) {
+            *_name = orig;
+            *_name_len = len;
+            *_domain = NULL;
+            *_domain_len = 0;
+        } else {
+            *_name = orig;
+            *_name_len = at - orig;
+            *_domain = at + 1;
+            *_domain_len = len - (at - orig) - 1;
+        }
+        return true;
+    case SSS_NAMES_RE_IPA_AD:
+        if (bs != NULL && bs != orig && bs != orig + len - 1) {
+            /* DOMAIN\name */
+            *_domain = orig;
+            *_domain_len = bs - orig;
+            *_name = bs + 1;
+            *_name_len = len - (bs - orig) - 1;
+            return true;
+        }
+
+        if (at != NULL && at != orig && at != orig + len - 1) {
+            /* name@domain */
+            *_name = orig;
+            *_name_len = at - orig;
+            *_domain = at + 1;
+            *_domain_len = len - (at - orig) - 1;
+            return true;
+        }
+
+        if (len > 0 && at == NULL && bs == NULL) {
+            *_name = orig;
+            *_name_len = len;
+            *_domain = NULL;
+            *_domain_len = 0;
+            return true;
+        }
+
+        return false;
+    case SSS_NAMES_RE_GENERIC:
+        break;
+    }
+
+    return false;
+}
+
 int sss_parse_name(TALLOC_CTX *memctx,
                    struct sss_names_ctx *snctx,
                    const char *orig, char **_domain, char **_name)
 {
     sss_regexp_t *re = snctx->re;
     const char *result;
+    const char *fname;
+    const char *fdomain;
+    size_t fname_len;
+    size_t fdomain_len;
     int ret;
 
+    if (sss_parse_name_fast(snctx, orig, &fname, &fname_len,
+                            &fdomain, &fdomain_len)) {
+        if (_name != NULL) {
+            *_name = talloc_strndup(memctx, fname, fname_len);
+            if (*_name == NULL) return ENOMEM;
+        }
+
+        if (_domain != NULL) {
+            /* ignore "" string */
+            if (fdomain != NULL && fdomain_len > 0) {
+                *_domain = talloc_strndup(memctx, fdomain, fdomain_len);
+                if (*_domain == NULL) return ENOMEM;
+            } else {
+                *_domain = NULL;
+            }
+        }
+
+        return EOK;
+    }
+
     ret = sss_regexp_match(re, orig, 0, SSS_REGEXP_NOTEMPTY);
     if (ret == SSS_REGEXP_ERROR_NOMATCH) {
         return ERR_REGEX_NOMATCH;
@@ -355,6 +478,7 @@ int sss_parse_name_for_domains(TALLOC_CTX *memctx,
                                const char *orig, char **domain, char **name)
 {
     struct sss_domain_info *dom, *match = NULL;
+    struct sss_names_ctx *last_names = NULL;
     char *rdomain, *rname;
     char *dmatch, *nmatch;
     char *candidate_name = NULL;
@@ -372,7 +496,15 @@ int sss_parse_name_for_domains(TALLOC_CTX *memctx,
     rdomain = NULL;
 
     for (dom = domains; dom != NULL; dom = get_next_domain(dom, 0)) {
-        ret = sss_parse_name(tmp_ctx, dom->names, orig, &dmatch, &nmatch);
+        /* Domains usually share the expression, parse the name only once
+         * for each distinct one. */
+        if (last_names == NULL || (dom->names != last_names
+                && strcmp(dom->names->re_pattern,
+                          last_names->re_pattern) != 0)) {
+            ret = sss_parse_name(tmp_ctx, dom->names, orig, &dmatch, &nmatch);
+            last_names = dom->names;
+        }
+
         if (ret == EOK) {
             /*
              * If the name matched without the domain part, make note of it.
@@ -215,11 +215,20 @@ void sss_erase_mem_securely(void *p, size_t size);
 /* from usertools.c */
 char *get_uppercase_realm(TALLOC_CTX *memctx, const char *name);
 
+/* Well known re_expression formats which sss_parse_name() matches without
+ * running the regular expression. */
+enum sss_names_re_format {
+    SSS_NAMES_RE_GENERIC = 0,
+    SSS_NAMES_RE_DEFAULT,   /* name or name@domain */
+    SSS_NAMES_RE_IPA_AD,    /* name, name@domain or DOMAIN\name */
+};
+
 struct sss_names_ctx {
     char *re_pattern;
     char *fq_fmt;
 
     sss_regexp_t *re;
+    enum sss_names_re_format re_format;
 };
 
 /* initialize sss_names_ctx directly from arguments */
@@ -541,6 +550,9 @@ struct sss_domain_info *find_domain_by_name_ex(struct sss_domain_info *domain,
                                                uint32_t gnd_flags);
 struct sss_domain_info *find_domain_by_sid(struct sss_domain_info *domain,
                                            const char *sid);
+/* Rebuild the name and SID lookup index of the domain list that @domain
+ * belongs to. Call it whenever domains are added or their names change. */
+void sss_domain_index_update(struct sss_domain_info *domain);
 enum sss_domain_state sss_domain_get_state(struct sss_domain_info *dom);
 void sss_domain_set_state(struct sss_domain_info *dom,
                           enum sss_domain_state state);